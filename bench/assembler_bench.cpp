@@ -0,0 +1,137 @@
+#include "assembler/assembler.hpp"
+#include "assembler/instruction.hpp"
+#include "assembler/one_pass_assembler.hpp"
+#include "assembler/operand.hpp"
+#include "assembler/parser.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+/// Appends `suffix` to the label of `instr` and to its label operands.
+void rename_labels(Instruction* instr, std::string const& suffix) {
+    if (instr->has_label()) {
+        instr->set_label(instr->get_label() + suffix);
+    }
+
+    for (std::size_t i = 0; i != instr->get_operands().size(); ++i) {
+        if (instr->get_operand(i).type() == Operand::Label) {
+            std::string const label = instr->get_operand(i).label() + suffix;
+            instr->set_operand(i, Operand::from_label(label.data(), label.data() + label.size()));
+        }
+    }
+}
+
+/// Parses the lab program at `path` and repeats everything between its `.ORIG` and `.END` until
+/// the program has at least `instruction_count` instructions. The labels of each copy get their
+/// own suffix, so they remain unique and every copy only refers to itself.
+auto scale_program(std::string const& path, std::size_t instruction_count)
+    -> std::vector<Instruction> {
+    std::ifstream input(path, std::ios::binary);
+    std::string const code(
+        (std::istreambuf_iterator<char>(input)),
+        std::istreambuf_iterator<char>()
+    );
+    Parser parser(code);
+    std::vector<Instruction> const lab = parser.parse_instructions();
+    if (lab.size() < 3) {
+        return {};
+    }
+
+    std::vector<Instruction> program;
+    program.reserve(instruction_count + lab.size());
+    program.push_back(lab.front());
+    for (std::size_t copy = 0; program.size() < instruction_count; ++copy) {
+        std::string const suffix = "_" + std::to_string(copy);
+        for (std::size_t i = 1; i + 1 < lab.size(); ++i) {
+            program.push_back(lab[i]);
+            rename_labels(&program.back(), suffix);
+        }
+    }
+    program.push_back(lab.back());
+    return program;
+}
+
+/// The fastest time of each step of `Assembler::run()`, and of `OnePassAssembler::run()`, over all
+/// repetitions, in seconds.
+struct PassTimes {
+    double build = 0;
+    double assign_addresses = 0;
+    double scan_label = 0;
+    double translate = 0;
+    double one_pass = 0;
+};
+
+void record(double* best, std::chrono::steady_clock::time_point start, bool first) {
+    std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+    if (first || elapsed.count() < *best) {
+        *best = elapsed.count();
+    }
+}
+}  // namespace
+
+/// Measures the passes of the `Assembler`, and the `OnePassAssembler`, on each lab program in
+/// `test/code_lc3`, scaled to about 1M instructions. The number of instructions and of repetitions
+/// (5 by default) can be passed as arguments. The fastest repetition of each pass is reported.
+auto main(int argc, char** argv) -> int {
+    std::size_t const instruction_count =
+        argc > 1 ? std::strtoul(argv[1], nullptr, 10) : std::size_t { 1000000 };
+    int const repetitions = argc > 2 ? std::atoi(argv[2]) : 5;
+
+    for (int lab = 1; lab <= 5; ++lab) {
+        std::string const name = "lab" + std::to_string(lab);
+        std::vector<Instruction> const program = scale_program(
+            ASSEMBLER_SOURCE_DIR "/test/code_lc3/" + name + "/" + name + ".asm",
+            instruction_count
+        );
+
+        PassTimes times;
+        std::size_t word_count = 0;
+        for (int repetition = 0; repetition < repetitions; ++repetition) {
+            Assembler assembler(program);
+            bool const first = repetition == 0;
+
+            auto start = std::chrono::steady_clock::now();
+            assembler.build_program_table();
+            record(&times.build, start, first);
+
+            start = std::chrono::steady_clock::now();
+            assembler.assign_addresses();
+            record(&times.assign_addresses, start, first);
+
+            start = std::chrono::steady_clock::now();
+            bool const ok = assembler.scan_label();
+            record(&times.scan_label, start, first);
+
+            start = std::chrono::steady_clock::now();
+            std::vector<std::uint16_t> const words = assembler.translate();
+            record(&times.translate, start, first);
+
+            OnePassAssembler one_pass;
+            start = std::chrono::steady_clock::now();
+            bool const one_pass_ok = one_pass.run(program);
+            record(&times.one_pass, start, first);
+
+            if (!ok || words.empty() || !one_pass_ok || one_pass.words() != words) {
+                std::cerr << "error: failed to assemble " << name << '\n';
+                return 1;
+            }
+            word_count = words.size();
+        }
+
+        std::cout << name << ": " << program.size() << " instructions, " << word_count
+                  << " words; build " << times.build * 1e3 << " ms, assign_addresses "
+                  << times.assign_addresses * 1e3 << " ms, scan_label " << times.scan_label * 1e3
+                  << " ms, translate " << times.translate * 1e3 << " ms; one pass "
+                  << times.one_pass * 1e3 << " ms\n";
+    }
+
+    return 0;
+}
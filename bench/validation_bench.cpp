@@ -0,0 +1,75 @@
+#include "assembler/instruction.hpp"
+#include "assembler/parser.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+/// Generates a program of `instruction_count` well-formed instructions, which cycles through
+/// instructions with different operand signatures.
+auto generate_program(std::size_t instruction_count) -> std::string {
+    static char const* const lines[] = {
+        "LOOP ADD R1, R1, #-1\n",
+        "AND R2, R2, R3\n",
+        "BRp LOOP\n",
+        "LD R0, DATA\n",
+        "LDR R4, R5, #12\n",
+        "NOT R6, R7\n",
+        "JSR LOOP\n",
+        "TRAP x25\n",
+        "DATA .FILL x1234\n",
+        ".BLKW 3\n",
+        "RET\n",
+        ".STRINGZ \"text\"\n",
+    };
+    std::size_t const line_count = sizeof(lines) / sizeof(lines[0]);
+
+    std::string program = ".ORIG x3000\n";
+    program.reserve(instruction_count * 16);
+    for (std::size_t i = 1; i < instruction_count; ++i) {
+        program += lines[i % line_count];
+    }
+    return program;
+}
+}  // namespace
+
+/// Measures how many instructions per second `Instruction::validate_and_emit_diagnostics()`
+/// validates. The number of instructions (1M by default) and of repetitions (5 by default) can be
+/// passed as arguments. The fastest repetition is reported.
+auto main(int argc, char** argv) -> int {
+    std::size_t const instruction_count =
+        argc > 1 ? std::strtoul(argv[1], nullptr, 10) : std::size_t { 1000000 };
+    int const repetitions = argc > 2 ? std::atoi(argv[2]) : 5;
+
+    std::string const program = generate_program(instruction_count);
+    Parser parser(program);
+    std::vector<Instruction> const instructions = parser.parse_instructions();
+
+    double best_seconds = 0;
+    for (int repetition = 0; repetition < repetitions; ++repetition) {
+        std::size_t valid_count = 0;
+        auto const start = std::chrono::steady_clock::now();
+        for (Instruction const& instr : instructions) {
+            valid_count += instr.validate_and_emit_diagnostics();
+        }
+        std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+
+        if (valid_count != instructions.size()) {
+            std::cerr << "error: " << instructions.size() - valid_count
+                      << " instruction(s) failed validation\n";
+            return 1;
+        }
+
+        if (repetition == 0 || elapsed.count() < best_seconds) {
+            best_seconds = elapsed.count();
+        }
+    }
+
+    std::cout << "validated " << instructions.size() << " instructions in " << best_seconds * 1e3
+              << " ms (" << instructions.size() / best_seconds / 1e6 << " M instructions/s)\n";
+    return 0;
+}
@@ -1,10 +1,40 @@
-# Run the assembler and capture output.
-execute_process(
-    COMMAND ${EXECUTABLE} ${INPUT_FILE}
-    OUTPUT_VARIABLE ASM_OUTPUT
-    ERROR_VARIABLE ASM_ERROR
-    RESULT_VARIABLE ASM_RESULT
-)
+# Run the assembler and capture output. If `READ_STDIN` is set, the input file is piped to the
+# standard input of the assembler instead of being passed by name. If `ONE_PASS` or `STREAM` is set,
+# the assembler is run with `--one-pass` or `--stream`, respectively. If `MAX_ERRORS`, `JOBS`, or
+# `FORMAT` is set, it is passed to `--max-errors`, `--jobs`, or `--format`, respectively.
+set(ASM_OPTIONS)
+if (ONE_PASS)
+    list(APPEND ASM_OPTIONS --one-pass)
+endif()
+if (STREAM)
+    list(APPEND ASM_OPTIONS --stream)
+endif()
+if (DEFINED MAX_ERRORS)
+    list(APPEND ASM_OPTIONS --max-errors ${MAX_ERRORS})
+endif()
+if (DEFINED JOBS)
+    list(APPEND ASM_OPTIONS --jobs ${JOBS})
+endif()
+if (DEFINED FORMAT)
+    list(APPEND ASM_OPTIONS --format ${FORMAT})
+endif()
+
+if (READ_STDIN)
+    execute_process(
+        COMMAND ${CMAKE_COMMAND} -E cat ${INPUT_FILE}
+        COMMAND ${EXECUTABLE} ${ASM_OPTIONS} -
+        OUTPUT_VARIABLE ASM_OUTPUT
+        ERROR_VARIABLE ASM_ERROR
+        RESULT_VARIABLE ASM_RESULT
+    )
+else()
+    execute_process(
+        COMMAND ${EXECUTABLE} ${ASM_OPTIONS} ${INPUT_FILE}
+        OUTPUT_VARIABLE ASM_OUTPUT
+        ERROR_VARIABLE ASM_ERROR
+        RESULT_VARIABLE ASM_RESULT
+    )
+endif()
 
 # Detect the expected output file suffix.
 get_filename_component(EXTENSION ${EXPECTED_OUTPUT_FILE} EXT)
@@ -15,6 +15,12 @@ typedef struct OpaqueAssembler* AssemblerRef;
 size_t assembler_get_instruction_size(AssemblerRef assembler);
 /// Returns the instruction at index `index` in the assembler `assembler`.
 InstructionRef assembler_get_instruction(AssemblerRef assembler, size_t index);
+/// Sets the number of memory words that the instruction at index `index` in the assembler
+/// `assembler` occupies.
+void assembler_set_word_count(AssemblerRef assembler, size_t index, uint16_t word_count);
+/// Assigns addresses to all instructions in the assembler `assembler` based on their word counts,
+/// starting at `origin`. A `.ORIG` instruction starts over at the address in its operand.
+void assembler_assign_addresses(AssemblerRef assembler, uint16_t origin);
 /// Adds the label `label` and its corresponding address `address` to the symbol table. If the label
 /// already exists in the symbol table, returns `0`; otherwise, returns `1`.
 int assembler_add_label(AssemblerRef assembler, char const* label, uint16_t address);
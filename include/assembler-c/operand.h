@@ -38,6 +38,9 @@ typedef enum {
     NumberOperand,
     LabelOperand,
     StringLiteralOperand,
+    ImmediateLiteralOperand,
+    LabelLiteralOperand,
+    ExpressionOperand,
 } OperandType;
 
 /// Returns the kind of the operand `operand`.
@@ -62,13 +65,14 @@ int16_t operand_get_immediate_value(OperandRef operand);
 /// behavior is undefined.
 int16_t operand_get_regular_decimal(OperandRef operand);
 /// Returns the label that the operand represents. For example, if the operand comes from the label
-/// token `LOOP`, this function returns the string `LOOP`.
+/// token `LOOP`, this function returns the string `LOOP`. For an expression, such as `TABLE+3`, it
+/// returns the text of the expression.
 ///
 /// Note that the returned string is not null-terminated. You must provide a variable to store the
 /// length of the string. You can pass a pointer to the variable to the `length` parameter.
 ///
-/// This function should only be called if `operand_get_type()` returns `Label`, otherwise the
-/// behavior is undefined.
+/// This function should only be called if `operand_get_type()` returns `Label`, `LabelLiteral`, or
+/// `Expression`, otherwise the behavior is undefined.
 char const* operand_get_label(OperandRef operand, size_t* length);
 /// Returns the string literal that the operand represents. For example, if the operand comes from
 /// the string literal token `"Hello"`, this function returns the string `Hello`. Note that the
@@ -14,7 +14,6 @@ EXTERN_C_BEGIN
 char const* parse_decimal_number(char const* current, char const* end);
 char const* parse_string_literal(char const* current, char const* end);
 void parse_instruction(ParserRef parser, InstructionRef instr);
-int16_t string_to_integer(char const* content, int* ok);
 void get_instruction_immediate_range(InstructionRef instr, int16_t* lb, int16_t* ub);
 void assign_addresses(AssemblerRef assembler);
 int scan_label(AssemblerRef assembler);
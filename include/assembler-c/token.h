@@ -63,6 +63,13 @@ typedef enum {
     /// Represents a string literal, such as `"Hello"`. String literals should be enclosed in double
     /// quotes. They are used as operands for the `.STRINGZ` pseudo-instruction.
     StringToken,
+    /// Represents a literal with an integer value: `=` followed by an immediate or a regular
+    /// decimal number, such as `=x1234` or `=-1`.
+    ImmediateLiteralToken,
+    /// Represents a literal whose value is the address of a label, such as `=TABLE`.
+    LabelLiteralToken,
+    /// Represents a constant expression of labels and numbers, such as `TABLE+3` or `END-START`.
+    ExpressionToken,
 
     // The following token types represent symbols that appear in LC-3 assembly code.
 
@@ -1,23 +1,52 @@
 #ifndef ASSEMBLER_ASSEMBLER_HPP
 #define ASSEMBLER_ASSEMBLER_HPP
 
+#include "assembler/diagnostic.hpp"
 #include "assembler/instruction.hpp"
 #include "assembler/operand.hpp"
+#include "assembler/program_table.hpp"
+#include "assembler/section.hpp"
+#include "assembler/symbol.hpp"
 
+#include <cstddef>
 #include <cstdint>
-#include <iostream>
+#include <functional>
+#include <memory>
+#include <ostream>
 #include <string>
-#include <unordered_map>
+#include <utility>
 #include <vector>
 
-#ifdef USE_CPP
-    #include <cstddef>
-#endif
-
 class Assembler {
 public:
-    explicit Assembler(std::vector<Instruction> instructions) :
-        instructions_(std::move(instructions)) { }
+    /// The literals that follow the words of the row `row`, which hosts them. See
+    /// `place_literal_pools()`.
+    struct LiteralPool {
+        std::uint32_t row;
+        /// The index of the first literal of the pool in `literals_`.
+        std::uint32_t first_literal;
+        std::uint32_t literal_count;
+        /// Whether the pool starts with a `BRnzp` over its literals, since execution may fall
+        /// through the end of `row` into it.
+        bool jump;
+    };
+
+    /// Constructs an assembler for `instructions`, whose labels and string literals are interned
+    /// into `symbols`, the pool of the `Parser` that parsed them (see `Parser::symbols()`).
+    /// `run()` and `run_parallel()` make it the pool of the current thread while they run.
+    Assembler(std::vector<Instruction> instructions, std::shared_ptr<SymbolPool> symbols) :
+        instructions_(std::move(instructions)),
+        symbols_(std::move(symbols)) { }
+
+    // The program table refers to the instructions of the assembler, so a copy would refer to the
+    // instructions of the original.
+    Assembler(Assembler const&) = delete;
+    auto operator=(Assembler const&) -> Assembler& = delete;
+
+    /// Returns the pool that the symbols of the program are interned into.
+    auto symbols() const -> std::shared_ptr<SymbolPool> const& {
+        return symbols_;
+    }
 
     auto get_instructions() const -> std::vector<Instruction> const& {
         return instructions_;
@@ -27,30 +56,100 @@ public:
         return instructions_;
     }
 
+    /// Returns the table that the passes run over. It is empty until `build_program_table()` is
+    /// called.
+    auto get_program() const -> ProgramTable const& {
+        return program_;
+    }
+
+    auto get_program() -> ProgramTable& {
+        return program_;
+    }
+
+    /// Builds the program table over the instructions. `run()` calls this after validating the
+    /// instructions, so that the passes below can run over the table. The instructions must not be
+    /// added or removed after this.
+    void build_program_table() {
+        program_ = ProgramTable(instructions_);
+    }
+
     /// Adds the label `label` and its corresponding address `address` to the symbol table. If the
     /// label already exists in the symbol table, returns `false`; otherwise, returns `true`.
-    auto add_label(std::string label, std::uint16_t address) -> bool {
-        return symbol_table_.emplace(std::move(label), address).second;
+    auto add_label(Symbol label, std::uint16_t address) -> bool {
+        std::uint32_t& entry = symbol_entry(label);
+        if (entry != no_label) {
+            return false;
+        }
+        entry = address;
+        return true;
+    }
+
+    auto add_label(std::string const& label, std::uint16_t address) -> bool {
+        return add_label(symbols_->intern(label), address);
     }
 
     /// Returns the address of the label `label`. If the label does not exist, sets `ok` to `false`.
-    auto get_label(std::string const& label, bool* ok) -> std::uint16_t {
-        auto const iter = symbol_table_.find(label);
-        if (iter == symbol_table_.end()) {
+    auto get_label(Symbol label, bool* ok) const -> std::uint16_t {
+        if (label.id() >= symbol_table_.size() || symbol_table_[label.id()] == no_label) {
             *ok = false;
             return 0;
         } else {
             *ok = true;
-            return iter->second;
+            return static_cast<std::uint16_t>(symbol_table_[label.id()]);
         }
     }
 
-    /// Assigns an address to each instruction.
+    auto get_label(std::string const& label, bool* ok) const -> std::uint16_t {
+        return get_label(symbols_->intern(label), ok);
+    }
+
+    /// Returns the address that the label `label` is loaded at, which is what a word that holds
+    /// the label, rather than an offset to it, stores. The program table gives each `.ORIG` a
+    /// word, so this is one less than `get_label()`. For a constant or an expression, this is its
+    /// value. If the label does not exist, sets `ok` to `false`.
+    auto get_label_value(Symbol label, bool* ok) const -> std::uint16_t {
+        return static_cast<std::uint16_t>(get_label(label, ok) - 1);
+    }
+
+    /// Assigns an address to each row of the program table.
     void assign_addresses();
 
-    /// Returns the starting address of the instruction sequence.
+    /// Returns the starting address of the instruction sequence, which is the origin of its first
+    /// section.
     auto start_address() const -> std::uint16_t {
-        return instructions_.front().get_address();
+        return program_.address(0);
+    }
+
+    /// Returns the sections of the program, in source order. They are set by `run()` and
+    /// `run_parallel()`, and refer to the words these return.
+    auto sections() const -> std::vector<Section> const& {
+        return sections_;
+    }
+
+    /// Sets whether `run()` and `run_parallel()` keep the blocks reserved by `.BLKW` as runs in
+    /// `zero_runs()`, instead of storing their zeros in the words they return. This is off by
+    /// default.
+    void set_keep_zero_runs(bool keep) {
+        keep_zero_runs_ = keep;
+    }
+
+    /// Sets whether `run()` and `run_parallel()` relax the instructions whose label lies out of
+    /// range, instead of reporting them. This is off by default. See `relax_branches()`.
+    void set_relax_branches(bool relax) {
+        relax_branches_ = relax;
+    }
+
+    /// Returns the literal pools of the program, which are placed by `run()` and `run_parallel()`.
+    /// See `place_literal_pools()`.
+    auto literal_pools() const -> std::vector<LiteralPool> const& {
+        return literal_pools_;
+    }
+
+    /// Returns the blocks of zero words that are not stored in the words returned by `run()` and
+    /// `run_parallel()`, in order. Adjacent blocks form a single run. Without
+    /// `set_keep_zero_runs()`, or if an error occurred, there are none.
+    auto zero_runs() const -> std::vector<ZeroRun> const& {
+        return zero_runs_;
     }
 
     /// Scans the instruction sequence and adds any labels found, along with their corresponding
@@ -66,26 +165,52 @@ public:
     ///
     /// This method will
     ///
-    ///     1. Check the validity of the instructions.
-    ///     2. Assign addresses to the instructions.
+    ///     1. Check the validity of the instructions, and build the program table from them.
+    ///     2. Assign addresses to the instructions, and place the literal pools.
     ///     3. Scan the instructions for labels and compute the address of each label.
-    ///     4. Translate the instructions into binary form.
+    ///     4. Evaluate the expressions and the constants defined by `.EQU`.
+    ///     5. Translate the instructions into binary form.
+    ///     6. Check that no two sections overlap.
+    ///
+    /// Each `.ORIG` starts a new section at its operand. The words of all sections are returned one
+    /// after another, and `sections()` tells where each section starts. With
+    /// `set_keep_zero_runs()`, the zeros of `.BLKW` are left out, and `zero_runs()` tells where
+    /// they belong. If an error occurs during any of these steps, the method will return an empty
+    /// vector.
     ///
-    /// If an error occurs during any of these steps, the method will return an empty vector.
+    /// The addresses are unknown if an instruction is invalid, so the later steps are skipped then.
+    /// Only the labels that are redefined, and those that are not defined anywhere, are still
+    /// reported, which needs no addresses (see `report_label_redefinitions()` and
+    /// `report_undefined_labels()`).
     auto run() -> std::vector<std::uint16_t>;
 
+    /// Assembles the instructions like `run()`, but on up to `thread_count` threads. The result and
+    /// the diagnostics are the same as those of `run()`.
+    ///
+    /// The instructions are split into chunks of at least `min_chunk_size` instructions, which are
+    /// validated and translated on their own threads. Each chunk stops at its first error, and
+    /// collects its diagnostics in its own `DiagnosticEngine`. Only the diagnostics of the chunks
+    /// up to the first one with an error are reported, which are exactly those of a serial run.
+    /// The program table is built, and addresses are assigned, in parallel as well (see
+    /// `ProgramTable`).
+    ///
+    /// Labels are not added by `scan_label()` but by a parallel scan, which defines each label at
+    /// its first row and reports the first row that redefines a label, like `scan_label()` does.
+    auto run_parallel(
+        unsigned thread_count,
+        std::size_t min_chunk_size = ProgramTable::default_min_chunk_size
+    ) -> std::vector<std::uint16_t>;
+
     /// Emits diagnostic information for a redefined label `label`. We make it a `public` interface
     /// for students to use.
     static void emit_label_redefinition_diag(Instruction const& instr) {
-        std::cout << "error: label `" << instr.get_label() << "` redefined by instruction `"
-                  << instr << "`\n";
+        instr.report_error(DiagnosticKind::LabelRedefinition, instr.get_label(), instr);
     }
 
     /// Emits diagnostic information for a label not found in an instruction. We make it a `public`
     /// interface for students to use.
     static void emit_label_not_found_diag(Operand const& label_operand, Instruction const& instr) {
-        std::cout << "error: label `" << label_operand.label() << "` in instruction `" << instr
-                  << "` not found\n";
+        instr.report_error(DiagnosticKind::LabelNotFound, label_operand.label(), instr);
     }
 
     /// Emits diagnostic information for an offset of a label in an instruction that is out of
@@ -95,15 +220,245 @@ public:
         Instruction const& instr,
         std::int16_t offset
     ) {
-        std::cout << "error: offset " << offset << " of label `" << label_operand.label()
-                  << "` in instruction `" << instr << "` is out of range\n";
+        instr.report_error(
+            DiagnosticKind::LabelOffsetOutOfRange,
+            offset,
+            label_operand.label(),
+            instr
+        );
     }
 
 private:
-    /// The instructions to be assembled.
+    friend class OnePassAssembler;
+
+    /// The instructions to be assembled. The program table reads their opcodes, labels, and
+    /// operands, and diagnostics are reported on them.
     std::vector<Instruction> instructions_;
-    /// The symbol table that maps labels to their addresses.
-    std::unordered_map<std::string, std::uint16_t> symbol_table_;
+    /// The pool of the symbols of the program, which is freed with the last of the assembler and
+    /// the instructions' parser.
+    std::shared_ptr<SymbolPool> symbols_;
+    /// The word counts and addresses of the instructions.
+    ProgramTable program_;
+    /// The sections of the program, once it has been assembled.
+    std::vector<Section> sections_;
+    /// The zero runs of the program, once it has been assembled with `keep_zero_runs_`.
+    std::vector<ZeroRun> zero_runs_;
+    bool keep_zero_runs_ = false;
+    bool relax_branches_ = false;
+    /// The literal pools, ordered by the row that hosts them.
+    std::vector<LiteralPool> literal_pools_;
+    /// The literals of all pools, one pool after another. A literal appears at most once in a pool.
+    std::vector<Operand> literals_;
+
+    /// A row with a literal operand, and the word of the pool that holds its value.
+    struct LiteralUse {
+        std::uint32_t row;
+        std::uint32_t pool;
+        /// The index of the literal within the pool.
+        std::uint32_t slot;
+    };
+
+    /// The rows with a literal operand, in order.
+    std::vector<LiteralUse> literal_uses_;
+    /// The symbol table, which maps the id of each symbol to the address of the label, or to
+    /// `no_label` if the label is not defined. A constant defined by `.EQU`, and the text of an
+    /// expression, are mapped to their values plus one instead, like the addresses of labels (see
+    /// `evaluate_expressions()` and `get_label_value()`). The ids of `symbols_` are dense, so the
+    /// table is a plain array, and looking up a label operand never hashes or compares its text.
+    /// Symbols interned after the table has grown lie past its end, and are undefined.
+    std::vector<std::uint32_t> symbol_table_;
+
+    /// Marks the ids of undefined labels in `symbol_table_`. It lies outside the range of
+    /// `std::uint16_t`, so every address can be stored.
+    static constexpr std::uint32_t no_label = 0xFFFFFFFF;
+
+    /// Returns the entry of `symbol` in the symbol table. If the table does not reach `symbol`, it
+    /// first grows to cover every symbol of the pool, with entries that are `no_label`.
+    auto symbol_entry(Symbol symbol) -> std::uint32_t& {
+        if (symbol.id() >= symbol_table_.size()) {
+            symbol_table_.resize(symbols_->size(), no_label);
+        }
+        return symbol_table_[symbol.id()];
+    }
+
+    /// Emits diagnostic information for a program that does not start with `.ORIG`, whose first
+    /// instruction is `instr`.
+    static void emit_missing_orig_diag(Instruction const& instr) {
+        instr.report_error(DiagnosticKind::MissingOrig, instr);
+    }
+
+    /// Emits diagnostic information for the `.ORIG` instruction `instr` of `section`, which
+    /// overlaps `other`.
+    static void emit_section_overlap_diag(
+        Instruction const& instr,
+        Section const& section,
+        Section const& other
+    );
+
+    /// Checks that the program starts with a `.ORIG` instruction, and emits a diagnostic if not.
+    auto check_orig() const -> bool;
+
+    /// Checks that no two of `sections` overlap, where `origs[i]` is the `.ORIG` instruction of
+    /// `sections[i]`. A section occupies the addresses from its origin up to, but excluding,
+    /// `origin + word_count`, so sections that only touch do not overlap.
+    ///
+    /// The sections are sorted by origin, and each one is compared with the section that reaches
+    /// furthest among those before it. An error is reported for every section that overlaps, until
+    /// `error_limit_reached()`. Returns `false` if any section overlaps.
+    static auto check_overlaps(
+        std::vector<Section> const& sections,
+        std::vector<Instruction const*> const& origs
+    ) -> bool;
+
+    /// Translates the rows in [first, last), appending the results to `results`, until an error
+    /// occurs and `error_limit_reached()`. If `zero_runs` is not null, the `.BLKW` rows are
+    /// appended to it as runs rather than to `results`. For each `.ORIG` row, the index of the
+    /// next word is appended to `section_starts`, unless it is null. Both indices count the words
+    /// of the runs, and start at 0 for `first`, since `results` and `zero_runs` must be empty.
+    /// Returns `false` if an error occurred.
+    auto translate_rows(
+        std::size_t first,
+        std::size_t last,
+        std::vector<std::uint16_t>& results,
+        std::vector<std::size_t>* section_starts,
+        std::vector<ZeroRun>* zero_runs
+    ) const -> bool;
+
+    /// Sets `sections_` from the index of the first word of each section in `section_starts`, for
+    /// a program of `word_count` words, including those of its zero runs. Returns the `.ORIG`
+    /// instruction of each section.
+    auto build_sections(std::vector<std::size_t> const& section_starts, std::size_t word_count)
+        -> std::vector<Instruction const*>;
+
+    /// Places the literals of the `LD`, `LDI`, and `STI` rows in literal pools within the reach of
+    /// their 9-bit offsets, and grows the rows that host the pools. This runs after
+    /// `assign_addresses()` and before `relax_branches()`, and reassigns the addresses.
+    ///
+    /// The pools are placed in a single pass over the rows. A row that refers to a literal reuses
+    /// the word of an earlier pool if it is still within reach, and otherwise adds the literal to
+    /// the pending pool, unless it is there already. The pending pool is placed after the next
+    /// unconditional `BR`, `JMP`, `RET`, `RTI`, or `HALT`, where execution never reaches it. If
+    /// none comes before the pool would move out of reach of its first literal, or before the
+    /// section ends, the pool is placed after the row before that point instead, behind a `BRnzp`
+    /// over it. With relaxation, the rows that may be relaxed are counted at their relaxed size, so
+    /// relaxing them cannot move a pool out of reach.
+    ///
+    /// A pool is never placed before a `.FILL`, `.BLKW`, `.STRINGZ`, or `.EQU` row, so it never
+    /// splits a table. If the data rows after a row leave no place for the pool within reach, it
+    /// is placed after them, and translation reports the rows it is out of reach of.
+    void place_literal_pools();
+
+    /// Returns whether the row `instr` has a literal operand, which is its second one.
+    static auto has_literal_operand(ProgramTable::Row instr) -> bool;
+
+    /// Returns the number of words of the pool that `row` hosts, or 0 if it hosts none.
+    auto literal_pool_word_count(std::size_t row) const -> std::size_t;
+
+    /// Translates the row `instr` with a literal operand, appending its word to `results`. Returns
+    /// `false` if the label of the literal is not defined, or its pool is out of reach, after
+    /// emitting a diagnostic.
+    auto translate_literal_use(ProgramTable::Row instr, std::vector<std::uint16_t>& results) const
+        -> bool;
+
+    /// Appends the words of `pool` to `results`.
+    void translate_literal_pool(LiteralPool const& pool, std::vector<std::uint16_t>& results) const;
+
+    /// Computes the value of every constant defined by `.EQU` and of every expression operand, and
+    /// stores it in the symbol table under the label of the constant or the text of the expression.
+    /// This runs after the labels are scanned, so an expression operand is then translated like a
+    /// label, whose address is the value of the expression.
+    ///
+    /// A constant depends on the label or expression that defines it, and an expression on the
+    /// labels of its terms, which may be constants themselves. The values are computed in
+    /// topological order by a depth-first search, which finds the constants that depend on
+    /// themselves. Such a cycle, and an undefined label in the definition of a constant, are
+    /// reported at the `.EQU`, and make the method return `false`. An expression operand with an
+    /// undefined label is left undefined, so that translation reports every row that uses it.
+    ///
+    /// The expressions are stored as the symbols of their texts, so each distinct expression is
+    /// parsed and evaluated once, however many rows use it.
+    auto evaluate_expressions() -> bool;
+
+    /// Translates the `.FILL` row `instr` whose operand is a label or an expression, appending the
+    /// value to `results`. Returns `false` if the value is not defined, after emitting a
+    /// diagnostic.
+    auto translate_fill_symbol(ProgramTable::Row instr, std::vector<std::uint16_t>& results) const
+        -> bool;
+
+    /// Returns the number of words that `row` may take after `relax_branches()`, which is its
+    /// relaxed size if relaxation is on and the row may be relaxed, and its word count otherwise.
+    auto max_word_count(std::size_t row) const -> std::size_t;
+
+    /// Relaxes the `BR`, `JSR`, `LD`, `LEA`, and `ST` rows whose label lies out of the range of
+    /// their offset, so that they reach it through an address stored next to them (see
+    /// `translate_relaxed()`). This runs after `assign_addresses()` and before the labels are
+    /// scanned, and reassigns the addresses.
+    ///
+    /// A relaxed row takes more words, which moves the rows after it, and may push other labels out
+    /// of range, so the word counts grow to a fixpoint. Rather than reassigning all addresses each
+    /// round, the addresses are kept in a Fenwick tree, and only the references whose span contains
+    /// a row that grew are checked again, which a segment tree over the spans finds. Rows never
+    /// shrink back, so each reference is relaxed at most once, in O(n log n) overall.
+    ///
+    /// A constant defined by `.EQU` is reached through its value, which is known here if it is a
+    /// number. Otherwise, it depends on the addresses, which are not final yet, so the rows that
+    /// refer to it are always relaxed.
+    ///
+    /// A relaxed row is a regular instruction that takes more than one word besides the literal
+    /// pool it may host, which is how `translate_row()` recognizes it.
+    void relax_branches();
+
+    /// Translates the relaxed row `instr`, appending its words to `results`:
+    ///
+    ///     BR   -> BR with the inverted conditions over the next 3 words, unless it is
+    ///             unconditional; LD R7, #1; JMP R7; .FILL label
+    ///     JSR  -> LD R7, #2; JSRR R7; BRnzp #1; .FILL label
+    ///     LD   -> LDI Rd, #1; BRnzp #1; .FILL label
+    ///     LEA  -> LD Rd, #1; BRnzp #1; .FILL label
+    ///     ST   -> STI Rs, #1; BRnzp #1; .FILL label
+    ///
+    /// A relaxed branch thus overwrites R7, like `JSR` and `TRAP` do. Since `LD` sets the condition
+    /// codes, a relaxed `BR` or `JSR` also leaves them set by the address it loads into R7, and a
+    /// relaxed `LEA` by the address it loads into Rd. A conditional `BR` still tests the condition
+    /// codes before they change.
+    void translate_relaxed(ProgramTable::Row instr, std::vector<std::uint16_t>& results) const;
+
+    /// Reports the valid instructions whose label is defined by an earlier valid instruction, or
+    /// with `add_label()`, in order, like `scan_label()` does, until `error_limit_reached()`. The
+    /// indices of the invalid instructions are `invalid`, in increasing order.
+    void report_label_redefinitions(std::vector<std::size_t> const& invalid) const;
+
+    /// Reports the operands of the valid instructions that refer to a label that no instruction
+    /// defines, in order, until `error_limit_reached()`. The indices of the invalid instructions
+    /// are `invalid`, in increasing order. A label in an expression counts as well, and is
+    /// reported as its expression like translation does.
+    void report_undefined_labels(std::vector<std::size_t> const& invalid) const;
+
+    /// Returns whether `operand` refers to a label for which `is_defined` returns `false`: a label
+    /// operand, a label literal, or an expression with such a label among its terms.
+    static auto refers_to_undefined_label(
+        Operand const& operand,
+        std::function<bool(Symbol)> const& is_defined
+    ) -> bool;
+
+    /// Adds the labels of the program table to the symbol table, working on the rows of each chunk
+    /// in `chunks` (see `split_range()`) on its own thread. Returns `false` if a label is
+    /// redefined, in which case the same diagnostic as in `scan_label()` has been emitted.
+    auto scan_label_parallel(std::vector<std::size_t> const& chunks) -> bool;
+
+    /// Translates the instruction in the row `instr`, appending the result to `results`. Returns
+    /// `false` if an error occurred, in which case a diagnostic has been emitted.
+    auto translate_row(ProgramTable::Row instr, std::vector<std::uint16_t>& results) const -> bool;
+
+    /// Translates the row `instr` like `translate_row()`, for `OnePassAssembler`. A label operand
+    /// that is not defined yet is translated as if it were defined at the next address, so that
+    /// its offset is 0, and is stored in `*forward_label` for the caller to patch the offset once
+    /// the label is defined. Otherwise, `*forward_label` is set to an empty symbol.
+    auto translate_row_forward(
+        ProgramTable::Row instr,
+        std::vector<std::uint16_t>& results,
+        Symbol* forward_label
+    ) -> bool;
 
     // The following member functions are used to translate the parts of an instruction into binary
     // form.
@@ -132,7 +487,7 @@ private:
     /// immediate operand is within the valid range.
     static auto translate_immediate(Operand const& imm_operand, unsigned bits) -> std::uint16_t;
 
-    /// Converts the operand at index `operand_idx` of the instruction `instr` into its binary form.
+    /// Converts the operand at index `operand_idx` of the row `instr` into its binary form.
     /// This operand must be a label. The function will look up the symbol table to obtain the
     /// address of the label and compute the actual offset based on the label's address and the
     /// instruction's address. Finally, it returns the lower `bits` bits of the offset.
@@ -140,22 +495,22 @@ private:
     /// If the label specified by the operand does not exist or the offset exceeds the range of
     /// `bits`, this function will emit diagnostic information.
     auto translate_label(  //
-        Instruction const& instr,
+        ProgramTable::Row instr,
         std::size_t operand_idx,
         unsigned bits
     ) const -> std::uint16_t;
 #endif
 
-    /// Translates a pseudo-instruction `instr`. The result will be appended to the end of
-    /// `results`.
+    /// Translates the pseudo-instruction in the row `instr`. The result will be appended to the end
+    /// of `results`.
     ///
     /// Since some pseudo-instructions may generate multiple results, we pass `results` directly as
     /// a parameter.
-    static void translate_pseudo(Instruction const& instr, std::vector<std::uint16_t>& results);
+    void translate_pseudo(ProgramTable::Row instr, std::vector<std::uint16_t>& results) const;
 
-    /// Translates a regular instruction (any instruction that is not a pseudo-instruction) into a
-    /// 16-bit binary representation.
-    auto translate_regular_instruction(Instruction const& instr) const -> std::uint16_t;
+    /// Translates the regular instruction (any instruction that is not a pseudo-instruction) in the
+    /// row `instr` into a 16-bit binary representation.
+    auto translate_regular_instruction(ProgramTable::Row instr) const -> std::uint16_t;
 };
 
 #endif  // ASSEMBLER_ASSEMBLER_HPP
@@ -0,0 +1,218 @@
+#ifndef ASSEMBLER_DIAGNOSTIC_HPP
+#define ASSEMBLER_DIAGNOSTIC_HPP
+
+#include "assembler/line_index.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/// Returns the stream that diagnostic messages are written to on the current thread. This is
+/// `std::cout`, unless the messages are redirected with a `DiagnosticRedirect`.
+///
+/// Diagnostics are only written to this stream if no `DiagnosticEngine` collects them.
+auto diagnostic_stream() -> std::ostream&;
+
+/// Redirects the diagnostic messages of the current thread to `stream` for the lifetime of the
+/// object. Redirections may be nested.
+class DiagnosticRedirect {
+public:
+    explicit DiagnosticRedirect(std::ostream& stream);
+    ~DiagnosticRedirect();
+
+    DiagnosticRedirect(DiagnosticRedirect const&) = delete;
+    auto operator=(DiagnosticRedirect const&) -> DiagnosticRedirect& = delete;
+
+private:
+    /// The stream that was in use before the redirection.
+    std::ostream* previous_;
+};
+
+/// Returns the index of the source code that diagnostic messages on the current thread refer to,
+/// or `nullptr` if it is unknown (see `DiagnosticSource`).
+auto diagnostic_source() -> LineIndex const*;
+
+/// Makes diagnostic messages on the current thread refer to the source code indexed by `source`
+/// for the lifetime of the object, so that they report the line and column of the error. `source`
+/// may be `nullptr` to report no locations. Like redirections, sources may be nested.
+class DiagnosticSource {
+public:
+    explicit DiagnosticSource(LineIndex const* source);
+    ~DiagnosticSource();
+
+    DiagnosticSource(DiagnosticSource const&) = delete;
+    auto operator=(DiagnosticSource const&) -> DiagnosticSource& = delete;
+
+private:
+    /// The source that was in use before this one.
+    LineIndex const* previous_;
+};
+
+/// The kinds of diagnostics, as listed in `diagnostic.def`.
+enum class DiagnosticKind : std::uint8_t {
+#define DIAGNOSTIC(name, format) name,
+#include "assembler/diagnostic.def"
+};
+
+/// A diagnostic, recorded as its kind, the range of the source code it is about, and the arguments
+/// of its message. Keeping the parts apart, rather than formatting the message right away, lets a
+/// `DiagnosticEngine` decide later whether and where to render it.
+struct Diagnostic {
+    /// The offset of a diagnostic that is not about a specific location in the source code.
+    static constexpr std::size_t unknown_offset = static_cast<std::size_t>(-1);
+
+    DiagnosticKind kind;
+    /// The range [begin, end) of the source code, in bytes. It is empty if only its start is
+    /// known, and both offsets are `unknown_offset` if the location is unknown.
+    std::size_t begin;
+    std::size_t end;
+    /// The arguments that replace the placeholders `{0}`, `{1}`, ... in the format of `kind`.
+    std::vector<std::string> arguments;
+};
+
+/// Writes the message of `diagnostic` to `out`, without its location and severity.
+void write_message(std::ostream& out, Diagnostic const& diagnostic);
+
+/// Writes `diagnostic` as a line of text to `out`. The message is prefixed with the line and column
+/// of the start of the diagnostic, such as `3:5: error: `, if `source` is not `nullptr` and
+/// contains the start. Otherwise, it only starts with `error: `.
+void render(std::ostream& out, Diagnostic const& diagnostic, LineIndex const* source);
+
+/// Receives the diagnostics of a `DiagnosticEngine` when it is flushed.
+class DiagnosticSink {
+public:
+    virtual ~DiagnosticSink() = default;
+
+    virtual void consume(Diagnostic const& diagnostic) = 0;
+};
+
+/// Renders diagnostics as text with `render()`.
+class TextDiagnosticSink : public DiagnosticSink {
+public:
+    /// Constructs a sink that writes to `out`, and takes the locations of diagnostics from
+    /// `source`, which may be `nullptr` to report no locations.
+    TextDiagnosticSink(std::ostream& out, LineIndex const* source) : out_(&out), source_(source) { }
+
+    void consume(Diagnostic const& diagnostic) override {
+        render(*out_, diagnostic, source_);
+    }
+
+private:
+    std::ostream* out_;
+    LineIndex const* source_;
+};
+
+/// Collects the diagnostics of an assembly, so that they are rendered once at the end instead of
+/// being written as they occur.
+///
+/// An engine belongs to a single assembly. Since `report()` finds the engine through a thread-local
+/// pointer (see `Scope`), several programs can be assembled concurrently, each on its own thread
+/// with its own engine, without their diagnostics interleaving.
+///
+/// At most `max_errors()` errors are kept. Further errors are only counted, and `flush()` reports
+/// their number in a single `TooManyErrors` diagnostic.
+class DiagnosticEngine {
+public:
+    /// Makes `engine` the engine of the current thread for the lifetime of the object. Scopes may
+    /// be nested.
+    class Scope {
+    public:
+        explicit Scope(DiagnosticEngine& engine);
+        ~Scope();
+
+        Scope(Scope const&) = delete;
+        auto operator=(Scope const&) -> Scope& = delete;
+
+    private:
+        /// The engine that was in use before this one.
+        DiagnosticEngine* previous_;
+    };
+
+    /// The error limit of an engine that keeps every error.
+    static constexpr std::size_t no_limit = static_cast<std::size_t>(-1);
+
+    explicit DiagnosticEngine(std::size_t max_errors = no_limit) : max_errors_(max_errors) { }
+
+    /// Records `diagnostic`, unless the error limit has been reached.
+    void report(Diagnostic diagnostic);
+
+    auto max_errors() const -> std::size_t {
+        return max_errors_;
+    }
+
+    /// Returns the number of errors reported so far, including those beyond the limit.
+    auto error_count() const -> std::size_t {
+        return error_count_;
+    }
+
+    /// Returns whether the error limit has been reached, i.e., further errors would be dropped.
+    auto at_limit() const -> bool {
+        return error_count_ >= max_errors_;
+    }
+
+    /// Returns the recorded diagnostics in the order they were reported.
+    auto diagnostics() const -> std::vector<Diagnostic> const& {
+        return diagnostics_;
+    }
+
+    /// Passes the recorded diagnostics to `sink` in order, followed by a `TooManyErrors`
+    /// diagnostic if errors were dropped, and then clears the engine.
+    void flush(DiagnosticSink& sink);
+
+    /// Reports the recorded diagnostics again with `::report()`, i.e., to the engine or stream of
+    /// the current thread, and then clears the engine. This merges the diagnostics of work that
+    /// was split across threads into the diagnostics of the thread that started it.
+    ///
+    /// Forwarding stops once the engine of the current thread reaches its limit, since a serial
+    /// run would have stopped there instead of finding the remaining errors. The engine should
+    /// therefore be limited to `remaining_errors()` of the thread that started the work.
+    void forward();
+
+private:
+    std::vector<Diagnostic> diagnostics_;
+    std::size_t max_errors_;
+    std::size_t error_count_ = 0;
+};
+
+/// Reports `diagnostic` to the engine of the current thread. Without an engine, the diagnostic is
+/// rendered to `diagnostic_stream()` right away, with its location taken from
+/// `diagnostic_source()`.
+void report(Diagnostic diagnostic);
+
+/// Returns whether the current thread has reported as many errors as it may, so that work which has
+/// just reported an error should stop rather than recover and look for further errors. Without a
+/// `DiagnosticEngine`, errors are not counted, and work stops at its first error.
+auto error_limit_reached() -> bool;
+
+/// Returns how many more errors the current thread may report before `error_limit_reached()`. This
+/// is 1 without a `DiagnosticEngine`.
+auto remaining_errors() -> std::size_t;
+
+/// Converts an argument of a diagnostic to text with `operator<<`.
+template <typename T>
+auto diagnostic_argument(T const& value) -> std::string {
+    std::ostringstream out;
+    out << value;
+    return out.str();
+}
+
+inline auto diagnostic_argument(std::string const& value) -> std::string {
+    return value;
+}
+
+/// Reports an error of `kind` about the range [begin, end) of the source code, whose message
+/// arguments are `arguments`.
+template <typename... Arguments>
+void report_error(
+    DiagnosticKind kind,
+    std::size_t begin,
+    std::size_t end,
+    Arguments const&... arguments
+) {
+    report(Diagnostic { kind, begin, end, { diagnostic_argument(arguments)... } });
+}
+
+#endif  // ASSEMBLER_DIAGNOSTIC_HPP
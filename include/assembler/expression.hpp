@@ -0,0 +1,33 @@
+#ifndef ASSEMBLER_EXPRESSION_HPP
+#define ASSEMBLER_EXPRESSION_HPP
+
+#include "assembler/operand.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/// A term of a constant expression, such as `TABLE` or `3` in `TABLE+3`.
+struct ExpressionTerm {
+    /// The id of the `Symbol` of a label, or the value of a number reinterpreted as a 16-bit
+    /// unsigned integer.
+    std::uint32_t payload;
+    /// Whether the term is a label, whose value is its address or, for a constant defined by
+    /// `.EQU`, its constant.
+    bool is_label;
+    /// Whether the term is subtracted rather than added.
+    bool negative;
+};
+
+/// Splits the content [begin, end) of an `Expression` token into its terms, and appends them to
+/// `*terms` unless `terms` is null. The labels of the terms are interned.
+///
+/// Each term is lexed like an operand of its own, and must be a label, an immediate, or a regular
+/// decimal number, so `TABLE+3`, `END-START`, and `x3000+#-1` are valid expressions. A term that
+/// is empty, such as in `TABLE+`, or that is a register or an opcode, makes the expression invalid.
+///
+/// Returns `OperandConstructionErrorType::InvalidExpression` for an invalid expression, the error
+/// of the first number that cannot be decoded, or `OperandConstructionErrorType::NoError`.
+auto parse_expression(char const* begin, char const* end, std::vector<ExpressionTerm>* terms)
+    -> OperandConstructionErrorType;
+
+#endif  // ASSEMBLER_EXPRESSION_HPP
@@ -1,56 +1,24 @@
 #ifndef ASSEMBLER_INSTRUCTION_HPP
 #define ASSEMBLER_INSTRUCTION_HPP
 
+#include "assembler/diagnostic.hpp"
 #include "assembler/operand.hpp"
+#include "assembler/symbol.hpp"
 #include "assembler/token.hpp"
 
+#include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <ostream>
 #include <string>
+#include <type_traits>
 #include <utility>
-#include <vector>
-
-/// Represents the error types that may occur when constructing an `Operand` from a `Token`. This
-/// type is returned when adding an operand using `Instruction::add_operand`.
-enum class OperandConstructionErrorType {
-    /// Indicates that no error occurred during the construction of the `Operand`, and the
-    /// constructed `Operand` was successfully inserted into the `Instruction`.
-    NoError,
-    /// Indicates that the token used to construct the `Operand` has an invalid type.
-    ///
-    /// `Operand` only supports five types: `Register`, `Immediate`, `Number`, `Label`, and
-    /// `StringLiteral`, which correspond to the token types `Token::Register`, `Token::Immediate`,
-    /// `Token::Number`, `Token::Label`, and `Token::String`. If the token type passed in is not one
-    /// of these five types, this error is returned.
-    InvalidTokenKind,
-    /// Invalid immediate number.
-    ///
-    /// The parser only checks if the characters that form the immediate number are valid, but a
-    /// token composed of valid characters may still represent an invalid number. For example,
-    /// `#+` consists of valid decimal characters but is not a valid immediate number.
-    InvalidNumber,
-    /// Indicates that the integer value represented by the token is out of range.
-    ///
-    /// In the `Operand`, we use a 16-bit signed integer to store integer values. If the integer
-    /// value represented by the token exceeds the range of a 16-bit signed integer, this error is
-    /// returned.
-    ///
-    /// It is worth noting that many instructions impose further restrictions on the range of
-    /// integer values. For example, the `ADD` instruction only allocates 5 bits of space for an
-    /// immediate operand. However, these details are not checked when constructing an `Operand`
-    /// from a token, as doing so would require knowledge of which instruction the operand belongs
-    /// to.
-    IntegerOverflow,
-    /// String literal error due to a missing closing quotation mark.
-    ///
-    /// When the token type is `Token::String`, this error should be reported if the content is
-    /// missing a closing quotation mark.
-    MissingQuote,
-};
-
-/// Outputs the error type `error` to the output stream `out`. Used for unit testing.
-auto operator<<(std::ostream& out, OperandConstructionErrorType error) -> std::ostream&;
 
+/// An instruction of an LC-3 assembly program: its label, opcode, and operands.
+///
+/// Large programs consist of millions of instructions, so an `Instruction` is kept small and
+/// trivially copyable. The operands are stored inline, since no instruction accepts more than
+/// `max_operand_count` of them, and the label is stored as a `Symbol`.
 class Instruction {
 public:
     enum Opcode : std::uint8_t {
@@ -60,62 +28,148 @@ public:
 #include "assembler/opcode.def"
     };
 
+    /// The largest number of operands that an instruction accepts, and the number of operands that
+    /// an instruction can store.
+    static constexpr std::size_t max_operand_count = 3;
+
+    /// The operands stored in an instruction, as the range [first, last).
+    struct OperandRange {
+        Operand const* first;
+        Operand const* last;
+
+        auto begin() const -> Operand const* {
+            return first;
+        }
+
+        auto end() const -> Operand const* {
+            return last;
+        }
+
+        auto size() const -> std::size_t {
+            return static_cast<std::size_t>(last - first);
+        }
+
+        auto empty() const -> bool {
+            return first == last;
+        }
+
+        auto operator[](std::size_t index) const -> Operand const& {
+            return first[index];
+        }
+
+        auto front() const -> Operand const& {
+            return *first;
+        }
+
+        auto back() const -> Operand const& {
+            return last[-1];
+        }
+    };
+
+    /// A list of operand types that an instruction accepts, as declared by the `SIGNATUREn` macros
+    /// in `assembler/opcode.def`. Only the first `size` elements of `types` are meaningful.
+    struct OperandSignature {
+        std::uint8_t size;
+        Operand::OperandType types[max_operand_count];
+    };
+
+    /// Returns the operand signatures of `opcode` as the range [result.first, result.second). The
+    /// signatures are stored in a static table, so this function never allocates memory. An
+    /// unknown opcode has a single signature without operands.
+    static auto operand_signatures(Opcode opcode)
+        -> std::pair<OperandSignature const*, OperandSignature const*>;
+
+    /// The `source_offset()` of an instruction whose position in the source code is unknown, such
+    /// as an instruction that was not produced by a `Parser`.
+    static constexpr std::uint32_t unknown_source_offset = UINT32_MAX;
+
     /// Checks the content of the `token` and, if the `token` is valid, converts it into an
-    /// `Operand` and inserts it into `operands_`. Otherwise, it returns an error type.
+    /// `Operand` and appends it to the operands of the instruction. Otherwise, it returns an error
+    /// type.
     ///
     /// Specifically, this function needs to accomplish the following two tasks:
     ///
     /// 1. Check the validity of the `token`.
     ///
     /// (1) The type of the `token` must be valid as an operand, meaning it must be one of
-    /// `Token::Register`, `Token::Immediate`, `Token::Number`, `Token::Label`, or `Token::String`.
-    /// If this condition is not met, return `OperandConstructionErrorType::InvalidTokenKind`.
+    /// `Token::Register`, `Token::Immediate`, `Token::Number`, `Token::Label`, `Token::String`,
+    /// `Token::ImmediateLiteral`, `Token::LabelLiteral`, or `Token::Expression`. If this condition
+    /// is not met, return `OperandConstructionErrorType::InvalidTokenKind`.
     ///
     /// (2) Tokens of type `Token::Register` and `Token::Label` are always valid, because only valid
     /// register names will be constructed as `Register` type tokens, and there are no restrictions
     /// on the content of labels.
     ///
-    /// (3) For tokens of type `Immediate` and `Number`, we need to check whether the number is
-    /// valid. The parser ensures that such tokens contain only valid characters (e.g., hexadecimal
-    /// immediates will not include the character `G`), but a token composed of valid characters is
-    /// not necessarily a valid number. For example, `#+` is a decimal immediate composed of valid
-    /// characters but is not a valid number. Such cases are uniformly treated as `InvalidNumber`
-    /// errors.
+    /// (3) For tokens of type `Immediate`, `Number`, and `ImmediateLiteral`, we need to check
+    /// whether the number is valid. The parser ensures that such tokens contain only valid
+    /// characters (e.g., hexadecimal immediates will not include the character `G`), but a token
+    /// composed of valid characters is not necessarily a valid number. For example, `#+` is a
+    /// decimal immediate composed of valid characters but is not a valid number. Such cases are
+    /// uniformly treated as `InvalidNumber` errors.
     ///
-    /// (4) For tokens of type `Immediate` and `Number`, we also need to check whether the integer
-    /// value represented by the `token` exceeds the range of a 16-bit signed integer. In such
-    /// cases, we need to return an `IntegerOverflow` error.
+    /// (4) For tokens of type `Immediate`, `Number`, and `ImmediateLiteral`, we also need to check
+    /// whether the integer value represented by the `token` exceeds the range of a 16-bit signed
+    /// integer. In such cases, we need to return an `IntegerOverflow` error.
     ///
     /// (5) For tokens of type `String`, we need to check whether the closing quote is present. If
     /// it is missing, we should return a `MissingQuote` error. The parser ensures that the string
     /// contains an opening quote and valid string content.
     ///
+    /// (6) For tokens of type `Expression`, every term must be a label or a valid number, as
+    /// checked by `parse_expression()`, which returns the error otherwise.
+    ///
     /// 2. If the `token` is valid, convert it into the appropriate type of `Operand` and insert it
     /// into `operands_`.
+    ///
+    /// The instruction must have fewer than `max_operand_count` operands. No instruction takes
+    /// more, so `Parser::parse_operand_list()` reports a longer operand list instead of adding it.
     auto add_operand(Token const& token) -> OperandConstructionErrorType;
 
+    /// Performs the checks described in `add_operand()` and, if the `token` is valid, stores the
+    /// converted `Operand` in `operand` instead of inserting it into an instruction.
+    ///
+    /// The conversion works directly on the source text referenced by the `token`. It only
+    /// allocates memory when a label or string literal is interned for the first time.
+    static auto construct_operand(Token const& token, Operand* operand)
+        -> OperandConstructionErrorType;
+
+    /// Returns the operand at `index`, which must be less than the size of `get_operands()`.
     auto get_operand(std::size_t index) const -> Operand const& {
+        assert(index < operand_size_);
         return operands_[index];
     }
 
-    auto get_operands() const -> std::vector<Operand> const& {
-        return operands_;
+    auto get_operands() const -> OperandRange {
+        return { operands_, operands_ + operand_size_ };
     }
 
     auto operand_size() const -> std::size_t {
-        return operands_.size();
+        return operand_size_;
+    }
+
+    /// Replaces the operand at index `index` with `operand`.
+    void set_operand(std::size_t index, Operand operand) {
+        assert(index < operand_size_);
+        operands_[index] = operand;
     }
 
     /// Sets the label of the instruction to `token.content()`.
     void set_label(Token const& token) {
-        set_label(token.content());
+        label_ = Symbol::intern(token.begin(), token.end());
     }
 
-    void set_label(std::string label) {
-        label_ = std::move(label);
+    void set_label(std::string const& label) {
+        label_ = Symbol::intern(label);
     }
 
+    /// Returns the label of the instruction, or an empty string if it has none. The string is
+    /// owned by the pool of interned symbols, so the reference remains valid after the instruction
+    /// is destroyed.
     auto get_label() const -> std::string const& {
+        return label_.str();
+    }
+
+    auto get_label_symbol() const -> Symbol {
         return label_;
     }
 
@@ -126,9 +180,12 @@ public:
     /// Sets the opcode based on the content of the `token`. The `token` must be of type
     /// `Token::Opcode` or `Token::Pseudo`.
     ///
-    /// This method converts the textual content of the `token` into an `Instruction::Opcode` enum
-    /// value.
-    void set_opcode(Token const& token);
+    /// The textual content of the `token` has already been converted into an `Instruction::Opcode`
+    /// enum value when the token was produced, so this method only copies it.
+    void set_opcode(Token const& token) {
+        assert(token.kind() == Token::Opcode || token.kind() == Token::Pseudo);
+        set_opcode(static_cast<Opcode>(token.opcode()));
+    }
 
     void set_opcode(Opcode opcode) {
         opcode_ = opcode;
@@ -160,8 +217,10 @@ public:
     /// can be either a register or an immediate. For a detailed description of all the checks
     /// performed by this function, refer to the comments in the function definition.
     ///
-    /// This function also emits diagnostic messages to the `std::cout` stream during validation. If
-    /// the validation passes, the function returns `true`; otherwise, it returns `false`.
+    /// This function also reports diagnostics (see `report()` in `diagnostic.hpp`) during
+    /// validation. If the validation passes, the function returns `true`; otherwise, it returns
+    /// `false`. An unknown instruction, which stands for a line that the parser has already
+    /// reported, is invalid without a further diagnostic.
     auto validate_and_emit_diagnostics() const -> bool;
 
     void set_address(std::uint16_t address) {
@@ -172,28 +231,59 @@ public:
         return address_;
     }
 
+    /// Sets the offset of the first token of the instruction (its label, or its opcode if there is
+    /// no label) from the beginning of the source code. Offsets that do not fit into 32 bits are
+    /// stored as `unknown_source_offset`.
+    void set_source_offset(std::size_t offset) {
+        source_offset_ = offset < unknown_source_offset ? static_cast<std::uint32_t>(offset)
+                                                        : unknown_source_offset;
+    }
+
+    auto source_offset() const -> std::uint32_t {
+        return source_offset_;
+    }
+
+    /// Reports an error of `kind` about this instruction like `report_error()` in
+    /// `diagnostic.hpp`, at the location of the instruction if it is known.
+    template <typename... Arguments>
+    void report_error(DiagnosticKind kind, Arguments const&... arguments) const {
+        std::size_t const offset = source_offset_ != unknown_source_offset
+            ? std::size_t { source_offset_ }
+            : Diagnostic::unknown_offset;
+        ::report_error(kind, offset, offset, arguments...);
+    }
+
 private:
-    std::string label_;
-    std::vector<Operand> operands_;
-    Opcode opcode_ = UnknownOp;
+    /// The first `operand_size_` elements are the operands of the instruction.
+    Operand operands_[max_operand_count];
+    Symbol label_;
+    /// The position of the instruction in the source code. It is only used to report diagnostic
+    /// messages.
+    std::uint32_t source_offset_ = unknown_source_offset;
     /// The address where the current instruction will be placed.
-    std::uint16_t address_;
+    std::uint16_t address_ = 0;
+    Opcode opcode_ = UnknownOp;
+    std::uint8_t operand_size_ = 0;
 
     /// Returns whether the current instruction allows a label. In the current implementation, we
     /// cannot attach labels to `.ORIG` and `.END`.
     auto allows_label() const -> bool;
 
-    /// Returns the expected types of operands for the current instruction. Some instructions may
-    /// accept a list of multiple operand types. For example, in an `ADD` instruction, the first and
-    /// second operands must be registers, while the third operand can be either a register or an
-    /// immediate. Therefore, we return a nested `std::vector`.
-    auto expected_operand_types() const -> std::vector<std::vector<Operand::OperandType>>;
+    /// Returns whether the current instruction needs a label, which only `.EQU` does, since the
+    /// label is the name of the constant it defines.
+    auto requires_label() const -> bool;
 
     /// Returns the range for the immediate operand in this instruction (if any). We will check if
     /// the immediate operand provided by the user exceeds this range.
     auto immediate_range() const -> std::pair<std::int16_t, std::int16_t>;
 };
 
+static_assert(
+    std::is_trivially_copyable<Instruction>::value,
+    "an `Instruction` should be trivially copyable"
+);
+static_assert(sizeof(Instruction) <= 24, "an `Instruction` should be at most 24 bytes");
+
 /// Outputs the `Instruction` object `instr` to the output stream `out`.
 auto operator<<(std::ostream& out, Instruction const& instr) -> std::ostream&;
 
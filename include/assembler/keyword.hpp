@@ -0,0 +1,26 @@
+#ifndef ASSEMBLER_KEYWORD_HPP
+#define ASSEMBLER_KEYWORD_HPP
+
+#include "assembler/token.hpp"
+
+#include <cstdint>
+
+/// The result of classifying an identifier with `classify_keyword()`.
+struct KeywordInfo {
+    /// `Token::Opcode` if the identifier is an opcode (such as `ADD`), `Token::Pseudo` if it is a
+    /// pseudo-instruction opcode (such as `.ORIG`), and `Token::Unknown` otherwise.
+    Token::TokenKind kind;
+    /// The `Instruction::Opcode` the identifier denotes, or `Instruction::UnknownOp` if it is not a
+    /// keyword. See `Token::opcode()` for why this is stored as an integer.
+    std::uint8_t opcode;
+};
+
+/// Classifies the identifier in the range [begin, end) as an opcode, a pseudo-instruction opcode or
+/// neither. Keywords are case-sensitive, and pseudo-instruction opcodes include the leading `.`.
+///
+/// The lookup uses a perfect hash table that is generated at compile time from
+/// `assembler/opcode.def`, so it hashes the identifier once and compares it with at most one
+/// keyword.
+auto classify_keyword(char const* begin, char const* end) -> KeywordInfo;
+
+#endif  // ASSEMBLER_KEYWORD_HPP
@@ -0,0 +1,49 @@
+#ifndef ASSEMBLER_LINE_INDEX_HPP
+#define ASSEMBLER_LINE_INDEX_HPP
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+/// A position in the source code, as reported in diagnostic messages. Both the line and the column
+/// start at 1. The column counts bytes, so a tab character is a single column.
+struct SourceLocation {
+    std::size_t line;
+    std::size_t column;
+};
+
+/// Maps offsets in the source code to lines and columns.
+///
+/// The lexer does not count lines, so that its hot loop does not pay for a feature that is only
+/// needed when something goes wrong. Instead, the offsets at which lines start are collected the
+/// first time `locate()` is called, and every lookup is a binary search over them. Constructing a
+/// `LineIndex` is therefore free, and a program without errors never scans for newlines twice.
+///
+/// `locate()` may be called from several threads at once. Note that the `LineIndex` does not own
+/// the source code, so the user must ensure that it remains valid as long as the index is used.
+class LineIndex {
+public:
+    /// Constructs an index for the source code in the range [begin, end).
+    LineIndex(char const* begin, char const* end) : begin_(begin), end_(end) { }
+
+    LineIndex(LineIndex const&) = delete;
+    auto operator=(LineIndex const&) -> LineIndex& = delete;
+
+    /// Returns the size of the source code in bytes.
+    auto size() const -> std::size_t {
+        return static_cast<std::size_t>(end_ - begin_);
+    }
+
+    /// Returns the location of the byte at `offset`, which must not be greater than `size()`.
+    auto locate(std::size_t offset) const -> SourceLocation;
+
+private:
+    char const* begin_;
+    char const* end_;
+    /// The offsets at which the lines start, in increasing order, once `line_starts_built_` has
+    /// been set. The first line starts at 0.
+    mutable std::vector<std::size_t> line_starts_;
+    mutable std::once_flag line_starts_built_;
+};
+
+#endif  // ASSEMBLER_LINE_INDEX_HPP
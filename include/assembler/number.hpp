@@ -0,0 +1,25 @@
+#ifndef ASSEMBLER_NUMBER_HPP
+#define ASSEMBLER_NUMBER_HPP
+
+#include "assembler/operand.hpp"
+
+#include <cstdint>
+
+/// Decodes the immediate or regular decimal number in the range [begin, end) and stores its value
+/// in `*value`.
+///
+/// The range is the content of an `Immediate` or `Number` token, so it only contains characters
+/// that are valid for its prefix: `#` for decimal, `x` for hexadecimal (in either case) and `b` for
+/// binary, or no prefix for a regular decimal number. A sign may follow the prefix.
+///
+/// Returns `OperandConstructionErrorType::InvalidNumber` if there are no digits (for example `#`,
+/// `x` or `#-`), and `OperandConstructionErrorType::IntegerOverflow` if the value exceeds the
+/// maximum value of an unsigned 16-bit integer or is less than the minimum value of a signed 16-bit
+/// integer. Values above `INT16_MAX` wrap around, so `xFFFF` is stored as -1. `*value` is only
+/// written when `OperandConstructionErrorType::NoError` is returned.
+///
+/// The number is decoded in a single pass that neither allocates memory nor throws exceptions.
+auto decode_number(char const* begin, char const* end, std::int16_t* value)
+    -> OperandConstructionErrorType;
+
+#endif  // ASSEMBLER_NUMBER_HPP
@@ -0,0 +1,173 @@
+#ifndef ASSEMBLER_ONE_PASS_ASSEMBLER_HPP
+#define ASSEMBLER_ONE_PASS_ASSEMBLER_HPP
+
+#include "assembler/assembler.hpp"
+#include "assembler/instruction.hpp"
+#include "assembler/operand.hpp"
+#include "assembler/section.hpp"
+#include "assembler/symbol.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/// Assembles a program in a single pass over its instructions.
+///
+/// `Assembler::run()` needs the whole program: it validates all instructions, then assigns all
+/// addresses, scans all labels, and finally translates all instructions. The `OnePassAssembler`
+/// instead validates each instruction, assigns its address, records its label, and translates it
+/// as soon as it is added, using the translation functions of `Assembler`. Only the current
+/// instruction and the words emitted so far are kept.
+///
+/// An instruction that refers to a label that has not been defined yet is translated with an offset
+/// of 0, and a fixup is recorded for it. The fixups of a label are patched when the label is
+/// defined. A `.FILL` of such a label gets a fixup as well, which stores the address of the label
+/// instead of an offset. A constant defined by `.EQU`, and an expression, are evaluated as soon as
+/// they are added, so they may only refer to labels defined before them. The fixups that remain at
+/// `finish()` refer to undefined labels, which is an error. Since a `.ORIG` after `.END` starts
+/// another section, `finish()` also checks that the sections do not overlap.
+///
+/// For a valid program, the result is the same as that of `Assembler::run()`. For an invalid one,
+/// the errors are reported in source order, which may differ from the order of `Assembler::run()`,
+/// since that runs each check over the whole program before the next one. Like `Assembler::run()`,
+/// the assembler keeps looking for errors after the first one until `error_limit_reached()`, but
+/// after an invalid instruction or a missing `.ORIG`, it only validates the remaining instructions.
+/// Their labels are still recorded, so that `finish()` reports the labels that are never defined.
+class OnePassAssembler {
+public:
+    /// Receives the word at `index` of the section that starts at `origin`, once it is final.
+    using Sink = std::function<void(std::uint16_t origin, std::size_t index, std::uint16_t word)>;
+
+    /// Constructs an assembler for instructions whose symbols are interned into `symbols`, the pool
+    /// of their `Parser`. `add()` and `finish()` make it the pool of the current thread.
+    explicit OnePassAssembler(std::shared_ptr<SymbolPool> symbols);
+
+    OnePassAssembler(OnePassAssembler const&) = delete;
+    auto operator=(OnePassAssembler const&) -> OnePassAssembler& = delete;
+
+    /// Sets the sink that receives the words of the output in order. A word is passed to the sink
+    /// as soon as it and all words before it are final, i.e., no fixup is pending for any of them.
+    /// The words are still collected into `words()` as well.
+    void set_sink(Sink sink) {
+        sink_ = std::move(sink);
+    }
+
+    /// Assembles `instr`, the next instruction of the program. Returns `false` if an error occurred
+    /// in this or a previous instruction, in which case a diagnostic has been emitted. Once the
+    /// error limit has been reached, the instructions are ignored.
+    auto add(Instruction const& instr) -> bool;
+
+    /// Assembles all of `instructions` and then calls `finish()`.
+    auto run(std::vector<Instruction> const& instructions) -> bool;
+
+    /// Finishes the program after its last instruction, reports labels that are still undefined,
+    /// and checks that its sections do not overlap. Returns `false` if an error occurred.
+    auto finish() -> bool;
+
+    /// Returns the words assembled so far. Words with pending fixups are not final yet.
+    auto words() const -> std::vector<std::uint16_t> const& {
+        return words_;
+    }
+
+    /// Returns the starting address of the program, as `Assembler::start_address()` does. It is 0
+    /// until the `.ORIG` instruction is added.
+    auto start_address() const -> std::uint16_t {
+        return origin_;
+    }
+
+    /// Returns the sections of the program started so far. The last one grows as instructions are
+    /// added.
+    auto sections() const -> std::vector<Section> const& {
+        return sections_;
+    }
+
+private:
+    /// A PC-relative field that refers to a label that was not defined when the field was
+    /// translated.
+    struct Fixup {
+        /// The instruction that contains the field, for the label operand and diagnostics.
+        Instruction instr;
+        /// The index of the word in `words_` that contains the field.
+        std::uint32_t word;
+        /// The index of the next fixup for the same label in `fixups_`, or `no_fixup`.
+        std::uint32_t next;
+    };
+
+    static constexpr std::uint32_t no_fixup = 0xFFFFFFFF;
+
+    /// Provides the symbol table and the translation functions. Its program table holds only the
+    /// instruction being assembled.
+    Assembler assembler_;
+    Sink sink_;
+    std::vector<std::uint16_t> words_;
+    /// The fixups in the order they were recorded, which is also the order of their words. Resolved
+    /// fixups have `word` set to `no_fixup`.
+    std::vector<Fixup> fixups_;
+    /// The index of the first pending fixup in `fixups_` for each label, indexed by the id of the
+    /// label, or `no_fixup`. Like the symbol table, this is a flat array because the ids are dense.
+    /// The labels past its end have no fixups.
+    std::vector<std::uint32_t> pending_fixups_;
+    /// The index of the first fixup in `fixups_` that may still be pending.
+    std::size_t first_pending_fixup_ = 0;
+    std::vector<Section> sections_;
+    /// The `.ORIG` instruction of each section, for diagnostics.
+    std::vector<Instruction> origs_;
+    /// The number of words that have been passed to the sink.
+    std::size_t flushed_ = 0;
+    /// The section of the next word to be passed to the sink.
+    std::size_t flushed_section_ = 0;
+    /// The address of the next instruction.
+    std::uint16_t address_ = 0;
+    std::uint16_t origin_ = 0;
+    bool started_ = false;
+    bool finished_ = false;
+    /// Whether an error has been reported. The words are then no longer passed to the sink.
+    bool failed_ = false;
+    /// Whether the error limit has been reached, so that no further errors are looked for.
+    bool stopped_ = false;
+    /// Whether the addresses are unknown after an error, so that the remaining instructions are
+    /// only validated.
+    bool validate_only_ = false;
+    /// The labels defined once the addresses are unknown, indexed by id. They are not in the symbol
+    /// table, which holds addresses.
+    std::vector<bool> unaddressed_labels_;
+    /// The valid instructions added once the addresses are unknown that refer to a label that is
+    /// not defined before them. `finish()` reports those that remain undefined.
+    std::vector<Instruction> unresolved_;
+
+    /// Assembles `instr`, reporting any errors.
+    void assemble(Instruction const& instr);
+
+    /// Defines the label of `instr` at `address`, and patches the pending fixups of the label.
+    void define_label(Instruction const& instr, std::uint16_t address);
+
+    /// Records the label of `instr`, and keeps `instr` in `unresolved_` if it refers to a label
+    /// that is not defined yet, once the addresses are unknown.
+    void record_labels(Instruction const& instr);
+
+    /// Returns whether `label` is defined, with an address or once the addresses are unknown.
+    auto is_defined(Symbol label) const -> bool;
+
+    /// Computes the value of `operand`, which is a number, a label, or an expression, from the
+    /// labels defined so far, and stores it in `*value`. The value of an expression is stored in
+    /// the symbol table as well, so that it is translated like a label. Returns `false` if a label
+    /// that the operand refers to is not defined yet.
+    auto evaluate(Operand const& operand, std::uint16_t* value) -> bool;
+
+    /// Patches the field of `fixup` with the offset to `label_address`, and returns `false` if the
+    /// offset is out of range. A `.FILL` is patched with the address that the label is loaded at
+    /// instead. The fixup is resolved either way.
+    auto patch(Fixup& fixup, std::uint16_t label_address) -> bool;
+
+    /// Records that an error has been reported. Returns `false` if the error limit has been
+    /// reached, so that assembling stops.
+    auto fail() -> bool;
+
+    /// Passes the words that have become final to the sink.
+    void flush();
+};
+
+#endif  // ASSEMBLER_ONE_PASS_ASSEMBLER_HPP
@@ -1,7 +1,8 @@
 #ifndef ASSEMBLER_OPERAND_HPP
 #define ASSEMBLER_OPERAND_HPP
 
-#include <array>
+#include "assembler/symbol.hpp"
+
 #include <cassert>
 #include <cstdint>
 #include <ostream>
@@ -10,8 +11,8 @@
 /// Represents an operand in an LC-3 assembly instruction.
 ///
 /// We refer to the part of an LC-3 assembly instruction other than the label and opcode as
-/// operands. Operands can be registers, immediates, regular decimal numbers, labels, or string
-/// literals. For example, in the following instruction:
+/// operands. Operands can be registers, immediates, regular decimal numbers, labels, string
+/// literals, or literals. For example, in the following instruction:
 ///
 ///     LOOP AND R3, R3, #0
 ///
@@ -21,11 +22,22 @@
 /// The `Operand` class can represent different types of operands. When it represents a register
 /// operand, it stores the register number (e.g., for register `R0`, it stores the value 0). When
 /// representing an immediate or number, it directly stores the value of the integer (as a 16-bit
-/// signed integer). When representing a label, it stores two pointers to the beginning and end of
-/// the label. When representing a string literal, it stores two pointers to the beginning and end
-/// of the string text (excluding the surrounding double quotes). You can call the `type()` member
-/// function to obtain the type of the `Operand` and then call `register_id()`, `immediate_value()`,
-/// `label()`, or `string_literal()` to get the specific content of the operand.
+/// signed integer). When representing a label or a string literal, it stores the `Symbol` of the
+/// label or of the string text (excluding the surrounding double quotes). You can call the `type()`
+/// member function to obtain the type of the `Operand` and then call `register_id()`,
+/// `immediate_value()`, `label()`, or `string_literal()` to get the specific content of the
+/// operand.
+///
+/// A literal, such as `=x1234` or `=TABLE`, stands for the address of a word that holds its value,
+/// which the assembler places in a literal pool (see `Assembler::place_literal_pools()`). It stores
+/// the value like an immediate, or the `Symbol` of the label like a label.
+///
+/// A constant expression, such as `TABLE+3` or `END-START`, stores the `Symbol` of its text. Its
+/// value is computed once all labels are known (see `Assembler::evaluate_expressions()`), and is
+/// then looked up like the address of a label, so an expression can stand wherever a label can.
+///
+/// The type and the content are packed into a single 32-bit integer, so an `Operand` is 4 bytes
+/// large and trivially copyable.
 class Operand {
 public:
     enum OperandType : std::uint8_t {
@@ -34,10 +46,20 @@ public:
         Number,
         Label,
         StringLiteral,
+        /// A literal with an integer value, such as `=x1234`, `=#-1`, or `=42`.
+        ImmediateLiteral,
+        /// A literal whose value is the address of a label, such as `=TABLE`.
+        LabelLiteral,
+        /// A constant expression of labels and numbers, such as `TABLE+3` or `END-START`.
+        Expression,
     };
 
+    /// Constructs an operand that represents register `R0`. This is only meant to be a placeholder
+    /// that is overwritten before it is used.
+    constexpr Operand() : bits_(0) { }
+
     auto type() const -> OperandType {
-        return type_;
+        return static_cast<OperandType>(bits_ & type_mask);
     }
 
     /// Returns the register number that the operand represents. For example, if the operand
@@ -46,8 +68,8 @@ public:
     /// This function should only be called if `type()` returns `Register`, otherwise the behavior
     /// is undefined.
     auto register_id() const -> std::uint8_t {
-        assert(type_ == Register);
-        return reg_id_;
+        assert(type() == Register);
+        return static_cast<std::uint8_t>(payload());
     }
 
     /// Returns the immediate value that the operand represents. For example, if the operand comes
@@ -57,8 +79,8 @@ public:
     /// This function should only be called if `type()` returns `Immediate`, otherwise the behavior
     /// is undefined.
     auto immediate_value() const -> std::int16_t {
-        assert(type_ == Immediate);
-        return imm_;
+        assert(type() == Immediate);
+        return static_cast<std::int16_t>(static_cast<std::uint16_t>(payload()));
     }
 
     /// Returns the regular decimal number that the operand represents. For example, if the operand
@@ -67,116 +89,190 @@ public:
     /// This function should only be called if `type()` returns `Number`, otherwise the behavior is
     /// undefined.
     auto regular_decimal() const -> std::int16_t {
-        assert(type_ == Number);
-        return imm_;
+        assert(type() == Number);
+        return static_cast<std::int16_t>(static_cast<std::uint16_t>(payload()));
+    }
+
+    /// Returns the value of an integer literal. For example, if the operand comes from the literal
+    /// token `=x1234`, this function returns 0x1234, stored in two's complement.
+    ///
+    /// This function should only be called if `type()` returns `ImmediateLiteral`, otherwise the
+    /// behavior is undefined.
+    auto literal_value() const -> std::int16_t {
+        assert(type() == ImmediateLiteral);
+        return static_cast<std::int16_t>(static_cast<std::uint16_t>(payload()));
+    }
+
+    /// Returns whether the operand is a literal, of type `ImmediateLiteral` or `LabelLiteral`.
+    auto is_literal() const -> bool {
+        return type() == ImmediateLiteral || type() == LabelLiteral;
     }
 
     /// Returns the label that the operand represents. For example, if the operand comes from the
-    /// label token `LOOP`, this function returns the string `LOOP`.
+    /// label token `LOOP`, or the literal token `=LOOP`, this function returns the string `LOOP`.
+    /// For an expression, it returns the text of the expression, such as `TABLE+3`. The string is
+    /// owned by the pool of interned symbols, so the reference remains valid after the operand is
+    /// destroyed.
     ///
-    /// This function should only be called if `type()` returns `Label`, otherwise the behavior is
-    /// undefined.
-    auto label() const -> std::string {
-        assert(type_ == Label);
-        return { string_content_[0], string_content_[1] };
+    /// This function should only be called if `type()` returns `Label`, `LabelLiteral`, or
+    /// `Expression`, otherwise the behavior is undefined.
+    auto label() const -> std::string const& {
+        assert(type() == Label || type() == LabelLiteral || type() == Expression);
+        return symbol().str();
     }
 
     /// Returns the string literal that the operand represents. For example, if the operand comes
     /// from the string literal token `"Hello"`, this function returns the string `Hello`. Note that
-    /// the returned result does not include the surrounding quotes.
+    /// the returned result does not include the surrounding quotes. See `label()` for the lifetime
+    /// of the result.
     ///
     /// This function should only be called if `type()` returns `StringLiteral`, otherwise the
     /// behavior is undefined.
-    auto string_literal() const -> std::string {
-        assert(type_ == StringLiteral);
-        return { string_content_[0], string_content_[1] };
+    auto string_literal() const -> std::string const& {
+        assert(type() == StringLiteral);
+        return symbol().str();
+    }
+
+    /// Returns the symbol of a label, of the content of a string literal, or of the text of an
+    /// expression. Comparing symbols is cheaper than comparing the strings returned by `label()` or
+    /// `string_literal()`.
+    ///
+    /// This function should only be called if `type()` returns `Label`, `StringLiteral`,
+    /// `LabelLiteral`, or `Expression`, otherwise the behavior is undefined.
+    auto symbol() const -> Symbol {
+        assert(
+            type() == Label || type() == StringLiteral || type() == LabelLiteral
+            || type() == Expression
+        );
+        return Symbol::from_id(payload());
     }
 
     /// Constructs an `Operand` object from a register ID, so that the operand represents a
     /// register.
     static auto from_register(std::uint8_t reg_id) -> Operand {
-        return Operand(RegisterTag {}, reg_id);
+        return Operand(Register, reg_id);
     }
 
     /// Constructs an `Operand` object from an immediate or regular number. If `is_immediate` is
     /// `true`, the operand represents an immediate (of type `Immediate`); otherwise, it represents
     /// a regular number (of type `Number`).
     static auto from_integer(bool is_immediate, std::int16_t imm) -> Operand {
-        if (is_immediate) {
-            return Operand(ImmediateTag {}, imm);
-        } else {
-            return Operand(NumberTag {}, imm);
-        }
+        return Operand(is_immediate ? Immediate : Number, static_cast<std::uint16_t>(imm));
     }
 
     /// Constructs an `Operand` object from a label, so that the operand represents a label. `begin`
     /// and `end` point to the first character of the label and the position just past the last
-    /// character, respectively.
+    /// character, respectively. The label is interned, so the text does not need to outlive the
+    /// operand.
     static auto from_label(char const* begin, char const* end) -> Operand {
-        return Operand(LabelTag {}, begin, end);
+        return Operand(Label, Symbol::intern(begin, end).id());
     }
 
     /// Constructs an `Operand` object from a string literal, so that the operand represents a
     /// string literal. `begin` and `end` point to the first character of the string literal and the
     /// position just past the last character, respectively. Note that the surrounding quotes are
-    /// not included.
+    /// not included. Like a label, the content is interned.
     static auto from_string_literal(char const* begin, char const* end) -> Operand {
         // We need to ensure that [begin, end) contains at least 2 characters, i.e., the string's
         // surrounding quotes.
         assert(end - begin >= 2);
         // Remove the surrounding quotes.
-        return Operand(StringLiteralTag {}, ++begin, --end);
+        return Operand(StringLiteral, Symbol::intern(begin + 1, end - 1).id());
+    }
+
+    /// Constructs an `Operand` object from the value of an integer literal, so that the operand
+    /// represents a literal of type `ImmediateLiteral`.
+    static auto from_immediate_literal(std::int16_t value) -> Operand {
+        return Operand(ImmediateLiteral, static_cast<std::uint16_t>(value));
+    }
+
+    /// Constructs an `Operand` object from the label of a literal, so that the operand represents a
+    /// literal of type `LabelLiteral`. [begin, end) is the label, without the leading `=`.
+    static auto from_label_literal(char const* begin, char const* end) -> Operand {
+        return Operand(LabelLiteral, Symbol::intern(begin, end).id());
+    }
+
+    /// Constructs an `Operand` object from the text [begin, end) of a constant expression, so that
+    /// the operand represents an expression. Like a label, the text is interned, and the same
+    /// expression always has the same symbol. The terms are not checked here (see
+    /// `parse_expression()`).
+    static auto from_expression(char const* begin, char const* end) -> Operand {
+        return Operand(Expression, Symbol::intern(begin, end).id());
     }
 
 private:
-    union {
-        /// Represents the register number. For example, register `R0` will be stored as 0.
-        ///
-        /// This member is valid only when `type_` is `Register`.
-        std::uint8_t reg_id_;
-        /// Represents the value of an immediate or regular number.
-        ///
-        /// We use a 16-bit integer to store the value since integer operands are no larger than 16
-        /// bits in LC-3. Some instructions further constrain the range of the integer operand,
-        /// which requires additional checks based on the instruction type.
-        ///
-        /// This member is valid only when `type_` is `Immediate` or `Number`.
-        std::int16_t imm_;
-        /// Represents the content of a label or a string literal.
-        ///
-        /// For labels, this member stores two pointers to the first character and the position just
-        /// past the last character of the label. For string literals, it stores in a similar way
-        /// but excludes the surrounding quotes.
-        ///
-        /// We do not use `std::string` to store labels because that would cause the `Operand`'s
-        /// special member functions to be defined as deleted, requiring us to manually implement
-        /// them. A better approach would be to use `std::string_view`, but that is a C++17 feature.
-        ///
-        /// This member is valid only when `type_` is `Label` or `StringLiteral`.
-        std::array<char const*, 2> string_content_;
-    };
-    /// The type of the operand. The appropriate member will be accessed based on the operand type.
-    OperandType type_;
-
-    // The following 5 tag types are used to explicitly specify the operand type (i.e., the `type_`
-    // member) when constructing an `Operand` object. This avoids the need to write verbose `switch`
-    // statements.
-
-    struct RegisterTag { };
-    struct ImmediateTag { };
-    struct NumberTag { };
-    struct LabelTag { };
-    struct StringLiteralTag { };
-
-    Operand(RegisterTag, std::uint8_t reg_id) : reg_id_(reg_id), type_(Register) { }
-    Operand(ImmediateTag, std::int16_t imm) : imm_(imm), type_(Immediate) { }
-    Operand(NumberTag, std::int16_t imm) : imm_(imm), type_(Number) { }
-    Operand(LabelTag, char const* begin, char const* end) :
-        string_content_ { begin, end }, type_(Label) { }
-    Operand(StringLiteralTag, char const* begin, char const* end) :
-        string_content_ { begin, end }, type_(StringLiteral) { }
+    /// The number of low bits of `bits_` that hold the type of the operand.
+    static constexpr unsigned type_bits = 3;
+    static constexpr std::uint32_t type_mask = (1u << type_bits) - 1;
+
+    static_assert(
+        type_bits + Symbol::id_bits <= 32,
+        "The id of a symbol must fit into an operand next to its type."
+    );
+
+    /// The type of the operand in the low `type_bits` bits, and its content in the remaining bits.
+    /// The content is the register number for `Register`, the value reinterpreted as a 16-bit
+    /// unsigned integer for `Immediate`, `Number`, and `ImmediateLiteral`, and the id of a `Symbol`
+    /// for `Label`, `StringLiteral`, `LabelLiteral`, and `Expression`.
+    ///
+    /// We use a 16-bit integer to store the value of an integer operand since integer operands are
+    /// no larger than 16 bits in LC-3. Some instructions further constrain the range of the integer
+    /// operand, which requires additional checks based on the instruction type.
+    std::uint32_t bits_;
+
+    Operand(OperandType type, std::uint32_t payload) : bits_(payload << type_bits | type) { }
+
+    auto payload() const -> std::uint32_t {
+        return bits_ >> type_bits;
+    }
 };
 
+static_assert(sizeof(Operand) == 4, "an `Operand` should be packed into 4 bytes");
+
+/// Represents the error types that may occur when constructing an `Operand` from a `Token`. This
+/// type is returned when adding an operand using `Instruction::add_operand`.
+enum class OperandConstructionErrorType {
+    /// Indicates that no error occurred during the construction of the `Operand`, and the
+    /// constructed `Operand` was successfully inserted into the `Instruction`.
+    NoError,
+    /// Indicates that the token used to construct the `Operand` has an invalid type.
+    ///
+    /// The types of `Operand` correspond to the token types `Token::Register`, `Token::Immediate`,
+    /// `Token::Number`, `Token::Label`, `Token::String`, `Token::ImmediateLiteral`,
+    /// `Token::LabelLiteral`, and `Token::Expression`. If the token type passed in is not one of
+    /// these, this error is returned.
+    InvalidTokenKind,
+    /// Invalid immediate number.
+    ///
+    /// The parser only checks if the characters that form the immediate number are valid, but a
+    /// token composed of valid characters may still represent an invalid number. For example,
+    /// `#+` consists of valid decimal characters but is not a valid immediate number.
+    InvalidNumber,
+    /// Indicates that the integer value represented by the token is out of range.
+    ///
+    /// In the `Operand`, we use a 16-bit signed integer to store integer values. If the integer
+    /// value represented by the token exceeds the range of a 16-bit signed integer, this error is
+    /// returned.
+    ///
+    /// It is worth noting that many instructions impose further restrictions on the range of
+    /// integer values. For example, the `ADD` instruction only allocates 5 bits of space for an
+    /// immediate operand. However, these details are not checked when constructing an `Operand`
+    /// from a token, as doing so would require knowledge of which instruction the operand belongs
+    /// to.
+    IntegerOverflow,
+    /// String literal error due to a missing closing quotation mark.
+    ///
+    /// When the token type is `Token::String`, this error should be reported if the content is
+    /// missing a closing quotation mark.
+    MissingQuote,
+    /// Indicates that a term of an expression is empty, or is neither a label nor a number, such
+    /// as in `TABLE+` or `TABLE+R1`.
+    InvalidExpression,
+};
+
+/// Outputs the error type `error` to the output stream `out`. Used for unit testing.
+auto operator<<(std::ostream& out, OperandConstructionErrorType error) -> std::ostream&;
+
 /// Overloads `operator<<` to support printing an operand type.
 auto operator<<(std::ostream& out, Operand::OperandType operand_type) -> std::ostream&;
 
@@ -0,0 +1,95 @@
+#ifndef ASSEMBLER_OUTPUT_WRITER_HPP
+#define ASSEMBLER_OUTPUT_WRITER_HPP
+
+#include "assembler/section.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+/// The formats in which the words of an assembled program can be written.
+enum class OutputFormat {
+    /// One `(ADDR) 0101...` line per word: the address in uppercase hexadecimal without leading
+    /// zeros, and the word as 16 binary digits.
+    Text,
+    /// One line per word, with the word as 4 uppercase hexadecimal digits.
+    Hex,
+    /// The words as big-endian 16-bit integers, without any separators.
+    Raw,
+    /// An LC-3 object file: the starting address of the program followed by its words, all as
+    /// big-endian 16-bit integers.
+    Object,
+};
+
+/// Writes the words of an assembled program to a stream.
+///
+/// Formatting a word through `std::ostream` with `std::hex` and `std::bitset` goes through locale
+/// and padding logic for every field, which makes printing a large image slower than assembling
+/// it. The writer instead formats each word with a lookup table that holds the binary and
+/// hexadecimal digits of every byte, and collects the lines in a large buffer, which is passed to
+/// the stream with a single `write()` call whenever it is full.
+///
+/// The words are only guaranteed to reach the stream after `flush()`, which the destructor calls.
+class OutputWriter {
+public:
+    /// The size of the buffer in bytes.
+    static constexpr std::size_t buffer_size = 64 * 1024;
+
+    OutputWriter(std::ostream& out, OutputFormat format);
+
+    OutputWriter(OutputWriter const&) = delete;
+    auto operator=(OutputWriter const&) -> OutputWriter& = delete;
+
+    ~OutputWriter();
+
+    /// Writes `word`, the word at `index` of a program that starts at `start_address`. The address
+    /// of the word is `start_address + index`; like the listing of the reference implementation, it
+    /// does not wrap around at 2^16. In an object file, the starting address is written before the
+    /// word at index 0.
+    void write(std::uint16_t start_address, std::size_t index, std::uint16_t word);
+
+    /// Writes all `words` of a program that starts at `start_address`.
+    void write(std::uint16_t start_address, std::vector<std::uint16_t> const& words);
+
+    /// Writes `count` zero words, starting at `index`, like as many calls to `write()` would. The
+    /// binary formats need no formatting for them, so they are filled into the buffer in bulk.
+    void write_zeros(std::uint16_t start_address, std::size_t index, std::size_t count);
+
+    /// Writes the words of each of `sections`, starting at the origin of the section. The words
+    /// in `zero_runs` are written with `write_zeros()`, and all others are taken from `words`.
+    void write(
+        std::vector<std::uint16_t> const& words,
+        std::vector<ZeroRun> const& zero_runs,
+        std::vector<Section> const& sections
+    );
+
+    /// Passes the buffered output to the stream.
+    void flush();
+
+private:
+    std::ostream* out_;
+    OutputFormat format_;
+    std::unique_ptr<char[]> buffer_;
+    std::size_t size_ = 0;
+
+    /// Appends the formatted `word` at `address` to the buffer, which must have room for it.
+    void append(std::size_t address, std::uint16_t word);
+};
+
+/// Writes an LC-3 object file for the program that starts at `origin` and consists of `words`, with
+/// the zeros of `zero_runs` in between.
+///
+/// Unlike `OutputWriter`, this does not format the words one by one: they are converted to
+/// big-endian in place, in a loop that the compiler vectorizes, and passed to the stream straight
+/// from the vector. The zero runs are written from a static block of zeros. `words` is taken by
+/// value, so callers that no longer need the words should move them in.
+void write_object(
+    std::ostream& out,
+    std::uint16_t origin,
+    std::vector<std::uint16_t> words,
+    std::vector<ZeroRun> const& zero_runs = std::vector<ZeroRun>()
+);
+
+#endif  // ASSEMBLER_OUTPUT_WRITER_HPP
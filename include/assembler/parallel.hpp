@@ -0,0 +1,41 @@
+#ifndef ASSEMBLER_PARALLEL_HPP
+#define ASSEMBLER_PARALLEL_HPP
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+/// Returns the number of threads used by default, which is the number of hardware threads, or 1 if
+/// it cannot be determined.
+auto default_thread_count() -> unsigned;
+
+/// Calls `task(index)` for every `index` in [0, count), and waits until all calls have finished.
+/// The calls run on the calling thread and on a pool of `default_thread_count() - 1` threads, which
+/// is started by the first call with `count > 1` and kept until the program exits. A call may call
+/// `parallel_for()` itself.
+///
+/// The calls must not throw exceptions.
+void parallel_for(std::size_t count, std::function<void(std::size_t)> const& task);
+
+/// Splits the indices in [0, size) into at most `chunk_count` chunks of similar size. Chunks
+/// smaller than `min_chunk_size` indices are avoided, so small ranges are not split at all.
+///
+/// Returns the boundaries of the chunks: chunk `i` is the range [result[i], result[i + 1]). The
+/// first boundary is 0 and the last is `size`.
+auto split_range(std::size_t size, std::size_t chunk_count, std::size_t min_chunk_size)
+    -> std::vector<std::size_t>;
+
+/// Splits the source code in the range [begin, end) into at most `chunk_count` chunks of similar
+/// size, each of which consists of complete lines. Chunks smaller than `min_chunk_size` bytes are
+/// avoided, so small inputs are not split at all.
+///
+/// Returns the boundaries of the chunks: chunk `i` is the range [result[i], result[i + 1]). The
+/// first boundary is `begin`, the last is `end`, and every other boundary is just past a '\n'.
+auto split_lines(
+    char const* begin,
+    char const* end,
+    std::size_t chunk_count,
+    std::size_t min_chunk_size
+) -> std::vector<char const*>;
+
+#endif  // ASSEMBLER_PARALLEL_HPP
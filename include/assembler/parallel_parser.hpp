@@ -0,0 +1,37 @@
+#ifndef ASSEMBLER_PARALLEL_PARSER_HPP
+#define ASSEMBLER_PARALLEL_PARSER_HPP
+
+#include "assembler/instruction.hpp"
+#include "assembler/symbol.hpp"
+#include "assembler/token_stream.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/// The smallest number of tokens that `parse_parallel()` parses on its own thread by default.
+constexpr std::size_t default_min_parse_chunk_size = 64 * 1024;
+
+/// Parses the tokens of `tokens` on up to `thread_count` threads. The result, including the
+/// diagnostic messages, is the same as that of `Parser::parse_instructions()` on the same tokens.
+///
+/// The tokens are split into chunks of complete lines, each containing at least `min_chunk_size`
+/// tokens, which are parsed independently into their own instruction arrays. The arrays are then
+/// concatenated in source order. Only the instructions up to the final `.END` are kept. The lines
+/// with an error that the parser recovered from are kept as unknown instructions, and if parsing
+/// stops at an error, an array containing only one unknown instruction is returned.
+///
+/// Each chunk collects its diagnostics in its own `DiagnosticEngine`, and only the diagnostics a
+/// serial parse would have reported are passed on to the caller (see
+/// `DiagnosticEngine::forward()`).
+///
+/// The symbols of the instructions are interned into `symbols`, which all chunks share, and which
+/// must be passed on to the `Assembler` of the instructions.
+auto parse_parallel(
+    TokenStream const& tokens,
+    std::shared_ptr<SymbolPool> const& symbols,
+    unsigned thread_count,
+    std::size_t min_chunk_size = default_min_parse_chunk_size
+) -> std::vector<Instruction>;
+
+#endif  // ASSEMBLER_PARALLEL_PARSER_HPP
@@ -1,43 +1,163 @@
 #ifndef ASSEMBLER_PARSER_HPP
 #define ASSEMBLER_PARSER_HPP
 
+#include "assembler/diagnostic.hpp"
 #include "assembler/instruction.hpp"
+#include "assembler/scanner.hpp"
+#include "assembler/symbol.hpp"
 #include "assembler/token.hpp"
+#include "assembler/token_stream.hpp"
 
+#include <cstddef>
 #include <cstring>
+#include <functional>
+#include <memory>
 #include <ostream>
 #include <string>
+#include <utility>
 #include <vector>
 
 class Parser {
 public:
+    /// The reason why `parse_instructions()` stopped.
+    enum class ParseStatus {
+        /// The end of the source code was reached without encountering `.END`.
+        EndOfInput,
+        /// The `.END` pseudo-instruction was parsed, and no `.ORIG` follows it. The remaining
+        /// source code is ignored.
+        EndPseudo,
+        /// Parsing stopped at an error, because `error_limit_reached()` (see `diagnostic.hpp`). The
+        /// errors that the parser recovered from are only counted by `error_count()`.
+        Error,
+    };
+
     /// Constructs a parser to parse the source code `source`. Note that the `Parser` does not own
     /// `source`, so the user must ensure that `source` remains valid during parsing.
-    explicit Parser(std::string const& source) :
-        source_begin_(source.data()),
-        source_end_(source.data() + source.size()),
-        current_(source_begin_) { }
+    ///
+    /// The labels and string literals of the instructions are interned into `symbols` (see
+    /// `symbols()`). Parsers that parse parts of the same program share its pool.
+    explicit Parser(std::string const& source, std::shared_ptr<SymbolPool> symbols = nullptr) :
+        Parser(source.data(), source.data() + source.size(), std::move(symbols)) { }
 
     /// Prevents the user from constructing a `Parser` with a temporary `std::string`, as the string
     /// would be destroyed almost immediately.
-    Parser(std::string const&&) = delete;
+    Parser(std::string const&&, std::shared_ptr<SymbolPool> = nullptr) = delete;
+
+    /// Constructs a parser to parse the source code in the range [begin, end), such as the content
+    /// of a `SourceBuffer`. The range does not need to be null-terminated. Note that the `Parser`
+    /// does not own the source code, so the user must ensure that it remains valid during parsing.
+    Parser(char const* begin, char const* end, std::shared_ptr<SymbolPool> symbols = nullptr) :
+        source_begin_(begin),
+        source_end_(end),
+        current_(source_begin_),
+        tokens_(nullptr),
+        next_index_(0),
+        end_index_(0),
+        symbols_(std::move(symbols)) {
+        set_scan_level(best_scan_level());
+    }
+
+    /// Constructs a parser that reads the tokens of `tokens` with indices in [begin_index,
+    /// end_index) instead of lexing source code. Once the tokens are exhausted, `next_token()`
+    /// keeps returning a `Token::End`: the last token of the range if it is one, and otherwise a
+    /// `Token::End` just past the last token. Note that the `Parser` does not own the tokens or the
+    /// source code they refer to.
+    Parser(
+        TokenStream const& tokens,
+        std::size_t begin_index,
+        std::size_t end_index,
+        std::shared_ptr<SymbolPool> symbols = nullptr
+    ) :
+        source_begin_(nullptr),
+        source_end_(nullptr),
+        current_(nullptr),
+        tokens_(&tokens),
+        next_index_(begin_index),
+        end_index_(end_index),
+        symbols_(std::move(symbols)) {
+        set_scan_level(best_scan_level());
+    }
+
+    /// Constructs a parser that reads all tokens of `tokens`.
+    explicit Parser(TokenStream const& tokens, std::shared_ptr<SymbolPool> symbols = nullptr) :
+        Parser(tokens, 0, tokens.size(), std::move(symbols)) { }
+
+    /// Prevents the user from constructing a `Parser` with a temporary `TokenStream`.
+    Parser(TokenStream const&&, std::shared_ptr<SymbolPool> = nullptr) = delete;
+
+    /// Returns the pool that the labels and string literals of the parsed instructions are
+    /// interned into, which must be passed on to the `Assembler` of the instructions. Unless a
+    /// pool was given to the constructor, the parser creates one when it is first needed, so a
+    /// parser that only lexes tokens allocates none.
+    auto symbols() -> std::shared_ptr<SymbolPool> const& {
+        if (symbols_ == nullptr) {
+            symbols_ = std::make_shared<SymbolPool>();
+        }
+        return symbols_;
+    }
 
     /// Produces a token starting from the current position `current_` is pointing to. Moves
     /// `current_` to the end of the token. The generated token is stored in `cur_token_` and
-    /// returned by this function.
+    /// returned by this function. If the parser reads pre-lexed tokens, the next token is taken
+    /// from them instead.
     auto next_token() -> Token const&;
 
     auto current_token() const -> Token const& {
         return cur_token_;
     }
 
+    /// Returns the token `n` positions after the current token without consuming any tokens, i.e.,
+    /// the token that the `n`-th call to `next_token()` would return. `peek(0)` returns the current
+    /// token. If the parser reads pre-lexed tokens, this takes constant time. Otherwise, the next
+    /// `n` tokens are lexed and then discarded.
+    auto peek(std::size_t n) const -> Token;
+
+    /// Selects the instruction set used by `next_token()` to skip over runs of whitespace,
+    /// comments, identifiers and string literals. By default, the fastest instruction set supported
+    /// by the processor is used. `ScanLevel::Scalar` selects the character-at-a-time
+    /// implementation.
+    ///
+    /// `level` must be supported by the current processor (see `is_scan_level_supported()`).
+    void set_scan_level(ScanLevel level);
+
+    auto scan_level() const -> ScanLevel {
+        return scan_level_;
+    }
+
     /// Parses a sequence of instructions from the given source code until encountering the `.END`
-    /// pseudo-instruction or reaching the end of the code. If an error is encountered during this
-    /// process (e.g., encountering an invalid token, using incorrect syntax, etc.), the parser will
-    /// provide diagnostic information and return a `vector` containing only one unknown
-    /// instruction.
+    /// pseudo-instruction or reaching the end of the code. A `.END` that is directly followed by a
+    /// `.ORIG` only ends a section of the program, so parsing continues after it. If an error is
+    /// encountered during this process (e.g., encountering an invalid token, using incorrect
+    /// syntax, etc.), the parser will provide diagnostic information.
+    ///
+    /// After an error, the parser recovers at the end of the line and keeps parsing to report the
+    /// errors in the following lines, until `error_limit_reached()`. The line with the error is
+    /// returned as an unknown instruction, which keeps the label of the line if it starts with
+    /// one, so that the well-formed instructions around it can still be validated. Once parsing
+    /// stops at an error, which without a `DiagnosticEngine` that allows more than one error is the
+    /// first one, a `vector` containing only one unknown instruction is returned.
     auto parse_instructions() -> std::vector<Instruction>;
 
+    /// Parses instructions like `parse_instructions()`, but passes each instruction to `consumer`
+    /// as soon as it is parsed instead of collecting them, so the caller decides which instructions
+    /// to keep. Returns why parsing stopped. The lines that the parser recovers from are passed to
+    /// `consumer` as unknown instructions, and a consumer that assembles the instructions fails
+    /// at them without reporting them again (see `Instruction::validate_and_emit_diagnostics()`).
+    auto parse_instructions(std::function<void(Instruction)> const& consumer) -> ParseStatus;
+
+    /// Returns the number of errors encountered by `parse_instructions()`, including those the
+    /// parser recovered from.
+    auto error_count() const -> std::size_t {
+        return error_count_;
+    }
+
+    /// Makes `parse_instructions()` treat the source code as the continuation of a program whose
+    /// last instruction was `.END`, so that it only parses instructions if the first one is
+    /// `.ORIG`. This lets a program that is parsed piece by piece continue across pieces.
+    void resume_after_end() {
+        after_end_ = true;
+    }
+
     /// Parses an operand list starting from the current token. The parsed operands are added to the
     /// instruction `instr`. Returns the modified instruction. If an error is encountered during
     /// this process, diagnostic information is emitted and an unknown instruction is returned.
@@ -53,12 +173,37 @@ private:
     char const* source_end_;
     /// Points to the character currently being parsed.
     char const* current_;
+    /// The pre-lexed tokens, if the parser was constructed from a `TokenStream`. Otherwise,
+    /// `nullptr`. The tokens with indices in [next_index_, end_index_) have not been returned yet.
+    TokenStream const* tokens_;
+    std::size_t next_index_;
+    std::size_t end_index_;
     /// Stores the current token to simplify the parser's implementation.
     Token cur_token_;
+    /// The instruction set selected by `set_scan_level()`, and the kernels implementing it.
+    ScanLevel scan_level_;
+    ScanKernels const* scan_kernels_;
+    /// The number of errors encountered by `parse_instructions()`.
+    std::size_t error_count_ = 0;
+    /// Whether the last instruction parsed was `.END`.
+    bool after_end_ = false;
+    /// The offset of the instruction being parsed, which `emit_operand_count_diag()` reports.
+    std::size_t instruction_offset_ = 0;
+    /// The pool of the symbols of the program, see `symbols()`.
+    std::shared_ptr<SymbolPool> symbols_;
 
-    /// Emits a diagnostic message at the location of the current token (returned by
-    /// `current_token()`).
-    auto emit_diagnostic_at_current_token() const -> std::ostream&;
+    /// Skips the tokens up to the end of the current line, so that parsing can recover from an
+    /// error on that line. The current token is then a `Token::EOL` or a `Token::End`.
+    void skip_line();
+
+    /// Returns the offset of `token` from the beginning of the source code being parsed, which is
+    /// the whole source code of the `TokenStream` if the parser reads pre-lexed tokens.
+    auto source_offset_of(Token const& token) const -> std::size_t;
+
+    /// Reports an error of `kind` about the current token (returned by `current_token()`). The
+    /// content of the token is the first argument of the message, followed by `arguments`.
+    template <typename... Arguments>
+    void report_at_current_token(DiagnosticKind kind, Arguments const&... arguments) const;
 
 public:
     /// This function is used to generate diagnostic messages when an error occurs while setting the
@@ -76,6 +221,12 @@ private:
     /// and the `token` that caused the error is obtained from `current_token()`.
     void emit_operand_diag_at_current_token(OperandConstructionErrorType error) const;
 
+    /// Reports that `instr`, which already has `Instruction::max_operand_count` operands, has too
+    /// many operands, quoting the instruction with all of them. The current token is the comma
+    /// before the first operand that does not fit. The rest of the operand list is consumed, and
+    /// if one of its operands is invalid, that error is reported instead.
+    void emit_operand_count_diag(Instruction const& instr);
+
     /// Parses a single instruction starting from the current token (the return value of
     /// `current_token()`). If an error is encountered during parsing, an unknown instruction is
     /// returned (i.e., `Instruction::is_unknown()` returns `true`).
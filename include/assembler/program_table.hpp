@@ -0,0 +1,173 @@
+#ifndef ASSEMBLER_PROGRAM_TABLE_HPP
+#define ASSEMBLER_PROGRAM_TABLE_HPP
+
+#include "assembler/instruction.hpp"
+#include "assembler/operand.hpp"
+#include "assembler/symbol.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// The columns that the passes of the `Assembler` compute for the instructions of a program: the
+/// number of words and the address of each instruction.
+///
+/// Row `i` of the table belongs to the `i`-th instruction that the table was built from, and its
+/// opcode, label, and operands are read from that instruction, so the table only adds 4 bytes per
+/// instruction. Assigning addresses, which relaxation and literal pools repeat, is a prefix sum
+/// over the `word_counts()` column into the `addresses()` column, which hold nothing but 16-bit
+/// words: the word counts of 32 instructions fit into one cache line.
+class ProgramTable {
+public:
+    class Row;
+
+    /// The smallest number of rows that a single thread works on by default.
+    static constexpr std::size_t default_min_chunk_size = 16 * 1024;
+
+    /// Constructs an empty table.
+    ProgramTable() = default;
+
+    /// Constructs a table with a row for each instruction of `instructions`. The addresses and word
+    /// counts of all rows are 0. The table refers to the elements of `instructions`, so the user
+    /// must ensure that they are neither destroyed nor reallocated while the table is used.
+    ///
+    /// `assign_addresses()` runs on up to `thread_count` threads, each of which works on at least
+    /// `min_chunk_size` rows.
+    explicit ProgramTable(
+        std::vector<Instruction> const& instructions,
+        unsigned thread_count = 1,
+        std::size_t min_chunk_size = default_min_chunk_size
+    ) :
+        thread_count_(thread_count), min_chunk_size_(min_chunk_size) {
+        assign(instructions);
+    }
+
+    /// Replaces the rows of the table with a row for each instruction of `instructions`, like the
+    /// constructor. The storage of the columns is reused.
+    void assign(std::vector<Instruction> const& instructions);
+
+    /// Returns the number of rows.
+    auto size() const -> std::size_t {
+        return word_counts_.size();
+    }
+
+    auto row(std::size_t index) const -> Row;
+
+    /// Returns the instruction that `row` belongs to.
+    auto instruction(std::size_t row) const -> Instruction const& {
+        return instructions_[row];
+    }
+
+    auto opcode(std::size_t row) const -> Instruction::Opcode {
+        return instructions_[row].get_opcode();
+    }
+
+    auto label(std::size_t row) const -> Symbol {
+        return instructions_[row].get_label_symbol();
+    }
+
+    /// Returns the operand at `index` of `row`, which the instruction of the row must have.
+    auto operand(std::size_t row, std::size_t index) const -> Operand const& {
+        return instructions_[row].get_operand(index);
+    }
+
+    auto operands(std::size_t row) const -> Instruction::OperandRange {
+        return instructions_[row].get_operands();
+    }
+
+    auto address(std::size_t row) const -> std::uint16_t {
+        return addresses_[row];
+    }
+
+    void set_address(std::size_t row, std::uint16_t address) {
+        addresses_[row] = address;
+    }
+
+    /// Sets the number of memory words that the instruction of `row` occupies.
+    void set_word_count(std::size_t row, std::uint16_t word_count) {
+        word_counts_[row] = word_count;
+    }
+
+    auto addresses() const -> std::vector<std::uint16_t> const& {
+        return addresses_;
+    }
+
+    auto word_counts() const -> std::vector<std::uint16_t> const& {
+        return word_counts_;
+    }
+
+    /// Sets the address of each row to `origin` plus the word counts of all rows before it. A
+    /// `.ORIG` row starts a new section instead: its address is its operand, and the rows after it
+    /// continue from there. Like the LC-3 address space, addresses wrap around at 2^16.
+    ///
+    /// With several threads, this is a parallel segmented prefix sum: each thread sums the word
+    /// counts of its chunk after its last `.ORIG` row, these give the first address of each chunk,
+    /// and each thread then assigns the addresses of its chunk.
+    void assign_addresses(std::uint16_t origin);
+
+private:
+    unsigned thread_count_ = 1;
+    std::size_t min_chunk_size_ = default_min_chunk_size;
+
+    /// The instructions of the rows, which the table does not own.
+    Instruction const* instructions_ = nullptr;
+    std::vector<std::uint16_t> word_counts_;
+    std::vector<std::uint16_t> addresses_;
+
+    /// Assigns addresses to the rows in [first, last), starting at `start`.
+    void assign_chunk_addresses(std::uint16_t start, std::size_t first, std::size_t last);
+
+    /// Returns the operand of the `.ORIG` instruction in `row`.
+    auto section_origin(std::size_t row) const -> std::uint16_t {
+        return static_cast<std::uint16_t>(operand(row, 0).immediate_value());
+    }
+};
+
+/// A row of a `ProgramTable`. It has the same accessors as an `Instruction`, so a pass can read a
+/// row like an instruction while only touching the columns it needs.
+///
+/// A `Row` refers to its table, so the user must ensure that the table outlives the row.
+class ProgramTable::Row {
+public:
+    Row(ProgramTable const& table, std::size_t index) : table_(&table), index_(index) { }
+
+    /// Returns the index of the row, which is also the index of the instruction it was built from.
+    auto index() const -> std::size_t {
+        return index_;
+    }
+
+    auto get_opcode() const -> Instruction::Opcode {
+        return table_->opcode(index_);
+    }
+
+    auto get_operand(std::size_t index) const -> Operand const& {
+        return table_->operand(index_, index);
+    }
+
+    auto get_operands() const -> Instruction::OperandRange {
+        return table_->operands(index_);
+    }
+
+    auto has_label() const -> bool {
+        return !table_->label(index_).empty();
+    }
+
+    auto get_label() const -> std::string const& {
+        return table_->label(index_).str();
+    }
+
+    auto get_address() const -> std::uint16_t {
+        return table_->address(index_);
+    }
+
+private:
+    ProgramTable const* table_;
+    std::size_t index_;
+};
+
+inline auto ProgramTable::row(std::size_t index) const -> Row {
+    return Row(*this, index);
+}
+
+#endif  // ASSEMBLER_PROGRAM_TABLE_HPP
@@ -0,0 +1,45 @@
+#ifndef ASSEMBLER_SCANNER_HPP
+#define ASSEMBLER_SCANNER_HPP
+
+#include <cstdint>
+
+/// The instruction set used by the lexer to skip over runs of characters (whitespace, comment
+/// tails, identifier bodies and string literal bodies).
+///
+/// `Scalar` processes the source one character at a time and is always available. `SSE2` and
+/// `AVX2` examine 16 and 32 characters at a time respectively, and are only available on x86
+/// processors that support the corresponding instruction set extension.
+enum class ScanLevel : std::uint8_t {
+    Scalar,
+    SSE2,
+    AVX2,
+};
+
+/// A set of functions used by the lexer to skip over runs of characters. Every function takes the
+/// range [current, end) and returns the position where it stops, which lies in [current, end].
+struct ScanKernels {
+    /// Skips non-newline whitespace characters (' ', '\t', '\v', '\f' and '\r').
+    char const* (*consume_spaces)(char const* current, char const* end);
+    /// Skips all characters until reaching a newline character.
+    char const* (*consume_comment)(char const* current, char const* end);
+    /// Skips alphanumeric characters.
+    char const* (*lex_identifier)(char const* current, char const* end);
+    /// Skips the body of a string literal until reaching a newline character or a closing double
+    /// quote. If a closing double quote is found, it is also consumed.
+    char const* (*lex_string_literal)(char const* current, char const* end);
+};
+
+/// Returns whether the current processor supports the instruction set `level`. `ScanLevel::Scalar`
+/// is always supported.
+auto is_scan_level_supported(ScanLevel level) -> bool;
+
+/// Returns the fastest instruction set supported by the current processor. The result is detected
+/// once at runtime and then cached.
+auto best_scan_level() -> ScanLevel;
+
+/// Returns the vectorized kernels for the instruction set `level`, or `nullptr` if `level` is
+/// `ScanLevel::Scalar` or not supported by the current processor. The scalar kernels are provided
+/// by the parser itself.
+auto vector_scan_kernels(ScanLevel level) -> ScanKernels const*;
+
+#endif  // ASSEMBLER_SCANNER_HPP
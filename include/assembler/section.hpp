@@ -0,0 +1,39 @@
+#ifndef ASSEMBLER_SECTION_HPP
+#define ASSEMBLER_SECTION_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/// A part of an assembled program that starts at a `.ORIG` pseudo-instruction and extends up to
+/// the next one.
+///
+/// The words of all sections are stored one after another in a single array, in source order, and
+/// a section only refers to its part of the array. The sections of a program therefore form a
+/// sparse memory image: the addresses between them are not part of the program, so they are never
+/// filled or printed.
+struct Section {
+    /// The operand of the `.ORIG` pseudo-instruction. The words of the section are listed at the
+    /// addresses starting at `origin`.
+    std::uint16_t origin;
+    /// The index of the first word of the section in the words of the program, counting the words
+    /// of the zero runs before it (see `ZeroRun`).
+    std::size_t first_word;
+    /// The number of words that the section emits, including those of its zero runs.
+    std::size_t word_count;
+};
+
+/// A block of zero words, reserved by `.BLKW`, that is not stored in the words of the program.
+///
+/// A program may reserve buffers far larger than its code, so rather than filling the words of the
+/// program with zeros, the assembler can keep each block as a run. Like those of `Section`, the
+/// indices of a run count the words of all runs before it, and are therefore the same as if the
+/// zeros were stored. The word at index `i` that is not part of a run is stored at `i` minus the
+/// number of words of the runs before it.
+struct ZeroRun {
+    /// The index of the first zero word.
+    std::size_t first_word;
+    /// The number of zero words.
+    std::size_t word_count;
+};
+
+#endif  // ASSEMBLER_SECTION_HPP
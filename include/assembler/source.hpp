@@ -0,0 +1,69 @@
+#ifndef ASSEMBLER_SOURCE_HPP
+#define ASSEMBLER_SOURCE_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/// Holds the source code of an assembly file in memory, so that a `Parser` can lex it in place.
+///
+/// Regular files are mapped into memory read-only, so their content is never copied: the parser
+/// reads directly from the page cache. Inputs that cannot be mapped, such as pipes, terminals and
+/// the standard input (named `-`), are read into a buffer that grows as data arrives. On platforms
+/// without `mmap`, every input is read into the buffer.
+///
+/// A `SourceBuffer` owns the mapping or the buffer, so it must outlive every `Parser`, `Token` and
+/// `Instruction` that refers to its content.
+class SourceBuffer {
+public:
+    SourceBuffer() : begin_(nullptr), end_(nullptr), mapping_(nullptr), mapping_size_(0) { }
+
+    SourceBuffer(SourceBuffer const&) = delete;
+    auto operator=(SourceBuffer const&) -> SourceBuffer& = delete;
+
+    SourceBuffer(SourceBuffer&& other) noexcept;
+    auto operator=(SourceBuffer&& other) noexcept -> SourceBuffer&;
+
+    ~SourceBuffer();
+
+    /// Loads the file at `path`, or the standard input if `path` is `-`, replacing the current
+    /// content. Returns `false` if the input cannot be opened or read, in which case the buffer is
+    /// left empty.
+    auto open(std::string const& path) -> bool;
+
+    /// Returns whether the content is mapped from a file rather than read into a buffer.
+    auto is_mapped() const -> bool {
+        return mapping_ != nullptr;
+    }
+
+    auto begin() const -> char const* {
+        return begin_;
+    }
+
+    auto end() const -> char const* {
+        return end_;
+    }
+
+    auto size() const -> std::size_t {
+        return static_cast<std::size_t>(end_ - begin_);
+    }
+
+    auto empty() const -> bool {
+        return begin_ == end_;
+    }
+
+private:
+    /// The content of the source code, which lies either in `mapping_` or in `buffer_`.
+    char const* begin_;
+    char const* end_;
+    /// The region mapped by `mmap`, or `nullptr` if the content is held in `buffer_`.
+    void* mapping_;
+    std::size_t mapping_size_;
+    /// The content read from an input that cannot be mapped.
+    std::vector<char> buffer_;
+
+    /// Releases the mapping and the buffer, leaving the content empty.
+    void reset();
+};
+
+#endif  // ASSEMBLER_SOURCE_HPP
@@ -0,0 +1,94 @@
+#ifndef ASSEMBLER_STREAMING_PARSER_HPP
+#define ASSEMBLER_STREAMING_PARSER_HPP
+
+#include "assembler/instruction.hpp"
+#include "assembler/parser.hpp"
+#include "assembler/symbol.hpp"
+#include "assembler/token.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <vector>
+
+/// Parses source code that is read from a stream in fixed-size windows, so that the source code
+/// never needs to be resident in memory as a whole.
+///
+/// `Parser` requires the entire source code in memory because tokens and operands refer to it. The
+/// `StreamingParser` instead reads a window of the input, and parses the complete lines in it with
+/// a `Parser`. The last, incomplete line is carried over to the next window. A label on a line of
+/// its own belongs to the instruction on the next line, so such a line is carried over as well.
+/// Since instructions never span lines otherwise, the result is the same as parsing the whole
+/// source code at once.
+///
+/// Each instruction is passed to a consumer as soon as it is parsed. Its label and string literal
+/// operands are interned `Symbol`s, so they remain valid after the window is reused. The memory
+/// used by the parser itself is therefore bounded by the window size (or the longest line, if it
+/// is longer).
+class StreamingParser {
+public:
+    /// The default size of a window, in bytes.
+    static constexpr std::size_t default_window_size = 1 << 20;
+
+    /// Constructs a parser that reads the source code from `input`. The stream should be opened in
+    /// binary mode. Note that the `StreamingParser` does not own `input`.
+    explicit StreamingParser(std::istream& input, std::size_t window_size = default_window_size);
+
+    /// Parses instructions like `Parser::parse_instructions()`, passing each instruction to
+    /// `consumer`.
+    ///
+    /// The input is read up to the end of the stream, or up to the line containing the `.END` that
+    /// ends the program. If `.END` ends a window, the next window is read to look for a `.ORIG`.
+    auto parse_instructions(std::function<void(Instruction)> const& consumer)
+        -> Parser::ParseStatus;
+
+    /// Returns the number of errors encountered by `parse_instructions()`, like
+    /// `Parser::error_count()`.
+    auto error_count() const -> std::size_t {
+        return error_count_;
+    }
+
+    /// Returns the pool that the symbols of the instructions are interned into, like
+    /// `Parser::symbols()`. The parsers of all windows share it.
+    auto symbols() -> std::shared_ptr<SymbolPool> const& {
+        if (symbols_ == nullptr) {
+            symbols_ = std::make_shared<SymbolPool>();
+        }
+        return symbols_;
+    }
+
+    /// Lexes the whole input, passing every token to `consumer`, including the final `Token::End`.
+    /// The tokens refer to the current window, so they are only valid during the call to
+    /// `consumer`.
+    void tokenize(std::function<void(Token const&)> const& consumer);
+
+private:
+    std::istream& input_;
+    /// The current window. `window_.size()` is the window size, which only grows if a single line
+    /// does not fit into the window.
+    std::vector<char> window_;
+    /// The range [tail_begin_, tail_end_) of `window_` holds the bytes read after the last complete
+    /// line. They are moved to the beginning of the window before reading the next window.
+    std::size_t tail_begin_;
+    std::size_t tail_end_;
+    /// The offset of the beginning of `window_` from the beginning of the input.
+    std::size_t window_offset_;
+    /// Whether the end of `input_` has been reached.
+    bool eof_;
+    std::size_t error_count_ = 0;
+    std::shared_ptr<SymbolPool> symbols_;
+
+    /// Reads the next window, and stores the range of complete lines in it in [*begin, *end).
+    /// Returns `false` if the whole input has been consumed.
+    ///
+    /// If `keep_labels` is `true`, trailing lines that consist only of a label (and blank lines
+    /// after it) are carried over to the next window together with the incomplete last line.
+    auto next_window(bool keep_labels, char const** begin, char const** end) -> bool;
+
+    /// Makes the source offset of `instr` relative to the beginning of the input instead of the
+    /// window.
+    void relocate(Instruction* instr) const;
+};
+
+#endif  // ASSEMBLER_STREAMING_PARSER_HPP
@@ -0,0 +1,136 @@
+#ifndef ASSEMBLER_SYMBOL_HPP
+#define ASSEMBLER_SYMBOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+class SymbolPool;
+
+/// An interned string, such as a label or the content of a string literal.
+///
+/// The text of every distinct string of a program is stored exactly once in the `SymbolPool` of
+/// that program, and a `Symbol` is the 32-bit id of its entry. Instructions and operands therefore
+/// refer to their labels and string literals without owning or pointing to any text, which keeps
+/// them small and trivially copyable, and keeps them valid after the source code they were parsed
+/// from is discarded. Two symbols of the same pool are equal if and only if their texts are equal.
+///
+/// Ids are dense: the `n`-th distinct text that is interned into a pool gets the id `n`, with the
+/// empty string as the 0-th. A table keyed by the symbols of a program can thus be a plain array
+/// indexed by `id()`, whose size only depends on that program.
+///
+/// `intern()` and `str()` use the pool of the current thread (see `SymbolPool::Scope`), which the
+/// `Parser` and the `Assembler` that own it install while they run.
+class Symbol {
+public:
+    /// Ids are smaller than `1 << id_bits`, so that an `Operand` can pack one together with its
+    /// type into 32 bits.
+    static constexpr unsigned id_bits = 29;
+
+    /// Constructs the symbol of the empty string.
+    constexpr Symbol() : id_(0) { }
+
+    /// Returns the symbol of the text in the range [begin, end) in the pool of the current thread,
+    /// adding the text to the pool if it has not been interned before. Only the first occurrence
+    /// of a text allocates memory.
+    static auto intern(char const* begin, char const* end) -> Symbol;
+
+    static auto intern(std::string const& text) -> Symbol {
+        return intern(text.data(), text.data() + text.size());
+    }
+
+    /// Returns the symbol with the id `id`, which must have been returned by `id()`.
+    static constexpr auto from_id(std::uint32_t id) -> Symbol {
+        return Symbol(id);
+    }
+
+    /// Returns the text of the symbol in the pool of the current thread. The result is a
+    /// null-terminated string owned by the pool.
+    auto str() const -> std::string const&;
+
+    constexpr auto id() const -> std::uint32_t {
+        return id_;
+    }
+
+    constexpr auto empty() const -> bool {
+        return id_ == 0;
+    }
+
+    friend constexpr auto operator==(Symbol lhs, Symbol rhs) -> bool {
+        return lhs.id_ == rhs.id_;
+    }
+
+    friend constexpr auto operator!=(Symbol lhs, Symbol rhs) -> bool {
+        return lhs.id_ != rhs.id_;
+    }
+
+private:
+    friend class SymbolPool;
+
+    /// The empty string always has the id 0.
+    std::uint32_t id_;
+
+    explicit constexpr Symbol(std::uint32_t id) : id_(id) { }
+};
+
+/// Stores the texts of the symbols of one program.
+///
+/// The pool of a program is created by the `Parser` that interns its labels and string literals,
+/// and shared with the `Assembler` that assembles it, so its memory is freed together with the
+/// program. Programs assembled one after another, or concurrently, thus use separate pools, and the
+/// ids of each are dense.
+///
+/// Several threads may intern texts and read them at the same time, so a program can be parsed and
+/// assembled in parallel. Entries are never removed, so a reference returned by `str()` remains
+/// valid until the pool is destroyed.
+class SymbolPool {
+public:
+    /// Makes `pool` the pool of the current thread for the lifetime of the object, which
+    /// `Symbol::intern()` and `Symbol::str()` use. `pool` may be `nullptr` to install no pool.
+    /// Scopes may be nested.
+    class Scope {
+    public:
+        explicit Scope(SymbolPool* pool);
+        ~Scope();
+
+        Scope(Scope const&) = delete;
+        auto operator=(Scope const&) -> Scope& = delete;
+
+    private:
+        /// The pool that was in use before this one.
+        SymbolPool* previous_;
+    };
+
+    SymbolPool();
+    ~SymbolPool();
+
+    SymbolPool(SymbolPool const&) = delete;
+    auto operator=(SymbolPool const&) -> SymbolPool& = delete;
+
+    /// Returns the pool of the current thread, or `nullptr` if no pool is installed.
+    static auto current() -> SymbolPool*;
+
+    /// Returns the symbol of the text in the range [begin, end), adding the text to the pool if it
+    /// has not been interned before. Throws `std::length_error` if the pool already holds
+    /// `1 << Symbol::id_bits` texts.
+    auto intern(char const* begin, char const* end) -> Symbol;
+
+    auto intern(std::string const& text) -> Symbol {
+        return intern(text.data(), text.data() + text.size());
+    }
+
+    /// Returns the text of `symbol`, which must have been interned into this pool.
+    auto str(Symbol symbol) const -> std::string const&;
+
+    /// Returns the number of distinct texts that have been interned, including the empty string,
+    /// which is one more than the largest id.
+    auto size() const -> std::size_t;
+
+private:
+    /// The texts, and the hash tables that look them up, which only `symbol.cpp` knows.
+    struct Storage;
+    std::unique_ptr<Storage> storage_;
+};
+
+#endif  // ASSEMBLER_SYMBOL_HPP
@@ -1,6 +1,8 @@
 #ifndef ASSEMBLER_TOKEN_HPP
 #define ASSEMBLER_TOKEN_HPP
 
+#include "assembler/operand.hpp"
+
 #include <cstddef>
 #include <cstdint>
 #include <ostream>
@@ -91,6 +93,17 @@ public:
         /// Represents a string literal, such as `"Hello"`. String literals should be enclosed in
         /// double quotes. They are used as operands for the `.STRINGZ` pseudo-instruction.
         String,
+        /// Represents a literal with an integer value: `=` followed by an immediate or a regular
+        /// decimal number, such as `=x1234` or `=-1`. The assembler stores the value in a literal
+        /// pool, and the operand refers to it there.
+        ImmediateLiteral,
+        /// Represents a literal whose value is the address of a label: `=` followed by a label,
+        /// such as `=TABLE`.
+        LabelLiteral,
+        /// Represents a constant expression: a label or an immediate, followed by terms that are
+        /// added or subtracted without any space in between, such as `TABLE+3` or `END-START`. A
+        /// term is a label, an immediate, or a regular decimal number.
+        Expression,
 
         // The following token types represent symbols that appear in LC-3 assembly code.
 
@@ -98,14 +111,78 @@ public:
         Comma,
     };
 
-    Token() : kind_(Unknown), begin_(nullptr), end_(nullptr) { }
-    Token(TokenKind kind, char const* begin, char const* end) :
-        kind_(kind), begin_(begin), end_(end) { }
+    Token() :
+        kind_(Unknown),
+        opcode_(0),
+        value_(0),
+        number_error_(0),
+        begin_(nullptr),
+        end_(nullptr) { }
+
+    /// Constructs a token of kind `kind` covering the range [begin, end). For `Opcode` and `Pseudo`
+    /// tokens, the opcode is decoded from the content. For `Immediate`, `Number`, and
+    /// `ImmediateLiteral` tokens, the integer value is decoded from the content.
+    Token(TokenKind kind, char const* begin, char const* end);
+
+    /// Constructs a token whose content has already been decoded by the lexer. `opcode` must be the
+    /// opcode denoted by the content for `Opcode` and `Pseudo` tokens, and 0 for other tokens.
+    /// `value` and `number_error` must be the result of `decode_number()` on the number of
+    /// `Immediate`, `Number`, and `ImmediateLiteral` tokens (see `number_begin()`), and 0 and
+    /// `OperandConstructionErrorType::NoError` for other tokens.
+    Token(
+        TokenKind kind,
+        char const* begin,
+        char const* end,
+        std::uint8_t opcode,
+        std::int16_t value,
+        OperandConstructionErrorType number_error
+    ) :
+        kind_(kind),
+        opcode_(opcode),
+        value_(value),
+        number_error_(static_cast<std::uint8_t>(number_error)),
+        begin_(begin),
+        end_(end) { }
 
     auto kind() const -> TokenKind {
         return kind_;
     }
 
+    /// Returns the `Instruction::Opcode` denoted by an `Opcode` or `Pseudo` token, which is decoded
+    /// once when the token is produced. For other tokens, returns 0 (`Instruction::UnknownOp`).
+    ///
+    /// The opcode is stored as its underlying integer because `Instruction` is built on top of
+    /// `Token`, so this header cannot depend on `assembler/instruction.hpp`.
+    auto opcode() const -> std::uint8_t {
+        return opcode_;
+    }
+
+    /// Returns the integer value of an `Immediate`, `Number`, or `ImmediateLiteral` token, which is
+    /// decoded once when the token is produced. Values above `INT16_MAX` (such as `xFFFF`) are
+    /// stored in two's complement. Returns 0 for other tokens, and for numbers whose
+    /// `number_error()` is not `OperandConstructionErrorType::NoError`.
+    auto value() const -> std::int16_t {
+        return value_;
+    }
+
+    /// Returns whether the number of an `Immediate`, `Number`, or `ImmediateLiteral` token is
+    /// invalid or out of range, as described in `decode_number()`. Returns
+    /// `OperandConstructionErrorType::NoError` for other tokens.
+    auto number_error() const -> OperandConstructionErrorType {
+        return static_cast<OperandConstructionErrorType>(number_error_);
+    }
+
+    /// Returns whether tokens of kind `kind` hold a number, which is decoded into `value()`.
+    static auto holds_number(TokenKind kind) -> bool {
+        return kind == Immediate || kind == Number || kind == ImmediateLiteral;
+    }
+
+    /// Returns the start of the number of a token that `holds_number()`, which follows the `=` of
+    /// an `ImmediateLiteral`.
+    static auto number_begin(TokenKind kind, char const* begin) -> char const* {
+        return kind == ImmediateLiteral ? begin + 1 : begin;
+    }
+
     auto begin() const -> char const* {
         return begin_;
     }
@@ -160,6 +237,15 @@ public:
 private:
     /// The type of the token.
     TokenKind kind_;
+    /// The decoded opcode of an `Opcode` or `Pseudo` token. It lives in the padding after `kind_`,
+    /// so it does not increase the size of `Token`.
+    std::uint8_t opcode_;
+    /// The decoded value of a token that `holds_number()`. Together with `number_error_`, it
+    /// also fits in the padding before `begin_`.
+    std::int16_t value_;
+    /// The `OperandConstructionErrorType` of a token that `holds_number()`, stored as its
+    /// underlying integer to keep `Token` small.
+    std::uint8_t number_error_;
     /// Points to the beginning of the token text in the source code, while `end_` points to the
     /// position right after the end of the token. Note that `Token` does not own the text.
     char const* begin_;
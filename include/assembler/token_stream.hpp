@@ -0,0 +1,108 @@
+#ifndef ASSEMBLER_TOKEN_STREAM_HPP
+#define ASSEMBLER_TOKEN_STREAM_HPP
+
+#include "assembler/token.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/// The smallest chunk of source code that a `TokenStream` lexes on its own thread by default.
+/// Smaller chunks cost more to start a thread for than they save.
+constexpr std::size_t default_min_lex_chunk_size = 256 * 1024;
+
+/// A token of a `TokenStream`, packed into 8 bytes. A `Token` holds two pointers into the source
+/// code, while a record holds the offset of the token in the source code and its length.
+struct TokenRecord {
+    /// The offset of the first character of the token from the beginning of the source code.
+    std::uint32_t offset;
+    /// The length of the token, or `TokenStream::long_token_length` if the token is at least that
+    /// long. The actual length of such a token is stored by the `TokenStream` separately.
+    std::uint16_t length;
+    Token::TokenKind kind;
+    /// The opcode of an `Opcode` or `Pseudo` token (see `Token::opcode()`), or the
+    /// `OperandConstructionErrorType` of a token that `Token::holds_number()`. 0 for other tokens.
+    std::uint8_t flags;
+};
+
+static_assert(sizeof(TokenRecord) == 8, "a `TokenRecord` should be packed into 8 bytes");
+
+/// The tokens of some source code, lexed in advance and stored as a dense array of `TokenRecord`s.
+///
+/// A `Parser` that lexes the source code produces one `Token` at a time. Pre-lexing the whole
+/// source code allows random access to the tokens in O(1), and lets a `Parser` look ahead with
+/// `Parser::peek()`. A record is a third of the size of a `Token`, so three times as many tokens
+/// fit into the same amount of cache when the tokens are read sequentially. The values of numbers
+/// are decoded once by the lexer, and kept in a separate array of 16-bit integers.
+///
+/// The last token of the stream is always a `Token::End` at the end of the source code, so the
+/// stream contains exactly the sequence produced by calling `Parser::next_token()` until it returns
+/// a `Token::End`. Everything after `.END` is lexed as well, just like the serial lexer does.
+class TokenStream {
+public:
+    /// The largest source code whose tokens can be stored, in bytes. The offsets of the tokens are
+    /// 32-bit integers.
+    static constexpr std::size_t max_source_size = UINT32_MAX;
+    /// Tokens at least this long have their length stored outside of their `TokenRecord`.
+    static constexpr std::size_t long_token_length = UINT16_MAX;
+
+    /// Lexes the source code in the range [begin, end), which must be at most `max_source_size`
+    /// bytes long, on up to `thread_count` threads.
+    ///
+    /// No token spans a newline character, and the lexer carries no state from one line to the
+    /// next, so the source code is split into chunks of complete lines that are lexed
+    /// independently. The records of each chunk, except for its final `Token::End`, are then
+    /// spliced together. Chunks are at least `min_chunk_size` bytes long, so small inputs are lexed
+    /// on the calling thread.
+    ///
+    /// Note that the `TokenStream` does not own the source code, so the user must ensure that it
+    /// remains valid as long as the tokens are used.
+    TokenStream(
+        char const* begin,
+        char const* end,
+        unsigned thread_count = 1,
+        std::size_t min_chunk_size = default_min_lex_chunk_size
+    );
+
+    /// Returns the number of tokens, including the final `Token::End`.
+    auto size() const -> std::size_t {
+        return records_.size();
+    }
+
+    auto kind(std::size_t index) const -> Token::TokenKind {
+        return records_[index].kind;
+    }
+
+    auto record(std::size_t index) const -> TokenRecord const& {
+        return records_[index];
+    }
+
+    /// Returns the token at `index` as a `Token` referring to the source code, with the value and
+    /// the error of a number as decoded by the lexer.
+    auto operator[](std::size_t index) const -> Token;
+
+    auto source_begin() const -> char const* {
+        return source_begin_;
+    }
+
+    auto source_end() const -> char const* {
+        return source_end_;
+    }
+
+private:
+    char const* source_begin_;
+    char const* source_end_;
+    std::vector<TokenRecord> records_;
+    /// The `Token::value()` of each token, by index, which is 0 for tokens that do not
+    /// `Token::holds_number()`. It is not packed into the records to keep them 8 bytes long.
+    std::vector<std::int16_t> values_;
+    /// The indices and lengths of the tokens whose length is at least `long_token_length`, sorted
+    /// by index. Only unusually long labels and string literals end up here.
+    std::vector<std::pair<std::size_t, std::size_t>> long_tokens_;
+
+    /// Returns the length of the token at `index`.
+    auto length(std::size_t index) const -> std::size_t;
+};
+
+#endif  // ASSEMBLER_TOKEN_STREAM_HPP
@@ -190,47 +190,12 @@ void parse_instruction(ParserRef parser, InstructionRef instr) {
     parser_parse_operand_list(parser, instr);
 }
 
-/// Converts the string representation of an immediate to an integer value and sets `*ok` to 0 if
-/// overflow occurs.
-///
-/// `content` is a null-terminated string that represents a valid integer or immediate value. The
-/// string may represent an immediate value with a prefix or a regular decimal integer. Regardless
-/// of the presence of a prefix, when it represents a decimal integer, it may have a sign.
-///
-/// Overflow is defined as exceeding the maximum value of an unsigned 16-bit integer for positive
-/// numbers or the minimum value of a signed 16-bit integer for negative numbers. You can use
-/// `UINT16_MAX` and `INT16_MIN` to represent the maximum and minimum values of unsigned and signed
-/// 16-bit integers.
-///
-/// Regarding hexadecimal immediates: The letters in hexadecimal immediates may be uppercase or
-/// lowercase, such as `xAB`, `xAb`, or `xaB`. However, the prefix will always be the lowercase
-/// letter `x`.
-///
-/// Here are some examples:
-///
-/// Example 1: For input `12`, return 12 and set `*ok` to 1.
-/// Example 2: For input `#12`, return 12 and set `*ok` to 1.
-/// Example 3: For input `+12`, return 12 and set `*ok` to 1.
-/// Example 4: For input `-12`, return -12 and set `*ok` to 1.
-/// Example 5: For input `#+12`, return 12 and set `*ok` to 1.
-/// Example 6: For input `#-12`, return -12 and set `*ok` to 1.
-/// Example 7: For input `x12`, return 18 and set `*ok` to 1.
-/// Example 8: For input `b101`, return 5 and set `*ok` to 1.
-/// Example 9: For input `65536`, set `*ok` to 0 and return any value.
-/// Example 10: For input `-32769`, set `*ok` to 0 and return any value.
-int16_t string_to_integer(const char* content, int* ok) {
-    // Replace the following 3 lines with your implementation.
-    (void) content;
-    *ok = 1;
-    return 0;
-}
-
 /// Returns the valid range of an immediate operand in an instruction.
 ///
 /// You need to store the range of the immediate operand in the `lb` and `ub` parameters. These two
 /// parameters represent the lower and upper bounds of the immediate operand. We have provided the
-/// ranges for the `TRAPOp`, `ORIGOp`, `FILLOp`, and `BLKWOp` instructions. You need to fill in the
-/// ranges for other instructions.
+/// ranges for the `TRAPOp`, `ORIGOp`, `FILLOp`, `BLKWOp`, and `EQUOp` instructions. You need to
+/// fill in the ranges for other instructions.
 void get_instruction_immediate_range(InstructionRef instr, int16_t* lb, int16_t* ub) {
     // clang-format off
     switch (instruction_get_opcode(instr)) {
@@ -240,7 +205,7 @@ void get_instruction_immediate_range(InstructionRef instr, int16_t* lb, int16_t*
         *ub = 255;
         break;
 
-    case ORIGOp: case FILLOp: case BLKWOp:
+    case ORIGOp: case FILLOp: case BLKWOp: case EQUOp:
         // 16-bit integer
         *lb = INT16_MIN;
         *ub = INT16_MAX;
@@ -256,8 +221,10 @@ void get_instruction_immediate_range(InstructionRef instr, int16_t* lb, int16_t*
 
 /// Assigns addresses to all instructions.
 ///
-/// We have provided a function framework for you. You need to complete the body. During this
-/// process, you may use the following functions:
+/// We have provided a function framework for you. You need to compute the number of memory words
+/// that each instruction occupies (`.EQU` defines a constant and occupies none); the assembler then
+/// assigns the addresses in a single tight loop. During this process, you may use the following
+/// functions:
 ///
 /// - `assembler_get_instruction_size(assembler)` in `assembler.h`: Get the number of instructions
 ///   to process.
@@ -270,8 +237,11 @@ void get_instruction_immediate_range(InstructionRef instr, int16_t* lb, int16_t*
 /// - `instruction_get_operand(instr, i)` in `instruction.h`: Get the `i`-th operand of the
 ///   instruction `instr`. Note that `i` is 0-based.
 ///
-/// - `instruction_set_address(instr, address)` in `instruction.h`: Set the address of the
-///   instruction `instr` to `address`.
+/// - `assembler_set_word_count(assembler, i, word_count)` in `assembler.h`: Set the number of
+///   memory words that the instruction at index `i` occupies.
+///
+/// - `assembler_assign_addresses(assembler, origin)` in `assembler.h`: Assign addresses to all
+///   instructions based on their word counts, starting at `origin`.
 ///
 /// - `operand_get_immediate_value(operand)` in `operand.h`: Get the value of the immediate
 ///   represented by the operand `operand`.
@@ -1,6 +1,7 @@
 #include "assembler/solution.hpp"
 
 #include "assembler/assembler.hpp"
+#include "assembler/diagnostic.hpp"
 #include "assembler/instruction.hpp"
 #include "assembler/operand.hpp"
 #include "assembler/parser.hpp"
@@ -211,69 +212,11 @@ auto Parser::parse_instruction() -> Instruction {
     return parse_operand_list(std::move(instr));
 }
 
-/// Converts the string representation of an immediate to an integer value and sets `*ok` to `false`
-/// if overflow occurs.
-///
-/// `content` is a string that represents a valid integer or immediate value. The string may
-/// represent an immediate value with a prefix or a regular decimal integer. Regardless of the
-/// presence of a prefix, when it represents a decimal integer, it may have a sign.
-///
-/// Overflow is defined as exceeding the maximum value of an unsigned 16-bit integer for positive
-/// numbers or the minimum value of a signed 16-bit integer for negative numbers. You can use
-/// `std::numeric_limits<std::uint16_t>::max()` and `std::numeric_limits<std::int16_t>::min()` to
-/// get the maximum and minimum values of unsigned and signed 16-bit integers.
-///
-/// Regarding hexadecimal immediates: The letters in hexadecimal immediates may be uppercase or
-/// lowercase, such as `xAB`, `xAb`, or `xaB`. However, the prefix will always be the lowercase
-/// letter `x`.
-///
-/// Here are some examples:
-///
-/// Example 1: For input `12`, return 12 and set `*ok` to 1.
-/// Example 2: For input `#12`, return 12 and set `*ok` to 1.
-/// Example 3: For input `+12`, return 12 and set `*ok` to 1.
-/// Example 4: For input `-12`, return -12 and set `*ok` to 1.
-/// Example 5: For input `#+12`, return 12 and set `*ok` to 1.
-/// Example 6: For input `#-12`, return -12 and set `*ok` to 1.
-/// Example 7: For input `x12`, return 18 and set `*ok` to 1.
-/// Example 8: For input `b101`, return 5 and set `*ok` to 1.
-/// Example 9: For input `65536`, set `*ok` to 0 and return any value.
-/// Example 10: For input `-32769`, set `*ok` to 0 and return any value.
-auto string_to_integer(std::string const& content, bool* ok) -> std::int16_t {
-    try {
-        std::size_t pos = 0;
-        int base = 10;
-        if (content[0] == '#') {
-            pos = 1;
-        } else if (content[0] == 'x') {
-            base = 16;
-            pos = 1;
-        } else if (content[0] == 'b') {
-            base = 2;
-            pos = 1;
-        }
-
-        long long value = std::stoll(content.substr(pos), nullptr, base);
-
-        if (value > std::numeric_limits<std::uint16_t>::max()
-            || value < std::numeric_limits<std::int16_t>::min()) {
-            *ok = false;
-            return 0;
-        }
-
-        *ok = true;
-        return static_cast<std::int16_t>(value);
-    } catch (...) {
-        *ok = false;
-        return 0;
-    }
-}
-
 /// Returns the valid range of an immediate operand in an instruction.
 ///
 /// You need to return the range of the immediate operand via the returned pair, where the first
 /// element is the lower bound and the second element is the upper bound. We have provided the
-/// ranges for the `TRAP`, `ORIG`, `FILL`, and `BLKW` instructions. You need to fill in the
+/// ranges for the `TRAP`, `ORIG`, `FILL`, `BLKW`, and `EQU` instructions. You need to fill in the
 /// ranges for other instructions.
 auto Instruction::immediate_range() const -> std::pair<std::int16_t, std::int16_t> {
     // clang-format off
@@ -282,7 +225,7 @@ auto Instruction::immediate_range() const -> std::pair<std::int16_t, std::int16_
         // trapvect8
         return { static_cast<std::int16_t>(0), static_cast<std::int16_t>(255) };
 
-    case ORIG: case FILL: case BLKW:
+    case ORIG: case FILL: case BLKW: case EQU:
         // 16-bit integer
         return {
             std::numeric_limits<std::int16_t>::min(),
@@ -314,18 +257,26 @@ auto Instruction::immediate_range() const -> std::pair<std::int16_t, std::int16_
 
 /// Assigns addresses to all instructions.
 ///
-/// We have provided a function framework for you. You need to complete the body. During this
-/// process, you may use the following functions:
+/// The passes of the assembler run over the program table, which holds the number of memory words
+/// and the address of each instruction (see `program_table.hpp`). Row `i` of the table belongs to
+/// the `i`-th instruction. We have provided a function framework for you. You need to compute the
+/// number of memory words that each instruction occupies (`.EQU` defines a constant and occupies
+/// none); the table then assigns the addresses in a single tight loop. During this process, you may use the
+/// following functions:
 ///
-/// - `Assembler::get_instructions()` in `assembler.hpp`: Get the list of instructions.
+/// - `Assembler::get_program()` in `assembler.hpp`: Get the program table.
 ///
-/// - `Instruction::get_opcode()` in `instruction.hpp`: Get the opcode of the instruction `*this`.
+/// - `ProgramTable::opcode(row)` in `program_table.hpp`: Get the opcode of the instruction in the
+///   row `row`.
 ///
-/// - `Instruction::get_operand(i)` in `instruction.hpp`: Get the `i`-th operand of the instruction
-///   `*this`. Note that `i` is 0-based.
+/// - `ProgramTable::operand(row, i)` in `program_table.hpp`: Get the `i`-th operand of the
+///   instruction in the row `row`. Note that `i` is 0-based.
 ///
-/// - `Instruction::set_address(address)` in `instruction.hpp`: Set the address of the instruction
-///   `*this` to `address`.
+/// - `ProgramTable::set_word_count(row, word_count)` in `program_table.hpp`: Set the number of
+///   memory words that the instruction in the row `row` occupies.
+///
+/// - `ProgramTable::assign_addresses(origin)` in `program_table.hpp`: Assign addresses to all rows
+///   based on their word counts, starting at `origin`.
 ///
 /// - `Operand::immediate_value()` in `operand.hpp`: Get the value of the immediate represented by
 ///   the operand `*this`.
@@ -338,60 +289,72 @@ auto Instruction::immediate_range() const -> std::pair<std::int16_t, std::int16_
 ///   operand `*this`. You need to use this function to get the value of the operand when processing
 ///   the `.STRINGZ` instruction.
 void Assembler::assign_addresses() {
-    std::uint16_t address = get_instructions().front().get_operand(0).immediate_value();
-    for (Instruction& instr : get_instructions()) {
-        instr.set_address(address);
-
-        switch (instr.get_opcode()) {
-        // case Instruction::ORIG:
-        //     address = instr.get_operand(0).immediate_value();
-        //     break;
-        case Instruction::FILL:
-            address += 1;
-            break;
+    ProgramTable& program = get_program();
+    for (std::size_t row = 0; row != program.size(); ++row) {
+        std::uint16_t word_count = 1;
+
+        switch (program.opcode(row)) {
         case Instruction::BLKW:
-            address += instr.get_operand(0).regular_decimal();
+            word_count = program.operand(row, 0).regular_decimal();
             break;
         case Instruction::STRINGZ:
-            address += instr.get_operand(0).string_literal().size() + 1;
+            word_count = program.operand(row, 0).string_literal().size() + 1;
+            break;
+        case Instruction::EQU:
+            // A constant takes no memory.
+            word_count = 0;
             break;
         default:
-            address += 1;
             break;
         }
+
+        program.set_word_count(row, word_count);
     }
+
+    program.assign_addresses(program.operand(0, 0).immediate_value());
 }
 
 /// Scans all labels in the instructions and adds the label and its associated address to the symbol
-/// table. If the label already exists in the symbol table, emits a diagnostic message. Returns
-/// `true` if no errors occur during this process; otherwise, returns `false`.
+/// table. If the label already exists in the symbol table, emits a diagnostic message, and keeps
+/// scanning for further redefinitions unless `error_limit_reached()`. Returns `true` if no errors
+/// occur during this process; otherwise, returns `false`.
 ///
 /// You may use the following functions to complete this task:
 ///
-/// - `Assembler::get_instructions()` in `assembler.hpp`: Get the list of instructions.
+/// - `Assembler::get_program()` in `assembler.hpp`: Get the program table.
 ///
 /// - `Assembler::add_label(label, address)` in `assembler.hpp`: Add the label `label` and its
 ///   corresponding address `address` to the symbol table. If the label already exists in the
 ///   symbol table, return `false`; otherwise, return `true`.
 ///
 /// - `Assembler::emit_label_redefinition_diag(instr)` in `assembler.hpp`: Emit diagnostic
-///   information for a redefined label attached to the instruction `instr`.
+///   information for a redefined label attached to the instruction `instr`. You can get the
+///   instruction in the row `row` by calling `get_instructions()[row]`.
 ///
-/// - `Instruction::has_label()` in `instruction.hpp`: Check if the instruction `*this` has a label.
+/// - `ProgramTable::label(row)` in `program_table.hpp`: Get the label of the instruction in the
+///   row `row` as a `Symbol`, which is empty if the instruction has no label. `add_label` takes the
+///   `Symbol` directly, so the text of the label is never needed.
 ///
-/// - `Instruction::get_label()` in `instruction.hpp`: Get the label of the instruction `*this`.
+/// - `ProgramTable::address(row)` in `program_table.hpp`: Get the address of the instruction in the
+///   row `row`.
 ///
-/// - `Instruction::get_address()` in `instruction.hpp`: Get the address of the instruction `*this`.
+/// - `error_limit_reached()` in `diagnostic.hpp`: Check whether no more errors may be reported.
 auto Assembler::scan_label() -> bool {
-    for (Instruction const& instr : get_instructions()) {
-        if (instr.has_label()) {
-            if (!add_label(instr.get_label(), instr.get_address())) {
-                emit_label_redefinition_diag(instr);
-                return false;
+    ProgramTable const& program = get_program();
+    bool ok = true;
+    for (std::size_t row = 0; row != program.size(); ++row) {
+        Symbol const label = program.label(row);
+        if (!label.empty()) {
+            if (!add_label(label, program.address(row))) {
+                emit_label_redefinition_diag(get_instructions()[row]);
+                ok = false;
+                if (error_limit_reached()) {
+                    return false;
+                }
             }
         }
     }
-    return true;
+    return ok;
 }
 
 /// Translates an instruction opcode `opcode` to its corresponding 4-bit binary representation. We
@@ -483,9 +446,9 @@ auto Assembler::translate_immediate(Operand const& imm_operand, unsigned bits) -
 }
 
 /// Translates a label operand to its corresponding binary representation and truncates it to `bits`
-/// bits. The label operand is the `operand_idx`-th operand of the instruction `instr`. You can get
-/// this operand by calling `Instruction::get_operand(operand_idx)`, and then get the content of the
-/// label by calling `Operand::label()`.
+/// bits. The label operand is the `operand_idx`-th operand of the instruction in the row `instr` of
+/// the program table. You can get this operand by calling `instr.get_operand(operand_idx)`, and
+/// then get the content of the label by calling `Operand::label()`.
 ///
 /// Similar to `translate_immediate()`, the `bits` parameter specifies the number of bits the label
 /// will occupy in the final binary instruction. For example, if `bits` is 9, it means that the
@@ -504,34 +467,41 @@ auto Assembler::translate_immediate(Operand const& imm_operand, unsigned bits) -
 ///   `assembler.hpp`: Emit diagnostic information when the offset `offset` of the label represented
 ///   by the label operand `label_operand` in the instruction `instr` is out of range.
 ///
-/// - `Instruction::get_address()` in `instruction.hpp`: Get the address of the instruction `*this`.
+/// - `ProgramTable::Row::get_address()` in `program_table.hpp`: Get the address of the instruction
+///   in the row `*this`.
+///
+/// - The diagnostic functions above take the instruction itself, which you can get by calling
+///   `get_instructions()[instr.index()]`.
 ///
-/// - You can access the private member `symbol_table_` in `Assembler` directly, which is a
-///   `std::unordered_map`. If you want to look up the address of a label in the symbol table, you
-///   can use the `find()` method provided by STL.
+/// - `Assembler::get_label(label, ok)` in `assembler.hpp`: Get the address of the label `label`.
+///   If the label does not exist, `*ok` is set to `false`. Pass `Operand::symbol()` as the label,
+///   so that the lookup is a single array access instead of hashing the text of the label.
 auto Assembler::translate_label(  //
-    Instruction const& instr,
+    ProgramTable::Row instr,
     std::size_t operand_idx,
     unsigned bits
 ) const -> std::uint16_t {
     auto const& label_operand = instr.get_operand(operand_idx);
-    auto const& label = label_operand.label();
     auto const instr_address = instr.get_address();
 
-    auto const iter = symbol_table_.find(label);
-    if (iter == symbol_table_.end()) {
-        emit_label_not_found_diag(label_operand, instr);
+    bool ok = false;
+    auto const label_address = get_label(label_operand.symbol(), &ok);
+    if (!ok) {
+        emit_label_not_found_diag(label_operand, get_instructions()[instr.index()]);
         return static_cast<std::uint16_t>(-1);
     }
 
-    auto const label_address = iter->second;
     auto const offset = static_cast<std::int16_t>(label_address - instr_address - 1);
 
     auto const max_offset = (1 << (bits - 1)) - 1;
     auto const min_offset = -(1 << (bits - 1));
 
     if (offset < min_offset || offset > max_offset) {
-        emit_label_offset_out_of_range_diag(label_operand, instr, offset);
+        emit_label_offset_out_of_range_diag(
+            label_operand,
+            get_instructions()[instr.index()],
+            offset
+        );
         return static_cast<std::uint16_t>(-1);
     }
 
@@ -539,13 +509,14 @@ auto Assembler::translate_label(  //
 }
 
 /// Translates a regular instruction to its corresponding 16-bit binary representation. The `instr`
-/// parameter represents the instruction to be translated.
+/// parameter represents the row of the program table that holds the instruction to be translated.
+/// A row has the same accessors as an `Instruction`, such as `get_opcode()` and `get_operand(i)`.
 ///
 /// You need to use the small functions you implemented above to complete this function. We have
 /// provided the implementation for the `ADD` and `AND` instructions. You need to complete the
 /// implementation for other instructions. You may need to read page 656 of the textbook to
 /// understand the format of each instruction.
-auto Assembler::translate_regular_instruction(Instruction const& instr) const -> std::uint16_t {
+auto Assembler::translate_regular_instruction(ProgramTable::Row instr) const -> std::uint16_t {
     std::uint16_t result = translate_opcode(instr.get_opcode()) << 12;
 
     switch (instr.get_opcode()) {
@@ -571,7 +542,7 @@ auto Assembler::translate_regular_instruction(Instruction const& instr) const ->
         break;
     case Instruction::BRz:
         result |= 0x2 << 9;
-        result |= (instr.get_operand(0).type() == Operand::Label) ? translate_label(instr, 0, 9) : translate_immediate(instr.get_operand(0), 9);
+        result |= (instr.get_operand(0).type() != Operand::Immediate) ? translate_label(instr, 0, 9) : translate_immediate(instr.get_operand(0), 9);
         break;
     case Instruction::BRp:
         result |= 0x1 << 9;
@@ -667,8 +638,8 @@ auto Assembler::translate_regular_instruction(Instruction const& instr) const ->
 }
 
 /// Translates a pseudo-instruction to its corresponding binary representation. The `instr`
-/// parameter represents the instruction to be translated. Your translated binary instruction should
-/// be added to the **back** of the `results` vector.
+/// parameter represents the row of the program table that holds the instruction to be translated.
+/// Your translated binary instruction should be added to the **back** of the `results` vector.
 ///
 /// Since a pseudo-instruction may be translated into multiple instructions (multiple
 /// `std::uint16_t` results), this function takes an additional `results` parameter. You need to
@@ -688,7 +659,10 @@ auto Assembler::translate_regular_instruction(Instruction const& instr) const ->
 ///
 /// - `Operand::string_literal()` in `operand.hpp`: Get the string literal represented by the
 ///   operand `*this`. This function is used to get the oeprand of the `.STRINGZ` instruction.
-void Assembler::translate_pseudo(Instruction const& instr, std::vector<std::uint16_t>& results) {
+void Assembler::translate_pseudo(
+    ProgramTable::Row instr,
+    std::vector<std::uint16_t>& results
+) const {
     switch (instr.get_opcode()) {
     case Instruction::FILL:
         // `.FILL` will fill the memory location with the value of the operand.
@@ -701,7 +675,10 @@ void Assembler::translate_pseudo(Instruction const& instr, std::vector<std::uint
 
     case Instruction::BLKW:
         // `.BLKW` reserves a block of memory.
-        results.resize(results.size() + instr.get_operand(0).regular_decimal(), 0);
+        results.resize(
+            results.size() + static_cast<std::uint16_t>(instr.get_operand(0).regular_decimal()),
+            0
+        );
         break;
 
     case Instruction::STRINGZ:
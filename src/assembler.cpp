@@ -3,84 +3,675 @@
 #include "assembler-c/assembler.h"
 #include "assembler-c/instruction.h"
 #include "assembler-c/operand.h"
+#include "assembler/diagnostic.hpp"
+#include "assembler/expression.hpp"
 #include "assembler/instruction.hpp"
 #include "assembler/operand.hpp"
+#include "assembler/parallel.hpp"
+#include "assembler/program_table.hpp"
+#include "assembler/section.hpp"
+#include "assembler/symbol.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
-#include <iostream>
+#include <functional>
+#include <iomanip>
+#include <ios>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <utility>
 #include <vector>
 
 #ifndef USE_CPP
     #include "assembler-c/solution.h"
 #endif
 
+namespace {
+/// Calls `task(chunk)` for every chunk in `chunks` (see `split_range()`), each call on its own
+/// thread. A task returns `false` if it found an error, after reporting a diagnostic. It stops
+/// looking any further once `error_limit_reached()`.
+///
+/// The diagnostics of each chunk are collected in its own `DiagnosticEngine`, and are passed on to
+/// the caller in order, up to the error limit of the caller. These are the diagnostics a serial run
+/// over all chunks would have reported. Returns `false` if any task found an error.
+auto run_chunks(
+    std::vector<std::size_t> const& chunks,
+    std::function<bool(std::size_t)> const& task
+) -> bool {
+    std::size_t const chunk_count = chunks.size() - 1;
+    if (chunk_count == 1) {
+        return task(0);
+    }
+
+    // Each chunk may report as many errors as the caller, since it cannot know how many errors the
+    // chunks before it report.
+    std::vector<DiagnosticEngine> diagnostics(chunk_count, DiagnosticEngine(remaining_errors()));
+    std::unique_ptr<bool[]> const ok(new bool[chunk_count]);
+    // The diagnostics print the symbols of the caller's program.
+    SymbolPool* const symbols = SymbolPool::current();
+    parallel_for(chunk_count, [&](std::size_t chunk) {
+        DiagnosticEngine::Scope const diagnostic_scope(diagnostics[chunk]);
+        SymbolPool::Scope const symbol_scope(symbols);
+        ok[chunk] = task(chunk);
+    });
+
+    bool all_ok = true;
+    for (std::size_t chunk = 0; chunk != chunk_count; ++chunk) {
+        diagnostics[chunk].forward();
+        if (!ok[chunk]) {
+            all_ok = false;
+            if (error_limit_reached()) {
+                break;
+            }
+        }
+    }
+
+    return all_ok;
+}
+
+/// Returns the address after the last one that `section` occupies, which may lie beyond xFFFF.
+auto end_address(Section const& section) -> std::size_t {
+    return section.origin + section.word_count;
+}
+
+/// Returns the number of words in `zero_runs`.
+auto zero_word_count(std::vector<ZeroRun> const& zero_runs) -> std::size_t {
+    std::size_t count = 0;
+    for (ZeroRun const& run : zero_runs) {
+        count += run.word_count;
+    }
+    return count;
+}
+
+/// Formats `address` as 4 or more uppercase hexadecimal digits, without the leading `x`.
+auto format_address(std::size_t address) -> std::string {
+    std::ostringstream out;
+    out << std::hex << std::uppercase << std::setw(4) << std::setfill('0') << address;
+    return out.str();
+}
+}  // namespace
+
+constexpr std::uint32_t Assembler::no_label;
+
 auto Assembler::translate() const -> std::vector<std::uint16_t> {
     std::vector<std::uint16_t> results;
-    results.reserve(instructions_.size());
+    results.reserve(program_.size());
+
+    // If an error occurred during translation, return an empty vector.
+    bool const ok = translate_rows(0, program_.size(), results, nullptr, nullptr);
+    return ok ? results : std::vector<std::uint16_t>();
+}
+
+auto Assembler::translate_rows(
+    std::size_t first,
+    std::size_t last,
+    std::vector<std::uint16_t>& results,
+    std::vector<std::size_t>* section_starts,
+    std::vector<ZeroRun>* zero_runs
+) const -> bool {
+    bool ok = true;
+    // The number of words in `zero_runs`, which are not stored in `results`.
+    std::size_t zero_count = 0;
+    // The next literal pool, which follows the words of its row.
+    std::vector<LiteralPool>::const_iterator pool = std::lower_bound(
+        literal_pools_.begin(),
+        literal_pools_.end(),
+        first,
+        [](LiteralPool const& pool, std::size_t row) { return pool.row < row; }
+    );
+    for (std::size_t index = first; index != last; ++index) {
+        Instruction::Opcode const opcode = program_.opcode(index);
+        if (section_starts != nullptr && opcode == Instruction::ORIG) {
+            section_starts->push_back(results.size() + zero_count);
+        }
+
+        if (zero_runs != nullptr && opcode == Instruction::BLKW) {
+            // The count is a 16-bit word, like in `assign_addresses()`, so `.BLKW -1` reserves
+            // xFFFF words.
+            std::size_t const first_word = results.size() + zero_count;
+            std::size_t const count =
+                static_cast<std::uint16_t>(program_.operand(index, 0).regular_decimal());
+            if (!zero_runs->empty()
+                && zero_runs->back().first_word + zero_runs->back().word_count == first_word) {
+                zero_runs->back().word_count += count;
+            } else if (count != 0) {
+                zero_runs->push_back({ first_word, count });
+            }
+            zero_count += count;
+        } else if (!translate_row(program_.row(index), results)) {
+            ok = false;
+            if (error_limit_reached()) {
+                break;
+            }
+        }
+
+        if (pool != literal_pools_.end() && pool->row == index) {
+            translate_literal_pool(*pool, results);
+            ++pool;
+        }
+    }
+    return ok;
+}
+
+auto Assembler::translate_row(ProgramTable::Row instr, std::vector<std::uint16_t>& results) const
+    -> bool {
+    switch (instr.get_opcode()) {
+    case Instruction::EQU:
+        // A constant takes no words.
+        return true;
+
+    case Instruction::FILL:
+        if (instr.get_operand(0).type() != Operand::Immediate) {
+            return translate_fill_symbol(instr, results);
+        }
+        translate_pseudo(instr, results);
+        return true;
+
+    case Instruction::ORIG:
+    case Instruction::END:
+    case Instruction::BLKW:
+    case Instruction::STRINGZ:
+        translate_pseudo(instr, results);
+        return true;
+
+    default:
+        if (!literal_uses_.empty() && has_literal_operand(instr)) {
+            return translate_literal_use(instr, results);
+        }
+
+        std::uint16_t const word_count = program_.word_counts()[instr.index()];
+        if (relax_branches_ && word_count > 1
+            && word_count - literal_pool_word_count(instr.index()) > 1) {
+            translate_relaxed(instr, results);
+            return true;
+        }
+
+        std::uint16_t const result = translate_regular_instruction(instr);
+        if (result == static_cast<std::uint16_t>(-1)) {
+            return false;
+        }
+        results.push_back(result);
+        return true;
+    }
+}
+
+auto Assembler::translate_row_forward(
+    ProgramTable::Row instr,
+    std::vector<std::uint16_t>& results,
+    Symbol* forward_label
+) -> bool {
+    *forward_label = Symbol();
+    Instruction::OperandRange const operands = instructions_[instr.index()].get_operands();
+    auto const label = std::find_if(operands.begin(), operands.end(), [](Operand const& operand) {
+        return operand.type() == Operand::Label;
+    });
+
+    bool found = true;
+    if (label != operands.end()) {
+        get_label(label->symbol(), &found);
+    }
+    if (found) {
+        return translate_row(instr, results);
+    }
 
+    // Define the label only while the row is translated, so that later rows still see it as
+    // undefined until its definition.
+    *forward_label = label->symbol();
+    add_label(*forward_label, static_cast<std::uint16_t>(instr.get_address() + 1));
+    bool const ok = translate_row(instr, results);
+    symbol_entry(*forward_label) = no_label;
+    return ok;
+}
+
+auto Assembler::translate_fill_symbol(
+    ProgramTable::Row instr,
+    std::vector<std::uint16_t>& results
+) const -> bool {
+    Operand const& operand = instr.get_operand(0);
+    bool found = false;
+    std::uint16_t const value = get_label_value(operand.symbol(), &found);
+    if (!found) {
+        emit_label_not_found_diag(operand, instructions_[instr.index()]);
+        return false;
+    }
+
+    results.push_back(value);
+    return true;
+}
+
+void Assembler::report_label_redefinitions(std::vector<std::size_t> const& invalid) const {
+    std::vector<bool> defined(symbols_->size(), false);
+    auto next_invalid = invalid.begin();
+    for (std::size_t index = 0; index != instructions_.size(); ++index) {
+        if (next_invalid != invalid.end() && *next_invalid == index) {
+            ++next_invalid;
+            continue;
+        }
+
+        Instruction const& instr = instructions_[index];
+        if (!instr.has_label()) {
+            continue;
+        }
+
+        Symbol const label = instr.get_label_symbol();
+        bool found = false;
+        get_label(label, &found);
+        if (defined[label.id()] || found) {
+            emit_label_redefinition_diag(instr);
+            if (error_limit_reached()) {
+                return;
+            }
+        }
+        defined[label.id()] = true;
+    }
+}
+
+void Assembler::report_undefined_labels(std::vector<std::size_t> const& invalid) const {
+    // The labels of the program, indexed by id. The labels in expressions are interned only when
+    // the expressions are parsed below, so their ids may lie past the end, and are undefined.
+    std::vector<bool> defined(symbols_->size(), false);
     for (Instruction const& instr : instructions_) {
-        switch (instr.get_opcode()) {
-        case Instruction::ORIG:
-        case Instruction::END:
-        case Instruction::FILL:
-        case Instruction::BLKW:
-        case Instruction::STRINGZ:
-            translate_pseudo(instr, results);
-            break;
-
-        default:
-            std::uint16_t const result = translate_regular_instruction(instr);
-            if (result == static_cast<std::uint16_t>(-1)) {
-                // An error occurred during translation. Return an empty vector.
-                return {};
+        if (instr.has_label()) {
+            defined[instr.get_label_symbol().id()] = true;
+        }
+    }
+    auto const is_defined = [&](Symbol label) {
+        return label.id() < defined.size() && defined[label.id()];
+    };
+
+    auto next_invalid = invalid.begin();
+    for (std::size_t index = 0; index != instructions_.size(); ++index) {
+        if (next_invalid != invalid.end() && *next_invalid == index) {
+            ++next_invalid;
+            continue;
+        }
+
+        Instruction const& instr = instructions_[index];
+        for (Operand const& operand : instr.get_operands()) {
+            if (refers_to_undefined_label(operand, is_defined)) {
+                emit_label_not_found_diag(operand, instr);
+                if (error_limit_reached()) {
+                    return;
+                }
             }
-            results.push_back(result);
-            break;
         }
     }
+}
 
-    return results;
+auto Assembler::refers_to_undefined_label(
+    Operand const& operand,
+    std::function<bool(Symbol)> const& is_defined
+) -> bool {
+    if (operand.type() == Operand::Label || operand.type() == Operand::LabelLiteral) {
+        return !is_defined(operand.symbol());
+    }
+    if (operand.type() != Operand::Expression) {
+        return false;
+    }
+
+    std::string const& text = operand.symbol().str();
+    std::vector<ExpressionTerm> terms;
+    parse_expression(text.data(), text.data() + text.size(), &terms);
+    return std::any_of(terms.begin(), terms.end(), [&](ExpressionTerm term) {
+        return term.is_label && !is_defined(Symbol::from_id(term.payload));
+    });
 }
 
 auto Assembler::run() -> std::vector<std::uint16_t> {
-    if (std::any_of(instructions_.begin(), instructions_.end(), [](Instruction const& instr) {
-            return !instr.validate_and_emit_diagnostics();
-        })) {
-        // There was an error during validation, so we return an empty vector.
+    SymbolPool::Scope const symbol_scope(symbols_.get());
+    zero_runs_.clear();
+    std::vector<std::size_t> invalid;
+    for (std::size_t index = 0; index != instructions_.size(); ++index) {
+        if (!instructions_[index].validate_and_emit_diagnostics()) {
+            invalid.push_back(index);
+            if (error_limit_reached()) {
+                break;
+            }
+        }
+    }
+
+    // There was an error during validation, so we return an empty vector. The sizes of invalid
+    // instructions are unknown, so the later passes would report bogus errors. Only redefined and
+    // undefined labels are independent of the addresses.
+    if (!invalid.empty()) {
+        if (!error_limit_reached()) {
+            report_label_redefinitions(invalid);
+        }
+        if (!error_limit_reached()) {
+            report_undefined_labels(invalid);
+        }
+        return {};
+    }
+    if (!check_orig()) {
         return {};
     }
 
-    // We need to check whether the final instruction sequence starts with `.ORIG` and whether it
-    // contains only one `.ORIG` instruction.
-    if (!instructions_.empty() && instructions_.front().get_opcode() != Instruction::ORIG) {
-        // If the instruction sequence does not start with `.ORIG`, we need to report an error.
-        std::cout << "error: expected the first instruction to be `.ORIG`, but got `"
-                  << instructions_.front() << "`\n";
+    build_program_table();
+    assign_addresses();
+    place_literal_pools();
+    if (relax_branches_) {
+        relax_branches();
+    }
+
+    // A redefined label keeps its first definition, so translation can still look for errors.
+    bool const labels_ok = scan_label();
+    if (!labels_ok && error_limit_reached()) {
+        return {};
+    }
 
+    // Translating the rows that use a constant that cannot be evaluated would only report it again.
+    if (!evaluate_expressions()) {
         return {};
     }
 
-    if (std::any_of(
-            std::next(instructions_.begin()),
-            instructions_.end(),
-            [](Instruction const& instr) { return instr.get_opcode() == Instruction::ORIG; }
-        )) {
-        // If the instruction sequence contains multiple `.ORIG` instructions, we need to report
-        // an error.
-        std::cout << "error: multiple `.ORIG` pseudo-instructions found\n";
+    std::vector<std::uint16_t> results;
+    results.reserve(program_.size());
+    std::vector<std::size_t> section_starts;
+    std::vector<ZeroRun> zero_runs;
+    bool const translated = translate_rows(
+        0,
+        program_.size(),
+        results,
+        &section_starts,
+        keep_zero_runs_ ? &zero_runs : nullptr
+    );
+    if (!translated || !labels_ok) {
         return {};
     }
 
+    std::vector<Instruction const*> const origs =
+        build_sections(section_starts, results.size() + zero_word_count(zero_runs));
+    if (!check_overlaps(sections_, origs)) {
+        return {};
+    }
+
+    zero_runs_ = std::move(zero_runs);
+    return results;
+}
+
+auto Assembler::run_parallel(unsigned thread_count, std::size_t min_chunk_size)
+    -> std::vector<std::uint16_t> {
+    SymbolPool::Scope const symbol_scope(symbols_.get());
+    zero_runs_.clear();
+    std::vector<std::size_t> const chunks =
+        split_range(instructions_.size(), thread_count, min_chunk_size);
+
+    // The invalid instructions of each chunk, which only the chunks up to the error limit report.
+    std::vector<std::vector<std::size_t>> chunk_invalid(chunks.size() - 1);
+    bool const valid = run_chunks(chunks, [&](std::size_t chunk) {
+        for (std::size_t index = chunks[chunk]; index != chunks[chunk + 1]; ++index) {
+            if (!instructions_[index].validate_and_emit_diagnostics()) {
+                chunk_invalid[chunk].push_back(index);
+                if (error_limit_reached()) {
+                    break;
+                }
+            }
+        }
+        return chunk_invalid[chunk].empty();
+    });
+
+    // Like `run()`, report the redefined and undefined labels after an error, unless a serial run
+    // would have stopped at the limit.
+    if (!valid) {
+        std::vector<std::size_t> invalid;
+        for (std::vector<std::size_t> const& indices : chunk_invalid) {
+            invalid.insert(invalid.end(), indices.begin(), indices.end());
+        }
+        if (!error_limit_reached()) {
+            report_label_redefinitions(invalid);
+        }
+        if (!error_limit_reached()) {
+            report_undefined_labels(invalid);
+        }
+        return {};
+    }
+    if (!check_orig()) {
+        return {};
+    }
+
+    program_ = ProgramTable(instructions_, thread_count, min_chunk_size);
     assign_addresses();
-    if (!scan_label()) {
-        // There was an error during scanning labels, so we return an empty vector.
+    place_literal_pools();
+    if (relax_branches_) {
+        relax_branches();
+    }
+    bool const labels_ok = scan_label_parallel(chunks);
+    if (!labels_ok && error_limit_reached()) {
+        return {};
+    }
+
+    if (!evaluate_expressions()) {
+        return {};
+    }
+
+    // Translate each chunk into its own slice, and concatenate the slices. The size of a slice is
+    // only known after translation, since `.ORIG` and `.END` occupy a word without emitting one.
+    std::vector<std::vector<std::uint16_t>> slices(chunks.size() - 1);
+    std::vector<std::vector<std::size_t>> slice_section_starts(chunks.size() - 1);
+    std::vector<std::vector<ZeroRun>> slice_zero_runs(chunks.size() - 1);
+    bool const translated = run_chunks(chunks, [&](std::size_t chunk) {
+        std::vector<std::uint16_t>& slice = slices[chunk];
+        slice.reserve(chunks[chunk + 1] - chunks[chunk]);
+        return translate_rows(
+            chunks[chunk],
+            chunks[chunk + 1],
+            slice,
+            &slice_section_starts[chunk],
+            keep_zero_runs_ ? &slice_zero_runs[chunk] : nullptr
+        );
+    });
+
+    if (!translated || !labels_ok) {
         return {};
     }
 
-    return translate();
+    // The stored words of each slice start at `offsets`, and all of its words, including those of
+    // its zero runs, at `word_offsets`. Runs that meet at the end of a slice are joined, like
+    // `translate_rows()` joins adjacent runs.
+    std::vector<std::size_t> offsets(slices.size() + 1, 0);
+    std::size_t word_offset = 0;
+    std::vector<std::size_t> section_starts;
+    std::vector<ZeroRun> zero_runs;
+    for (std::size_t chunk = 0; chunk != slices.size(); ++chunk) {
+        offsets[chunk + 1] = offsets[chunk] + slices[chunk].size();
+        for (std::size_t start : slice_section_starts[chunk]) {
+            section_starts.push_back(word_offset + start);
+        }
+
+        for (ZeroRun const& run : slice_zero_runs[chunk]) {
+            std::size_t const first_word = word_offset + run.first_word;
+            if (!zero_runs.empty()
+                && zero_runs.back().first_word + zero_runs.back().word_count == first_word) {
+                zero_runs.back().word_count += run.word_count;
+            } else {
+                zero_runs.push_back({ first_word, run.word_count });
+            }
+        }
+        word_offset += slices[chunk].size() + zero_word_count(slice_zero_runs[chunk]);
+    }
+
+    std::vector<Instruction const*> const origs = build_sections(section_starts, word_offset);
+    if (!check_overlaps(sections_, origs)) {
+        return {};
+    }
+    zero_runs_ = std::move(zero_runs);
+
+    std::vector<std::uint16_t> results(offsets.back());
+    parallel_for(slices.size(), [&](std::size_t chunk) {
+        std::copy(slices[chunk].begin(), slices[chunk].end(), results.begin() + offsets[chunk]);
+    });
+    return results;
+}
+
+auto Assembler::check_orig() const -> bool {
+    // We need to check whether the final instruction sequence starts with `.ORIG`. Every later
+    // `.ORIG` starts a new section.
+    if (!instructions_.empty() && instructions_.front().get_opcode() != Instruction::ORIG) {
+        // If the instruction sequence does not start with `.ORIG`, we need to report an error.
+        emit_missing_orig_diag(instructions_.front());
+        return false;
+    }
+
+    return true;
+}
+
+void Assembler::emit_section_overlap_diag(
+    Instruction const& instr,
+    Section const& section,
+    Section const& other
+) {
+    instr.report_error(
+        DiagnosticKind::SectionOverlap,
+        format_address(section.origin),
+        format_address(other.origin),
+        format_address(end_address(other) - 1)
+    );
+}
+
+auto Assembler::build_sections(
+    std::vector<std::size_t> const& section_starts,
+    std::size_t word_count
+) -> std::vector<Instruction const*> {
+    sections_.clear();
+    std::vector<Instruction const*> origs;
+    for (std::size_t row = 0; row != program_.size(); ++row) {
+        if (program_.opcode(row) == Instruction::ORIG) {
+            std::size_t const first_word = section_starts[sections_.size()];
+            if (!sections_.empty()) {
+                sections_.back().word_count = first_word - sections_.back().first_word;
+            }
+            sections_.push_back({ program_.address(row), first_word, 0 });
+            origs.push_back(&instructions_[row]);
+        }
+    }
+
+    if (!sections_.empty()) {
+        sections_.back().word_count = word_count - sections_.back().first_word;
+    }
+    return origs;
+}
+
+auto Assembler::check_overlaps(
+    std::vector<Section> const& sections,
+    std::vector<Instruction const*> const& origs
+) -> bool {
+    std::vector<std::size_t> order(sections.size());
+    for (std::size_t i = 0; i != order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return sections[a].origin < sections[b].origin;
+    });
+
+    bool ok = true;
+    // The section that reaches furthest among those with smaller origins.
+    Section const* furthest = nullptr;
+    for (std::size_t index : order) {
+        Section const& section = sections[index];
+        if (furthest != nullptr && section.origin < end_address(*furthest)) {
+            emit_section_overlap_diag(*origs[index], section, *furthest);
+            ok = false;
+            if (error_limit_reached()) {
+                break;
+            }
+        }
+
+        if (furthest == nullptr || end_address(section) > end_address(*furthest)) {
+            furthest = &section;
+        }
+    }
+
+    return ok;
+}
+
+auto Assembler::scan_label_parallel(std::vector<std::size_t> const& chunks) -> bool {
+    std::size_t const chunk_count = chunks.size() - 1;
+
+    // The first row that defines each label, indexed by the id of the label. All labels of the
+    // program have been interned into its pool while parsing, so their ids are smaller than
+    // `symbol_count`.
+    constexpr std::uint32_t no_row = 0xFFFFFFFF;
+    std::size_t const symbol_count = symbols_->size();
+    std::unique_ptr<std::atomic<std::uint32_t>[]> const first_rows(
+        new std::atomic<std::uint32_t>[symbol_count]
+    );
+
+    std::vector<std::size_t> const id_chunks = split_range(symbol_count, chunk_count, 1);
+    parallel_for(id_chunks.size() - 1, [&](std::size_t chunk) {
+        for (std::size_t id = id_chunks[chunk]; id != id_chunks[chunk + 1]; ++id) {
+            first_rows[id].store(no_row, std::memory_order_relaxed);
+        }
+    });
+
+    parallel_for(chunk_count, [&](std::size_t chunk) {
+        for (std::size_t row = chunks[chunk]; row != chunks[chunk + 1]; ++row) {
+            Symbol const label = program_.label(row);
+            if (label.empty()) {
+                continue;
+            }
+
+            // Keep the smallest row, whichever thread gets there first.
+            std::atomic<std::uint32_t>& first_row = first_rows[label.id()];
+            std::uint32_t current = first_row.load(std::memory_order_relaxed);
+            while (row < current
+                   && !first_row.compare_exchange_weak(
+                       current,
+                       static_cast<std::uint32_t>(row),
+                       std::memory_order_relaxed
+                   )) { }
+        }
+    });
+
+    // Labels defined with `add_label()` before have entries already.
+    symbol_table_.resize(symbols_->size(), no_label);
+
+    // A row redefines its label if an earlier row, or a call to `add_label()` before, defined it.
+    // These are the rows `scan_label()` reports.
+    bool const unique = run_chunks(chunks, [&](std::size_t chunk) {
+        bool chunk_unique = true;
+        for (std::size_t row = chunks[chunk]; row != chunks[chunk + 1]; ++row) {
+            Symbol const label = program_.label(row);
+            if (label.empty()) {
+                continue;
+            }
+
+            if (first_rows[label.id()].load(std::memory_order_relaxed) != row
+                || symbol_table_[label.id()] != no_label) {
+                emit_label_redefinition_diag(instructions_[row]);
+                chunk_unique = false;
+                if (error_limit_reached()) {
+                    break;
+                }
+            }
+        }
+        return chunk_unique;
+    });
+
+    if (!unique && error_limit_reached()) {
+        return false;
+    }
+
+    // Every label is defined by its first row, unless it was defined before, so the threads write
+    // disjoint entries.
+    parallel_for(chunk_count, [&](std::size_t chunk) {
+        for (std::size_t row = chunks[chunk]; row != chunks[chunk + 1]; ++row) {
+            Symbol const label = program_.label(row);
+            if (label.empty() || first_rows[label.id()].load(std::memory_order_relaxed) != row) {
+                continue;
+            }
+
+            if (symbol_table_[label.id()] == no_label) {
+                symbol_table_[label.id()] = program_.address(row);
+            }
+        }
+    });
+
+    return unique;
 }
 
 //==================================================================================================
@@ -108,6 +699,14 @@ auto unwrap(OperandRef operand) -> Operand const& {
 auto wrap(Assembler const& assembler) -> AssemblerRef {
     return reinterpret_cast<AssemblerRef>(const_cast<Assembler*>(&assembler));
 }
+
+/// Stores the address of each row of `program` into its instruction, where the C solution reads
+/// it.
+void store_addresses(ProgramTable const& program, std::vector<Instruction>& instructions) {
+    for (std::size_t row = 0; row != program.size(); ++row) {
+        instructions[row].set_address(program.address(row));
+    }
+}
 #endif
 }  // namespace
 
@@ -119,6 +718,18 @@ auto assembler_get_instruction(AssemblerRef assembler, std::size_t index) -> Ins
     return wrap(unwrap(assembler).get_instructions()[index]);
 }
 
+void assembler_set_word_count(
+    AssemblerRef assembler,
+    std::size_t index,
+    std::uint16_t word_count
+) {
+    unwrap(assembler).get_program().set_word_count(index, word_count);
+}
+
+void assembler_assign_addresses(AssemblerRef assembler, std::uint16_t origin) {
+    unwrap(assembler).get_program().assign_addresses(origin);
+}
+
 auto assembler_add_label(AssemblerRef assembler, char const* label, std::uint16_t address) -> int {
     return unwrap(assembler).add_label(label, address);
 }
@@ -166,19 +777,29 @@ void Assembler::assign_addresses() {
 }
 
 auto Assembler::scan_label() -> bool {
+    // The addresses are final once the branches are relaxed and the literal pools are placed.
+    store_addresses(program_, instructions_);
     // This function will be implemented by the student.
     return ::scan_label(wrap(*this));
 }
 
-auto Assembler::translate_regular_instruction(Instruction const& instr) const -> std::uint16_t {
+auto Assembler::translate_regular_instruction(ProgramTable::Row instr) const -> std::uint16_t {
+    // `run_parallel()` does not call `scan_label()`, which stores the addresses of the rows into
+    // the instructions, so the instruction is translated at the address of its row.
+    Instruction current = instructions_[instr.index()];
+    current.set_address(instr.get_address());
     // This function will be implemented by the student.
-    return ::translate_regular_instruction(wrap(*this), wrap(instr));
+    return ::translate_regular_instruction(wrap(*this), wrap(current));
 }
 
-void Assembler::translate_pseudo(Instruction const& instr, std::vector<std::uint16_t>& results) {
+void Assembler::translate_pseudo(
+    ProgramTable::Row instr,
+    std::vector<std::uint16_t>& results
+) const {
     size_t result_length = 0;
     // This function will be implemented by the student.
-    std::uint16_t* const result = ::translate_pseudo(wrap(instr), &result_length);
+    std::uint16_t* const result =
+        ::translate_pseudo(wrap(instructions_[instr.index()]), &result_length);
     results.insert(results.end(), result, result + result_length);
     free_translate_result_array(result);
 }
@@ -0,0 +1,409 @@
+#include "assembler/assembler.hpp"
+
+#include "assembler/instruction.hpp"
+#include "assembler/operand.hpp"
+#include "assembler/program_table.hpp"
+#include "assembler/symbol.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace {
+constexpr std::uint32_t no_row = 0xFFFFFFFF;
+/// Marks the labels that are defined by `.EQU`, which occupies no row.
+constexpr std::uint32_t constant_row = 0xFFFFFFFE;
+
+/// Returns the condition codes that the branch `opcode` tests, as they are encoded in bits 9 to
+/// 11, or 0 if `opcode` is not a branch.
+auto branch_conditions(Instruction::Opcode opcode) -> std::uint16_t {
+    switch (opcode) {
+    case Instruction::BR:
+    case Instruction::BRnzp:
+        return 0x7;
+    case Instruction::BRn:
+        return 0x4;
+    case Instruction::BRz:
+        return 0x2;
+    case Instruction::BRp:
+        return 0x1;
+    case Instruction::BRzp:
+        return 0x3;
+    case Instruction::BRnp:
+        return 0x5;
+    case Instruction::BRnz:
+        return 0x6;
+    default:
+        return 0;
+    }
+}
+
+/// Returns the number of words that `opcode` takes once relaxed (see
+/// `Assembler::translate_relaxed()`), or 0 if it cannot be relaxed.
+auto relaxed_word_count(Instruction::Opcode opcode) -> std::uint16_t {
+    switch (opcode) {
+    case Instruction::JSR:
+        return 4;
+    case Instruction::LD:
+    case Instruction::LEA:
+    case Instruction::ST:
+        return 3;
+    default:
+        std::uint16_t const conditions = branch_conditions(opcode);
+        return conditions == 0 ? 0 : conditions == 0x7 ? 3 : 4;
+    }
+}
+
+/// Returns the index of the label operand of the instruction `opcode`, which can be relaxed.
+auto label_operand_index(Instruction::Opcode opcode) -> std::size_t {
+    return opcode == Instruction::LD || opcode == Instruction::LEA || opcode == Instruction::ST
+        ? 1
+        : 0;
+}
+
+/// A Fenwick tree over the word counts of the rows of a program table. It gives the number of
+/// words before a row, and is updated when a row grows, both in O(log n).
+class WordCountTree {
+public:
+    explicit WordCountTree(std::vector<std::uint16_t> const& word_counts) :
+        tree_(word_counts.size() + 1, 0) {
+        for (std::size_t i = 1; i != tree_.size(); ++i) {
+            tree_[i] += word_counts[i - 1];
+            std::size_t const parent = i + (i & (~i + 1));
+            if (parent < tree_.size()) {
+                tree_[parent] += tree_[i];
+            }
+        }
+    }
+
+    /// Returns the number of words of the rows before `row`.
+    auto words_before(std::size_t row) const -> std::size_t {
+        std::size_t sum = 0;
+        for (std::size_t i = row; i != 0; i &= i - 1) {
+            sum += tree_[i];
+        }
+        return sum;
+    }
+
+    /// Adds `count` words to `row`.
+    void grow(std::size_t row, std::size_t count) {
+        for (std::size_t i = row + 1; i < tree_.size(); i += i & (~i + 1)) {
+            tree_[i] += count;
+        }
+    }
+
+private:
+    std::vector<std::size_t> tree_;
+};
+
+/// The spans of the references that are still short, as a segment tree over the references sorted
+/// by their first row. Each node holds the largest last row among its references, so the spans that
+/// contain a row are found in O(log n) each.
+class SpanTree {
+public:
+    /// Inserts all references, whose last rows are `last_rows`.
+    explicit SpanTree(std::vector<std::size_t> const& last_rows) : leaf_count_(1) {
+        while (leaf_count_ < last_rows.size()) {
+            leaf_count_ *= 2;
+        }
+        // A removed reference has a last row of 0, which no query looks for.
+        tree_.assign(2 * leaf_count_, 0);
+        std::copy(last_rows.begin(), last_rows.end(), tree_.begin() + leaf_count_);
+        for (std::size_t node = leaf_count_ - 1; node != 0; --node) {
+            tree_[node] = std::max(tree_[2 * node], tree_[2 * node + 1]);
+        }
+    }
+
+    /// Removes the reference at `index`.
+    void remove(std::size_t index) {
+        std::size_t node = leaf_count_ + index;
+        tree_[node] = 0;
+        for (node /= 2; node != 0; node /= 2) {
+            tree_[node] = std::max(tree_[2 * node], tree_[2 * node + 1]);
+        }
+    }
+
+    /// Calls `visit(index)` for each of the first `count` references whose last row is after
+    /// `row`.
+    template <typename Visit>
+    void find(std::size_t count, std::size_t row, Visit const& visit) const {
+        find(1, 0, leaf_count_, count, row, visit);
+    }
+
+private:
+    std::size_t leaf_count_;
+    std::vector<std::size_t> tree_;
+
+    template <typename Visit>
+    void find(
+        std::size_t node,
+        std::size_t first,
+        std::size_t last,
+        std::size_t count,
+        std::size_t row,
+        Visit const& visit
+    ) const {
+        if (first >= count || tree_[node] <= row) {
+            return;
+        }
+        if (node >= leaf_count_) {
+            visit(first);
+            return;
+        }
+
+        std::size_t const middle = first + (last - first) / 2;
+        find(2 * node, first, middle, count, row, visit);
+        find(2 * node + 1, middle, last, count, row, visit);
+    }
+};
+
+/// An instruction that refers to a label, and the row that defines the label, or the address of
+/// the program table that a constant stands for.
+struct Reference {
+    std::uint32_t row;
+    std::uint32_t target;
+};
+}  // namespace
+
+void Assembler::relax_branches() {
+    std::size_t const row_count = program_.size();
+
+    // The first row that defines each label, which is the definition that `scan_label()` keeps,
+    // indexed by the id of the label, and the `.ORIG` row of the section of each row. A symbol that
+    // no row defines has `no_row`.
+    //
+    // A constant defined by `.EQU` occupies no word, so its row is `constant_row`. Its value is
+    // known here if it is a number, and is then stored in `constant_addresses` plus one, like an
+    // address of the program table. Otherwise it depends on addresses that relaxation changes, and
+    // is `no_row`.
+    std::vector<std::uint32_t> label_rows(symbols_->size(), no_row);
+    std::vector<std::uint32_t> constant_addresses(symbols_->size(), no_row);
+    std::vector<std::uint32_t> section_rows(row_count);
+    std::uint32_t section_row = 0;
+    for (std::size_t row = 0; row != row_count; ++row) {
+        Instruction::Opcode const opcode = program_.opcode(row);
+        if (opcode == Instruction::ORIG) {
+            section_row = static_cast<std::uint32_t>(row);
+        }
+        section_rows[row] = section_row;
+
+        Symbol const label = program_.label(row);
+        if (label.empty() || label_rows[label.id()] != no_row) {
+            continue;
+        }
+
+        if (opcode != Instruction::EQU) {
+            label_rows[label.id()] = static_cast<std::uint32_t>(row);
+            continue;
+        }
+
+        Operand const& value = program_.operand(row, 0);
+        label_rows[label.id()] = constant_row;
+        if (value.type() == Operand::Immediate) {
+            constant_addresses[label.id()] =
+                static_cast<std::uint16_t>(value.immediate_value() + 1);
+        } else if (value.type() == Operand::Number) {
+            constant_addresses[label.id()] =
+                static_cast<std::uint16_t>(value.regular_decimal() + 1);
+        }
+    }
+
+    // Only the references to labels and constants of the program can be relaxed. Undefined labels
+    // are reported by translation, like those that a label defined with `add_label()` cannot
+    // reach. A reference to a constant whose value is not known yet is relaxed right away, since
+    // its offset cannot be checked.
+    std::vector<Reference> references;
+    std::vector<Reference> cross_references;
+    std::vector<Reference> constant_references;
+    std::vector<std::uint32_t> unknown_constant_rows;
+    for (std::size_t row = 0; row != row_count; ++row) {
+        Instruction::Opcode const opcode = program_.opcode(row);
+        if (relaxed_word_count(opcode) == 0) {
+            continue;
+        }
+
+        Operand const& operand = program_.operand(row, label_operand_index(opcode));
+        if (operand.type() != Operand::Label) {
+            continue;
+        }
+
+        std::uint32_t const label = operand.symbol().id();
+        std::uint32_t const target = label_rows[label];
+        if (target == no_row) {
+            continue;
+        }
+
+        if (target != constant_row) {
+            Reference const reference = { static_cast<std::uint32_t>(row), target };
+            (section_rows[row] == section_rows[target] ? references : cross_references)
+                .push_back(reference);
+        } else if (constant_addresses[label] != no_row) {
+            // The target of the reference is the address of the constant.
+            constant_references.push_back(
+                { static_cast<std::uint32_t>(row), constant_addresses[label] }
+            );
+        } else {
+            unknown_constant_rows.push_back(static_cast<std::uint32_t>(row));
+        }
+    }
+
+    // Within a section, a row that grows moves every row after it. The offset of a reference thus
+    // changes exactly when the row lies in its span, from its first row up to, but excluding, its
+    // last row, and it only grows. A reference that is out of range therefore stays so, and is
+    // relaxed once.
+    std::sort(references.begin(), references.end(), [](Reference a, Reference b) {
+        return std::min(a.row, a.target) < std::min(b.row, b.target);
+    });
+    std::vector<std::size_t> first_rows(references.size());
+    std::vector<std::size_t> last_rows(references.size());
+    for (std::size_t i = 0; i != references.size(); ++i) {
+        first_rows[i] = std::min(references[i].row, references[i].target);
+        last_rows[i] = std::max(references[i].row, references[i].target);
+    }
+
+    WordCountTree words(program_.word_counts());
+    SpanTree spans(last_rows);
+    std::vector<std::size_t> worklist;
+
+    auto const address = [&](std::size_t row) -> std::uint16_t {
+        std::size_t const section = section_rows[row];
+        return static_cast<std::uint16_t>(
+            program_.address(section) + words.words_before(row) - words.words_before(section)
+        );
+    };
+
+    // Returns whether the row `row` reaches `target`, which is an address of the program table.
+    auto const reaches = [&](std::size_t row, std::uint16_t target) {
+        unsigned const bits = program_.opcode(row) == Instruction::JSR ? 11 : 9;
+        auto const offset = static_cast<std::int16_t>(target - address(row) - 1);
+        return offset >= -(1 << (bits - 1)) && offset <= (1 << (bits - 1)) - 1;
+    };
+
+    auto const in_range = [&](Reference reference) {
+        return reaches(reference.row, address(reference.target));
+    };
+
+    auto const check = [&](std::size_t index) {
+        if (!in_range(references[index])) {
+            spans.remove(index);
+            worklist.push_back(index);
+        }
+    };
+
+    // Grows `row` to its relaxed size, and checks the references whose span contains it. The row
+    // keeps the literal pool it may host.
+    auto const relax = [&](std::size_t row) {
+        std::uint16_t const relaxed = relaxed_word_count(program_.opcode(row));
+        auto const growth = static_cast<std::uint16_t>(relaxed - 1);
+        words.grow(row, growth);
+        program_.set_word_count(
+            row,
+            static_cast<std::uint16_t>(program_.word_counts()[row] + growth)
+        );
+
+        std::size_t const count = static_cast<std::size_t>(
+            std::upper_bound(first_rows.begin(), first_rows.end(), row) - first_rows.begin()
+        );
+        spans.find(count, row, check);
+    };
+
+    for (std::size_t i = 0; i != references.size(); ++i) {
+        check(i);
+    }
+    for (std::uint32_t const row : unknown_constant_rows) {
+        relax(row);
+    }
+
+    // A row that grows moves the rows after it in its own section only, so the offset of a
+    // reference across sections may shrink as well, and that of a reference to a constant may
+    // change either way. These are few, so they are checked again whenever the worklist runs
+    // empty, until none of them is relaxed anymore. Relaxed rows never shrink back, so this
+    // terminates.
+    std::vector<bool> cross_relaxed(cross_references.size(), false);
+    std::vector<bool> constant_relaxed(constant_references.size(), false);
+    for (bool changed = true; changed;) {
+        while (!worklist.empty()) {
+            std::size_t const index = worklist.back();
+            worklist.pop_back();
+            relax(references[index].row);
+        }
+
+        changed = false;
+        for (std::size_t i = 0; i != cross_references.size(); ++i) {
+            if (!cross_relaxed[i] && !in_range(cross_references[i])) {
+                cross_relaxed[i] = true;
+                changed = true;
+                relax(cross_references[i].row);
+            }
+        }
+        for (std::size_t i = 0; i != constant_references.size(); ++i) {
+            Reference const reference = constant_references[i];
+            if (!constant_relaxed[i]
+                && !reaches(reference.row, static_cast<std::uint16_t>(reference.target))) {
+                constant_relaxed[i] = true;
+                changed = true;
+                relax(reference.row);
+            }
+        }
+    }
+
+    program_.assign_addresses(program_.address(0));
+}
+
+auto Assembler::max_word_count(std::size_t row) const -> std::size_t {
+    Instruction::Opcode const opcode = program_.opcode(row);
+    std::uint16_t const relaxed = relax_branches_ ? relaxed_word_count(opcode) : 0;
+    if (relaxed != 0
+        && program_.operand(row, label_operand_index(opcode)).type() == Operand::Label) {
+        return relaxed;
+    }
+    return program_.word_counts()[row];
+}
+
+void Assembler::translate_relaxed(
+    ProgramTable::Row instr,
+    std::vector<std::uint16_t>& results
+) const {
+    Instruction::Opcode const opcode = instr.get_opcode();
+    bool found = false;
+    std::uint16_t const target =
+        get_label_value(instr.get_operand(label_operand_index(opcode)).symbol(), &found);
+
+    // LD, LEA, and ST are followed by `BRnzp #1`, which skips the address after it.
+    auto const access = [&](std::uint16_t opcode_bits) {
+        auto const reg = static_cast<std::uint16_t>(instr.get_operand(0).register_id() << 9);
+        results.insert(
+            results.end(),
+            { static_cast<std::uint16_t>(opcode_bits | reg | 1), 0x0E01, target }
+        );
+    };
+
+    switch (opcode) {
+    case Instruction::JSR:
+        // LD R7, #2; JSRR R7; BRnzp #1; .FILL target. The subroutine returns to the `BR`.
+        results.insert(results.end(), { 0x2E02, 0x41C0, 0x0E01, target });
+        break;
+    case Instruction::LD:
+        // LDI Rd, #1; BRnzp #1; .FILL target
+        access(0xA000);
+        break;
+    case Instruction::LEA:
+        // LD Rd, #1; BRnzp #1; .FILL target
+        access(0x2000);
+        break;
+    case Instruction::ST:
+        // STI Rs, #1; BRnzp #1; .FILL target
+        access(0xB000);
+        break;
+    default:
+        // A branch with the inverted conditions over the jump, unless the branch is
+        // unconditional, then LD R7, #1; JMP R7; .FILL target.
+        auto const inverted = static_cast<std::uint16_t>(~branch_conditions(opcode) & 0x7);
+        if (inverted != 0) {
+            results.push_back(static_cast<std::uint16_t>(inverted << 9 | 3));
+        }
+        results.insert(results.end(), { 0x2E01, 0xC1C0, target });
+        break;
+    }
+}
@@ -0,0 +1,152 @@
+#include "assembler/diagnostic.hpp"
+
+#include "assembler/line_index.hpp"
+
+#include <cstddef>
+#include <iostream>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+constexpr std::size_t Diagnostic::unknown_offset;
+constexpr std::size_t DiagnosticEngine::no_limit;
+
+namespace {
+/// The diagnostic stream of the current thread, or `nullptr` for `std::cout`.
+thread_local std::ostream* current_stream = nullptr;
+/// The source code that the diagnostic messages of the current thread refer to, if known.
+thread_local LineIndex const* current_source = nullptr;
+/// The engine that collects the diagnostics of the current thread, if any.
+thread_local DiagnosticEngine* current_engine = nullptr;
+
+/// The format of each kind of diagnostic, indexed by `DiagnosticKind`.
+char const* const diagnostic_formats[] = {
+#define DIAGNOSTIC(name, format) format,
+#include "assembler/diagnostic.def"
+};
+}  // namespace
+
+auto diagnostic_stream() -> std::ostream& {
+    return current_stream != nullptr ? *current_stream : std::cout;
+}
+
+DiagnosticRedirect::DiagnosticRedirect(std::ostream& stream) : previous_(current_stream) {
+    current_stream = &stream;
+}
+
+DiagnosticRedirect::~DiagnosticRedirect() {
+    current_stream = previous_;
+}
+
+auto diagnostic_source() -> LineIndex const* {
+    return current_source;
+}
+
+DiagnosticSource::DiagnosticSource(LineIndex const* source) : previous_(current_source) {
+    current_source = source;
+}
+
+DiagnosticSource::~DiagnosticSource() {
+    current_source = previous_;
+}
+
+void write_message(std::ostream& out, Diagnostic const& diagnostic) {
+    char const* const format = diagnostic_formats[static_cast<std::size_t>(diagnostic.kind)];
+
+    char const* text = format;
+    for (char const* p = format; *p != '\0'; ++p) {
+        // The formats only use single-digit placeholders.
+        if (p[0] != '{' || p[1] < '0' || p[1] > '9' || p[2] != '}') {
+            continue;
+        }
+
+        std::size_t const index = static_cast<std::size_t>(p[1] - '0');
+        out.write(text, p - text);
+        if (index < diagnostic.arguments.size()) {
+            out << diagnostic.arguments[index];
+        }
+        p += 2;
+        text = p + 1;
+    }
+    out << text;
+}
+
+void render(std::ostream& out, Diagnostic const& diagnostic, LineIndex const* source) {
+    if (source != nullptr && diagnostic.begin <= source->size()) {
+        SourceLocation const location = source->locate(diagnostic.begin);
+        out << location.line << ':' << location.column << ": ";
+    }
+
+    out << "error: ";
+    write_message(out, diagnostic);
+    out << '\n';
+}
+
+DiagnosticEngine::Scope::Scope(DiagnosticEngine& engine) : previous_(current_engine) {
+    current_engine = &engine;
+}
+
+DiagnosticEngine::Scope::~Scope() {
+    current_engine = previous_;
+}
+
+void DiagnosticEngine::report(Diagnostic diagnostic) {
+    if (!at_limit()) {
+        diagnostics_.push_back(std::move(diagnostic));
+    }
+    ++error_count_;
+}
+
+void DiagnosticEngine::flush(DiagnosticSink& sink) {
+    for (Diagnostic const& diagnostic : diagnostics_) {
+        sink.consume(diagnostic);
+    }
+
+    if (error_count_ > diagnostics_.size()) {
+        std::size_t const dropped = error_count_ - diagnostics_.size();
+        sink.consume(Diagnostic {
+            DiagnosticKind::TooManyErrors,
+            Diagnostic::unknown_offset,
+            Diagnostic::unknown_offset,
+            { diagnostic_argument(dropped) },
+        });
+    }
+
+    diagnostics_.clear();
+    error_count_ = 0;
+}
+
+void DiagnosticEngine::forward() {
+    std::vector<Diagnostic> diagnostics;
+    diagnostics.swap(diagnostics_);
+    error_count_ = 0;
+
+    for (Diagnostic& diagnostic : diagnostics) {
+        if (current_engine != nullptr && current_engine->at_limit()) {
+            break;
+        }
+        ::report(std::move(diagnostic));
+    }
+}
+
+void report(Diagnostic diagnostic) {
+    if (current_engine != nullptr) {
+        current_engine->report(std::move(diagnostic));
+        return;
+    }
+
+    render(diagnostic_stream(), diagnostic, current_source);
+}
+
+auto error_limit_reached() -> bool {
+    return current_engine == nullptr || current_engine->at_limit();
+}
+
+auto remaining_errors() -> std::size_t {
+    if (current_engine == nullptr) {
+        return 1;
+    }
+
+    DiagnosticEngine const& engine = *current_engine;
+    return engine.at_limit() ? 0 : engine.max_errors() - engine.error_count();
+}
@@ -0,0 +1,315 @@
+#include "assembler/expression.hpp"
+
+#include "assembler/assembler.hpp"
+#include "assembler/diagnostic.hpp"
+#include "assembler/instruction.hpp"
+#include "assembler/operand.hpp"
+#include "assembler/parser.hpp"
+#include "assembler/program_table.hpp"
+#include "assembler/symbol.hpp"
+#include "assembler/token.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+auto parse_expression(char const* begin, char const* end, std::vector<ExpressionTerm>* terms)
+    -> OperandConstructionErrorType {
+    auto const is_operator = [](char ch) { return ch == '+' || ch == '-'; };
+
+    char const* current = begin;
+    bool negative = false;
+    while (true) {
+        // The sign after the `#` of a decimal immediate belongs to the term, as in `BASE+#-1`.
+        char const* term_end = current;
+        if (term_end != end && *term_end == '#') {
+            ++term_end;
+            if (term_end != end && is_operator(*term_end)) {
+                ++term_end;
+            }
+        }
+        term_end = std::find_if(term_end, end, is_operator);
+
+        // Lex the term like an operand, so that it is classified exactly as one.
+        Parser parser(current, term_end);
+        Token const& token = parser.next_token();
+        if (token.end() != term_end) {
+            return OperandConstructionErrorType::InvalidExpression;
+        }
+
+        ExpressionTerm term = {};
+        term.negative = negative;
+        switch (token.kind()) {
+        case Token::Label:
+            term.is_label = true;
+            if (terms != nullptr) {
+                term.payload = Symbol::intern(token.begin(), token.end()).id();
+            }
+            break;
+
+        case Token::Immediate:
+        case Token::Number:
+            if (token.number_error() != OperandConstructionErrorType::NoError) {
+                return token.number_error();
+            }
+            term.payload = static_cast<std::uint16_t>(token.value());
+            break;
+
+        default:
+            // An empty term is lexed as `Token::End`.
+            return OperandConstructionErrorType::InvalidExpression;
+        }
+
+        if (terms != nullptr) {
+            terms->push_back(term);
+        }
+
+        if (term_end == end) {
+            return OperandConstructionErrorType::NoError;
+        }
+        negative = *term_end == '-';
+        current = term_end + 1;
+    }
+}
+
+namespace {
+/// A constant defined by `.EQU`, or an expression operand, whose value is the sum of its terms.
+struct ExpressionNode {
+    /// The label of the constant, or the symbol of the text of the expression.
+    Symbol symbol;
+    /// The row of the `.EQU` that defines the constant, or `no_row` for an expression.
+    std::uint32_t row;
+    /// The terms of the node are `terms[first_term, first_term + term_count)`.
+    std::uint32_t first_term;
+    std::uint32_t term_count;
+};
+
+constexpr std::uint32_t no_row = 0xFFFFFFFF;
+/// Marks the symbols that are not a node.
+constexpr std::uint32_t no_node = 0xFFFFFFFF;
+
+enum class NodeState : std::uint8_t {
+    Unvisited,
+    /// The node is on the stack of the depth-first search, so reaching it again closes a cycle.
+    Visiting,
+    Evaluated,
+    Failed,
+};
+
+/// A node on the stack of the depth-first search, whose terms before `next_term` have been added.
+struct EvaluationFrame {
+    std::uint32_t node;
+    std::uint32_t next_term;
+    std::uint16_t sum;
+    bool failed;
+    /// The first undefined label that a term refers to, directly or through an expression.
+    Symbol missing;
+};
+}  // namespace
+
+auto Assembler::evaluate_expressions() -> bool {
+    std::vector<ExpressionNode> nodes;
+    std::vector<ExpressionTerm> terms;
+    // The node of each symbol, indexed by its id, or `no_node`. Labels and operands were interned
+    // by the parser, but the labels in expressions are only interned when the expressions are
+    // parsed below, so their ids may lie past the end.
+    std::vector<std::uint32_t> node_of(symbols_->size(), no_node);
+    auto const node_index = [&](Symbol symbol) {
+        return symbol.id() < node_of.size() ? node_of[symbol.id()] : no_node;
+    };
+    // The labels that a row before the current one defines, in which case `.EQU` redefines it,
+    // which `scan_label()` reports, and the first definition is kept.
+    std::vector<bool> defined(symbols_->size(), false);
+
+    auto const add_node = [&](Symbol symbol, std::uint32_t row) {
+        node_of[symbol.id()] = static_cast<std::uint32_t>(nodes.size());
+        nodes.push_back({ symbol, row, static_cast<std::uint32_t>(terms.size()), 0 });
+    };
+
+    for (std::size_t row = 0; row != program_.size(); ++row) {
+        Symbol const label = program_.label(row);
+        bool const first_definition = !label.empty() && !defined[label.id()];
+        if (first_definition) {
+            defined[label.id()] = true;
+        }
+
+        ProgramTable::Row const instr = program_.row(row);
+        if (instr.get_opcode() == Instruction::EQU && first_definition) {
+            // A constant has a single term, its operand.
+            add_node(label, static_cast<std::uint32_t>(row));
+            Operand const& operand = instr.get_operand(0);
+            ExpressionTerm term = {};
+            switch (operand.type()) {
+            case Operand::Immediate:
+                term.payload = static_cast<std::uint16_t>(operand.immediate_value());
+                break;
+            case Operand::Number:
+                term.payload = static_cast<std::uint16_t>(operand.regular_decimal());
+                break;
+            default:
+                // A label, or an expression, which is a node of its own.
+                term.payload = operand.symbol().id();
+                term.is_label = true;
+                break;
+            }
+            terms.push_back(term);
+            nodes.back().term_count = 1;
+        }
+
+        for (Operand const& operand : program_.operands(row)) {
+            if (operand.type() != Operand::Expression || node_index(operand.symbol()) != no_node) {
+                continue;
+            }
+
+            // The text of the expression has been checked when the operand was constructed.
+            add_node(operand.symbol(), no_row);
+            std::string const& text = operand.symbol().str();
+            parse_expression(text.data(), text.data() + text.size(), &terms);
+            nodes.back().term_count = static_cast<std::uint32_t>(terms.size())
+                - nodes.back().first_term;
+        }
+    }
+
+    if (nodes.empty()) {
+        return true;
+    }
+
+    // Evaluate the nodes in topological order, by a depth-first search that adds the value of each
+    // term once it is known. The search keeps its own stack, since a chain of constants may be as
+    // long as the program.
+    std::vector<NodeState> states(nodes.size(), NodeState::Unvisited);
+    std::vector<std::uint16_t> values(nodes.size(), 0);
+    std::vector<Symbol> missing(nodes.size());
+    std::vector<EvaluationFrame> stack;
+    bool ok = true;
+
+    // Reports the errors of a constant, and returns whether assembly may go on looking for errors.
+    auto const report = [&](DiagnosticKind kind, std::uint32_t node, Symbol label) {
+        Instruction const& instr = instructions_[nodes[node].row];
+        if (kind == DiagnosticKind::LabelNotFound) {
+            instr.report_error(kind, label.str(), instr);
+        } else {
+            instr.report_error(kind, nodes[node].symbol.str(), instr);
+        }
+        ok = false;
+        return !error_limit_reached();
+    };
+
+    for (std::uint32_t root = 0; root != nodes.size(); ++root) {
+        if (states[root] != NodeState::Unvisited) {
+            continue;
+        }
+
+        states[root] = NodeState::Visiting;
+        stack.push_back({ root, 0, 0, false, Symbol() });
+        while (!stack.empty()) {
+            EvaluationFrame& frame = stack.back();
+            ExpressionNode const& node = nodes[frame.node];
+
+            if (frame.next_term == node.term_count) {
+                // All terms are known, or one of them failed.
+                std::uint32_t const done = frame.node;
+                states[done] = frame.failed ? NodeState::Failed : NodeState::Evaluated;
+                values[done] = frame.sum;
+                missing[done] = frame.missing;
+                stack.pop_back();
+
+                if (node.row != no_row && states[done] == NodeState::Failed
+                    && !missing[done].empty()
+                    && !report(DiagnosticKind::LabelNotFound, done, missing[done])) {
+                    return false;
+                }
+
+                if (!stack.empty()) {
+                    // Add the node to the term of its parent that refers to it. The failure of a
+                    // constant has been reported, so it is only passed on as a failure.
+                    EvaluationFrame& parent = stack.back();
+                    ExpressionTerm const& term =
+                        terms[nodes[parent.node].first_term + parent.next_term - 1];
+                    if (states[done] == NodeState::Failed) {
+                        parent.failed = true;
+                        if (node.row == no_row && parent.missing.empty()) {
+                            parent.missing = missing[done];
+                        }
+                    } else {
+                        parent.sum = static_cast<std::uint16_t>(
+                            term.negative ? parent.sum - values[done] : parent.sum + values[done]
+                        );
+                    }
+                }
+                continue;
+            }
+
+            ExpressionTerm const& term = terms[node.first_term + frame.next_term++];
+            std::uint16_t value = static_cast<std::uint16_t>(term.payload);
+            if (term.is_label) {
+                std::uint32_t const child = node_index(Symbol::from_id(term.payload));
+                if (child == no_node) {
+                    // A label of the program, whose address is known.
+                    bool found = false;
+                    value = get_label_value(Symbol::from_id(term.payload), &found);
+                    if (!found) {
+                        frame.failed = true;
+                        if (frame.missing.empty()) {
+                            frame.missing = Symbol::from_id(term.payload);
+                        }
+                        continue;
+                    }
+                } else if (states[child] == NodeState::Unvisited) {
+                    // The term is added once the child is evaluated.
+                    states[child] = NodeState::Visiting;
+                    stack.push_back({ child, 0, 0, false, Symbol() });
+                    continue;
+                } else if (states[child] == NodeState::Visiting) {
+                    // The child is on the stack, so it depends on itself. Report the first
+                    // constant of the cycle, since an expression does not define a symbol. The
+                    // failure is passed on to every node of the cycle.
+                    auto const cycle = std::find_if(
+                        stack.begin(),
+                        stack.end(),
+                        [&](EvaluationFrame const& entry) {
+                            return entry.node == child;
+                        }
+                    );
+                    auto const constant = std::find_if(
+                        cycle,
+                        stack.end(),
+                        [&](EvaluationFrame const& entry) {
+                            return nodes[entry.node].row != no_row;
+                        }
+                    );
+                    stack.back().failed = true;
+                    if (!report(DiagnosticKind::ConstantCycle, constant->node, Symbol())) {
+                        return false;
+                    }
+                    continue;
+                } else if (states[child] == NodeState::Failed) {
+                    frame.failed = true;
+                    if (nodes[child].row == no_row && frame.missing.empty()) {
+                        frame.missing = missing[child];
+                    }
+                    continue;
+                } else {
+                    value = values[child];
+                }
+            }
+
+            frame.sum = static_cast<std::uint16_t>(
+                term.negative ? frame.sum - value : frame.sum + value
+            );
+        }
+    }
+
+    // Every constant is defined by its first row, so it replaces the address that `scan_label()`
+    // has stored for the label. A constant that failed is left undefined. Like that of a label, the
+    // entry is one more than the value, so that offsets to it reach the value itself.
+    for (std::size_t index = 0; index != nodes.size(); ++index) {
+        symbol_entry(nodes[index].symbol) = states[index] == NodeState::Evaluated
+            ? static_cast<std::uint16_t>(values[index] + 1)
+            : no_label;
+    }
+
+    return ok;
+}
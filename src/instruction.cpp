@@ -3,21 +3,19 @@
 #include "assembler-c/instruction.h"
 #include "assembler-c/operand.h"
 #include "assembler-c/token.h"
+#include "assembler/diagnostic.hpp"
+#include "assembler/expression.hpp"
 #include "assembler/operand.hpp"
 #include "assembler/token.hpp"
 
 #include <algorithm>
-#include <cassert>
 #include <cstddef>
 #include <cstdint>
-#include <iostream>
 #include <iterator>
 #include <ostream>
 #include <string>
 #include <type_traits>
-#include <unordered_map>
 #include <utility>
-#include <vector>
 
 #ifdef USE_CPP
     #include "assembler/solution.hpp"
@@ -26,95 +24,117 @@
 #endif
 
 namespace {
-/// Checks whether `token_content` is a valid immediate number or integer.
-///
-/// The `token_content` is guaranteed to meet the following conditions:
-///
-///     + If `token_content` represents an immediate value, it has a prefix of `#`, `x`, or `b`. For
-///       regular integers, it does not have a prefix.
-///
-///     + The length of `token_content` is at least 1.
-///
-///     + All characters in `token_content` are valid. For example, a decimal integer will only
-///       contain numeric characters.
-///
-///     + `token_content` may contain at most one sign (+/-), and this sign must be at the beginning
-///       of `token_content` (for a regular number) or immediately following the prefix `#` (for an
-///       immediate value). For example, `token_content` could be `+` or `#-`, but not `++` or
-///       `#2+`.
-///
-/// This function further checks if `token_content` is a valid immediate number or integer. For
-/// instance, `#` by itself satisfies the above four conditions, but it is not a valid immediate
-/// number.
-///
-/// Note that binary and hexadecimal immediate numbers cannot have a sign.
-auto is_valid_number(std::string const& token_content) -> bool {
-    switch (token_content.front()) {
-    case '#':
-    case 'x':
-    case 'b':
-        if (token_content.size() == 1) {
-            // The immediate consists of only a prefix, so it is invalid.
-            return false;
-        }
+/// The operand signatures of all instructions, in the order of `assembler/opcode.def`.
+constexpr Instruction::OperandSignature signature_table[] = {
+    // Instructions with an unknown opcode accept no operands.
+    { 0, {} },
+#define SIGNATURE0(name) { 0, {} },
+#define SIGNATURE1(name, type1) { 1, { Operand::type1 } },
+#define SIGNATURE2(name, type1, type2) { 2, { Operand::type1, Operand::type2 } },
+#define SIGNATURE3(name, type1, type2, type3)                                                      \
+    { 3, { Operand::type1, Operand::type2, Operand::type3 } },
+#include "assembler/opcode.def"
+};
+
+/// The opcode that each entry of `signature_table` belongs to.
+constexpr Instruction::Opcode signature_opcodes[] = {
+    Instruction::UnknownOp,
+#define SIGNATURE0(name) Instruction::name,
+#define SIGNATURE1(name, type1) Instruction::name,
+#define SIGNATURE2(name, type1, type2) Instruction::name,
+#define SIGNATURE3(name, type1, type2, type3) Instruction::name,
+#include "assembler/opcode.def"
+};
 
-        if (token_content.size() == 2) {
-            // If the length of the immediate is 2 (i.e., there is only one character after the
-            // prefix), that character cannot be a sign.
-            return token_content[1] != '+' && token_content[1] != '-';
-        }
+constexpr std::size_t signature_count = sizeof(signature_opcodes) / sizeof(signature_opcodes[0]);
 
-        // In all other cases, `token_content` is a valid immediate.
-        return true;
+/// Returns the index of the first signature of `opcode` in `signature_table` at or after `index`,
+/// or `signature_count` if there is none.
+constexpr auto first_signature(Instruction::Opcode opcode, std::size_t index = 0) -> std::size_t {
+    return index == signature_count || signature_opcodes[index] == opcode
+        ? index
+        : first_signature(opcode, index + 1);
+}
 
-    case '+':
-    case '-':
-        // For regular integers, if it starts with a sign, it must contain at least one digit.
-        return token_content.size() > 1;
+/// Returns the index just past the run of signatures of `opcode` that starts at `index`.
+constexpr auto end_of_signatures(Instruction::Opcode opcode, std::size_t index) -> std::size_t {
+    return index != signature_count && signature_opcodes[index] == opcode
+        ? end_of_signatures(opcode, index + 1)
+        : index;
+}
 
-    default:
-        // In all other cases, `token_content` is a valid integer, as it definitely contains at
-        // least one digit.
-        return true;
-    }
+/// The signatures of an opcode are the entries of `signature_table` with indices in [first, last).
+struct SignatureRange {
+    std::size_t first;
+    std::size_t last;
+};
+
+constexpr auto signature_range(Instruction::Opcode opcode) -> SignatureRange {
+    return { first_signature(opcode), end_of_signatures(opcode, first_signature(opcode)) };
 }
 
-/// Converts the immediate or regular decimal integer represented by `content` into an integer of
-/// type `std::int16_t`. If the conversion result exceeds the range of `std::int16_t`, sets `ok` to
-/// `false`.
-auto to_integer(std::string const& content, bool* ok) -> std::int16_t {
-    // This function will be implemented by the student.
-#ifdef USE_CPP
-    return string_to_integer(content, ok);
-#else
-    int _ok = 0;
-    std::int16_t const result = string_to_integer(content.c_str(), &_ok);
-    *ok = static_cast<bool>(_ok);
-    return result;
-#endif
+/// The signatures of every opcode, indexed by `Instruction::Opcode`.
+constexpr SignatureRange signature_ranges[] = {
+    signature_range(Instruction::UnknownOp),
+#define OPCODE(name) signature_range(Instruction::name),
+#define PSEUDO(name) signature_range(Instruction::name),
+#include "assembler/opcode.def"
+};
+
+constexpr std::size_t opcode_count = sizeof(signature_ranges) / sizeof(signature_ranges[0]);
+
+/// Returns the total number of signatures of the opcodes with values in [opcode, opcode_count), or
+/// 0 if one of them has no signature.
+constexpr auto total_signature_count(std::size_t opcode = 0) -> std::size_t {
+    return opcode == opcode_count ? 0
+        : signature_ranges[opcode].first == signature_ranges[opcode].last
+        ? 0
+        : signature_ranges[opcode].last - signature_ranges[opcode].first
+            + total_signature_count(opcode + 1);
+}
+
+/// Returns whether each signature with an index in [index, signature_count) has as many operands
+/// as the first signature of its opcode.
+constexpr auto have_consistent_sizes(std::size_t index = 0) -> bool {
+    return index == signature_count
+        || (signature_table[index].size
+                == signature_table[first_signature(signature_opcodes[index])].size
+            && have_consistent_sizes(index + 1));
 }
+
+// Every signature belongs to exactly one run, so the signatures of each opcode are adjacent.
+static_assert(
+    total_signature_count() == signature_count,
+    "Every opcode in `opcode.def` needs adjacent signatures."
+);
+static_assert(
+    have_consistent_sizes(),
+    "The signatures of an opcode in `opcode.def` differ in the number of operands."
+);
 }  // namespace
 
-auto operator<<(std::ostream& out, OperandConstructionErrorType error) -> std::ostream& {
-    out << "OperandConstructionErrorType::";
-
-    switch (error) {
-    case OperandConstructionErrorType::NoError:
-        return out << "NoError";
-    case OperandConstructionErrorType::InvalidTokenKind:
-        return out << "InvalidTokenKind";
-    case OperandConstructionErrorType::InvalidNumber:
-        return out << "InvalidNumber";
-    case OperandConstructionErrorType::IntegerOverflow:
-        return out << "IntegerOverflow";
-    case OperandConstructionErrorType::MissingQuote:
-        return out << "MissingQuote";
-    default:
-        return out << "Unknown";
-    }
+constexpr std::size_t Instruction::max_operand_count;
+
+auto Instruction::operand_signatures(Opcode opcode)
+    -> std::pair<OperandSignature const*, OperandSignature const*> {
+    SignatureRange const& range = signature_ranges[opcode];
+    return { signature_table + range.first, signature_table + range.last };
 }
 
 auto Instruction::add_operand(Token const& token) -> OperandConstructionErrorType {
+    Operand operand;
+    OperandConstructionErrorType const error = construct_operand(token, &operand);
+
+    if (error == OperandConstructionErrorType::NoError) {
+        assert(operand_size_ < max_operand_count);
+        operands_[operand_size_++] = operand;
+    }
+
+    return error;
+}
+
+auto Instruction::construct_operand(Token const& token, Operand* operand)
+    -> OperandConstructionErrorType {
     switch (token.kind()) {
     case Token::Register:
         // Tokens of type `Token::Register` are always valid.
@@ -122,42 +142,53 @@ auto Instruction::add_operand(Token const& token) -> OperandConstructionErrorTyp
         // For `Register` type tokens, the content will only be register names ranging from `R0` to
         // `R7`. Therefore, we can easily retrieve the register number using the character at
         // index 1.
-        operands_.push_back(Operand::from_register(token[1] - '0'));
+        *operand = Operand::from_register(token[1] - '0');
         return OperandConstructionErrorType::NoError;
 
     case Token::Label:
         // Tokens of type `Token::Label` are always valid.
-        operands_.push_back(Operand::from_label(token.begin(), token.end()));
+        *operand = Operand::from_label(token.begin(), token.end());
         return OperandConstructionErrorType::NoError;
 
     case Token::Immediate:
-    case Token::Number: {
-        std::string const token_content = token.content();
+    case Token::Number:
+        // The number has already been decoded and checked when the token was produced, so the
+        // text is not parsed again here.
+        if (token.number_error() == OperandConstructionErrorType::NoError) {
+            *operand = Operand::from_integer(
+                /*is_immediate=*/token.kind() == Token::Immediate,
+                token.value()
+            );
+        }
+        return token.number_error();
 
-        // Check whether it is a valid number.
-        if (!is_valid_number(token_content)) {
-            return OperandConstructionErrorType::InvalidNumber;
+    case Token::ImmediateLiteral:
+        // Like an immediate, the value of the literal has been decoded by the lexer.
+        if (token.number_error() == OperandConstructionErrorType::NoError) {
+            *operand = Operand::from_immediate_literal(token.value());
         }
+        return token.number_error();
 
-        // Check if the integer value exceeds the range of a 16-bit signed integer.
-        bool ok = true;
-        std::int16_t const value = to_integer(token_content, &ok);
+    case Token::LabelLiteral:
+        // The label follows the leading `=`.
+        *operand = Operand::from_label_literal(token.begin() + 1, token.end());
+        return OperandConstructionErrorType::NoError;
 
-        if (ok) {
-            operands_.push_back(
-                Operand::from_integer(/*is_immediate=*/token.kind() == Token::Immediate, value)
-            );
-            return OperandConstructionErrorType::NoError;
-        } else {
-            return OperandConstructionErrorType::IntegerOverflow;
+    case Token::Expression: {
+        // The terms are checked here, so that the assembler can evaluate any expression operand.
+        OperandConstructionErrorType const error =
+            parse_expression(token.begin(), token.end(), nullptr);
+        if (error == OperandConstructionErrorType::NoError) {
+            *operand = Operand::from_expression(token.begin(), token.end());
         }
+        return error;
     }
 
     case Token::String:
         // Check whether the content of the `String` token contains a closing quotation mark. Note
         // that we cannot simply check whether the last character of the string is `"`.
         if (token.size() > 1 && token.back() == '"') {
-            operands_.push_back(Operand::from_string_literal(token.begin(), token.end()));
+            *operand = Operand::from_string_literal(token.begin(), token.end());
             return OperandConstructionErrorType::NoError;
         } else {
             return OperandConstructionErrorType::MissingQuote;
@@ -169,23 +200,6 @@ auto Instruction::add_operand(Token const& token) -> OperandConstructionErrorTyp
     }
 }
 
-void Instruction::set_opcode(Token const& token) {
-    // clang-format off
-    static std::unordered_map<std::string, Opcode> const opcode_map = {
-#define OPCODE(name) { #name, Opcode::name },
-#define PSEUDO(name) { "." #name, Opcode::name },
-#include "assembler/opcode.def"
-    };
-    // clang-format on
-
-    assert(token.kind() == Token::Opcode || token.kind() == Token::Pseudo);
-
-    auto const iter = opcode_map.find(token.content());
-    assert(iter != opcode_map.end());
-
-    set_opcode(iter->second);
-}
-
 auto Instruction::get_opcode_spelling() const -> char const* {
     switch (opcode_) {
 #define OPCODE(name)                                                                               \
@@ -201,83 +215,101 @@ auto Instruction::get_opcode_spelling() const -> char const* {
     }
 }
 
+constexpr std::uint32_t Instruction::unknown_source_offset;
+
 auto Instruction::validate_and_emit_diagnostics() const -> bool {
+    // The parser has reported the error of a line that it recovered from.
+    if (is_unknown()) {
+        return false;
+    }
+
     // Check if a label is attached to an instruction that should not have a label.
     if (!allows_label() && has_label()) {
-        std::cout << "error: instruction `" << *this << "` does not allow a label\n";
+        report_error(DiagnosticKind::LabelNotAllowed, *this);
         return false;
     }
 
-    // Get the expected operand types for the instruction.
-    std::vector<std::vector<Operand::OperandType>> const expected_operands =
-        expected_operand_types();
+    if (requires_label() && !has_label()) {
+        report_error(DiagnosticKind::LabelRequired, *this);
+        return false;
+    }
+
+    // Get the expected operand signatures for the instruction. They are stored in a static table,
+    // so validating a well-formed instruction does not allocate memory.
+    std::pair<OperandSignature const*, OperandSignature const*> const signatures =
+        operand_signatures(opcode_);
 
     // Check if the number of operands provided matches the expected number of operands for the
-    // instruction. In the current implementation, we assume that for every expected operand type
-    // list, the number of operands is consistent.
-    std::size_t const expected_operand_size = expected_operands.front().size();
-    if (operands_.size() != expected_operand_size) {
-        std::cout << "error: instruction `" << *this << "` expects " << expected_operand_size
-                  << " operand(s), but got " << operands_.size() << " operand(s)\n";
+    // instruction. All signatures of an instruction have the same number of operands, which is
+    // checked when the table is built.
+    std::size_t const expected_operand_size = signatures.first->size;
+    if (operand_size() != expected_operand_size) {
+        report_error(DiagnosticKind::OperandCount, *this, expected_operand_size, operand_size());
         return false;
     }
 
+    OperandRange const operands = get_operands();
+
     // Check if the types of the provided operands match the expected types.
 
     // The following two variables are used to record the information about the first mismatched
-    // operand. Since some instructions may expect multiple operand type lists, we also need to
-    // record the expected operand type in case of a mismatch.
+    // operand. Since some instructions may accept multiple signatures, we also need to record the
+    // expected operand type in case of a mismatch.
 
     // The index of the first mismatched operand.
     std::size_t mismatched_operand_index = 0;
     // The expected type for the mismatched operand.
     Operand::OperandType expected_operand_type {};
 
-    for (std::vector<Operand::OperandType> const& expected : expected_operands) {
-        // For the expected operand type list `expected`, find the first operand where it mismatches
-        // with the actual operand types.
+    for (OperandSignature const* signature = signatures.first; signature != signatures.second;
+         ++signature) {
+        // For the signature, find the first operand where it mismatches with the actual operand
+        // types.
         auto const mismatched_iters = std::mismatch(
-            operands_.begin(),
-            operands_.end(),
-            expected.begin(),
+            operands.begin(),
+            operands.end(),
+            signature->types,
             [](Operand const& lhs, Operand::OperandType rhs) { return lhs.type() == rhs; }
         );
 
         // Record the index of the mismatched operand. If there is no mismatch, the value of
         // `mismatched_operand_index` will be the number of operands.
-        mismatched_operand_index = std::distance(operands_.begin(), mismatched_iters.first);
+        mismatched_operand_index = std::distance(operands.begin(), mismatched_iters.first);
 
-        if (mismatched_iters.first == operands_.end()) {
-            // All operand types match. As soon as we find one matching operand type list, we stop
-            // checking.
+        if (mismatched_iters.first == operands.end()) {
+            // All operand types match. As soon as we find one matching signature, we stop checking.
             break;
         } else {
             // Record the information of the mismatched operand.
             //
             // In the current implementation, we record the information about the mismatched operand
-            // from the last operand type list that encountered a mismatch. A better approach would
-            // be to record the operand type list with the highest degree of matching.
+            // from the last signature that encountered a mismatch. A better approach would be to
+            // record the signature with the highest degree of matching.
             expected_operand_type = *mismatched_iters.second;
         }
     }
 
-    if (mismatched_operand_index != operands_.size()) {
+    if (mismatched_operand_index != operands.size()) {
         // None of the operand type lists matched the user's provided operand list. Report
         // diagnostic message.
-        std::cout << "error: operand " << mismatched_operand_index + 1 << " of instruction `"
-                  << *this << "` should be of type `" << expected_operand_type << "`, but got `"
-                  << operands_[mismatched_operand_index].type() << "`\n";
+        report_error(
+            DiagnosticKind::OperandType,
+            mismatched_operand_index + 1,
+            *this,
+            expected_operand_type,
+            operands[mismatched_operand_index].type()
+        );
 
         return false;
     }
 
     // If the current instruction has an immediate operand, check if its range is valid.
     auto const imm_operand_iter =
-        std::find_if(operands_.begin(), operands_.end(), [](Operand const& operand) {
+        std::find_if(operands.begin(), operands.end(), [](Operand const& operand) {
             return operand.type() == Operand::Immediate || operand.type() == Operand::Number;
         });
 
-    if (imm_operand_iter != operands_.end()) {
+    if (imm_operand_iter != operands.end()) {
         // Get the valid range for the immediate operand of the current instruction.
         auto const valid_range = immediate_range();
         // Get the value of the immediate operand provided by the user.
@@ -287,9 +319,13 @@ auto Instruction::validate_and_emit_diagnostics() const -> bool {
 
         // Check if the immediate operand provided by the user is within the valid range.
         if (imm_value < valid_range.first || imm_value > valid_range.second) {
-            std::cout << "error: immediate operand " << *imm_operand_iter << " of instruction `"
-                      << *this << "` is out of range [" << valid_range.first << ", "
-                      << valid_range.second << "]\n";
+            report_error(
+                DiagnosticKind::ImmediateOutOfRange,
+                *imm_operand_iter,
+                *this,
+                valid_range.first,
+                valid_range.second
+            );
             return false;
         }
     }
@@ -301,45 +337,8 @@ auto Instruction::allows_label() const -> bool {
     return opcode_ != Opcode::ORIG && opcode_ != Opcode::END;
 }
 
-auto Instruction::expected_operand_types() const -> std::vector<std::vector<Operand::OperandType>> {
-    // clang-format off
-    switch (opcode_) {
-    case ADD: case AND:
-        return {
-            { Operand::Register, Operand::Register, Operand::Register  },
-            { Operand::Register, Operand::Register, Operand::Immediate },
-        };
-
-    case BRn: case BRz: case BRp: case BR: case BRzp: case BRnp: case BRnz: case BRnzp: case JSR:
-        return { { Operand::Label },
-                 { Operand::Immediate} };
-
-    case JMP: case JSRR:
-        return { { Operand::Register } };
-
-    case LD: case LDI: case LEA: case ST: case STI:
-        return { { Operand::Register, Operand::Label } };
-
-    case LDR: case STR:
-        return { { Operand::Register, Operand::Register, Operand::Immediate } };
-
-    case NOT:
-        return { { Operand::Register, Operand::Register } };
-
-    case RET: case RTI: case GETC: case OUT: case PUTS: case IN: case PUTSP: case HALT: case END:
-    default:
-        return { {} };
-
-    case TRAP: case ORIG: case FILL:
-        return { { Operand::Immediate } };
-
-    case BLKW:
-        return { { Operand::Number } };
-
-    case STRINGZ:
-        return { { Operand::StringLiteral } };
-    }
-    // clang-format on
+auto Instruction::requires_label() const -> bool {
+    return opcode_ == Opcode::EQU;
 }
 
 auto operator<<(std::ostream& out, Instruction const& instr) -> std::ostream& {
@@ -352,14 +351,15 @@ auto operator<<(std::ostream& out, Instruction const& instr) -> std::ostream& {
     out << instr.get_opcode_spelling();
 
     // Print the operand list.
-    if (instr.operand_size() != 0) {
+    Instruction::OperandRange const operands = instr.get_operands();
+    if (!operands.empty()) {
         out << ' ';
-        for (std::size_t i = 0; i != instr.operand_size(); ++i) {
+        for (std::size_t i = 0; i != operands.size(); ++i) {
             if (i != 0) {
                 out << ", ";
             }
 
-            out << instr.get_operand(i);
+            out << operands[i];
         }
     }
 
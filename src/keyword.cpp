@@ -0,0 +1,116 @@
+#include "assembler/keyword.hpp"
+
+#include "assembler/instruction.hpp"
+#include "assembler/token.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+/// An opcode or pseudo-instruction opcode, as listed in `assembler/opcode.def`.
+struct Keyword {
+    char const* spelling;
+    std::size_t length;
+    Token::TokenKind kind;
+    Instruction::Opcode opcode;
+};
+
+// clang-format off
+constexpr Keyword keywords[] = {
+#define OPCODE(name) { #name, sizeof(#name) - 1, Token::Opcode, Instruction::name },
+#define PSEUDO(name) { "." #name, sizeof("." #name) - 1, Token::Pseudo, Instruction::name },
+#include "assembler/opcode.def"
+};
+// clang-format on
+
+constexpr std::size_t keyword_count = sizeof(keywords) / sizeof(keywords[0]);
+
+/// The shortest and longest keywords (`BR` and `.STRINGZ`). Identifiers outside this range of
+/// lengths are rejected before hashing, which also guarantees that `keyword_hash` can read the
+/// first two and last two characters.
+constexpr std::size_t min_keyword_length = 2;
+constexpr std::size_t max_keyword_length = 8;
+
+/// The number of slots in the hash table. It must be a power of 2.
+constexpr unsigned table_size = 64;
+
+/// Hashes a keyword candidate of `length` characters starting at `text`, where `length` is in
+/// [min_keyword_length, max_keyword_length].
+///
+/// All LC-3 keywords are distinguished by their length together with their first two and last two
+/// characters. The multipliers were found by a brute-force search so that no two keywords share a
+/// slot; `is_perfect_hash` below verifies this at compile time, so adding a keyword to
+/// `opcode.def` that collides with another one is a compilation error.
+constexpr auto keyword_hash(char const* text, std::size_t length) -> unsigned {
+    return (static_cast<unsigned char>(text[0]) * 1u + static_cast<unsigned char>(text[1]) * 3u
+            + static_cast<unsigned char>(text[length - 2]) * 7u
+            + static_cast<unsigned char>(text[length - 1]) * 6u + static_cast<unsigned>(length))
+        & (table_size - 1);
+}
+
+// The following functions are evaluated at compile time. C++11 `constexpr` functions consist of a
+// single `return` statement, so loops are written as recursion.
+
+constexpr auto keyword_slot(std::size_t index) -> unsigned {
+    return keyword_hash(keywords[index].spelling, keywords[index].length);
+}
+
+/// Returns the index of the first keyword at or after `index` that hashes to `slot`, or
+/// `keyword_count` if there is none.
+constexpr auto find_keyword_in_slot(unsigned slot, std::size_t index) -> std::size_t {
+    return index == keyword_count ? keyword_count
+        : keyword_slot(index) == slot ? index
+                                      : find_keyword_in_slot(slot, index + 1);
+}
+
+/// Returns whether every keyword at or after `index` fits the length limits and is the only
+/// keyword in its slot.
+constexpr auto is_perfect_hash(std::size_t index) -> bool {
+    return index == keyword_count
+        || (keywords[index].length >= min_keyword_length
+            && keywords[index].length <= max_keyword_length
+            && find_keyword_in_slot(keyword_slot(index), index + 1) == keyword_count
+            && is_perfect_hash(index + 1));
+}
+
+static_assert(keyword_count < 256, "Keyword indices must fit in `std::uint8_t`.");
+static_assert(is_perfect_hash(0), "Two keywords in `opcode.def` share a slot of the hash table.");
+
+/// Maps each slot of the hash table to the index of the keyword stored there, or to `keyword_count`
+/// if the slot is empty.
+#define KEYWORD_SLOT(slot) static_cast<std::uint8_t>(find_keyword_in_slot(slot, 0))
+#define KEYWORD_SLOTS_4(slot)                                                                      \
+    KEYWORD_SLOT(slot), KEYWORD_SLOT(slot + 1), KEYWORD_SLOT(slot + 2), KEYWORD_SLOT(slot + 3)
+#define KEYWORD_SLOTS_16(slot)                                                                     \
+    KEYWORD_SLOTS_4(slot), KEYWORD_SLOTS_4(slot + 4), KEYWORD_SLOTS_4(slot + 8),                   \
+        KEYWORD_SLOTS_4(slot + 12)
+
+constexpr std::uint8_t keyword_table[table_size] = {
+    KEYWORD_SLOTS_16(0),
+    KEYWORD_SLOTS_16(16),
+    KEYWORD_SLOTS_16(32),
+    KEYWORD_SLOTS_16(48),
+};
+
+#undef KEYWORD_SLOTS_16
+#undef KEYWORD_SLOTS_4
+#undef KEYWORD_SLOT
+}  // namespace
+
+auto classify_keyword(char const* begin, char const* end) -> KeywordInfo {
+    std::size_t const length = static_cast<std::size_t>(end - begin);
+
+    if (length >= min_keyword_length && length <= max_keyword_length) {
+        std::size_t const index = keyword_table[keyword_hash(begin, length)];
+
+        if (index != keyword_count) {
+            Keyword const& keyword = keywords[index];
+            if (keyword.length == length && std::memcmp(keyword.spelling, begin, length) == 0) {
+                return { keyword.kind, keyword.opcode };
+            }
+        }
+    }
+
+    return { Token::Unknown, Instruction::UnknownOp };
+}
@@ -0,0 +1,31 @@
+#include "assembler/line_index.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#include <vector>
+
+auto LineIndex::locate(std::size_t offset) const -> SourceLocation {
+    std::call_once(line_starts_built_, [this] {
+        line_starts_.push_back(0);
+
+        char const* current = begin_;
+        while (current != end_) {
+            std::size_t const remaining = static_cast<std::size_t>(end_ - current);
+            void const* const newline = std::memchr(current, '\n', remaining);
+            if (newline == nullptr) {
+                break;
+            }
+
+            current = static_cast<char const*>(newline) + 1;
+            line_starts_.push_back(static_cast<std::size_t>(current - begin_));
+        }
+    });
+
+    // Find the last line that starts at or before `offset`.
+    auto const next_line = std::upper_bound(line_starts_.begin(), line_starts_.end(), offset);
+    auto const line = std::distance(line_starts_.begin(), next_line);
+    return { static_cast<std::size_t>(line), offset - next_line[-1] + 1 };
+}
@@ -0,0 +1,291 @@
+#include "assembler/assembler.hpp"
+
+#include "assembler/diagnostic.hpp"
+#include "assembler/instruction.hpp"
+#include "assembler/operand.hpp"
+#include "assembler/program_table.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+/// The largest number of words from the word after a row to a literal it refers to, which is the
+/// largest 9-bit offset.
+constexpr std::size_t max_literal_offset = 255;
+
+/// Returns whether execution never continues after `opcode` to the next word.
+auto is_barrier(Instruction::Opcode opcode) -> bool {
+    switch (opcode) {
+    case Instruction::BR:
+    case Instruction::BRnzp:
+    case Instruction::JMP:
+    case Instruction::RET:
+    case Instruction::RTI:
+    case Instruction::HALT:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/// Returns whether `opcode` is a data row, which only holds words, or a constant. A pool is never
+/// placed right before one, so that the words of a table stay together, and an address computed
+/// from the label of the table, such as `TABLE+3`, still refers to a word of the table.
+auto is_data(Instruction::Opcode opcode) -> bool {
+    switch (opcode) {
+    case Instruction::FILL:
+    case Instruction::BLKW:
+    case Instruction::STRINGZ:
+    case Instruction::EQU:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/// Returns the key of `literal`, which is the same for literals with the same value: the value of
+/// an integer literal, and 2^16 plus the id of the label of a label literal.
+auto literal_key(Operand const& literal) -> std::uint32_t {
+    return literal.type() == Operand::ImmediateLiteral
+        ? static_cast<std::uint16_t>(literal.literal_value())
+        : 0x10000 + literal.symbol().id();
+}
+
+/// Where the value of a literal is stored.
+struct LiteralSlot {
+    std::uint32_t pool;
+    std::uint32_t slot;
+    /// The position of the word of a placed literal, in words from the start of its section.
+    std::size_t position;
+};
+}  // namespace
+
+auto Assembler::has_literal_operand(ProgramTable::Row instr) -> bool {
+    switch (instr.get_opcode()) {
+    case Instruction::LD:
+    case Instruction::LDI:
+    case Instruction::STI:
+        return instr.get_operand(1).is_literal();
+    default:
+        return false;
+    }
+}
+
+void Assembler::place_literal_pools() {
+    literal_pools_.clear();
+    literals_.clear();
+    literal_uses_.clear();
+
+    // The literals of the pending pool, which has the index `literal_pools_.size()`, and the last
+    // slot of each literal value in the current section.
+    std::vector<Operand> pending;
+    std::unordered_map<std::uint32_t, LiteralSlot> slots;
+
+    // The positions count the words from the start of the section, including the pools placed so
+    // far, with every row at its `max_word_count()`. They may only overestimate the distances.
+    std::size_t position = 0;
+    // The largest position at which the literals of the pending pool can start, after the `BRnzp`
+    // over them if there is one, so that all of them are within reach of the rows that use them.
+    std::size_t pool_limit = 0;
+    bool placed = false;
+
+    // Places the pending pool after `row`, whose words end at `end`.
+    auto const place = [&](std::size_t row, std::size_t end, bool jump) {
+        auto const pool = static_cast<std::uint32_t>(literal_pools_.size());
+        auto const count = static_cast<std::uint32_t>(pending.size());
+        literal_pools_.push_back(
+            { static_cast<std::uint32_t>(row), static_cast<std::uint32_t>(literals_.size()), count,
+              jump }
+        );
+
+        std::size_t const first_position = end + (jump ? 1 : 0);
+        for (std::uint32_t slot = 0; slot != count; ++slot) {
+            slots[literal_key(pending[slot])] = { pool, slot, first_position + slot };
+        }
+        literals_.insert(literals_.end(), pending.begin(), pending.end());
+        pending.clear();
+
+        // The pool never takes more than a few hundred words, since it is placed within reach.
+        program_.set_word_count(
+            row,
+            static_cast<std::uint16_t>(program_.word_counts()[row] + (jump ? 1 : 0) + count)
+        );
+        position += (jump ? 1 : 0) + count;
+        placed = true;
+    };
+
+    // Places the pending pool right before `row`, after the row before it.
+    auto const place_before = [&](std::size_t row) {
+        if (!pending.empty()) {
+            // A row with a literal precedes the pending pool in the same section, so `row - 1`
+            // exists and is not a `.ORIG`.
+            place(row - 1, position, !is_barrier(program_.opcode(row - 1)));
+        }
+    };
+
+    // Returns the number of words from `row` up to the next row that the pending pool may be
+    // placed before, which is the first row after it that is not a data row.
+    auto const span_word_count = [&](std::size_t row) {
+        std::size_t count = max_word_count(row);
+        std::size_t next = row + 1;
+        for (; next != program_.size() && is_data(program_.opcode(next)); ++next) {
+            count += max_word_count(next);
+        }
+        return count;
+    };
+
+    for (std::size_t row = 0; row != program_.size(); ++row) {
+        Instruction::Opcode const opcode = program_.opcode(row);
+        if (opcode == Instruction::ORIG || opcode == Instruction::END) {
+            // The pools of a section are placed within it, and no literal is reused across
+            // sections. A section may not end with `.END`, but at the next `.ORIG`.
+            place_before(row);
+            if (opcode == Instruction::ORIG) {
+                slots.clear();
+                position = 0;
+            }
+        }
+
+        std::size_t const word_count = max_word_count(row);
+        // Placing the pending pool after the data rows that follow this row must still be
+        // possible, with a `BRnzp` over it. The data rows themselves are skipped, since the pool
+        // is never placed before one.
+        std::size_t const span = is_data(opcode) ? 0 : span_word_count(row);
+        if (!pending.empty() && !is_data(opcode) && position + span + 1 > pool_limit) {
+            place_before(row);
+        }
+
+        if (has_literal_operand(program_.row(row))) {
+            Operand const& literal = program_.operand(row, 1);
+            auto const found = slots.find(literal_key(literal));
+            bool const pending_found =
+                found != slots.end() && found->second.pool == literal_pools_.size();
+            bool const placed_found = found != slots.end() && !pending_found
+                && found->second.position + max_literal_offset >= position;
+
+            LiteralSlot slot = {};
+            if (pending_found || placed_found) {
+                slot = found->second;
+            } else {
+                // The largest position of the pending pool that keeps this literal within reach.
+                auto const limit = [&] {
+                    return position + max_literal_offset + 1 - pending.size();
+                };
+                if (position + span + 1 > limit()) {
+                    // The pending pool is full.
+                    place_before(row);
+                }
+                pool_limit = pending.empty() ? limit() : std::min(pool_limit, limit());
+
+                slot.pool = static_cast<std::uint32_t>(literal_pools_.size());
+                slot.slot = static_cast<std::uint32_t>(pending.size());
+                slots[literal_key(literal)] = slot;
+                pending.push_back(literal);
+            }
+            literal_uses_.push_back({ static_cast<std::uint32_t>(row), slot.pool, slot.slot });
+        }
+
+        position += word_count;
+        if (!pending.empty() && is_barrier(opcode)) {
+            place(row, position, false);
+        }
+    }
+
+    if (!pending.empty()) {
+        place(program_.size() - 1, position, true);
+    }
+
+    if (placed) {
+        program_.assign_addresses(program_.address(0));
+    }
+}
+
+auto Assembler::literal_pool_word_count(std::size_t row) const -> std::size_t {
+    auto const pool = std::lower_bound(
+        literal_pools_.begin(),
+        literal_pools_.end(),
+        row,
+        [](LiteralPool const& pool, std::size_t value) { return pool.row < value; }
+    );
+    if (pool == literal_pools_.end() || pool->row != row) {
+        return 0;
+    }
+    return (pool->jump ? 1 : 0) + pool->literal_count;
+}
+
+auto Assembler::translate_literal_use(
+    ProgramTable::Row instr,
+    std::vector<std::uint16_t>& results
+) const -> bool {
+    Operand const& literal = instr.get_operand(1);
+    if (literal.type() == Operand::LabelLiteral) {
+        bool found = false;
+        get_label(literal.symbol(), &found);
+        if (!found) {
+            emit_label_not_found_diag(literal, instructions_[instr.index()]);
+            return false;
+        }
+    }
+
+    auto const use = std::lower_bound(
+        literal_uses_.begin(),
+        literal_uses_.end(),
+        instr.index(),
+        [](LiteralUse const& use, std::size_t row) { return use.row < row; }
+    );
+    assert(use != literal_uses_.end() && use->row == instr.index());
+
+    // The literals are the last words of the row that hosts the pool.
+    LiteralPool const& pool = literal_pools_[use->pool];
+    auto const address = static_cast<std::uint16_t>(
+        program_.address(pool.row) + program_.word_counts()[pool.row] - pool.literal_count
+        + use->slot
+    );
+    // A pool lies out of reach only if the data rows after the row leave no place for it.
+    auto const offset = static_cast<std::int16_t>(address - instr.get_address() - 1);
+    if (offset < -256 || offset > 255) {
+        instructions_[instr.index()].report_error(
+            DiagnosticKind::LiteralOffsetOutOfRange,
+            offset,
+            literal,
+            instructions_[instr.index()]
+        );
+        return false;
+    }
+
+    std::uint16_t opcode_bits = 0x2000;
+    if (instr.get_opcode() == Instruction::LDI) {
+        opcode_bits = 0xA000;
+    } else if (instr.get_opcode() == Instruction::STI) {
+        opcode_bits = 0xB000;
+    }
+    results.push_back(static_cast<std::uint16_t>(
+        opcode_bits | instr.get_operand(0).register_id() << 9 | (offset & 0x1FF)
+    ));
+    return true;
+}
+
+void Assembler::translate_literal_pool(
+    LiteralPool const& pool,
+    std::vector<std::uint16_t>& results
+) const {
+    if (pool.jump) {
+        // BRnzp over the literals.
+        results.push_back(static_cast<std::uint16_t>(0x0E00 | pool.literal_count));
+    }
+
+    for (std::uint32_t i = 0; i != pool.literal_count; ++i) {
+        Operand const& literal = literals_[pool.first_literal + i];
+        if (literal.type() == Operand::ImmediateLiteral) {
+            results.push_back(static_cast<std::uint16_t>(literal.literal_value()));
+        } else {
+            // An undefined label has been reported by the rows that refer to it.
+            bool found = false;
+            results.push_back(get_label_value(literal.symbol(), &found));
+        }
+    }
+}
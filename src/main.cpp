@@ -1,18 +1,33 @@
 #include "CLI/CLI.hpp"
 #include "assembler/assembler.hpp"
+#include "assembler/diagnostic.hpp"
 #include "assembler/instruction.hpp"
+#include "assembler/line_index.hpp"
+#include "assembler/one_pass_assembler.hpp"
+#include "assembler/output_writer.hpp"
+#include "assembler/parallel.hpp"
+#include "assembler/parallel_parser.hpp"
 #include "assembler/parser.hpp"
+#include "assembler/section.hpp"
+#include "assembler/source.hpp"
+#include "assembler/streaming_parser.hpp"
+#include "assembler/symbol.hpp"
 #include "assembler/token.hpp"
+#include "assembler/token_stream.hpp"
 
-#include <bitset>
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <fstream>
 #include <ios>
-#include <iterator>
+#include <iostream>
+#include <istream>
+#include <map>
+#include <memory>
 #include <ostream>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace {
@@ -21,13 +36,23 @@ struct ProgramOptions {
     std::string output_file;
     bool print_tokens = false;
     bool print_instructions = false;
+    bool stream = false;
+    bool one_pass = false;
+    bool relax = false;
+    unsigned jobs = 1;
+    std::size_t max_errors = 1;
+    OutputFormat format = OutputFormat::Text;
 };
 
 auto parse_program_options(int argc, char** argv) -> ProgramOptions {
     ProgramOptions options;
 
     CLI::App app { "LC-3 Assembler" };
-    app.add_option("input_file", options.input_file, "Path to the input assembly file")->required();
+    app.add_option(
+        "input_file",
+        options.input_file,
+        "Path to the input assembly file, or '-' to read from standard input"
+    )->required();
     app.add_option("-o,--output", options.output_file, "Path to the output file");
     app.add_flag("-t,--tokens", options.print_tokens, "Print all parsed tokens and stop");
     app.add_flag(
@@ -35,6 +60,51 @@ auto parse_program_options(int argc, char** argv) -> ProgramOptions {
         options.print_instructions,
         "Print all parsed instructions and stop"
     );
+    CLI::Option* const stream = app.add_flag(
+        "--stream",
+        options.stream,
+        "Read the input in fixed-size windows instead of loading it as a whole. Tokens and "
+        "instructions are printed as soon as they are parsed"
+    );
+    CLI::Option* const one_pass = app.add_flag(
+        "--one-pass",
+        options.one_pass,
+        "Assemble each instruction as soon as it is parsed, patching references to labels that are "
+        "defined later. With --stream, words are printed as soon as they are final"
+    );
+    app.add_flag(
+        "--relax",
+        options.relax,
+        "Rewrite BR, JSR, LD, LEA, and ST instructions whose label is out of range into longer "
+        "sequences that reach it through an address stored next to them. Relaxed branches "
+        "overwrite R7, and relaxed BR, JSR, and LEA instructions set the condition codes"
+    )->excludes(one_pass);
+    app.add_option(
+        "-j,--jobs",
+        options.jobs,
+        "Number of threads used to lex, parse, and assemble the input, or 0 to use all hardware "
+        "threads"
+    )->excludes(stream);
+    app.add_option(
+        "--max-errors",
+        options.max_errors,
+        "Keep looking for errors after the first one, and stop after reporting this many errors, "
+        "or 0 to report all errors"
+    );
+    std::map<std::string, OutputFormat> const formats = {
+        { "text", OutputFormat::Text },
+        { "hex", OutputFormat::Hex },
+        { "raw", OutputFormat::Raw },
+        { "obj", OutputFormat::Object },
+    };
+    app.add_option(
+        "-f,--format",
+        options.format,
+        "Format of the assembled program: 'text' prints `(ADDR) 0101...` lines, 'hex' prints each "
+        "word as 4 hexadecimal digits, 'raw' writes the words as big-endian 16-bit integers, and "
+        "'obj' writes an LC-3 object file, which starts with the starting address. Only 'text' "
+        "can write a program with more than one section"
+    )->transform(CLI::CheckedTransformer(formats));
     app.set_help_flag("-h, --help", "Print help information");
 
     try {
@@ -46,85 +116,288 @@ auto parse_program_options(int argc, char** argv) -> ProgramOptions {
     return options;
 }
 
-/// Reads the entire content of the input stream `input` and returns it as a string.
-auto read_all(std::ifstream& input) -> std::string {
-    std::string content;
-    input.seekg(0, std::ios::end);
-    content.reserve(input.tellg());
-    input.seekg(0, std::ios::beg);
-    content.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
-    return content;
+/// Returns the name of `format` on the command line.
+auto format_name(OutputFormat format) -> char const* {
+    switch (format) {
+    case OutputFormat::Text:
+        return "text";
+    case OutputFormat::Hex:
+        return "hex";
+    case OutputFormat::Raw:
+        return "raw";
+    case OutputFormat::Object:
+        return "obj";
+    }
+    return "";
 }
-}  // namespace
 
-auto main(int argc, char** argv) -> int {
-    ProgramOptions const options = parse_program_options(argc, argv);
+/// Checks that a program of `section_count` sections can be written in `format`, and reports an
+/// error if not. Only the text format prints the address of every word. An object file has a
+/// single origin, and the hex and raw formats have none, so they hold a single section.
+auto check_section_count(OutputFormat format, std::size_t section_count) -> bool {
+    if (format != OutputFormat::Text && section_count > 1) {
+        report_error(
+            DiagnosticKind::FormatSections,
+            Diagnostic::unknown_offset,
+            Diagnostic::unknown_offset,
+            format_name(format),
+            section_count
+        );
+        return false;
+    }
+    return true;
+}
 
-    // Open the input file.
-    std::ifstream input(options.input_file);
-    if (!input) {
-        std::cerr << "error: cannot open file '" << options.input_file << "'\n";
+/// Assembles `instructions`, whose symbols are interned into `symbols`, as requested by `options`,
+/// and prints the binary representation of the program to `out`. Returns the exit code of the
+/// program.
+auto assemble_and_print(
+    std::vector<Instruction> instructions,
+    std::shared_ptr<SymbolPool> symbols,
+    ProgramOptions const& options,
+    std::ostream& out
+) -> int {
+    std::vector<std::uint16_t> binary;
+    std::vector<Section> sections;
+    std::vector<ZeroRun> zero_runs;
+
+    // Emit the binary representation of the instructions.
+    if (options.one_pass) {
+        OnePassAssembler assembler(std::move(symbols));
+        if (assembler.run(instructions)) {
+            binary = assembler.words();
+            sections = assembler.sections();
+        }
+    } else {
+        // The blocks of `.BLKW` are only expanded into zeros while they are written.
+        Assembler assembler(std::move(instructions), std::move(symbols));
+        assembler.set_keep_zero_runs(true);
+        assembler.set_relax_branches(options.relax);
+        binary = options.jobs > 1 ? assembler.run_parallel(options.jobs) : assembler.run();
+        sections = assembler.sections();
+        zero_runs = assembler.zero_runs();
+    }
+
+    // Print the binary representation of the instructions. Each section is printed at its own
+    // origin, and the addresses between sections are skipped.
+    if ((binary.empty() && zero_runs.empty())
+        || !check_section_count(options.format, sections.size())) {
         return 1;
     }
 
-    std::ofstream output_file;
-    auto& out = [&]() -> std::ostream& {
-        if (options.output_file.empty()) {
-            return std::cout;
-        } else {
-            output_file.open(options.output_file);
-            return output_file;
-        }
-    }();
+    if (options.format == OutputFormat::Object) {
+        write_object(out, sections.front().origin, std::move(binary), zero_runs);
+    } else {
+        OutputWriter(out, options.format).write(binary, zero_runs, sections);
+    }
+    return 0;
+}
 
-    if (!out) {
-        std::cerr << "error: cannot open file '"
-                  << (options.output_file.empty() ? "stdout" : options.output_file) << "'\n";
+/// Prints the parsed `instructions`, whose symbols are interned into `symbols`, if requested by
+/// `options`, and assembles them otherwise. Returns the exit code of the program.
+auto run_instructions(
+    std::vector<Instruction> instructions,
+    std::shared_ptr<SymbolPool> symbols,
+    ProgramOptions const& options,
+    std::ostream& out
+) -> int {
+    // Parsing stopped at an error, so we return an error code.
+    if (instructions.size() == 1 && instructions.front().is_unknown()) {
         return 1;
     }
 
-    // Read the source code into `source`.
-    std::string const source = read_all(input);
+    if (options.print_instructions) {
+        // The lines that the parser recovered from are errors, but their instructions are unknown.
+        if (std::any_of(instructions.begin(), instructions.end(), [](Instruction const& instr) {
+                return instr.is_unknown();
+            })) {
+            return 1;
+        }
+
+        SymbolPool::Scope const symbol_scope(symbols.get());
+        for (Instruction const& instruction : instructions) {
+            out << instruction << '\n';
+        }
+
+        return 0;
+    }
+
+    return assemble_and_print(std::move(instructions), std::move(symbols), options, out);
+}
 
-    Parser parser(source);
+/// Runs the assembler on `input` in streaming mode (`--stream`). Returns the exit code of the
+/// program.
+///
+/// Only the labels and string literals of the program are kept in memory while parsing, so
+/// printing tokens or instructions works for inputs of any size. Assembling collects all
+/// instructions before translating them, but the source code itself is never resident. With
+/// `--one-pass`, the instructions are assembled as they are parsed instead, and each word is
+/// printed as soon as it is final. The output is then incomplete if an error occurs.
+auto run_streaming(std::istream& input, ProgramOptions const& options, std::ostream& out) -> int {
+    StreamingParser parser(input);
 
     if (options.print_tokens) {
-        while (parser.next_token().kind() != Token::End) {
-            out << parser.current_token() << '\n';
+        parser.tokenize([&](Token const& token) { out << token << '\n'; });
+        return 0;
+    }
+
+    if (options.print_instructions) {
+        // Stop printing at the first line with an error.
+        bool failed = false;
+        Parser::ParseStatus const status = parser.parse_instructions([&](Instruction instr) {
+            failed = failed || instr.is_unknown();
+            if (!failed) {
+                out << instr << '\n';
+            }
+        });
+        return status == Parser::ParseStatus::Error || parser.error_count() != 0 ? 1 : 0;
+    }
+
+    if (options.one_pass) {
+        OnePassAssembler assembler(parser.symbols());
+        OutputWriter writer(out, options.format);
+        bool sections_ok = true;
+        assembler.set_sink([&](std::uint16_t origin, std::size_t index, std::uint16_t word) {
+            // Stop writing once a section that does not fit the format starts.
+            if (index == 0 && sections_ok) {
+                sections_ok = check_section_count(options.format, assembler.sections().size());
+            }
+            if (sections_ok) {
+                writer.write(origin, index, word);
+            }
+        });
+
+        bool ok = true;
+        Parser::ParseStatus const status = parser.parse_instructions([&](Instruction instr) {
+            ok = assembler.add(instr) && ok;
+        });
+
+        // The lines that the parser recovered from reach the assembler as unknown instructions,
+        // which make it fail.
+        if (status == Parser::ParseStatus::Error || !ok || !assembler.finish()) {
+            return 1;
         }
 
-        out << parser.current_token() << '\n';
-        return 0;
+        // A section without words never reaches the sink, so check the sections once more.
+        if (!sections_ok || !check_section_count(options.format, assembler.sections().size())) {
+            return 1;
+        }
+        return assembler.words().empty() ? 1 : 0;
     }
 
-    // Parse the source code into a sequence of instructions.
-    std::vector<Instruction> const instructions = parser.parse_instructions();
+    std::vector<Instruction> instructions;
+    Parser::ParseStatus const status = parser.parse_instructions([&](Instruction instr) {
+        instructions.push_back(std::move(instr));
+    });
 
-    // There was an error during parsing, so we return an error code.
-    if (instructions.size() == 1 && instructions.front().is_unknown()) {
+    if (status == Parser::ParseStatus::Error) {
         return 1;
     }
 
-    if (options.print_instructions) {
-        for (Instruction const& instruction : instructions) {
-            out << instruction << '\n';
+    return assemble_and_print(std::move(instructions), parser.symbols(), options, out);
+}
+
+/// Runs the assembler on `source`, which is held in memory as a whole. Returns the exit code of
+/// the program.
+auto run_buffered(SourceBuffer const& source, ProgramOptions options, std::ostream& out) -> int {
+    if (options.jobs == 0) {
+        options.jobs = default_thread_count();
+    }
+
+    if (source.size() > TokenStream::max_source_size) {
+        // The input is too large for the offsets of a `TokenStream`, so lex it on the fly.
+        Parser parser(source.begin(), source.end());
+
+        if (options.print_tokens) {
+            while (parser.next_token().kind() != Token::End) {
+                out << parser.current_token() << '\n';
+            }
+
+            out << parser.current_token() << '\n';
+            return 0;
+        }
+
+        std::vector<Instruction> instructions = parser.parse_instructions();
+        return run_instructions(std::move(instructions), parser.symbols(), options, out);
+    }
+
+    // Lex the whole input up front into a dense array of tokens. With multiple jobs, the input is
+    // lexed in parallel, and the instructions are parsed in parallel from the resulting tokens.
+    TokenStream const tokens(source.begin(), source.end(), options.jobs);
+
+    if (options.print_tokens) {
+        for (std::size_t i = 0; i != tokens.size(); ++i) {
+            out << tokens[i] << '\n';
         }
 
         return 0;
     }
 
-    Assembler assembler(std::move(instructions));
-    // Emit the binary representation of the instructions.
-    std::vector<std::uint16_t> const binary = assembler.run();
+    // Parse the source code into a sequence of instructions.
+    auto const symbols = std::make_shared<SymbolPool>();
+    std::vector<Instruction> instructions = options.jobs > 1
+        ? parse_parallel(tokens, symbols, options.jobs)
+        : Parser(tokens, symbols).parse_instructions();
+    return run_instructions(std::move(instructions), symbols, options, out);
+}
+}  // namespace
+
+auto main(int argc, char** argv) -> int {
+    ProgramOptions options = parse_program_options(argc, argv);
+
+    // Open the input. In streaming mode, the input is read in windows through a stream. Otherwise,
+    // regular files are mapped into memory rather than copied, and standard input is read into a
+    // buffer.
+    bool const is_stdin = options.input_file == "-";
+    std::ifstream input_file;
+    SourceBuffer source;
+
+    if (options.stream && !is_stdin) {
+        input_file.open(options.input_file, std::ios::binary);
+    }
+
+    if (options.stream ? !is_stdin && !input_file : !source.open(options.input_file)) {
+        std::cerr << "error: cannot open file '" << options.input_file << "'\n";
+        return 1;
+    }
+
+    std::ofstream output_file;
+    auto& out = [&]() -> std::ostream& {
+        if (options.output_file.empty()) {
+            return std::cout;
+        } else {
+            output_file.open(
+                options.output_file,
+                options.format == OutputFormat::Raw || options.format == OutputFormat::Object
+                    ? std::ios::binary
+                    : std::ios::out
+            );
+            return output_file;
+        }
+    }();
 
-    // Print the binary representation of the instructions.
-    if (binary.empty()) {
+    if (!out) {
+        std::cerr << "error: cannot open file '"
+                  << (options.output_file.empty() ? "stdout" : options.output_file) << "'\n";
         return 1;
     }
 
-    std::uint16_t const start_address = assembler.start_address();
-    for (std::size_t i = 0; i != binary.size(); ++i) {
-        out << '(' << std::hex << std::uppercase << start_address + i << ") "
-            << std::bitset<16>(binary[i]) << '\n';
+    // Diagnostics are collected while the input is processed, and printed once at the end. They
+    // report the line and column of errors in the source code, whose lines are only located once
+    // an error is rendered. In streaming mode, the source code is gone by then, so no locations are
+    // reported.
+    DiagnosticEngine diagnostics(
+        options.max_errors == 0 ? DiagnosticEngine::no_limit : options.max_errors
+    );
+    int exit_code = 0;
+    {
+        DiagnosticEngine::Scope const diagnostic_scope(diagnostics);
+        exit_code = options.stream ? run_streaming(is_stdin ? std::cin : input_file, options, out)
+                                   : run_buffered(source, options, out);
     }
+
+    LineIndex const line_index(source.begin(), source.end());
+    TextDiagnosticSink sink(std::cout, options.stream ? nullptr : &line_index);
+    diagnostics.flush(sink);
+    return exit_code;
 }
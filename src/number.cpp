@@ -0,0 +1,59 @@
+#include "assembler/number.hpp"
+
+#include "assembler/operand.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+auto decode_number(char const* begin, char const* end, std::int16_t* value)
+    -> OperandConstructionErrorType {
+    std::uint32_t base = 10;
+    if (begin != end) {
+        switch (*begin) {
+        case '#':
+            ++begin;
+            break;
+        case 'x':
+            base = 16;
+            ++begin;
+            break;
+        case 'b':
+            base = 2;
+            ++begin;
+            break;
+        default:
+            break;
+        }
+    }
+
+    bool const negative = begin != end && *begin == '-';
+    if (begin != end && (*begin == '+' || *begin == '-')) {
+        ++begin;
+    }
+
+    if (begin == end) {
+        return OperandConstructionErrorType::InvalidNumber;
+    }
+
+    // The magnitude saturates just above the largest valid value, so a long run of digits can
+    // neither overflow it nor needs an early exit from the loop.
+    std::uint32_t const saturation = 0x10000;
+    std::uint32_t magnitude = 0;
+    for (; begin != end; ++begin) {
+        // The lexer only accepts digits valid for the base. For '0'-'9', the low nibble is the
+        // digit and bit 6 is clear; for 'A'-'F' and 'a'-'f', the low nibble is 1-6 and bit 6 is
+        // set, which adds the missing 9.
+        std::uint32_t const ch = static_cast<unsigned char>(*begin);
+        std::uint32_t const digit = (ch & 0xF) + 9 * (ch >> 6);
+        magnitude = std::min(magnitude * base + digit, saturation);
+    }
+
+    std::uint32_t const limit = negative ? 0x8000 : 0xFFFF;
+    if (magnitude > limit) {
+        return OperandConstructionErrorType::IntegerOverflow;
+    }
+
+    std::uint32_t const bits = negative ? 0x10000 - magnitude : magnitude;
+    *value = static_cast<std::int16_t>(static_cast<std::uint16_t>(bits));
+    return OperandConstructionErrorType::NoError;
+}
@@ -0,0 +1,385 @@
+#include "assembler/one_pass_assembler.hpp"
+
+#include "assembler/assembler.hpp"
+#include "assembler/diagnostic.hpp"
+#include "assembler/expression.hpp"
+#include "assembler/instruction.hpp"
+#include "assembler/operand.hpp"
+#include "assembler/symbol.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+/// Returns the label operand of `instr`, which must have one.
+auto label_operand(Instruction const& instr) -> Operand const& {
+    Instruction::OperandRange const operands = instr.get_operands();
+    return *std::find_if(operands.begin(), operands.end(), [](Operand const& operand) {
+        return operand.type() == Operand::Label;
+    });
+}
+
+/// Returns the operand of `instr` whose value `Assembler::evaluate_expressions()` computes: an
+/// expression, or the operand of `.EQU`. Returns null if there is none.
+auto evaluated_operand(Instruction const& instr) -> Operand const* {
+    Instruction::OperandRange const operands = instr.get_operands();
+    if (instr.get_opcode() == Instruction::EQU) {
+        return &operands.front();
+    }
+
+    auto const expression = std::find_if(operands.begin(), operands.end(), [](Operand const& op) {
+        return op.type() == Operand::Expression;
+    });
+    return expression != operands.end() ? &*expression : nullptr;
+}
+
+/// Returns the width of the PC-relative field that the label operand of `instr` is translated to.
+auto label_offset_bits(Instruction const& instr) -> unsigned {
+    return instr.get_opcode() == Instruction::JSR ? 11 : 9;
+}
+}  // namespace
+
+constexpr std::uint32_t OnePassAssembler::no_fixup;
+
+OnePassAssembler::OnePassAssembler(std::shared_ptr<SymbolPool> symbols) :
+    assembler_({}, std::move(symbols)) { }
+
+auto OnePassAssembler::add(Instruction const& instr) -> bool {
+    if (stopped_ || finished_) {
+        return !failed_;
+    }
+
+    SymbolPool::Scope const symbol_scope(assembler_.symbols_.get());
+    assemble(instr);
+    if (stopped_) {
+        return false;
+    }
+
+    flush();
+    return !failed_;
+}
+
+auto OnePassAssembler::run(std::vector<Instruction> const& instructions) -> bool {
+    for (Instruction const& instr : instructions) {
+        if (!add(instr) && stopped_) {
+            return false;
+        }
+    }
+
+    return finish();
+}
+
+auto OnePassAssembler::finish() -> bool {
+    if (stopped_ || finished_) {
+        return !failed_;
+    }
+
+    finished_ = true;
+    SymbolPool::Scope const symbol_scope(assembler_.symbols_.get());
+
+    // The fixups that are still pending refer to labels that are never defined, unless they are
+    // defined after the addresses became unknown. Like `Assembler::report_undefined_labels()`,
+    // report them in order, followed by the instructions after that point, which come later.
+    for (std::size_t index = first_pending_fixup_; index != fixups_.size(); ++index) {
+        Fixup const& fixup = fixups_[index];
+        Operand const& operand = label_operand(fixup.instr);
+        if (fixup.word != no_fixup && !is_defined(operand.symbol())) {
+            Assembler::emit_label_not_found_diag(operand, fixup.instr);
+            if (!fail()) {
+                return false;
+            }
+        }
+    }
+
+    auto const defined = [this](Symbol label) { return is_defined(label); };
+    for (Instruction const& instr : unresolved_) {
+        for (Operand const& operand : instr.get_operands()) {
+            if (Assembler::refers_to_undefined_label(operand, defined)) {
+                Assembler::emit_label_not_found_diag(operand, instr);
+                if (!fail()) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    if (!validate_only_ && !failed_) {
+        std::vector<Instruction const*> origs;
+        for (Instruction const& orig : origs_) {
+            origs.push_back(&orig);
+        }
+        if (!Assembler::check_overlaps(sections_, origs)) {
+            fail();
+        }
+    }
+
+    flush();
+    return !failed_;
+}
+
+auto OnePassAssembler::fail() -> bool {
+    failed_ = true;
+    stopped_ = error_limit_reached();
+    return !stopped_;
+}
+
+void OnePassAssembler::assemble(Instruction const& instr) {
+    // After an invalid instruction, whose size is unknown, or a missing `.ORIG`, the addresses are
+    // unknown. Like `Assembler::run()`, only validate the remaining instructions then.
+    if (!instr.validate_and_emit_diagnostics()) {
+        validate_only_ = true;
+        fail();
+        return;
+    }
+
+    if (!validate_only_ && !started_) {
+        if (instr.get_opcode() != Instruction::ORIG) {
+            Assembler::emit_missing_orig_diag(instr);
+            validate_only_ = true;
+            if (!fail()) {
+                return;
+            }
+        } else {
+            started_ = true;
+            origin_ = instr.get_operand(0).immediate_value();
+        }
+    }
+
+    // The labels are still recorded, so that `finish()` can report those that are never defined.
+    if (validate_only_) {
+        record_labels(instr);
+        return;
+    }
+
+    if (instr.get_opcode() == Instruction::ORIG) {
+        // Every `.ORIG` starts a new section at its operand.
+        address_ = static_cast<std::uint16_t>(instr.get_operand(0).immediate_value());
+        sections_.push_back({ address_, words_.size(), 0 });
+        origs_.push_back(instr);
+    }
+
+    // A constant, or an expression, is evaluated from the labels defined so far. If one of them is
+    // defined later, the instruction is rejected below, and a constant is left undefined.
+    std::uint16_t const address = address_;
+    bool const is_constant = instr.get_opcode() == Instruction::EQU;
+    Operand const* const evaluated = evaluated_operand(instr);
+    std::uint16_t value = 0;
+    bool const known = evaluated == nullptr || evaluate(*evaluated, &value);
+
+    if (instr.has_label() && (known || !is_constant)) {
+        // Like the address of a label, the entry of a constant is one more than its value.
+        define_label(instr, is_constant ? static_cast<std::uint16_t>(value + 1) : address);
+        if (stopped_) {
+            return;
+        }
+    }
+
+    // The translation functions read the instruction from the program table, which holds only
+    // this instruction.
+    std::vector<Instruction>& current = assembler_.instructions_;
+    current.assign(1, instr);
+    current.front().set_address(address);
+    assembler_.program_.assign(current);
+    assembler_.program_.set_address(0, address);
+
+    std::size_t const word = words_.size();
+    bool ok = false;
+    // The label that the instruction refers to before its definition, if any. A label in a `.FILL`
+    // is patched like a PC-relative field.
+    Symbol label;
+    if (Assembler::has_literal_operand(assembler_.program_.row(0))) {
+        // The pools of the literals are placed by `Assembler::place_literal_pools()`, which needs
+        // the rows after this one.
+        instr.report_error(DiagnosticKind::LiteralInOnePass, instr.get_operand(1), instr);
+    } else if (!known) {
+        instr.report_error(DiagnosticKind::ExpressionInOnePass, *evaluated, instr);
+    } else {
+        ok = assembler_.translate_row_forward(assembler_.program_.row(0), words_, &label);
+    }
+
+    if (!ok) {
+        // Keep the addresses of the following instructions by emitting a placeholder word, unless
+        // the instruction is a constant, which takes none.
+        if (instr.get_opcode() != Instruction::EQU) {
+            words_.push_back(0);
+        }
+        if (!fail()) {
+            return;
+        }
+    }
+
+    if (!label.empty()) {
+        // The pool grows as instructions are parsed, and the array with it.
+        if (label.id() >= pending_fixups_.size()) {
+            pending_fixups_.resize(assembler_.symbols_->size(), no_fixup);
+        }
+
+        Fixup const fixup = {
+            current.front(),
+            static_cast<std::uint32_t>(word),
+            pending_fixups_[label.id()],
+        };
+        fixups_.push_back(fixup);
+        pending_fixups_[label.id()] = static_cast<std::uint32_t>(fixups_.size() - 1);
+    }
+
+    // `.ORIG` emits no words, but occupies one like in `Assembler::assign_addresses()`. Every other
+    // instruction occupies the words it emits.
+    std::size_t const word_count =
+        instr.get_opcode() == Instruction::ORIG ? 1 : words_.size() - word;
+    address_ = static_cast<std::uint16_t>(address + word_count);
+    sections_.back().word_count = words_.size() - sections_.back().first_word;
+}
+
+void OnePassAssembler::define_label(Instruction const& instr, std::uint16_t address) {
+    Symbol const label = instr.get_label_symbol();
+    if (!assembler_.add_label(label, address)) {
+        // The label keeps its first definition.
+        Assembler::emit_label_redefinition_diag(instr);
+        fail();
+        return;
+    }
+
+    if (label.id() >= pending_fixups_.size()) {
+        return;
+    }
+
+    std::uint32_t index = pending_fixups_[label.id()];
+    pending_fixups_[label.id()] = no_fixup;
+    for (; index != no_fixup; index = fixups_[index].next) {
+        if (!patch(fixups_[index], address) && !fail()) {
+            return;
+        }
+    }
+}
+
+void OnePassAssembler::record_labels(Instruction const& instr) {
+    if (instr.has_label()) {
+        Symbol const label = instr.get_label_symbol();
+        if (label.id() >= unaddressed_labels_.size()) {
+            unaddressed_labels_.resize(assembler_.symbols_->size(), false);
+        }
+        unaddressed_labels_[label.id()] = true;
+    }
+
+    Instruction::OperandRange const operands = instr.get_operands();
+    auto const defined = [this](Symbol label) { return is_defined(label); };
+    if (std::any_of(operands.begin(), operands.end(), [&](Operand const& operand) {
+            return Assembler::refers_to_undefined_label(operand, defined);
+        })) {
+        unresolved_.push_back(instr);
+    }
+}
+
+auto OnePassAssembler::is_defined(Symbol label) const -> bool {
+    bool found = false;
+    assembler_.get_label(label, &found);
+    return found || (label.id() < unaddressed_labels_.size() && unaddressed_labels_[label.id()]);
+}
+
+auto OnePassAssembler::evaluate(Operand const& operand, std::uint16_t* value) -> bool {
+    bool found = true;
+    switch (operand.type()) {
+    case Operand::Immediate:
+        *value = static_cast<std::uint16_t>(operand.immediate_value());
+        return true;
+    case Operand::Number:
+        *value = static_cast<std::uint16_t>(operand.regular_decimal());
+        return true;
+    case Operand::Label:
+        *value = assembler_.get_label_value(operand.symbol(), &found);
+        return found;
+    default:
+        break;
+    }
+
+    // The text of the expression has been checked when the operand was constructed.
+    std::string const& text = operand.symbol().str();
+    std::vector<ExpressionTerm> terms;
+    parse_expression(text.data(), text.data() + text.size(), &terms);
+
+    std::uint16_t sum = 0;
+    for (ExpressionTerm const& term : terms) {
+        auto term_value = static_cast<std::uint16_t>(term.payload);
+        if (term.is_label) {
+            term_value = assembler_.get_label_value(Symbol::from_id(term.payload), &found);
+            if (!found) {
+                return false;
+            }
+        }
+        sum = static_cast<std::uint16_t>(term.negative ? sum - term_value : sum + term_value);
+    }
+
+    // Store the value like `Assembler::evaluate_expressions()` does, so that the operand is
+    // translated like a label.
+    assembler_.symbol_entry(operand.symbol()) = static_cast<std::uint16_t>(sum + 1);
+    *value = sum;
+    return true;
+}
+
+auto OnePassAssembler::patch(Fixup& fixup, std::uint16_t label_address) -> bool {
+    if (fixup.instr.get_opcode() == Instruction::FILL) {
+        // The word holds the address that the label is loaded at, rather than an offset.
+        words_[fixup.word] = static_cast<std::uint16_t>(label_address - 1);
+        fixup.word = no_fixup;
+        return true;
+    }
+
+    unsigned const bits = label_offset_bits(fixup.instr);
+    auto const offset =
+        static_cast<std::int16_t>(label_address - fixup.instr.get_address() - 1);
+
+    auto const max_offset = (1 << (bits - 1)) - 1;
+    auto const min_offset = -(1 << (bits - 1));
+
+    if (offset < min_offset || offset > max_offset) {
+        Assembler::emit_label_offset_out_of_range_diag(
+            label_operand(fixup.instr),
+            fixup.instr,
+            offset
+        );
+        // The fixup is resolved with an error, so it is not reported as undefined again.
+        fixup.word = no_fixup;
+        return false;
+    }
+
+    // The field was translated with an offset of 0, so the offset only needs to be added.
+    words_[fixup.word] |= static_cast<std::uint16_t>(offset & ((1 << bits) - 1));
+    fixup.word = no_fixup;
+    return true;
+}
+
+void OnePassAssembler::flush() {
+    while (first_pending_fixup_ != fixups_.size()
+           && fixups_[first_pending_fixup_].word == no_fixup) {
+        ++first_pending_fixup_;
+    }
+
+    if (first_pending_fixup_ == fixups_.size()) {
+        // Every fixup has been resolved, so no label refers to them anymore.
+        fixups_.clear();
+        first_pending_fixup_ = 0;
+    }
+
+    // The words of an invalid program are not passed on.
+    if (!sink_ || failed_) {
+        return;
+    }
+
+    std::size_t const end =
+        fixups_.empty() ? words_.size() : fixups_[first_pending_fixup_].word;
+    for (; flushed_ != end; ++flushed_) {
+        while (flushed_section_ + 1 != sections_.size()
+               && sections_[flushed_section_ + 1].first_word <= flushed_) {
+            ++flushed_section_;
+        }
+
+        Section const& section = sections_[flushed_section_];
+        sink_(section.origin, flushed_ - section.first_word, words_[flushed_]);
+    }
+}
@@ -2,12 +2,36 @@
 
 #include "assembler-c/operand.h"
 
-#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <ostream>
+#include <string>
 #include <type_traits>
 
+constexpr unsigned Operand::type_bits;
+constexpr std::uint32_t Operand::type_mask;
+
+auto operator<<(std::ostream& out, OperandConstructionErrorType error) -> std::ostream& {
+    out << "OperandConstructionErrorType::";
+
+    switch (error) {
+    case OperandConstructionErrorType::NoError:
+        return out << "NoError";
+    case OperandConstructionErrorType::InvalidTokenKind:
+        return out << "InvalidTokenKind";
+    case OperandConstructionErrorType::InvalidNumber:
+        return out << "InvalidNumber";
+    case OperandConstructionErrorType::IntegerOverflow:
+        return out << "IntegerOverflow";
+    case OperandConstructionErrorType::MissingQuote:
+        return out << "MissingQuote";
+    case OperandConstructionErrorType::InvalidExpression:
+        return out << "InvalidExpression";
+    default:
+        return out << "Unknown";
+    }
+}
+
 auto operator<<(std::ostream& out, Operand::OperandType operand_type) -> std::ostream& {
     switch (operand_type) {
     case Operand::Register:
@@ -20,6 +44,12 @@ auto operator<<(std::ostream& out, Operand::OperandType operand_type) -> std::os
         return out << "Label";
     case Operand::StringLiteral:
         return out << "StringLiteral";
+    case Operand::ImmediateLiteral:
+        return out << "ImmediateLiteral";
+    case Operand::LabelLiteral:
+        return out << "LabelLiteral";
+    case Operand::Expression:
+        return out << "Expression";
     default:
         return out << "UnknownOperandType";
     }
@@ -43,6 +73,16 @@ auto operator<<(std::ostream& out, Operand const& operand) -> std::ostream& {
     case Operand::StringLiteral:
         return out << '"' << operand.string_literal() << '"';
 
+    case Operand::ImmediateLiteral:
+        // Like immediates, integer literals are printed in decimal form.
+        return out << "=#" << operand.literal_value();
+
+    case Operand::LabelLiteral:
+        return out << '=' << operand.label();
+
+    case Operand::Expression:
+        return out << operand.label();
+
     default:
         return out << "UnknownOperand";
     }
@@ -78,30 +118,15 @@ auto operand_get_regular_decimal(OperandRef operand) -> std::int16_t {
 }
 
 auto operand_get_label(OperandRef operand, std::size_t* length) -> char const* {
-    static_assert(
-        std::is_standard_layout<Operand>::value,
-        "Operand must be standard layout to support the implementation of this function."
-    );
-
-    // This function requires us to get a pointer to the string stored inside `Operand`. We cannot
-    // call the `label()` member function and return its `data()` pointer, as the `std::string`
-    // returned by `label()` will be destroyed after the function ends.
-    //
-    // We need to read the value of `string_content_` directly. One approach is to add a `public`
-    // interface to get the content of the original `string_content_` member. Another approach is to
-    // add this function as a friend of `Operand`.
-    //
-    // Here we try a trick. We have already determined that `Operand` is a standard layout type, so
-    // `Operand` and its first non-static data member are pointer-interconvertible, and `union` and
-    // its non-static data members are also pointer-interconvertible. Therefore, we can safely use
-    // `reinterpret_cast` to convert a pointer to an `Operand` object to a pointer to
-    // `string_content_`.
-    auto const string_content =
-        *reinterpret_cast<std::array<char const*, 2> const*>(&unwrap(operand));
-    *length = string_content[1] - string_content[0];
-    return string_content[0];
+    // The label is owned by the pool of interned symbols, so the pointer remains valid after this
+    // function returns.
+    std::string const& label = unwrap(operand).label();
+    *length = label.size();
+    return label.data();
 }
 
 auto operand_get_string_literal(OperandRef operand, std::size_t* length) -> char const* {
-    return operand_get_label(operand, length);
+    std::string const& string_literal = unwrap(operand).string_literal();
+    *length = string_literal.size();
+    return string_literal.data();
 }
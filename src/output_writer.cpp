@@ -0,0 +1,232 @@
+#include "assembler/output_writer.hpp"
+
+#include "assembler/section.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <vector>
+
+constexpr std::size_t OutputWriter::buffer_size;
+
+namespace {
+/// The longest line of any format: a parenthesized address of up to 16 hexadecimal digits, a space,
+/// 16 binary digits, and a newline.
+constexpr std::size_t max_line_size = 48;
+
+/// The digits of every byte. A table for all 2^16 words would take 1 MiB and keep little of it in
+/// the cache, so each word is looked up as two bytes instead.
+struct DigitTable {
+    char binary[256][8];
+    char hex[256][2];
+
+    DigitTable() {
+        char const digits[] = "0123456789ABCDEF";
+        for (unsigned byte = 0; byte != 256; ++byte) {
+            for (unsigned bit = 0; bit != 8; ++bit) {
+                binary[byte][bit] = (byte >> (7 - bit)) & 1 ? '1' : '0';
+            }
+            hex[byte][0] = digits[byte >> 4];
+            hex[byte][1] = digits[byte & 0xF];
+        }
+    }
+};
+
+auto digit_table() -> DigitTable const& {
+    static DigitTable const table;
+    return table;
+}
+
+/// Stores the big-endian representation of `word` at `out`, and returns the end of it.
+auto write_big_endian(char* out, std::uint16_t word) -> char* {
+    out[0] = static_cast<char>(word >> 8);
+    out[1] = static_cast<char>(word & 0xFF);
+    return out + 2;
+}
+
+/// Returns whether the host stores integers with the least significant byte first.
+auto is_little_endian() -> bool {
+    std::uint16_t const probe = 1;
+    unsigned char first_byte = 0;
+    std::memcpy(&first_byte, &probe, 1);
+    return first_byte == 1;
+}
+
+/// Writes `address` in uppercase hexadecimal without leading zeros to `out`, and returns the end of
+/// the written digits.
+auto write_address(char* out, std::size_t address) -> char* {
+    char digits[2 * sizeof(std::size_t)];
+    char* first = digits + sizeof(digits);
+    do {
+        *--first = "0123456789ABCDEF"[address & 0xF];
+        address >>= 4;
+    } while (address != 0);
+
+    std::size_t const length = static_cast<std::size_t>(digits + sizeof(digits) - first);
+    std::memcpy(out, first, length);
+    return out + length;
+}
+}  // namespace
+
+OutputWriter::OutputWriter(std::ostream& out, OutputFormat format) :
+    out_(&out), format_(format), buffer_(new char[buffer_size]) {
+    digit_table();
+}
+
+OutputWriter::~OutputWriter() {
+    flush();
+}
+
+void OutputWriter::write(std::uint16_t start_address, std::size_t index, std::uint16_t word) {
+    if (buffer_size - size_ < max_line_size) {
+        flush();
+    }
+    if (format_ == OutputFormat::Object && index == 0) {
+        write_big_endian(buffer_.get() + size_, start_address);
+        size_ += 2;
+    }
+    append(start_address + index, word);
+}
+
+void OutputWriter::write(std::uint16_t start_address, std::vector<std::uint16_t> const& words) {
+    for (std::size_t i = 0; i != words.size(); ++i) {
+        write(start_address, i, words[i]);
+    }
+}
+
+void OutputWriter::write_zeros(std::uint16_t start_address, std::size_t index, std::size_t count) {
+    if (format_ != OutputFormat::Raw && format_ != OutputFormat::Object) {
+        for (; count != 0; ++index, --count) {
+            write(start_address, index, 0);
+        }
+        return;
+    }
+
+    if (count != 0 && index == 0) {
+        // Let `write()` put the starting address of an object file first.
+        write(start_address, 0, 0);
+        --count;
+    }
+
+    for (std::size_t size = 2 * count; size != 0;) {
+        if (size_ == buffer_size) {
+            flush();
+        }
+        std::size_t const length = std::min(size, buffer_size - size_);
+        std::memset(buffer_.get() + size_, 0, length);
+        size_ += length;
+        size -= length;
+    }
+}
+
+void OutputWriter::write(
+    std::vector<std::uint16_t> const& words,
+    std::vector<ZeroRun> const& zero_runs,
+    std::vector<Section> const& sections
+) {
+    std::vector<ZeroRun>::const_iterator run = zero_runs.begin();
+    std::size_t stored = 0;
+    for (Section const& section : sections) {
+        std::size_t const end = section.first_word + section.word_count;
+        for (std::size_t index = section.first_word; index != end;) {
+            while (run != zero_runs.end() && run->first_word + run->word_count <= index) {
+                ++run;
+            }
+
+            if (run != zero_runs.end() && run->first_word <= index) {
+                // A run that reaches into the next section is split at its end.
+                std::size_t const run_end = std::min(run->first_word + run->word_count, end);
+                write_zeros(section.origin, index - section.first_word, run_end - index);
+                index = run_end;
+                continue;
+            }
+
+            std::size_t const next =
+                run != zero_runs.end() ? std::min(run->first_word, end) : end;
+            for (; index != next; ++index, ++stored) {
+                write(section.origin, index - section.first_word, words[stored]);
+            }
+        }
+    }
+}
+
+void OutputWriter::flush() {
+    if (size_ != 0) {
+        out_->write(buffer_.get(), static_cast<std::streamsize>(size_));
+        size_ = 0;
+    }
+}
+
+void OutputWriter::append(std::size_t address, std::uint16_t word) {
+    DigitTable const& table = digit_table();
+    char* out = buffer_.get() + size_;
+    unsigned const high = word >> 8;
+    unsigned const low = word & 0xFF;
+
+    switch (format_) {
+    case OutputFormat::Text:
+        *out++ = '(';
+        out = write_address(out, address);
+        *out++ = ')';
+        *out++ = ' ';
+        std::memcpy(out, table.binary[high], 8);
+        std::memcpy(out + 8, table.binary[low], 8);
+        out += 16;
+        *out++ = '\n';
+        break;
+    case OutputFormat::Hex:
+        std::memcpy(out, table.hex[high], 2);
+        std::memcpy(out + 2, table.hex[low], 2);
+        out[4] = '\n';
+        out += 5;
+        break;
+    case OutputFormat::Raw:
+    case OutputFormat::Object:
+        out = write_big_endian(out, word);
+        break;
+    }
+
+    size_ = static_cast<std::size_t>(out - buffer_.get());
+}
+
+void write_object(
+    std::ostream& out,
+    std::uint16_t origin,
+    std::vector<std::uint16_t> words,
+    std::vector<ZeroRun> const& zero_runs
+) {
+    if (is_little_endian()) {
+        for (std::uint16_t& word : words) {
+            word = static_cast<std::uint16_t>(word >> 8 | word << 8);
+        }
+    }
+
+    char header[2];
+    write_big_endian(header, origin);
+    out.write(header, sizeof(header));
+
+    // The number of words of `words` that have been written.
+    std::size_t stored = 0;
+    auto const write_words = [&](std::size_t end) {
+        out.write(
+            reinterpret_cast<char const*>(words.data() + stored),
+            static_cast<std::streamsize>((end - stored) * sizeof(std::uint16_t))
+        );
+        stored = end;
+    };
+
+    static char const zeros[4096] = {};
+    std::size_t zero_count = 0;
+    for (ZeroRun const& run : zero_runs) {
+        write_words(run.first_word - zero_count);
+        for (std::size_t size = run.word_count * sizeof(std::uint16_t); size != 0;) {
+            std::size_t const length = std::min(size, sizeof(zeros));
+            out.write(zeros, static_cast<std::streamsize>(length));
+            size -= length;
+        }
+        zero_count += run.word_count;
+    }
+    write_words(words.size());
+}
@@ -0,0 +1,177 @@
+#include "assembler/parallel.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+auto default_thread_count() -> unsigned {
+    return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+namespace {
+/// The calls of one `parallel_for()`. The threads of the pool and the caller take its indices one
+/// by one, under the mutex of the pool.
+struct Batch {
+    std::function<void(std::size_t)> const* task;
+    std::size_t count;
+    /// The next index that no thread has taken yet.
+    std::size_t next;
+    /// The number of calls that have returned.
+    std::size_t finished;
+};
+
+/// The threads that run the calls of `parallel_for()`. They are started with the first call that
+/// needs them, and wait for further batches until the program exits, so a pass over a program
+/// does not pay for starting and joining its threads.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned thread_count) {
+        threads_.reserve(thread_count);
+        for (unsigned index = 0; index != thread_count; ++index) {
+            threads_.emplace_back([this] { work(); });
+        }
+    }
+
+    ThreadPool(ThreadPool const&) = delete;
+    auto operator=(ThreadPool const&) -> ThreadPool& = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> const lock(mutex_);
+            stopping_ = true;
+        }
+        work_available_.notify_all();
+        for (std::thread& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    /// Returns the pool of `default_thread_count() - 1` threads, since the caller of
+    /// `parallel_for()` takes calls as well.
+    static auto instance() -> ThreadPool& {
+        static ThreadPool pool(default_thread_count() - 1);
+        return pool;
+    }
+
+    void run(std::size_t count, std::function<void(std::size_t)> const& task) {
+        Batch batch { &task, count, 0, 0 };
+        std::unique_lock<std::mutex> lock(mutex_);
+        batches_.push_back(&batch);
+        work_available_.notify_all();
+
+        // The caller takes the calls of its own batch too, so a task that calls `parallel_for()`
+        // does not wait for threads that are all busy waiting as well.
+        while (batch.next != batch.count) {
+            run_next(batch, lock);
+        }
+        batch_finished_.wait(lock, [&] { return batch.finished == batch.count; });
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable work_available_;
+    std::condition_variable batch_finished_;
+    /// The batches with indices that no thread has taken yet, oldest first.
+    std::deque<Batch*> batches_;
+    bool stopping_ = false;
+    std::vector<std::thread> threads_;
+
+    void work() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            work_available_.wait(lock, [this] { return stopping_ || !batches_.empty(); });
+            if (batches_.empty()) {
+                return;
+            }
+            run_next(*batches_.front(), lock);
+        }
+    }
+
+    /// Takes the next index of `batch`, and calls its task with `lock` released.
+    void run_next(Batch& batch, std::unique_lock<std::mutex>& lock) {
+        std::size_t const index = batch.next++;
+        if (batch.next == batch.count) {
+            batches_.erase(std::find(batches_.begin(), batches_.end(), &batch));
+        }
+
+        lock.unlock();
+        (*batch.task)(index);
+        lock.lock();
+
+        // The caller may return as soon as the last call is counted, so `batch` must not be used
+        // after this.
+        if (++batch.finished == batch.count) {
+            batch_finished_.notify_all();
+        }
+    }
+};
+}  // namespace
+
+void parallel_for(std::size_t count, std::function<void(std::size_t)> const& task) {
+    if (count == 0) {
+        return;
+    }
+    if (count == 1) {
+        task(0);
+        return;
+    }
+
+    ThreadPool::instance().run(count, task);
+}
+
+auto split_range(std::size_t size, std::size_t chunk_count, std::size_t min_chunk_size)
+    -> std::vector<std::size_t> {
+    chunk_count = std::max<std::size_t>(
+        std::min(chunk_count, size / std::max<std::size_t>(min_chunk_size, 1)),
+        1
+    );
+
+    // The first `size % chunk_count` chunks get one index more than the others.
+    std::vector<std::size_t> boundaries;
+    boundaries.reserve(chunk_count + 1);
+    for (std::size_t i = 0; i <= chunk_count; ++i) {
+        boundaries.push_back(size / chunk_count * i + std::min(i, size % chunk_count));
+    }
+
+    return boundaries;
+}
+
+auto split_lines(
+    char const* begin,
+    char const* end,
+    std::size_t chunk_count,
+    std::size_t min_chunk_size
+) -> std::vector<char const*> {
+    std::size_t const size = static_cast<std::size_t>(end - begin);
+    chunk_count = std::max<std::size_t>(
+        std::min(chunk_count, size / std::max<std::size_t>(min_chunk_size, 1)),
+        1
+    );
+
+    std::vector<char const*> boundaries;
+    boundaries.reserve(chunk_count + 1);
+    boundaries.push_back(begin);
+
+    for (std::size_t i = 1; i < chunk_count; ++i) {
+        // Move the evenly spaced split point to the beginning of the next line. A very long line
+        // may swallow several split points, in which case fewer chunks are produced.
+        char const* const target = std::max(begin + size / chunk_count * i, boundaries.back());
+        char const* const newline = std::find(target, end, '\n');
+        if (newline == end) {
+            break;
+        }
+
+        boundaries.push_back(newline + 1);
+    }
+
+    if (boundaries.back() != end || boundaries.size() == 1) {
+        boundaries.push_back(end);
+    }
+
+    return boundaries;
+}
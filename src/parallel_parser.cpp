@@ -0,0 +1,168 @@
+#include "assembler/parallel_parser.hpp"
+
+#include "assembler/diagnostic.hpp"
+#include "assembler/instruction.hpp"
+#include "assembler/parallel.hpp"
+#include "assembler/parser.hpp"
+#include "assembler/symbol.hpp"
+#include "assembler/token.hpp"
+#include "assembler/token_stream.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace {
+/// Returns whether the tokens with indices in [0, boundary) may be parsed separately from the
+/// tokens after them, where `boundary` is just past a `Token::EOL`.
+///
+/// Instructions occupy a single line, except that `Parser::parse_instruction()` joins a label to
+/// the opcode after it across any number of EOLs. A chunk must therefore not end with a label
+/// followed only by EOLs. This also rejects some boundaries after label operands (such as
+/// `BR LOOP`), which only moves the boundary a little further.
+auto is_valid_boundary(TokenStream const& tokens, std::size_t boundary) -> bool {
+    std::size_t last = boundary;
+    while (last != 0 && tokens.kind(last - 1) == Token::EOL) {
+        --last;
+    }
+
+    return last == 0 || tokens.kind(last - 1) != Token::Label;
+}
+
+/// Splits `tokens` into at most `chunk_count` chunks of complete lines that can be parsed
+/// independently, each containing at least `min_chunk_size` tokens if possible. Returns the
+/// boundaries of the chunks as token indices, like `split_lines()`.
+auto split_token_lines(
+    TokenStream const& tokens,
+    std::size_t chunk_count,
+    std::size_t min_chunk_size
+) -> std::vector<std::size_t> {
+    std::size_t const size = tokens.size();
+    chunk_count = std::max<std::size_t>(
+        std::min(chunk_count, size / std::max<std::size_t>(min_chunk_size, 1)),
+        1
+    );
+
+    std::vector<std::size_t> boundaries;
+    boundaries.reserve(chunk_count + 1);
+    boundaries.push_back(0);
+
+    for (std::size_t i = 1; i < chunk_count; ++i) {
+        std::size_t current = std::max(size / chunk_count * i, boundaries.back());
+
+        // Move forward to the first valid boundary after an EOL.
+        while (true) {
+            while (current != size && tokens.kind(current) != Token::EOL) {
+                ++current;
+            }
+            if (current == size || is_valid_boundary(tokens, current + 1)) {
+                break;
+            }
+            ++current;
+        }
+
+        if (current == size || current + 1 == size) {
+            break;
+        }
+
+        boundaries.push_back(current + 1);
+    }
+
+    boundaries.push_back(size);
+    return boundaries;
+}
+
+/// Returns whether the first token at or after `index` that is not a `Token::EOL` is `.ORIG`, so
+/// that a program that ended with `.END` before `index` continues there.
+auto starts_section(TokenStream const& tokens, std::size_t index) -> bool {
+    while (index != tokens.size() && tokens.kind(index) == Token::EOL) {
+        ++index;
+    }
+
+    return index != tokens.size() && tokens.kind(index) == Token::Pseudo
+        && tokens.record(index).flags == Instruction::ORIG;
+}
+
+/// The result of parsing one chunk.
+struct ChunkResult {
+    std::vector<Instruction> instructions;
+    Parser::ParseStatus status;
+    /// Whether the parser stopped at the end of the chunk after `.END`, so that the program
+    /// continues if the next chunk starts with `.ORIG`.
+    bool ends_after_end;
+    std::size_t error_count;
+    /// The diagnostics reported while parsing the chunk.
+    DiagnosticEngine diagnostics;
+};
+}  // namespace
+
+auto parse_parallel(
+    TokenStream const& tokens,
+    std::shared_ptr<SymbolPool> const& symbols,
+    unsigned thread_count,
+    std::size_t min_chunk_size
+) -> std::vector<Instruction> {
+    std::vector<std::size_t> const boundaries =
+        split_token_lines(tokens, thread_count, min_chunk_size);
+    std::size_t const chunk_count = boundaries.size() - 1;
+
+    // Each chunk may report as many errors as the caller, since it cannot know how many errors the
+    // chunks before it report.
+    std::size_t const max_errors = remaining_errors();
+
+    std::vector<ChunkResult> chunks(chunk_count);
+    parallel_for(chunk_count, [&](std::size_t index) {
+        ChunkResult& chunk = chunks[index];
+        chunk.diagnostics = DiagnosticEngine(max_errors);
+        DiagnosticEngine::Scope const diagnostic_scope(chunk.diagnostics);
+
+        Parser parser(tokens, boundaries[index], boundaries[index + 1], symbols);
+        chunk.status = parser.parse_instructions([&](Instruction instr) {
+            chunk.instructions.push_back(std::move(instr));
+        });
+        chunk.ends_after_end = chunk.status == Parser::ParseStatus::EndPseudo
+            && parser.current_token().kind() == Token::End;
+        chunk.error_count = parser.error_count();
+    });
+
+    // Concatenate the chunks in source order, until reaching the `.END` that ends the program or
+    // the error limit. The chunks after that would not have been parsed by a serial parser, so
+    // their results are dropped. A chunk that starts with `.ORIG` after `.END` was parsed just
+    // like a serial parser would have continued.
+    std::size_t instruction_count = 0;
+    for (ChunkResult const& chunk : chunks) {
+        instruction_count += chunk.instructions.size();
+    }
+
+    std::vector<Instruction> instructions;
+    instructions.reserve(instruction_count);
+    for (std::size_t index = 0; index != chunk_count; ++index) {
+        ChunkResult& chunk = chunks[index];
+        if (index != 0 && chunks[index - 1].ends_after_end
+            && !starts_section(tokens, boundaries[index])) {
+            break;
+        }
+
+        chunk.diagnostics.forward();
+
+        if (chunk.status == Parser::ParseStatus::Error
+            || (chunk.error_count != 0 && error_limit_reached())) {
+            return { {} };
+        }
+
+        std::move(
+            chunk.instructions.begin(),
+            chunk.instructions.end(),
+            std::back_inserter(instructions)
+        );
+
+        if (chunk.status == Parser::ParseStatus::EndPseudo && !chunk.ends_after_end) {
+            break;
+        }
+    }
+
+    return instructions;
+}
@@ -2,17 +2,24 @@
 
 #include "assembler-c/instruction.h"
 #include "assembler-c/parser.h"
+#include "assembler/diagnostic.hpp"
 #include "assembler/instruction.hpp"
+#include "assembler/keyword.hpp"
+#include "assembler/number.hpp"
+#include "assembler/operand.hpp"
+#include "assembler/scanner.hpp"
 #include "assembler/token.hpp"
+#include "assembler/token_stream.hpp"
 
 #include <algorithm>
 #include <cctype>
+#include <cstddef>
+#include <cstdint>
 #include <cstdio>
-#include <iostream>
+#include <functional>
 #include <iterator>
 #include <ostream>
-#include <string>
-#include <unordered_set>
+#include <sstream>
 #include <utility>
 #include <vector>
 
@@ -70,26 +77,41 @@ auto lex_identifier(char const* current, char const* end) -> char const* {
     return std::find_if_not(current, end, static_cast<int (*)(int)>(std::isalnum));
 }
 
-/// Checks if `identifier` is a valid LC-3 opcode, such as `ADD`, `AND`, `BRp`, etc. In our
-/// implementation, opcodes are case-sensitive, so `Add` is not a valid opcode.
-///
-/// You can find all opcodes in the textbook on page 656.
-auto is_valid_opcode(std::string const& identifier) -> bool {
-    static std::unordered_set<std::string> const opcodes = {
-#define OPCODE(name) #name,
-#include "assembler/opcode.def"
-    };
+/// Checks if the character at `current` is a `+` or `-` that continues an expression, which is
+/// the case if a term follows it directly. A sign followed by anything else, as in `x+ X1234`, is
+/// a token of its own.
+auto continues_expression(char const* current, char const* end) -> bool {
+    return current != end && (*current == '+' || *current == '-') && current + 1 != end
+        && (std::isalnum(static_cast<unsigned char>(current[1])) || current[1] == '#');
+}
 
-    return opcodes.find(identifier) != opcodes.end();
+/// Consumes the terms of an expression that follow its first one, starting from the operator
+/// pointed to by `current`, until reaching `end` or a character that cannot continue the
+/// expression. Returns the position where it stops.
+///
+/// Each term is preceded by `+` or `-`, and consists of alphanumeric characters, optionally after
+/// a `#` with its own sign, as in `TABLE+3`, `END-START`, or `BASE+#-1`.
+auto lex_expression_terms(char const* current, char const* end) -> char const* {
+    while (continues_expression(current, end)) {
+        ++current;
+        if (current != end && *current == '#') {
+            ++current;
+            if (current != end && (*current == '+' || *current == '-')) {
+                ++current;
+            }
+        }
+        current = std::find_if_not(current, end, static_cast<int (*)(int)>(std::isalnum));
+    }
+    return current;
 }
 
-/// Checks if `identifier` is a valid register name. In LC-3, valid register names are `R0`~`R7`.
-auto is_valid_register(std::string const& identifier) -> bool {
-    return identifier.size() == 2 && identifier[0] == 'R' && '0' <= identifier[1]
-        && identifier[1] < '8';
+/// Checks if the identifier in the range [begin, end) is a valid register name. In LC-3, valid
+/// register names are `R0`~`R7`.
+auto is_valid_register(char const* begin, char const* end) -> bool {
+    return end - begin == 2 && begin[0] == 'R' && '0' <= begin[1] && begin[1] < '8';
 }
 
-/// Checks if `identifier` *can* be a valid immediate value.
+/// Checks if the identifier in the range [begin, end) *can* be a valid immediate value.
 ///
 /// Note that this function does not actually verify whether the immediate value is fully valid,
 /// since it cannot cover all cases. For example, decimal immediate values cannot be checked here
@@ -105,24 +127,22 @@ auto is_valid_register(std::string const& identifier) -> bool {
 /// only a prefix, it will still be considered "valid" because `std::all_of` always returns `true`
 /// for an empty range. For example, the identifier `x` would be treated as an immediate value. We
 /// will further check such cases later.
-auto may_be_valid_immediate_number(std::string const& identifier) -> bool {
-    // Since we know that `identifier` contains at least one character, it is safe to call
-    // `front()` on it.
-    switch (identifier.front()) {
+auto may_be_valid_immediate_number(char const* begin, char const* end) -> bool {
+    // Since we know that the identifier contains at least one character, it is safe to dereference
+    // `begin`.
+    switch (*begin) {
     case 'x':
-        // When the prefix is 'x', we are trying to interpret `identifier` as a hexadecimal
+        // When the prefix is 'x', we are trying to interpret the identifier as a hexadecimal
         // immediate value. We need to ensure that all characters making up the integer are valid
         // hexadecimal digits, i.e., 0-9, a-f, A-F.
-        return std::all_of(std::next(identifier.begin()), identifier.end(), [](char ch) {
+        return std::all_of(std::next(begin), end, [](char ch) {
             return ('0' <= ch && ch <= '9') || ('a' <= ch && ch <= 'f') || ('A' <= ch && ch <= 'F');
         });
 
     case 'b':
-        // When the prefix is 'b', we are trying to interpret `identifier` as a binary immediate
+        // When the prefix is 'b', we are trying to interpret the identifier as a binary immediate
         // value. We need to ensure that all characters making up the integer are either '0' or '1'.
-        return std::all_of(std::next(identifier.begin()), identifier.end(), [](char ch) {
-            return ch == '0' || ch == '1';
-        });
+        return std::all_of(std::next(begin), end, [](char ch) { return ch == '0' || ch == '1'; });
 
     default:
         return false;
@@ -131,24 +151,27 @@ auto may_be_valid_immediate_number(std::string const& identifier) -> bool {
 
 /// Determines whether an identifier is an opcode, register, immediate value, or label based on its
 /// content. The identifier's text content is specified by the range [identifier_begin,
-/// identifier_end).
-auto identifier_kind(char const* identifier_begin, char const* identifier_end) -> Token::TokenKind {
-    // Convert the token's content to a `std::string`, which makes it easier to handle the string
-    // content (e.g., using it in `std::unordered_set`).
-    //
-    // A better approach would be to use `std::string_view`, which is a C++17 feature. However,
-    // considering that students' environments may not have newer compilers, we didn't do this.
-    std::string const identifier(identifier_begin, identifier_end);
-
-    if (is_valid_opcode(identifier)) {
+/// identifier_end). If the identifier is an opcode, its decoded opcode is stored in `opcode`.
+auto identifier_kind(
+    char const* identifier_begin,
+    char const* identifier_end,
+    std::uint8_t* opcode
+) -> Token::TokenKind {
+    // Opcodes are recognized with a single probe of a perfect hash table, without constructing a
+    // `std::string`.
+    KeywordInfo const keyword = classify_keyword(identifier_begin, identifier_end);
+    if (keyword.kind == Token::Opcode) {
+        *opcode = keyword.opcode;
         return Token::Opcode;
     }
 
-    if (is_valid_register(identifier)) {
+    // The remaining checks also work directly on the source text. Lexing an identifier never
+    // allocates memory.
+    if (is_valid_register(identifier_begin, identifier_end)) {
         return Token::Register;
     }
 
-    if (may_be_valid_immediate_number(identifier)) {
+    if (may_be_valid_immediate_number(identifier_begin, identifier_end)) {
         return Token::Immediate;
     }
 
@@ -158,15 +181,19 @@ auto identifier_kind(char const* identifier_begin, char const* identifier_end) -
 /// Checks if the content of a token is a valid LC-3 pseudo-instruction opcode, such as `.ORIG`,
 /// `.END`, etc. In our implementation, pseudo-instruction opcodes are case-sensitive, so `.End` is
 /// not a valid opcode. `content_begin` and `content_end` specify the range of the token's content.
+/// Returns `Token::Pseudo` and stores the decoded opcode in `opcode` if the content is valid, and
+/// returns `Token::Unknown` otherwise.
 ///
 /// You can find all pseudo-instruction opcodes in the textbook on page 236.
-auto is_valid_pseudo(char const* content_begin, char const* content_end) -> bool {
-    static std::unordered_set<std::string> const pseudos = {
-#define PSEUDO(name) "." #name,
-#include "assembler/opcode.def"
-    };
+auto pseudo_kind(char const* content_begin, char const* content_end, std::uint8_t* opcode)
+    -> Token::TokenKind {
+    KeywordInfo const keyword = classify_keyword(content_begin, content_end);
+    if (keyword.kind == Token::Pseudo) {
+        *opcode = keyword.opcode;
+        return Token::Pseudo;
+    }
 
-    return pseudos.find(std::string(content_begin, content_end)) != pseudos.end();
+    return Token::Unknown;
 }
 
 /// Consumes all characters starting from the position pointed to by `current` until reaching a
@@ -175,14 +202,70 @@ auto is_valid_pseudo(char const* content_begin, char const* content_end) -> bool
 auto consume_comment(char const* current, char const* end) -> char const* {
     return std::find(current, end, '\n');
 }
+
+/// The character-at-a-time kernels. They are used when vectorized kernels are not available, and
+/// serve as the reference implementation for the vectorized kernels.
+ScanKernels const scalar_scan_kernels = {
+    consume_spaces,
+    consume_comment,
+    lex_identifier,
+    lex_string_literal,
+};
 }  // namespace
 
+void Parser::set_scan_level(ScanLevel level) {
+    ScanKernels const* const kernels = vector_scan_kernels(level);
+    scan_level_ = kernels != nullptr ? level : ScanLevel::Scalar;
+    scan_kernels_ = kernels != nullptr ? kernels : &scalar_scan_kernels;
+}
+
+auto Parser::peek(std::size_t n) const -> Token {
+    if (n == 0) {
+        return cur_token_;
+    }
+
+    if (tokens_ != nullptr && n <= end_index_ - next_index_) {
+        return (*tokens_)[next_index_ + n - 1];
+    }
+
+    Parser lookahead = *this;
+    if (tokens_ != nullptr) {
+        // Every token after the range is a `Token::End` following the last token of the range.
+        if (next_index_ != end_index_) {
+            lookahead.cur_token_ = (*tokens_)[end_index_ - 1];
+            lookahead.next_index_ = end_index_;
+        }
+        n = 1;
+    }
+
+    for (; n != 0; --n) {
+        lookahead.next_token();
+    }
+
+    return lookahead.cur_token_;
+}
+
 auto Parser::next_token() -> Token const& {
+    if (tokens_ != nullptr) {
+        // The tokens have been lexed in advance. Once they are exhausted, stay at a `Token::End`.
+        if (next_index_ != end_index_) {
+            cur_token_ = (*tokens_)[next_index_++];
+        } else if (cur_token_.kind() != Token::End) {
+            cur_token_ = { Token::End, cur_token_.end(), cur_token_.end() };
+        }
+        return cur_token_;
+    }
+
 Restart:
     // Save the current value of `current_`. It will be used as the start of the token.
     char const* const token_begin = current_;
     // The type of the current token. We will modify this based on the current character below.
     Token::TokenKind kind = Token::Unknown;
+    // The opcode of `Opcode` and `Pseudo` tokens, decoded together with the token kind.
+    std::uint8_t opcode = Instruction::UnknownOp;
+    // The value of `Immediate` and `Number` tokens, decoded once the extent of the token is known.
+    std::int16_t value = 0;
+    OperandConstructionErrorType number_error = OperandConstructionErrorType::NoError;
 
     if (current_ == source_end_) {
         // If we have reached the end of the source code, generate a `Token::End`.
@@ -201,7 +284,7 @@ Restart:
             // clang-format on
             // Skip all non-newline whitespace characters, such as '\r' and ' '. We need to preserve
             // '\n' to correctly generate `Token::EOL`.
-            current_ = consume_spaces(current_, source_end_);
+            current_ = scan_kernels_->consume_spaces(current_, source_end_);
             // Restart the process to parse the token from the updated position.
             goto Restart;
 
@@ -223,9 +306,39 @@ Restart:
             kind = Token::Immediate;
             break;
 
+        case '=':
+            // The '=' starts a literal, which is followed by an immediate, a decimal number, or a
+            // label without any space in between. Anything else leaves a lone '=' as `Unknown`.
+            if (current_ == source_end_) {
+                break;
+            } else if (*current_ == '#') {
+                current_ = lex_decimal_number(current_ + 1, source_end_);
+                kind = Token::ImmediateLiteral;
+            } else if (('0' <= *current_ && *current_ <= '9') || *current_ == '+'
+                       || *current_ == '-') {
+                current_ = lex_decimal_number(current_, source_end_);
+                kind = Token::ImmediateLiteral;
+            } else if (('A' <= *current_ && *current_ <= 'Z')
+                       || ('a' <= *current_ && *current_ <= 'z')) {
+                current_ = scan_kernels_->lex_identifier(current_ + 1, source_end_);
+                // Registers and opcodes cannot be literals, so they are left `Unknown`.
+                switch (identifier_kind(token_begin + 1, current_, &opcode)) {
+                case Token::Immediate:
+                    kind = Token::ImmediateLiteral;
+                    break;
+                case Token::Label:
+                    kind = Token::LabelLiteral;
+                    break;
+                default:
+                    opcode = Instruction::UnknownOp;
+                    break;
+                }
+            }
+            break;
+
         case '"':
             // Parse string literals.
-            current_ = lex_string_literal(current_, source_end_);
+            current_ = scan_kernels_->lex_string_literal(current_, source_end_);
             kind = Token::String;
             break;
 
@@ -247,30 +360,35 @@ Restart:
         case 's': case 't': case 'u': case 'v': case 'w': case 'x': case 'y': case 'z':
             // clang-format on
             // The current token starts with a letter, parse it as an identifier.
-            current_ = lex_identifier(current_, source_end_);
+            current_ = scan_kernels_->lex_identifier(current_, source_end_);
             // We need to determine whether the identifier is an opcode, register, immediate value,
             // or label. Note that it cannot be a pseudo-instruction because it doesn't satisfy the
             // format of a pseudo-instruction.
-            kind = identifier_kind(token_begin, current_);
+            kind = identifier_kind(token_begin, current_, &opcode);
+
+            // A label or an immediate directly followed by `+` or `-` and a term starts an
+            // expression. Its terms are only checked when the operand is constructed (see
+            // `parse_expression()`).
+            if ((kind == Token::Label || kind == Token::Immediate)
+                && continues_expression(current_, source_end_)) {
+                current_ = lex_expression_terms(current_, source_end_);
+                kind = Token::Expression;
+            }
             break;
 
         case '.':
             // The current token starts with a '.', and it is always parsed as a pseudo-instruction
             // because it cannot be interpreted as any other type of token, even though it might be
             // an invalid pseudo-instruction.
-            current_ = lex_identifier(current_, source_end_);
+            current_ = scan_kernels_->lex_identifier(current_, source_end_);
             // Check if the content of the token is a valid pseudo-instruction opcode.
-            if (is_valid_pseudo(token_begin, current_)) {
-                kind = Token::Pseudo;
-            } else {
-                kind = Token::Unknown;
-            }
+            kind = pseudo_kind(token_begin, current_, &opcode);
             break;
 
         case ';':
             // A semicolon marks the beginning of a line comment, so skip the remaining characters
             // in the line.
-            current_ = consume_comment(current_, source_end_);
+            current_ = scan_kernels_->consume_comment(current_, source_end_);
             // Restart the process to parse the token from the updated position.
             goto Restart;
 
@@ -280,48 +398,109 @@ Restart:
         }
     }
 
+    // Immediates come from the '#', digit, identifier and '=' cases above, so they are decoded here
+    // in one place. Consumers of the token never need to parse its text again.
+    if (Token::holds_number(kind)) {
+        number_error = decode_number(Token::number_begin(kind, token_begin), current_, &value);
+    }
+
     // Construct the token and save it in `cur_token_`.
-    cur_token_ = { kind, token_begin, current_ };
+    cur_token_ = { kind, token_begin, current_, opcode, value, number_error };
     return cur_token_;
 }
 
-auto Parser::emit_diagnostic_at_current_token() const -> std::ostream& {
-    // TODO: We need to enhance this function to report the line and column position of the token,
-    // as this will help students debug more effectively.
-    return std::cout << "error: at token `" << current_token().display_content() << "`: ";
+auto Parser::source_offset_of(Token const& token) const -> std::size_t {
+    return static_cast<std::size_t>(token.begin() - (tokens_ != nullptr ? tokens_->source_begin()
+                                                                         : source_begin_));
+}
+
+template <typename... Arguments>
+void Parser::report_at_current_token(DiagnosticKind kind, Arguments const&... arguments) const {
+    Token const& token = current_token();
+    if (token.begin() == nullptr) {
+        report_error(
+            kind,
+            Diagnostic::unknown_offset,
+            Diagnostic::unknown_offset,
+            token.display_content(),
+            arguments...
+        );
+        return;
+    }
+
+    // The line and column of the token are only looked up when the diagnostic is rendered, so
+    // lexing never counts lines.
+    std::size_t const begin = source_offset_of(token);
+    report_error(
+        kind,
+        begin,
+        begin + static_cast<std::size_t>(token.end() - token.begin()),
+        token.display_content(),
+        arguments...
+    );
 }
 
 void Parser::emit_opcode_diag_at_current_token() const {
-    emit_diagnostic_at_current_token()
-        << "expected token kind `" << Token::Opcode << "` or `" << Token::Pseudo << "`, but got `"
-        << current_token().kind() << "`\n";
+    report_at_current_token(
+        DiagnosticKind::ExpectedOpcode,
+        Token::Opcode,
+        Token::Pseudo,
+        current_token().kind()
+    );
 }
 
 void Parser::emit_operand_diag_at_current_token(OperandConstructionErrorType error) const {
-    std::ostream& out = emit_diagnostic_at_current_token()
-        << "error when constructing an operand: ";
-
     switch (error) {
     case OperandConstructionErrorType::InvalidTokenKind:
-        out << "cannot construct an operand from token kind `" << current_token().kind() << '`';
+        report_at_current_token(DiagnosticKind::InvalidOperandToken, current_token().kind());
         break;
     case OperandConstructionErrorType::InvalidNumber:
-        out << "invalid number `" << current_token().display_content() << '`';
+        report_at_current_token(DiagnosticKind::InvalidNumber);
         break;
     case OperandConstructionErrorType::IntegerOverflow:
-        out << "integer value overflow `" << current_token().display_content()
-            << "` for a 16-bit integer";
+        report_at_current_token(DiagnosticKind::IntegerOverflow);
         break;
     case OperandConstructionErrorType::MissingQuote:
-        out << "missing closing quote in string literal `" << current_token().display_content()
-            << '`';
+        report_at_current_token(DiagnosticKind::MissingQuote);
+        break;
+    case OperandConstructionErrorType::InvalidExpression:
+        report_at_current_token(DiagnosticKind::InvalidExpression);
         break;
     default:
-        out << "ICE: unknown error type `" << error << '`';
+        report_at_current_token(DiagnosticKind::UnknownOperandError, error);
         break;
     }
+}
 
-    out << '\n';
+void Parser::emit_operand_count_diag(Instruction const& instr) {
+    std::ostringstream text;
+    text << instr;
+    std::size_t operand_size = instr.operand_size();
+
+    // The current token is the comma before the first operand that is not stored.
+    do {
+        Operand operand;
+        OperandConstructionErrorType const error =
+            Instruction::construct_operand(next_token(), &operand);
+        if (error != OperandConstructionErrorType::NoError) {
+            emit_operand_diag_at_current_token(error);
+            return;
+        }
+
+        text << ", " << operand;
+        ++operand_size;
+    } while (next_token().kind() == Token::Comma);
+
+    std::size_t const expected_operand_size =
+        Instruction::operand_signatures(instr.get_opcode()).first->size;
+    report_error(
+        DiagnosticKind::OperandCount,
+        instruction_offset_,
+        instruction_offset_,
+        text.str(),
+        expected_operand_size,
+        operand_size
+    );
 }
 
 auto Parser::parse_operand_list(Instruction instr) -> Instruction {
@@ -354,6 +533,13 @@ auto Parser::parse_operand_list(Instruction instr) -> Instruction {
     // Now we parse the remaining part as a comma-separated operand list until encountering a token
     // that cannot form part of the operand list.
     while (next_token().kind() == Token::Comma) {
+        // No instruction takes more operands than an `Instruction` stores, so a longer operand
+        // list is reported here, while its remaining operands can still be quoted.
+        if (instr.operand_size() == Instruction::max_operand_count) {
+            emit_operand_count_diag(instr);
+            return {};
+        }
+
         // Try to construct an operand from the next token.
         OperandConstructionErrorType const construction_result = instr.add_operand(next_token());
 
@@ -373,6 +559,28 @@ auto Parser::parse_operand_list(Instruction instr) -> Instruction {
 
 auto Parser::parse_instructions() -> std::vector<Instruction> {
     std::vector<Instruction> instructions;
+    ParseStatus const status = parse_instructions([&](Instruction instr) {
+        instructions.push_back(std::move(instr));
+    });
+
+    // If parsing stopped at an error, we return a result containing only one unknown instruction
+    // to indicate parsing failure. The errors that the parser recovered from are left as unknown
+    // instructions among the others.
+    if (status == ParseStatus::Error) {
+        return { {} };
+    }
+
+    return instructions;
+}
+
+void Parser::skip_line() {
+    while (current_token().kind() != Token::EOL && current_token().kind() != Token::End) {
+        next_token();
+    }
+}
+
+auto Parser::parse_instructions(std::function<void(Instruction)> const& consumer) -> ParseStatus {
+    SymbolPool::Scope const symbol_scope(symbols().get());
 
     // Call `next_token()` to generate the first token and save it to `cur_token_`.
     next_token();
@@ -387,27 +595,48 @@ auto Parser::parse_instructions() -> std::vector<Instruction> {
 
         case Token::End:
             // We reach the end of the code, so stop parsing.
-            return instructions;
+            return after_end_ ? ParseStatus::EndPseudo : ParseStatus::EndOfInput;
 
         default:
+            // After `.END`, the program only continues if another section starts. Otherwise, the
+            // remaining source code is ignored.
+            if (after_end_) {
+                if (current_token().kind() != Token::Pseudo
+                    || current_token().opcode() != Instruction::ORIG) {
+                    return ParseStatus::EndPseudo;
+                }
+                after_end_ = false;
+            }
+
             // Try to parse an instruction starting from the current token.
+            instruction_offset_ = source_offset_of(current_token());
+            Token const first_token = current_token();
             Instruction instr = parse_instruction();
+            instr.set_source_offset(instruction_offset_);
 
             // If an unknown instruction is returned, it indicates an error was encountered during
-            // parsing. We return a result containing only one unknown instruction to indicate
-            // parsing failure.
+            // parsing.
             if (instr.is_unknown()) {
-                return { {} };
+                ++error_count_;
+                if (error_limit_reached()) {
+                    return ParseStatus::Error;
+                }
+
+                // Recover at the next line, to report the errors in the rest of the program. The
+                // line still defines its label, so that the instructions that refer to it do not
+                // report it as undefined.
+                if (first_token.kind() == Token::Label) {
+                    instr.set_label(first_token);
+                }
+                consumer(std::move(instr));
+                skip_line();
+                break;
             }
 
-            // Add the current instruction to the result.
-            instructions.push_back(std::move(instr));
-
-            // Check if the current instruction is the `.END` pseudo-instruction. If so, stop
-            // parsing.
-            if (instr.get_opcode() == Instruction::END) {
-                return instructions;
-            }
+            // Check if the current instruction is the `.END` pseudo-instruction. If so, only a
+            // `.ORIG` may follow it.
+            after_end_ = instr.get_opcode() == Instruction::END;
+            consumer(std::move(instr));
         }
     }
 }
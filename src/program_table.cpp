@@ -0,0 +1,76 @@
+#include "assembler/program_table.hpp"
+
+#include "assembler/instruction.hpp"
+#include "assembler/operand.hpp"
+#include "assembler/parallel.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+constexpr std::size_t ProgramTable::default_min_chunk_size;
+
+void ProgramTable::assign(std::vector<Instruction> const& instructions) {
+    instructions_ = instructions.data();
+    word_counts_.assign(instructions.size(), 0);
+    addresses_.assign(instructions.size(), 0);
+}
+
+void ProgramTable::assign_addresses(std::uint16_t origin) {
+    std::vector<std::size_t> const chunks =
+        split_range(addresses_.size(), thread_count_, min_chunk_size_);
+    std::size_t const chunk_count = chunks.size() - 1;
+    if (chunk_count == 1) {
+        assign_chunk_addresses(origin, 0, addresses_.size());
+        return;
+    }
+
+    // Sum the word counts of each chunk, starting over at each `.ORIG` row. The sums wrap around
+    // like the addresses. A chunk with a `.ORIG` row ends at the same address wherever it starts.
+    std::vector<std::uint16_t> starts(chunk_count, 0);
+    std::unique_ptr<bool[]> const has_orig(new bool[chunk_count]);
+    parallel_for(chunk_count, [&](std::size_t chunk) {
+        has_orig[chunk] = false;
+        std::uint16_t sum = 0;
+        for (std::size_t row = chunks[chunk]; row != chunks[chunk + 1]; ++row) {
+            if (opcode(row) == Instruction::ORIG) {
+                has_orig[chunk] = true;
+                sum = section_origin(row);
+            }
+            sum = static_cast<std::uint16_t>(sum + word_counts_[row]);
+        }
+        starts[chunk] = sum;
+    });
+
+    std::uint16_t start = origin;
+    for (std::size_t chunk = 0; chunk != chunk_count; ++chunk) {
+        std::uint16_t const sum = starts[chunk];
+        starts[chunk] = start;
+        start = has_orig[chunk] ? sum : static_cast<std::uint16_t>(start + sum);
+    }
+
+    parallel_for(chunk_count, [&](std::size_t chunk) {
+        assign_chunk_addresses(starts[chunk], chunks[chunk], chunks[chunk + 1]);
+    });
+}
+
+void ProgramTable::assign_chunk_addresses(
+    std::uint16_t start,
+    std::size_t first,
+    std::size_t last
+) {
+    Instruction const* const instructions = instructions_;
+    std::uint16_t const* const word_counts = word_counts_.data();
+    std::uint16_t* const addresses = addresses_.data();
+
+    std::uint16_t address = start;
+    for (std::size_t row = first; row != last; ++row) {
+        if (instructions[row].get_opcode() == Instruction::ORIG) {
+            address = section_origin(row);
+        }
+        addresses[row] = address;
+        address = static_cast<std::uint16_t>(address + word_counts[row]);
+    }
+}
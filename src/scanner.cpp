@@ -0,0 +1,338 @@
+#include "assembler/scanner.hpp"
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define ASSEMBLER_SCANNER_X86 1
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #endif
+#endif
+
+// GCC and Clang only allow AVX2 intrinsics inside functions compiled for AVX2. We cannot enable
+// AVX2 for the whole file, since the kernels are selected at runtime and the processor may not
+// support it. MSVC allows using the intrinsics anywhere.
+#if defined(__GNUC__) || defined(__clang__)
+    #define ASSEMBLER_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+    #define ASSEMBLER_TARGET_AVX2
+#endif
+
+namespace {
+#ifdef ASSEMBLER_SCANNER_X86
+// The following scalar predicates are used to process the tail of the range that is shorter than
+// a vector. They must agree with the scalar lexer, which uses `std::isspace` and `std::isalnum` in
+// the "C" locale.
+
+auto is_blank(char ch) -> bool {
+    return ch == ' ' || ('\t' <= ch && ch <= '\r' && ch != '\n');
+}
+
+auto is_alnum(char ch) -> bool {
+    return ('0' <= ch && ch <= '9') || ('a' <= ch && ch <= 'z') || ('A' <= ch && ch <= 'Z');
+}
+
+auto skip_blanks_tail(char const* current, char const* end) -> char const* {
+    while (current != end && is_blank(*current)) {
+        ++current;
+    }
+    return current;
+}
+
+auto skip_alnums_tail(char const* current, char const* end) -> char const* {
+    while (current != end && is_alnum(*current)) {
+        ++current;
+    }
+    return current;
+}
+
+auto find_newline_tail(char const* current, char const* end) -> char const* {
+    while (current != end && *current != '\n') {
+        ++current;
+    }
+    return current;
+}
+
+auto find_quote_or_newline_tail(char const* current, char const* end) -> char const* {
+    while (current != end && *current != '"' && *current != '\n') {
+        ++current;
+    }
+    return current;
+}
+
+/// Finishes a string literal whose body ends at `current`: if `current` points to the closing
+/// double quote, consumes it.
+auto finish_string_literal(char const* current, char const* end) -> char const* {
+    return current != end && *current == '"' ? current + 1 : current;
+}
+
+/// Returns the index of the lowest set bit of `mask`. `mask` must not be 0.
+auto count_trailing_zeros(std::uint32_t mask) -> unsigned {
+    #ifdef _MSC_VER
+    unsigned long index = 0;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+    #else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+    #endif
+}
+
+//==================================================================================================
+// SSE2 kernels, processing 16 characters at a time.
+//==================================================================================================
+
+/// Returns a mask where each byte is 0xFF if the corresponding character of `chars` is a
+/// non-newline whitespace character.
+auto sse2_blank_mask(__m128i chars) -> __m128i {
+    // Characters in the range ['\t', '\r'] are whitespace characters. We subtract '\t' and use an
+    // unsigned comparison to check the range with a single instruction.
+    __m128i const shifted = _mm_sub_epi8(chars, _mm_set1_epi8('\t'));
+    __m128i const control =
+        _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8('\r' - '\t')), shifted);
+    __m128i const newline = _mm_cmpeq_epi8(chars, _mm_set1_epi8('\n'));
+    __m128i const space = _mm_cmpeq_epi8(chars, _mm_set1_epi8(' '));
+    return _mm_or_si128(_mm_andnot_si128(newline, control), space);
+}
+
+/// Returns a mask where each byte is 0xFF if the corresponding character of `chars` is
+/// alphanumeric.
+auto sse2_alnum_mask(__m128i chars) -> __m128i {
+    __m128i const digit = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+    __m128i const is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+    // Setting bit 5 maps uppercase letters to lowercase letters, and maps no other character into
+    // the range ['a', 'z'].
+    __m128i const lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+    __m128i const letter = _mm_sub_epi8(lower, _mm_set1_epi8('a'));
+    __m128i const is_letter = _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(25)), letter);
+    return _mm_or_si128(is_digit, is_letter);
+}
+
+auto sse2_load(char const* current) -> __m128i {
+    return _mm_loadu_si128(reinterpret_cast<__m128i const*>(current));
+}
+
+auto sse2_movemask(__m128i mask) -> std::uint32_t {
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(mask));
+}
+
+auto sse2_consume_spaces(char const* current, char const* end) -> char const* {
+    for (; end - current >= 16; current += 16) {
+        std::uint32_t const mask = sse2_movemask(sse2_blank_mask(sse2_load(current)));
+        if (mask != 0xFFFF) {
+            return current + count_trailing_zeros(~mask);
+        }
+    }
+    return skip_blanks_tail(current, end);
+}
+
+auto sse2_consume_comment(char const* current, char const* end) -> char const* {
+    __m128i const newline = _mm_set1_epi8('\n');
+    for (; end - current >= 16; current += 16) {
+        std::uint32_t const mask = sse2_movemask(_mm_cmpeq_epi8(sse2_load(current), newline));
+        if (mask != 0) {
+            return current + count_trailing_zeros(mask);
+        }
+    }
+    return find_newline_tail(current, end);
+}
+
+auto sse2_lex_identifier(char const* current, char const* end) -> char const* {
+    for (; end - current >= 16; current += 16) {
+        std::uint32_t const mask = sse2_movemask(sse2_alnum_mask(sse2_load(current)));
+        if (mask != 0xFFFF) {
+            return current + count_trailing_zeros(~mask);
+        }
+    }
+    return skip_alnums_tail(current, end);
+}
+
+auto sse2_lex_string_literal(char const* current, char const* end) -> char const* {
+    __m128i const quote = _mm_set1_epi8('"');
+    __m128i const newline = _mm_set1_epi8('\n');
+    for (; end - current >= 16; current += 16) {
+        __m128i const chars = sse2_load(current);
+        std::uint32_t const mask = sse2_movemask(
+            _mm_or_si128(_mm_cmpeq_epi8(chars, quote), _mm_cmpeq_epi8(chars, newline))
+        );
+        if (mask != 0) {
+            return finish_string_literal(current + count_trailing_zeros(mask), end);
+        }
+    }
+    return finish_string_literal(find_quote_or_newline_tail(current, end), end);
+}
+
+//==================================================================================================
+// AVX2 kernels, processing 32 characters at a time. They mirror the SSE2 kernels above.
+//==================================================================================================
+
+ASSEMBLER_TARGET_AVX2 auto avx2_blank_mask(__m256i chars) -> __m256i {
+    __m256i const shifted = _mm256_sub_epi8(chars, _mm256_set1_epi8('\t'));
+    __m256i const control =
+        _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8('\r' - '\t')), shifted);
+    __m256i const newline = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('\n'));
+    __m256i const space = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8(' '));
+    return _mm256_or_si256(_mm256_andnot_si256(newline, control), space);
+}
+
+ASSEMBLER_TARGET_AVX2 auto avx2_alnum_mask(__m256i chars) -> __m256i {
+    __m256i const digit = _mm256_sub_epi8(chars, _mm256_set1_epi8('0'));
+    __m256i const is_digit =
+        _mm256_cmpeq_epi8(_mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit);
+    __m256i const lower = _mm256_or_si256(chars, _mm256_set1_epi8(0x20));
+    __m256i const letter = _mm256_sub_epi8(lower, _mm256_set1_epi8('a'));
+    __m256i const is_letter =
+        _mm256_cmpeq_epi8(_mm256_min_epu8(letter, _mm256_set1_epi8(25)), letter);
+    return _mm256_or_si256(is_digit, is_letter);
+}
+
+ASSEMBLER_TARGET_AVX2 auto avx2_load(char const* current) -> __m256i {
+    return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(current));
+}
+
+ASSEMBLER_TARGET_AVX2 auto avx2_movemask(__m256i mask) -> std::uint32_t {
+    return static_cast<std::uint32_t>(_mm256_movemask_epi8(mask));
+}
+
+ASSEMBLER_TARGET_AVX2 auto avx2_consume_spaces(char const* current, char const* end)
+    -> char const* {
+    for (; end - current >= 32; current += 32) {
+        std::uint32_t const mask = avx2_movemask(avx2_blank_mask(avx2_load(current)));
+        if (mask != 0xFFFFFFFF) {
+            return current + count_trailing_zeros(~mask);
+        }
+    }
+    return skip_blanks_tail(current, end);
+}
+
+ASSEMBLER_TARGET_AVX2 auto avx2_consume_comment(char const* current, char const* end)
+    -> char const* {
+    __m256i const newline = _mm256_set1_epi8('\n');
+    for (; end - current >= 32; current += 32) {
+        std::uint32_t const mask = avx2_movemask(_mm256_cmpeq_epi8(avx2_load(current), newline));
+        if (mask != 0) {
+            return current + count_trailing_zeros(mask);
+        }
+    }
+    return find_newline_tail(current, end);
+}
+
+ASSEMBLER_TARGET_AVX2 auto avx2_lex_identifier(char const* current, char const* end)
+    -> char const* {
+    for (; end - current >= 32; current += 32) {
+        std::uint32_t const mask = avx2_movemask(avx2_alnum_mask(avx2_load(current)));
+        if (mask != 0xFFFFFFFF) {
+            return current + count_trailing_zeros(~mask);
+        }
+    }
+    return skip_alnums_tail(current, end);
+}
+
+ASSEMBLER_TARGET_AVX2 auto avx2_lex_string_literal(char const* current, char const* end)
+    -> char const* {
+    __m256i const quote = _mm256_set1_epi8('"');
+    __m256i const newline = _mm256_set1_epi8('\n');
+    for (; end - current >= 32; current += 32) {
+        __m256i const chars = avx2_load(current);
+        std::uint32_t const mask = avx2_movemask(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chars, quote), _mm256_cmpeq_epi8(chars, newline))
+        );
+        if (mask != 0) {
+            return finish_string_literal(current + count_trailing_zeros(mask), end);
+        }
+    }
+    return finish_string_literal(find_quote_or_newline_tail(current, end), end);
+}
+
+/// Returns whether both the processor and the operating system support AVX2.
+auto detect_avx2() -> bool {
+    #ifdef _MSC_VER
+    int info[4] = {};
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+
+    // The operating system must save the YMM registers on context switches (OSXSAVE and XCR0).
+    __cpuid(info, 1);
+    bool const has_osxsave = (info[2] & (1 << 27)) != 0;
+    bool const has_avx = (info[2] & (1 << 28)) != 0;
+    if (!has_osxsave || !has_avx || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+    #else
+    return __builtin_cpu_supports("avx2");
+    #endif
+}
+#endif  // ASSEMBLER_SCANNER_X86
+}  // namespace
+
+auto is_scan_level_supported(ScanLevel level) -> bool {
+    switch (level) {
+    case ScanLevel::Scalar:
+        return true;
+
+#ifdef ASSEMBLER_SCANNER_X86
+    case ScanLevel::SSE2:
+        // SSE2 is part of the x86-64 baseline.
+        return true;
+
+    case ScanLevel::AVX2: {
+        static bool const supported = detect_avx2();
+        return supported;
+    }
+#endif
+
+    default:
+        return false;
+    }
+}
+
+auto best_scan_level() -> ScanLevel {
+    static ScanLevel const level = [] {
+        if (is_scan_level_supported(ScanLevel::AVX2)) {
+            return ScanLevel::AVX2;
+        }
+        if (is_scan_level_supported(ScanLevel::SSE2)) {
+            return ScanLevel::SSE2;
+        }
+        return ScanLevel::Scalar;
+    }();
+    return level;
+}
+
+auto vector_scan_kernels(ScanLevel level) -> ScanKernels const* {
+    if (!is_scan_level_supported(level)) {
+        return nullptr;
+    }
+
+    switch (level) {
+#ifdef ASSEMBLER_SCANNER_X86
+    case ScanLevel::SSE2: {
+        static ScanKernels const kernels = {
+            sse2_consume_spaces,
+            sse2_consume_comment,
+            sse2_lex_identifier,
+            sse2_lex_string_literal,
+        };
+        return &kernels;
+    }
+
+    case ScanLevel::AVX2: {
+        static ScanKernels const kernels = {
+            avx2_consume_spaces,
+            avx2_consume_comment,
+            avx2_lex_identifier,
+            avx2_lex_string_literal,
+        };
+        return &kernels;
+    }
+#endif
+
+    default:
+        return nullptr;
+    }
+}
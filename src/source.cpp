@@ -0,0 +1,172 @@
+#include "assembler/source.hpp"
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define ASSEMBLER_SOURCE_POSIX 1
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#else
+    #include <fstream>
+    #include <ios>
+    #include <iostream>
+#endif
+
+namespace {
+/// The number of bytes requested from the input at a time when it cannot be mapped. The buffer
+/// grows geometrically, so large inputs are still read in few system calls.
+constexpr std::size_t initial_read_size = 64 * 1024;
+
+#ifdef ASSEMBLER_SOURCE_POSIX
+/// Reads everything from the file descriptor `fd` until the end of the input, appending it to
+/// `buffer`. Returns `false` on a read error.
+auto read_descriptor(int fd, std::vector<char>* buffer) -> bool {
+    std::size_t size = buffer->size();
+
+    for (;;) {
+        if (buffer->size() - size < initial_read_size) {
+            buffer->resize(buffer->size() < initial_read_size ? initial_read_size
+                                                              : buffer->size() * 2);
+        }
+
+        ssize_t const count = ::read(fd, buffer->data() + size, buffer->size() - size);
+        if (count > 0) {
+            size += static_cast<std::size_t>(count);
+        } else if (count == 0) {
+            buffer->resize(size);
+            return true;
+        } else if (errno != EINTR) {
+            return false;
+        }
+    }
+}
+#else
+/// Reads everything from the stream `input` until the end of the input, appending it to `buffer`.
+/// Returns `false` on a read error.
+auto read_stream(std::istream& input, std::vector<char>* buffer) -> bool {
+    std::size_t size = buffer->size();
+
+    for (;;) {
+        if (buffer->size() - size < initial_read_size) {
+            buffer->resize(buffer->size() < initial_read_size ? initial_read_size
+                                                              : buffer->size() * 2);
+        }
+
+        input.read(buffer->data() + size, static_cast<std::streamsize>(buffer->size() - size));
+        size += static_cast<std::size_t>(input.gcount());
+
+        if (!input) {
+            buffer->resize(size);
+            return input.eof();
+        }
+    }
+}
+#endif
+}  // namespace
+
+SourceBuffer::SourceBuffer(SourceBuffer&& other) noexcept :
+    begin_(other.begin_),
+    end_(other.end_),
+    mapping_(other.mapping_),
+    mapping_size_(other.mapping_size_),
+    buffer_(std::move(other.buffer_)) {
+    other.begin_ = nullptr;
+    other.end_ = nullptr;
+    other.mapping_ = nullptr;
+    other.mapping_size_ = 0;
+}
+
+auto SourceBuffer::operator=(SourceBuffer&& other) noexcept -> SourceBuffer& {
+    if (this != &other) {
+        reset();
+        std::swap(begin_, other.begin_);
+        std::swap(end_, other.end_);
+        std::swap(mapping_, other.mapping_);
+        std::swap(mapping_size_, other.mapping_size_);
+        buffer_.swap(other.buffer_);
+    }
+
+    return *this;
+}
+
+SourceBuffer::~SourceBuffer() {
+    reset();
+}
+
+void SourceBuffer::reset() {
+#ifdef ASSEMBLER_SOURCE_POSIX
+    if (mapping_ != nullptr) {
+        ::munmap(mapping_, mapping_size_);
+    }
+#endif
+
+    begin_ = nullptr;
+    end_ = nullptr;
+    mapping_ = nullptr;
+    mapping_size_ = 0;
+    buffer_.clear();
+}
+
+auto SourceBuffer::open(std::string const& path) -> bool {
+    reset();
+    bool const is_stdin = path == "-";
+
+#ifdef ASSEMBLER_SOURCE_POSIX
+    int const fd = is_stdin ? STDIN_FILENO : ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    // Map regular files directly. Standard input is mapped too when it is redirected from a regular
+    // file. Empty files cannot be mapped, but there is nothing to read from them either.
+    struct stat status;
+    if (::fstat(fd, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0) {
+        std::size_t const size = static_cast<std::size_t>(status.st_size);
+        void* const mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (mapping != MAP_FAILED) {
+            // The lexer makes a single pass from the beginning to the end of the file.
+            ::madvise(mapping, size, MADV_SEQUENTIAL);
+
+            mapping_ = mapping;
+            mapping_size_ = size;
+            begin_ = static_cast<char const*>(mapping);
+            end_ = begin_ + size;
+
+            if (!is_stdin) {
+                ::close(fd);
+            }
+            return true;
+        }
+    }
+
+    // The input is a pipe, a terminal or a file that cannot be mapped, so read it into memory.
+    bool const ok = read_descriptor(fd, &buffer_);
+    if (!is_stdin) {
+        ::close(fd);
+    }
+#else
+    bool ok = false;
+    if (is_stdin) {
+        ok = read_stream(std::cin, &buffer_);
+    } else {
+        std::ifstream input(path, std::ios::binary);
+        ok = input && read_stream(input, &buffer_);
+    }
+#endif
+
+    if (!ok) {
+        reset();
+        return false;
+    }
+
+    begin_ = buffer_.data();
+    end_ = buffer_.data() + buffer_.size();
+    return true;
+}
@@ -0,0 +1,200 @@
+#include "assembler/streaming_parser.hpp"
+
+#include "assembler/instruction.hpp"
+#include "assembler/parser.hpp"
+#include "assembler/token.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <istream>
+#include <utility>
+#include <vector>
+
+namespace {
+/// Returns the beginning of the line that ends at `line_end` (just past its '\n', if any) and
+/// starts no earlier than `begin`.
+auto line_begin_of(char const* begin, char const* line_end) -> char const* {
+    char const* current = line_end;
+    if (current != begin && current[-1] == '\n') {
+        --current;
+    }
+
+    while (current != begin && current[-1] != '\n') {
+        --current;
+    }
+
+    return current;
+}
+
+/// The lines at the end of a window that must be carried over to the next window.
+enum class LineKind {
+    /// A line without tokens, i.e., an empty line or a line with only a comment.
+    Blank,
+    /// A line consisting of a single label, which belongs to the instruction on a later line.
+    LabelOnly,
+    Other,
+};
+
+auto classify_line(char const* begin, char const* end) -> LineKind {
+    Parser parser(begin, end);
+    std::size_t token_count = 0;
+    Token::TokenKind kind = Token::Unknown;
+
+    while (parser.next_token().kind() != Token::End) {
+        if (parser.current_token().kind() != Token::EOL) {
+            kind = parser.current_token().kind();
+            ++token_count;
+        }
+    }
+
+    if (token_count == 0) {
+        return LineKind::Blank;
+    }
+
+    return token_count == 1 && kind == Token::Label ? LineKind::LabelOnly : LineKind::Other;
+}
+
+/// Returns where the trailing lines of [begin, end) that consist only of labels and blank lines
+/// start, if there is at least one label among them. Otherwise, returns `end`.
+auto trailing_labels_begin(char const* begin, char const* end) -> char const* {
+    char const* result = end;
+    char const* line_end = end;
+
+    while (line_end != begin) {
+        char const* const line_begin = line_begin_of(begin, line_end);
+        LineKind const kind = classify_line(line_begin, line_end);
+
+        if (kind == LineKind::Other) {
+            break;
+        }
+
+        if (kind == LineKind::LabelOnly) {
+            result = line_begin;
+        }
+
+        line_end = line_begin;
+    }
+
+    return result;
+}
+}  // namespace
+
+constexpr std::size_t StreamingParser::default_window_size;
+
+StreamingParser::StreamingParser(std::istream& input, std::size_t window_size) :
+    input_(input),
+    window_(std::max<std::size_t>(window_size, 1)),
+    tail_begin_(0),
+    tail_end_(0),
+    window_offset_(0),
+    eof_(false) { }
+
+auto StreamingParser::next_window(bool keep_labels, char const** begin, char const** end)
+    -> bool {
+    // Move the bytes after the last complete line of the previous window to the front.
+    std::size_t filled = tail_end_ - tail_begin_;
+    std::memmove(window_.data(), window_.data() + tail_begin_, filled);
+    window_offset_ += tail_begin_;
+    tail_begin_ = 0;
+    tail_end_ = filled;
+
+    if (eof_ && filled == 0) {
+        return false;
+    }
+
+    while (true) {
+        if (!eof_) {
+            input_.read(
+                window_.data() + filled,
+                static_cast<std::streamsize>(window_.size() - filled)
+            );
+            filled += static_cast<std::size_t>(input_.gcount());
+            eof_ = filled != window_.size();
+        }
+
+        char const* const data = window_.data();
+        char const* cut = data + filled;
+
+        if (!eof_) {
+            // Only complete lines can be parsed. Lines ending with a label must wait for the
+            // instruction they belong to.
+            cut = data;
+            for (char const* current = data + filled; current != data; --current) {
+                if (current[-1] == '\n') {
+                    cut = current;
+                    break;
+                }
+            }
+
+            if (keep_labels) {
+                cut = trailing_labels_begin(data, cut);
+            }
+        }
+
+        if (cut == data && !eof_) {
+            // Not even a single line fits into the window, so grow it and keep reading.
+            window_.resize(window_.size() * 2);
+            continue;
+        }
+
+        tail_begin_ = static_cast<std::size_t>(cut - data);
+        tail_end_ = filled;
+        *begin = data;
+        *end = cut;
+        return true;
+    }
+}
+
+void StreamingParser::relocate(Instruction* instr) const {
+    instr->set_source_offset(window_offset_ + instr->source_offset());
+}
+
+auto StreamingParser::parse_instructions(std::function<void(Instruction)> const& consumer)
+    -> Parser::ParseStatus {
+    char const* begin = nullptr;
+    char const* end = nullptr;
+    bool after_end = false;
+
+    while (next_window(/*keep_labels=*/true, &begin, &end)) {
+        Parser parser(begin, end, symbols());
+        if (after_end) {
+            parser.resume_after_end();
+        }
+
+        Parser::ParseStatus const status = parser.parse_instructions([&](Instruction instr) {
+            relocate(&instr);
+            consumer(std::move(instr));
+        });
+
+        error_count_ += parser.error_count();
+
+        // If the window ends right after `.END`, a `.ORIG` in the next window continues the
+        // program.
+        after_end = status == Parser::ParseStatus::EndPseudo
+            && parser.current_token().kind() == Token::End;
+        if (status != Parser::ParseStatus::EndOfInput && !after_end) {
+            return status;
+        }
+    }
+
+    return after_end ? Parser::ParseStatus::EndPseudo : Parser::ParseStatus::EndOfInput;
+}
+
+void StreamingParser::tokenize(std::function<void(Token const&)> const& consumer) {
+    char const* begin = nullptr;
+    char const* end = nullptr;
+
+    while (next_window(/*keep_labels=*/false, &begin, &end)) {
+        Parser parser(begin, end);
+        while (parser.next_token().kind() != Token::End) {
+            consumer(parser.current_token());
+        }
+    }
+
+    // Every window ends with a `Token::End`, but only the one at the end of the input is passed to
+    // the consumer.
+    Parser parser(end, end);
+    consumer(parser.next_token());
+}
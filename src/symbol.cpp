@@ -0,0 +1,238 @@
+#include "assembler/symbol.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+/// The texts are stored in segments that are never moved, so `Symbol::str()` can read them without
+/// taking a lock while other texts are added. The first segment holds `1 << first_segment_bits`
+/// texts, and every further segment is twice as large as the one before. The text with id `i` is
+/// stored at position `i` of the concatenation of all segments.
+constexpr unsigned first_segment_bits = 6;
+constexpr std::size_t segment_count = Symbol::id_bits - first_segment_bits + 1;
+
+/// There can be at most `max_symbol_count` symbols, so that every id fits into `Symbol::id_bits`.
+constexpr std::size_t max_symbol_count = std::size_t(1) << Symbol::id_bits;
+
+/// The lookup of texts is split into `shard_count` shards with their own locks, so that threads
+/// interning different texts rarely wait for each other. The low bits of the hash of a text
+/// select its shard.
+constexpr std::size_t shard_count = 16;
+
+/// Returns the segment that holds the text with the id `id`, and stores the position of the text
+/// in the segment in `*position`.
+auto locate(std::size_t id, std::size_t* position) -> std::size_t {
+    // Segment `k` starts at position `((1 << k) - 1) << first_segment_bits`.
+    std::size_t const blocks = (id >> first_segment_bits) + 1;
+    std::size_t segment = 0;
+    while ((blocks >> (segment + 1)) != 0) {
+        ++segment;
+    }
+
+    *position = id - (((std::size_t(1) << segment) - 1) << first_segment_bits);
+    return segment;
+}
+
+/// Returns the 64-bit FNV-1a hash of the text in the range [begin, end).
+auto hash_text(char const* begin, char const* end) -> std::uint64_t {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (; begin != end; ++begin) {
+        hash ^= static_cast<unsigned char>(*begin);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+/// The texts of all symbols, indexed by id.
+class TextStore {
+public:
+    TextStore() : size_(0) {
+        for (std::atomic<std::string*>& segment : segments_) {
+            segment.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    ~TextStore() {
+        for (std::atomic<std::string*>& segment : segments_) {
+            delete[] segment.load(std::memory_order_relaxed);
+        }
+    }
+
+    TextStore(TextStore const&) = delete;
+    auto operator=(TextStore const&) -> TextStore& = delete;
+
+    /// Stores a copy of the text in the range [begin, end) with the next free id, and returns the
+    /// id.
+    auto add(char const* begin, char const* end) -> std::uint32_t {
+        std::size_t const id = size_.fetch_add(1, std::memory_order_relaxed);
+        if (id >= max_symbol_count) {
+            throw std::length_error("too many distinct labels and string literals");
+        }
+
+        std::size_t position = 0;
+        std::size_t const segment = locate(id, &position);
+        std::string* texts = segments_[segment].load(std::memory_order_acquire);
+        if (texts == nullptr) {
+            // Segments are allocated rarely, so a single lock for all of them is enough.
+            std::lock_guard<std::mutex> const lock(segment_mutex_);
+            texts = segments_[segment].load(std::memory_order_relaxed);
+            if (texts == nullptr) {
+                texts = new std::string[std::size_t(1) << (first_segment_bits + segment)];
+                segments_[segment].store(texts, std::memory_order_release);
+            }
+        }
+
+        texts[position].assign(begin, end);
+        return static_cast<std::uint32_t>(id);
+    }
+
+    auto at(std::size_t id) const -> std::string const& {
+        std::size_t position = 0;
+        std::size_t const segment = locate(id, &position);
+        return segments_[segment].load(std::memory_order_acquire)[position];
+    }
+
+    /// Returns the number of ids that have been handed out.
+    auto size() const -> std::size_t {
+        return std::min(size_.load(std::memory_order_relaxed), max_symbol_count);
+    }
+
+private:
+    std::atomic<std::string*> segments_[segment_count];
+    std::atomic<std::size_t> size_;
+    std::mutex segment_mutex_;
+};
+
+/// A hash table that maps texts to the ids of their symbols.
+class Shard {
+public:
+    Shard() : size_(0), slots_(64, 0) { }
+
+    Shard(Shard const&) = delete;
+    auto operator=(Shard const&) -> Shard& = delete;
+
+    /// Returns the id of the text in the range [begin, end), which has the hash `hash`, adding the
+    /// text to `texts` if it has not been interned yet.
+    auto find_or_add(TextStore& texts, std::uint64_t hash, char const* begin, char const* end)
+        -> std::uint32_t {
+        std::lock_guard<std::mutex> const lock(mutex_);
+
+        std::uint64_t const tag = hash >> 32;
+        std::size_t const mask = slots_.size() - 1;
+        std::size_t const length = static_cast<std::size_t>(end - begin);
+
+        std::size_t position = static_cast<std::size_t>(tag) & mask;
+        for (; slots_[position] != 0; position = (position + 1) & mask) {
+            if ((slots_[position] >> 32) != tag) {
+                continue;
+            }
+
+            std::uint32_t const id = static_cast<std::uint32_t>(slots_[position]);
+            std::string const& text = texts.at(id);
+            if (text.size() == length && std::equal(begin, end, text.data())) {
+                return id;
+            }
+        }
+
+        std::uint32_t const id = texts.add(begin, end);
+        slots_[position] = tag << 32 | id;
+        if (++size_ * 2 > slots_.size()) {
+            grow();
+        }
+        return id;
+    }
+
+private:
+    std::mutex mutex_;
+    /// The number of texts in the shard.
+    std::size_t size_;
+    /// An open-addressing hash table over the texts. A slot holds the upper 32 bits of the hash of
+    /// a text and its id, or 0 if it is empty. The empty string, whose id is 0, is never stored.
+    /// At most half of the slots are used.
+    std::vector<std::uint64_t> slots_;
+
+    /// Doubles the number of slots.
+    void grow() {
+        std::vector<std::uint64_t> slots(slots_.size() * 2, 0);
+        std::size_t const mask = slots.size() - 1;
+
+        for (std::uint64_t const slot : slots_) {
+            if (slot == 0) {
+                continue;
+            }
+
+            std::size_t position = static_cast<std::size_t>(slot >> 32) & mask;
+            while (slots[position] != 0) {
+                position = (position + 1) & mask;
+            }
+            slots[position] = slot;
+        }
+
+        slots_.swap(slots);
+    }
+};
+
+/// The pool of the current thread, if any.
+thread_local SymbolPool* current_pool = nullptr;
+}  // namespace
+
+struct SymbolPool::Storage {
+    TextStore texts;
+    Shard shards[shard_count];
+};
+
+constexpr unsigned Symbol::id_bits;
+
+auto Symbol::intern(char const* begin, char const* end) -> Symbol {
+    assert(current_pool != nullptr && "no `SymbolPool::Scope` is installed on this thread");
+    return current_pool->intern(begin, end);
+}
+
+auto Symbol::str() const -> std::string const& {
+    assert(current_pool != nullptr && "no `SymbolPool::Scope` is installed on this thread");
+    return current_pool->str(*this);
+}
+
+SymbolPool::Scope::Scope(SymbolPool* pool) : previous_(current_pool) {
+    current_pool = pool;
+}
+
+SymbolPool::Scope::~Scope() {
+    current_pool = previous_;
+}
+
+SymbolPool::SymbolPool() : storage_(new Storage()) {
+    // The empty string is the first text, so its id is 0.
+    storage_->texts.add(nullptr, nullptr);
+}
+
+SymbolPool::~SymbolPool() = default;
+
+auto SymbolPool::current() -> SymbolPool* {
+    return current_pool;
+}
+
+auto SymbolPool::intern(char const* begin, char const* end) -> Symbol {
+    if (begin == end) {
+        return Symbol();
+    }
+
+    std::uint64_t const hash = hash_text(begin, end);
+    Shard& shard = storage_->shards[static_cast<std::size_t>(hash) & (shard_count - 1)];
+    return Symbol(shard.find_or_add(storage_->texts, hash, begin, end));
+}
+
+auto SymbolPool::str(Symbol symbol) const -> std::string const& {
+    return storage_->texts.at(symbol.id());
+}
+
+auto SymbolPool::size() const -> std::size_t {
+    return storage_->texts.size();
+}
@@ -1,12 +1,26 @@
 #include "assembler/token.hpp"
 
 #include "assembler-c/token.h"
+#include "assembler/keyword.hpp"
+#include "assembler/number.hpp"
+#include "assembler/operand.hpp"
 
 #include <cstddef>
+#include <cstdint>
 #include <ostream>
 #include <string>
 #include <type_traits>
 
+Token::Token(TokenKind kind, char const* begin, char const* end) :
+    kind_(kind), opcode_(0), value_(0), number_error_(0), begin_(begin), end_(end) {
+    if (kind == Opcode || kind == Pseudo) {
+        opcode_ = classify_keyword(begin, end).opcode;
+    } else if (holds_number(kind)) {
+        number_error_ =
+            static_cast<std::uint8_t>(decode_number(number_begin(kind, begin), end, &value_));
+    }
+}
+
 auto Token::display_content() const -> std::string {
     std::string result;
     result.reserve(size());
@@ -55,6 +69,12 @@ auto operator<<(std::ostream& out, Token::TokenKind kind) -> std::ostream& {
             return "Number";
         case Token::String:
             return "String";
+        case Token::ImmediateLiteral:
+            return "ImmediateLiteral";
+        case Token::LabelLiteral:
+            return "LabelLiteral";
+        case Token::Expression:
+            return "Expression";
         case Token::Comma:
             return "Comma";
         default:
@@ -0,0 +1,155 @@
+#include "assembler/token_stream.hpp"
+
+#include "assembler/operand.hpp"
+#include "assembler/parallel.hpp"
+#include "assembler/parser.hpp"
+#include "assembler/token.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace {
+/// The tokens of one chunk of the source code.
+struct ChunkTokens {
+    std::vector<TokenRecord> records;
+    /// The value of each record (see `TokenStream::values_`).
+    std::vector<std::int16_t> values;
+    /// The long tokens of the chunk, indexed relative to the beginning of the chunk.
+    std::vector<std::pair<std::size_t, std::size_t>> long_tokens;
+};
+
+/// Lexes the chunk [begin, end) of the source code starting at `source_begin`. The final
+/// `Token::End` of the chunk is dropped.
+void lex_chunk(char const* source_begin, char const* begin, char const* end, ChunkTokens* chunk) {
+    Parser parser(begin, end);
+    // Typical source code has a token every few bytes, so this avoids most reallocations.
+    chunk->records.reserve(static_cast<std::size_t>(end - begin) / 4 + 1);
+    chunk->values.reserve(chunk->records.capacity());
+
+    while (parser.next_token().kind() != Token::End) {
+        Token const& token = parser.current_token();
+
+        TokenRecord record;
+        record.offset = static_cast<std::uint32_t>(token.begin() - source_begin);
+        record.length = static_cast<std::uint16_t>(
+            std::min(token.size(), TokenStream::long_token_length)
+        );
+        record.kind = token.kind();
+        record.flags = Token::holds_number(token.kind())
+            ? static_cast<std::uint8_t>(token.number_error())
+            : token.opcode();
+
+        if (token.size() >= TokenStream::long_token_length) {
+            chunk->long_tokens.emplace_back(chunk->records.size(), token.size());
+        }
+
+        chunk->records.push_back(record);
+        chunk->values.push_back(token.value());
+    }
+}
+}  // namespace
+
+constexpr std::size_t TokenStream::max_source_size;
+constexpr std::size_t TokenStream::long_token_length;
+
+TokenStream::TokenStream(
+    char const* begin,
+    char const* end,
+    unsigned thread_count,
+    std::size_t min_chunk_size
+) :
+    source_begin_(begin),
+    source_end_(end) {
+    std::vector<char const*> const boundaries =
+        split_lines(begin, end, thread_count, min_chunk_size);
+    std::size_t const chunk_count = boundaries.size() - 1;
+
+    // Lex every chunk into its own array.
+    std::vector<ChunkTokens> chunks(chunk_count);
+    parallel_for(chunk_count, [&](std::size_t index) {
+        lex_chunk(begin, boundaries[index], boundaries[index + 1], &chunks[index]);
+    });
+
+    if (chunk_count == 1) {
+        records_ = std::move(chunks.front().records);
+        values_ = std::move(chunks.front().values);
+        long_tokens_ = std::move(chunks.front().long_tokens);
+    } else {
+        // Splice the chunks in order. Each chunk is copied to its final position by its own thread.
+        std::vector<std::size_t> offsets(chunk_count + 1, 0);
+        for (std::size_t index = 0; index != chunk_count; ++index) {
+            offsets[index + 1] = offsets[index] + chunks[index].records.size();
+        }
+
+        records_.resize(offsets.back());
+        values_.resize(offsets.back());
+        parallel_for(chunk_count, [&](std::size_t index) {
+            std::vector<TokenRecord>& records = chunks[index].records;
+            std::copy(records.begin(), records.end(), records_.begin() + offsets[index]);
+            std::vector<TokenRecord>().swap(records);
+
+            std::vector<std::int16_t>& values = chunks[index].values;
+            std::copy(values.begin(), values.end(), values_.begin() + offsets[index]);
+            std::vector<std::int16_t>().swap(values);
+        });
+
+        for (std::size_t index = 0; index != chunk_count; ++index) {
+            for (std::pair<std::size_t, std::size_t> const& entry : chunks[index].long_tokens) {
+                long_tokens_.emplace_back(offsets[index] + entry.first, entry.second);
+            }
+        }
+    }
+
+    // The serial lexer produces its `Token::End` at the end of the source code.
+    TokenRecord const end_record = {
+        static_cast<std::uint32_t>(end - begin), 0, Token::End, 0
+    };
+    records_.push_back(end_record);
+    values_.push_back(0);
+}
+
+auto TokenStream::length(std::size_t index) const -> std::size_t {
+    if (records_[index].length != long_token_length) {
+        return records_[index].length;
+    }
+
+    auto const long_token = std::lower_bound(
+        long_tokens_.begin(),
+        long_tokens_.end(),
+        index,
+        [](std::pair<std::size_t, std::size_t> const& entry, std::size_t value) {
+            return entry.first < value;
+        }
+    );
+    return long_token->second;
+}
+
+auto TokenStream::operator[](std::size_t index) const -> Token {
+    TokenRecord const& record = records_[index];
+    char const* const begin = source_begin_ + record.offset;
+    char const* const end = begin + length(index);
+
+    switch (record.kind) {
+    case Token::Opcode:
+    case Token::Pseudo:
+        return { record.kind, begin, end, record.flags, 0, OperandConstructionErrorType::NoError };
+
+    case Token::Immediate:
+    case Token::Number:
+    case Token::ImmediateLiteral:
+        return {
+            record.kind,
+            begin,
+            end,
+            0,
+            values_[index],
+            static_cast<OperandConstructionErrorType>(record.flags),
+        };
+
+    default:
+        return { record.kind, begin, end, 0, 0, OperandConstructionErrorType::NoError };
+    }
+}
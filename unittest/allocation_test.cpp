@@ -0,0 +1,107 @@
+#include "assembler/instruction.hpp"
+#include "assembler/operand.hpp"
+#include "assembler/parser.hpp"
+#include "assembler/symbol.hpp"
+#include "assembler/token.hpp"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace {
+/// The number of calls to the global allocation function since the program started.
+std::atomic<std::size_t> allocation_count(0);
+}  // namespace
+
+// Replace the global allocation functions with counting ones. The array forms and the nothrow forms
+// forward to these by default.
+
+auto operator new(std::size_t size) -> void* {
+    ++allocation_count;
+    if (void* const ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+TEST(AllocationTest, LexingAndOperandConstructionDoNotAllocate) {
+    std::ifstream input(ASSEMBLER_SOURCE_DIR "/test/code_lc3/lab5/lab5.asm", std::ios::binary);
+    ASSERT_TRUE(input);
+    std::string const code(
+        (std::istreambuf_iterator<char>(input)),
+        std::istreambuf_iterator<char>()
+    );
+
+    // Interning a label or string literal for the first time allocates memory, so every operand is
+    // constructed once before counting.
+    SymbolPool pool;
+    SymbolPool::Scope const scope(&pool);
+    {
+        Parser parser(code);
+        while (parser.next_token().kind() != Token::End) {
+            Operand operand;
+            Instruction::construct_operand(parser.current_token(), &operand);
+        }
+    }
+
+    for (ScanLevel const level : { ScanLevel::Scalar, best_scan_level() }) {
+        Parser parser(code);
+        parser.set_scan_level(level);
+
+        std::size_t token_count = 0;
+        std::size_t operand_count = 0;
+        std::size_t const allocations_before = allocation_count;
+
+        while (parser.next_token().kind() != Token::End) {
+            ++token_count;
+
+            Operand operand;
+            if (Instruction::construct_operand(parser.current_token(), &operand)
+                == OperandConstructionErrorType::NoError) {
+                ++operand_count;
+            }
+        }
+
+        std::size_t const allocations = allocation_count - allocations_before;
+
+        EXPECT_GT(token_count, 0);
+        EXPECT_GT(operand_count, 0);
+        EXPECT_EQ(allocations, 0) << "while lexing " << token_count << " tokens";
+    }
+}
+
+TEST(AllocationTest, ValidationDoesNotAllocate) {
+    std::ifstream input(ASSEMBLER_SOURCE_DIR "/test/code_lc3/lab5/lab5.asm", std::ios::binary);
+    ASSERT_TRUE(input);
+    std::string const code(
+        (std::istreambuf_iterator<char>(input)),
+        std::istreambuf_iterator<char>()
+    );
+
+    Parser parser(code);
+    std::vector<Instruction> const instructions = parser.parse_instructions();
+    ASSERT_GT(instructions.size(), 1);
+
+    std::size_t const allocations_before = allocation_count;
+    for (Instruction const& instr : instructions) {
+        EXPECT_TRUE(instr.validate_and_emit_diagnostics()) << instr;
+    }
+    std::size_t const allocations = allocation_count - allocations_before;
+
+    EXPECT_EQ(allocations, 0) << "while validating " << instructions.size() << " instructions";
+}
@@ -0,0 +1,61 @@
+#ifndef ASSEMBLER_UNITTEST_ASSEMBLE_HPP
+#define ASSEMBLER_UNITTEST_ASSEMBLE_HPP
+
+#include "assembler/assembler.hpp"
+#include "assembler/diagnostic.hpp"
+#include "assembler/one_pass_assembler.hpp"
+#include "assembler/parser.hpp"
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// Assembles `code`, and returns the words, or an empty vector after an error. The diagnostic
+/// messages are stored in `*diagnostics`. With `relax`, instructions whose label is out of range
+/// are relaxed, and with more than one thread, the program is assembled by `run_parallel()`.
+inline auto assemble(
+    std::string const& code,
+    std::string* diagnostics = nullptr,
+    bool relax = false,
+    unsigned thread_count = 1
+) -> std::vector<std::uint16_t> {
+    std::ostringstream messages;
+    DiagnosticRedirect const redirect(messages);
+
+    Parser parser(code);
+    std::vector<Instruction> instructions = parser.parse_instructions();
+    Assembler assembler(std::move(instructions), parser.symbols());
+    assembler.set_relax_branches(relax);
+    std::vector<std::uint16_t> words =
+        thread_count == 1 ? assembler.run() : assembler.run_parallel(thread_count, 1);
+    if (diagnostics != nullptr) {
+        *diagnostics = messages.str();
+    }
+    return words;
+}
+
+/// Assembles `code` with relaxation, and returns the words, or an empty vector after an error.
+inline auto assemble_relaxed(std::string const& code, unsigned thread_count = 1)
+    -> std::vector<std::uint16_t> {
+    return assemble(code, nullptr, true, thread_count);
+}
+
+/// Assembles `code` in one pass, and returns the words, or an empty vector after an error. The
+/// diagnostic messages are stored in `*diagnostics`.
+inline auto assemble_one_pass(std::string const& code, std::string* diagnostics = nullptr)
+    -> std::vector<std::uint16_t> {
+    std::ostringstream messages;
+    DiagnosticRedirect const redirect(messages);
+
+    Parser parser(code);
+    OnePassAssembler assembler(parser.symbols());
+    bool const ok = assembler.run(parser.parse_instructions());
+    if (diagnostics != nullptr) {
+        *diagnostics = messages.str();
+    }
+    return ok ? assembler.words() : std::vector<std::uint16_t>();
+}
+
+#endif  // ASSEMBLER_UNITTEST_ASSEMBLE_HPP
@@ -0,0 +1,185 @@
+#include "assembler/assembler.hpp"
+#include "assembler/diagnostic.hpp"
+#include "assembler/instruction.hpp"
+#include "assembler/parser.hpp"
+
+#include "assemble.hpp"
+
+#include "gtest/gtest.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+/// Returns `words` followed by `count` zeros.
+auto with_zeros(std::vector<std::uint16_t> words, std::size_t count)
+    -> std::vector<std::uint16_t> {
+    words.resize(words.size() + count, 0);
+    return words;
+}
+}  // namespace
+
+TEST(BranchRelaxationTest, OffRange) {
+    std::string const code = ".ORIG x3000\nBRz FAR\n.BLKW 300\nFAR HALT\n.END\n";
+
+    // Without relaxation, the offset is reported.
+    std::string diagnostics;
+    EXPECT_TRUE(assemble(code, &diagnostics).empty());
+    EXPECT_NE(diagnostics.find("out of range"), std::string::npos) << diagnostics;
+
+    // BRnp #3; LD R7, #1; JMP R7; .FILL FAR, where `FAR` is at x3000 + 4 + 300.
+    std::vector<std::uint16_t> expected = with_zeros({ 0x0A03, 0x2E01, 0xC1C0, 0x3130 }, 300);
+    expected.push_back(0xF025);
+    EXPECT_EQ(assemble_relaxed(code), expected);
+}
+
+TEST(BranchRelaxationTest, InRange) {
+    // Labels within range are left alone.
+    EXPECT_EQ(
+        assemble_relaxed(".ORIG x3000\nA BRz B\nLD R0, A\nB JSR A\n.END\n"),
+        (std::vector<std::uint16_t> { 0x0401, 0x21FE, 0x4FFD })
+    );
+}
+
+TEST(BranchRelaxationTest, Forms) {
+    // Backward references from beyond the range of `JSR`, to `A` at x3000.
+    std::string const code =
+        ".ORIG x3000\nA HALT\n.BLKW 1100\nBR A\nJSR A\nLD R1, A\nLEA R2, A\nST R3, A\n.END\n";
+    std::vector<std::uint16_t> expected = with_zeros({ 0xF025 }, 1100);
+    std::vector<std::uint16_t> const relaxed = {
+        0x2E01, 0xC1C0, 0x3000,          // BR A
+        0x2E02, 0x41C0, 0x0E01, 0x3000,  // JSR A
+        0xA201, 0x0E01, 0x3000,          // LD R1, A
+        0x2401, 0x0E01, 0x3000,          // LEA R2, A
+        0xB601, 0x0E01, 0x3000,          // ST R3, A
+    };
+    expected.insert(expected.end(), relaxed.begin(), relaxed.end());
+    EXPECT_EQ(assemble_relaxed(code), expected);
+
+    // The offset of `JSR` has 11 bits, so it still reaches over 1022 words.
+    EXPECT_EQ(assemble_relaxed(".ORIG x3000\nA JSR B\n.BLKW 1022\nB JSR A\n.END\n")[0], 0x4BFE);
+}
+
+TEST(BranchRelaxationTest, Cascade) {
+    // `BR A` is in range until `LD R0, FAR` grows by 2 words.
+    std::string const code =
+        ".ORIG x3000\nBRnzp A\nLD R0, FAR\n.BLKW 253\nA HALT\n.BLKW 300\nFAR .FILL #1\n.END\n";
+    std::vector<std::uint16_t> expected =
+        with_zeros({ 0x2E01, 0xC1C0, 0x3103, 0xA001, 0x0E01, 0x3230 }, 253);
+    expected.push_back(0xF025);
+    expected = with_zeros(expected, 300);
+    expected.push_back(0x0001);
+    EXPECT_EQ(assemble_relaxed(code), expected);
+    EXPECT_EQ(assemble_relaxed(code, 2), expected);
+}
+
+TEST(BranchRelaxationTest, Sections) {
+    EXPECT_EQ(
+        assemble_relaxed(".ORIG x3000\nLD R0, FAR\n.END\n.ORIG x5000\nFAR .FILL #7\n.END\n"),
+        (std::vector<std::uint16_t> { 0xA001, 0x0E01, 0x5000, 0x0007 })
+    );
+}
+
+TEST(BranchRelaxationTest, Constants) {
+    // A constant is reached through its value, rather than through the row of its `.EQU`. A
+    // constant that depends on labels is relaxed whether or not it is in range.
+    std::string const code = ".ORIG x3000\nBRz FAR\nJSR FAR\nBRz NEAR\nBR NEXT\nHALT\n"
+                             "FAR .EQU x4000\nNEAR .EQU x3001\nNEXT .EQU FAR+1\n.END\n";
+    std::vector<std::uint16_t> const expected = {
+        0x0A03, 0x2E01, 0xC1C0, 0x4000,  // BRz FAR
+        0x2E02, 0x41C0, 0x0E01, 0x4000,  // JSR FAR
+        0x05F8,                          // BRz NEAR
+        0x2E01, 0xC1C0, 0x4001,          // BR NEXT
+        0xF025,
+    };
+    EXPECT_EQ(assemble_relaxed(code), expected);
+    EXPECT_EQ(assemble_relaxed(code, 2), expected);
+}
+
+TEST(BranchRelaxationTest, Unrelaxable) {
+    // `LDI` has no longer form, and undefined labels are reported as usual.
+    EXPECT_TRUE(
+        assemble_relaxed(".ORIG x3000\nLDI R0, FAR\n.BLKW 300\nFAR HALT\n.END\n").empty()
+    );
+    EXPECT_TRUE(assemble_relaxed(".ORIG x3000\nBR NONE\n.END\n").empty());
+}
+
+TEST(BranchRelaxationTest, MatchesFixpoint) {
+    // Random programs of references across blocks, whose relaxed rows are compared with those of
+    // a fixpoint that reassigns all addresses in each round.
+    std::mt19937 random(42);
+    char const* const forms[] = { "BRz", "BR", "JSR", "LD R1,", "LEA R2,", "ST R3," };
+    std::uint16_t const relaxed_sizes[] = { 4, 3, 4, 3, 3, 3 };
+    unsigned const ranges[] = { 9, 9, 11, 9, 9, 9 };
+
+    for (int round = 0; round != 20; ++round) {
+        std::size_t const row_count = 300;
+        std::vector<int> forms_of_rows(row_count, -1);
+        std::vector<std::size_t> targets(row_count, 0);
+        std::vector<std::size_t> blocks(row_count, 0);
+
+        std::ostringstream code;
+        code << ".ORIG x0000\n";
+        for (std::size_t row = 0; row != row_count; ++row) {
+            code << 'L' << row << ' ';
+            if (random() % 3 == 0) {
+                blocks[row] = random() % 60;
+                code << ".BLKW " << blocks[row] << '\n';
+            } else {
+                forms_of_rows[row] = static_cast<int>(random() % 6);
+                targets[row] = random() % row_count;
+                code << forms[forms_of_rows[row]] << " L" << targets[row] << '\n';
+            }
+        }
+        code << ".END\n";
+
+        std::vector<std::uint16_t> sizes(row_count);
+        for (std::size_t row = 0; row != row_count; ++row) {
+            sizes[row] = forms_of_rows[row] < 0 ? static_cast<std::uint16_t>(blocks[row]) : 1;
+        }
+        for (bool changed = true; changed;) {
+            // The `.ORIG` row takes the first word.
+            std::vector<long> addresses(row_count, 1);
+            for (std::size_t row = 1; row != row_count; ++row) {
+                addresses[row] = addresses[row - 1] + sizes[row - 1];
+            }
+
+            changed = false;
+            for (std::size_t row = 0; row != row_count; ++row) {
+                int const form = forms_of_rows[row];
+                if (form < 0 || sizes[row] != 1) {
+                    continue;
+                }
+                long const offset = addresses[targets[row]] - addresses[row] - 1;
+                long const limit = 1L << (ranges[form] - 1);
+                if (offset < -limit || offset >= limit) {
+                    sizes[row] = relaxed_sizes[form];
+                    changed = true;
+                }
+            }
+        }
+
+        std::string const source = code.str();
+        for (unsigned const thread_count : { 1u, 3u }) {
+            std::ostringstream diagnostics;
+            DiagnosticRedirect const redirect(diagnostics);
+            Parser parser(source);
+            Assembler assembler(parser.parse_instructions(), parser.symbols());
+            assembler.set_relax_branches(true);
+            std::vector<std::uint16_t> const words =
+                thread_count == 1 ? assembler.run() : assembler.run_parallel(thread_count, 16);
+            ASSERT_FALSE(words.empty()) << diagnostics.str();
+
+            // Skip the `.ORIG` and `.END` rows.
+            std::vector<std::uint16_t> const& word_counts = assembler.get_program().word_counts();
+            EXPECT_EQ(
+                std::vector<std::uint16_t>(word_counts.begin() + 1, word_counts.end() - 1),
+                sizes
+            ) << "round " << round << ", " << thread_count << " threads";
+        }
+    }
+}
@@ -0,0 +1,185 @@
+#include "assembler/assembler.hpp"
+#include "assembler/diagnostic.hpp"
+#include "assembler/instruction.hpp"
+#include "assembler/line_index.hpp"
+#include "assembler/parser.hpp"
+
+#include "gtest/gtest.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+/// A sink that keeps the messages of the diagnostics it receives.
+class MessageSink : public DiagnosticSink {
+public:
+    void consume(Diagnostic const& diagnostic) override {
+        std::ostringstream out;
+        write_message(out, diagnostic);
+        messages.push_back(out.str());
+    }
+
+    std::vector<std::string> messages;
+};
+
+auto message(Diagnostic const& diagnostic) -> std::string {
+    std::ostringstream out;
+    write_message(out, diagnostic);
+    return out.str();
+}
+}  // namespace
+
+TEST(DiagnosticTest, WriteMessage) {
+    Diagnostic const diagnostic = {
+        DiagnosticKind::InvalidNumber,
+        0,
+        3,
+        { diagnostic_argument("#1x") },
+    };
+    EXPECT_EQ(
+        message(diagnostic),
+        "at token `#1x`: error when constructing an operand: invalid number `#1x`"
+    );
+
+    // Placeholders in the arguments are not replaced.
+    Diagnostic const nested = {
+        DiagnosticKind::LabelNotFound,
+        0,
+        0,
+        { diagnostic_argument("{1}"), diagnostic_argument(42) },
+    };
+    EXPECT_EQ(message(nested), "label `{1}` in instruction `42` not found");
+}
+
+TEST(DiagnosticTest, Engine) {
+    std::string const code = ".ORIG x3000\nADD R1, R1, #100\n";
+    LineIndex const index(code.data(), code.data() + code.size());
+    std::ostringstream stream;
+    DiagnosticRedirect const redirect(stream);
+
+    DiagnosticEngine engine;
+    {
+        DiagnosticEngine::Scope const scope(engine);
+        Parser parser(code);
+        std::vector<Instruction> const instructions = parser.parse_instructions();
+        ASSERT_EQ(instructions.size(), 2u);
+        EXPECT_FALSE(instructions[1].validate_and_emit_diagnostics());
+        report_error(DiagnosticKind::MissingOrig, 0, 5, "HALT");
+    }
+
+    // Nothing is written until the engine is flushed.
+    EXPECT_EQ(stream.str(), "");
+    ASSERT_EQ(engine.error_count(), 2u);
+    ASSERT_EQ(engine.diagnostics().size(), 2u);
+    EXPECT_EQ(engine.diagnostics()[0].kind, DiagnosticKind::ImmediateOutOfRange);
+    EXPECT_EQ(engine.diagnostics()[0].begin, 12u);
+    EXPECT_EQ(engine.diagnostics()[0].arguments.size(), 4u);
+
+    std::ostringstream out;
+    TextDiagnosticSink sink(out, &index);
+    engine.flush(sink);
+    EXPECT_EQ(
+        out.str(),
+        "2:1: error: immediate operand #100 of instruction `ADD R1, R1, #100` is out of range "
+        "[-16, 15]\n"
+        "1:1: error: expected the first instruction to be `.ORIG`, but got `HALT`\n"
+    );
+    EXPECT_EQ(engine.error_count(), 0u);
+    EXPECT_TRUE(engine.diagnostics().empty());
+
+    // Without an engine, diagnostics are rendered right away.
+    report_error(DiagnosticKind::MissingOrig, 0, 5, "HALT");
+    EXPECT_EQ(
+        stream.str(),
+        "error: expected the first instruction to be `.ORIG`, but got `HALT`\n"
+    );
+}
+
+TEST(DiagnosticTest, MaxErrors) {
+    DiagnosticEngine engine(2);
+    {
+        DiagnosticEngine::Scope const scope(engine);
+        for (int i = 0; i != 5; ++i) {
+            EXPECT_EQ(engine.at_limit(), i >= 2);
+            report_error(DiagnosticKind::LabelNotFound, 0, 0, i, "BR L");
+        }
+    }
+
+    EXPECT_EQ(engine.error_count(), 5u);
+    EXPECT_EQ(engine.diagnostics().size(), 2u);
+
+    MessageSink sink;
+    engine.flush(sink);
+    EXPECT_EQ(
+        sink.messages,
+        std::vector<std::string>({
+            "label `0` in instruction `BR L` not found",
+            "label `1` in instruction `BR L` not found",
+            "too many errors, 3 more not shown",
+        })
+    );
+}
+
+TEST(DiagnosticTest, NestedScopesAndForward) {
+    DiagnosticEngine outer;
+    DiagnosticEngine inner;
+    {
+        DiagnosticEngine::Scope const outer_scope(outer);
+        report_error(DiagnosticKind::MissingOrig, 0, 0, "a");
+        {
+            DiagnosticEngine::Scope const inner_scope(inner);
+            report_error(DiagnosticKind::MissingOrig, 0, 0, "b");
+        }
+        report_error(DiagnosticKind::MissingOrig, 0, 0, "c");
+        inner.forward();
+    }
+
+    EXPECT_TRUE(inner.diagnostics().empty());
+    MessageSink sink;
+    outer.flush(sink);
+    EXPECT_EQ(
+        sink.messages,
+        std::vector<std::string>({
+            "expected the first instruction to be `.ORIG`, but got `a`",
+            "expected the first instruction to be `.ORIG`, but got `c`",
+            "expected the first instruction to be `.ORIG`, but got `b`",
+        })
+    );
+}
+
+TEST(DiagnosticTest, ConcurrentAssemblies) {
+    // Each thread assembles its own program into its own engine, so the diagnostics of different
+    // programs never mix.
+    std::size_t const thread_count = 4;
+    std::vector<DiagnosticEngine> engines(thread_count);
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i != thread_count; ++i) {
+        threads.emplace_back([&engines, i]() {
+            DiagnosticEngine::Scope const scope(engines[i]);
+            std::string const label = "MISSING" + std::string(i + 1, 'X');
+            for (int repetition = 0; repetition != 100; ++repetition) {
+                std::string const code = ".ORIG x3000\nBR " + label + "\n.END\n";
+                Parser parser(code);
+                Assembler assembler(parser.parse_instructions(), parser.symbols());
+                EXPECT_TRUE(assembler.run().empty());
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    for (std::size_t i = 0; i != thread_count; ++i) {
+        std::string const expected =
+            "label `MISSING" + std::string(i + 1, 'X') + "` in instruction `BR MISSING"
+            + std::string(i + 1, 'X') + "` not found";
+        ASSERT_EQ(engines[i].error_count(), 100u);
+        for (Diagnostic const& diagnostic : engines[i].diagnostics()) {
+            EXPECT_EQ(message(diagnostic), expected);
+        }
+    }
+}
@@ -0,0 +1,144 @@
+#include "assembler/expression.hpp"
+
+#include "assembler/assembler.hpp"
+#include "assembler/instruction.hpp"
+#include "assembler/operand.hpp"
+#include "assembler/parser.hpp"
+#include "assembler/symbol.hpp"
+
+#include "assemble.hpp"
+
+#include "gtest/gtest.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+/// Parses `text` as an expression, and returns its terms, or an empty vector after an error.
+auto parse(std::string const& text, OperandConstructionErrorType* error = nullptr)
+    -> std::vector<ExpressionTerm> {
+    std::vector<ExpressionTerm> terms;
+    OperandConstructionErrorType const result =
+        parse_expression(text.data(), text.data() + text.size(), &terms);
+    if (error != nullptr) {
+        *error = result;
+    }
+    if (result != OperandConstructionErrorType::NoError) {
+        terms.clear();
+    }
+    return terms;
+}
+}  // namespace
+
+TEST(ExpressionTest, Parse) {
+    SymbolPool pool;
+    SymbolPool::Scope const scope(&pool);
+    std::vector<ExpressionTerm> const terms = parse("TABLE+3-x10+#-1-b11");
+    ASSERT_EQ(terms.size(), 5);
+    EXPECT_TRUE(terms[0].is_label);
+    EXPECT_FALSE(terms[0].negative);
+    EXPECT_EQ(Symbol::from_id(terms[0].payload).str(), "TABLE");
+    EXPECT_FALSE(terms[1].is_label);
+    EXPECT_FALSE(terms[1].negative);
+    EXPECT_EQ(terms[1].payload, 3);
+    EXPECT_TRUE(terms[2].negative);
+    EXPECT_EQ(terms[2].payload, 0x10);
+    EXPECT_FALSE(terms[3].negative);
+    EXPECT_EQ(terms[3].payload, 0xFFFF);
+    EXPECT_TRUE(terms[4].negative);
+    EXPECT_EQ(terms[4].payload, 3);
+
+    // Empty terms, registers, opcodes, and numbers out of range are errors.
+    OperandConstructionErrorType error = OperandConstructionErrorType::NoError;
+    for (char const* text : { "A+", "A++B", "+A", "A+R1", "A-ADD", "A+.FILL" }) {
+        EXPECT_TRUE(parse(text, &error).empty()) << text;
+        EXPECT_EQ(error, OperandConstructionErrorType::InvalidExpression) << text;
+    }
+    EXPECT_TRUE(parse("A+#70000", &error).empty());
+    EXPECT_EQ(error, OperandConstructionErrorType::IntegerOverflow);
+}
+
+TEST(ExpressionTest, Operands) {
+    // The words are at x3000, x3001, ..., and `TABLE` is x3005.
+    std::string const code =
+        ".ORIG x3000\n"
+        "LEA R0, TABLE+2\n"
+        "LD R1, TABLE-1\n"
+        "BRnzp NEXT-1\n"
+        "NEXT .FILL END-TABLE\n"
+        ".FILL TABLE\n"
+        "TABLE .BLKW 3\n"
+        "END .FILL x10+#-1\n"
+        ".END\n";
+    std::vector<std::uint16_t> const expected = {
+        0xE006, 0x2202, 0x0FFF, 0x0003, 0x3005, 0x0000, 0x0000, 0x0000, 0x000F,
+    };
+    EXPECT_EQ(assemble(code), expected);
+
+    // Parallel translation evaluates the expressions once, before the workers start.
+    Parser parser(code);
+    Assembler assembler(parser.parse_instructions(), parser.symbols());
+    EXPECT_EQ(assembler.run_parallel(3, 2), expected);
+}
+
+TEST(ExpressionTest, Constants) {
+    // Constants may refer to constants and labels defined anywhere, in any order.
+    std::string const code =
+        ".ORIG x3000\n"
+        "SIZE .EQU COUNT+COUNT\n"
+        "COUNT .EQU #3\n"
+        "LAST .EQU TABLE+SIZE-1\n"
+        "LEA R0, LAST\n"
+        ".FILL SIZE\n"
+        ".FILL LAST-TABLE\n"
+        "TABLE .BLKW 1\n"
+        ".END\n";
+    // `.EQU` takes no memory, so `TABLE` is x3003.
+    EXPECT_EQ(
+        assemble(code),
+        (std::vector<std::uint16_t> { 0xE007, 0x0006, 0x0005, 0x0000 })
+    );
+
+    // A constant that holds an address is the address itself, both as a word and as a target.
+    EXPECT_EQ(
+        assemble(
+            ".ORIG x3000\nLD R0, K\nK .EQU x3003\n.FILL T\nL .EQU T+2\n.FILL L\nT HALT\n.END\n"
+        ),
+        (std::vector<std::uint16_t> { 0x2002, 0x3003, 0x3005, 0xF025 })
+    );
+}
+
+TEST(ExpressionTest, Errors) {
+    std::string diagnostics;
+
+    EXPECT_TRUE(assemble(".ORIG x3000\nA .EQU B+1\nB .EQU A-1\n.END\n", &diagnostics).empty());
+    EXPECT_NE(diagnostics.find("depends on itself"), std::string::npos) << diagnostics;
+
+    EXPECT_TRUE(assemble(".ORIG x3000\nA .EQU A\n.END\n", &diagnostics).empty());
+    EXPECT_NE(diagnostics.find("constant `A`"), std::string::npos) << diagnostics;
+
+    EXPECT_TRUE(assemble(".ORIG x3000\nA .EQU NONE+1\n.END\n", &diagnostics).empty());
+    EXPECT_NE(diagnostics.find("label `NONE`"), std::string::npos) << diagnostics;
+
+    EXPECT_TRUE(assemble(".ORIG x3000\nLEA R0, NONE+1\n.END\n", &diagnostics).empty());
+    EXPECT_NE(diagnostics.find("NONE+1"), std::string::npos) << diagnostics;
+
+    EXPECT_TRUE(assemble(".ORIG x3000\n.EQU #1\n.END\n", &diagnostics).empty());
+    EXPECT_NE(diagnostics.find("requires a label"), std::string::npos) << diagnostics;
+
+    EXPECT_TRUE(assemble(".ORIG x3000\nLEA R0, A+R1\nA .FILL #0\n.END\n", &diagnostics).empty());
+    EXPECT_FALSE(diagnostics.empty());
+
+    // Immediate fields only take numbers, whose range is checked when they are parsed.
+    EXPECT_TRUE(assemble(".ORIG x3000\nADD R0, R0, A+1\nA .FILL #0\n.END\n", &diagnostics).empty());
+    EXPECT_FALSE(diagnostics.empty());
+
+    // A single pass cannot wait for the labels that an expression, or a constant, refers to.
+    for (char const* const line : { "LEA R0, A+1", "B .EQU A", "B .EQU A-1" }) {
+        std::string const one_pass_code = std::string(".ORIG x3000\n") + line + "\nA HALT\n.END\n";
+        EXPECT_TRUE(assemble_one_pass(one_pass_code, &diagnostics).empty()) << line;
+        EXPECT_NE(diagnostics.find("single pass"), std::string::npos) << diagnostics;
+    }
+}
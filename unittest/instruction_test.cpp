@@ -1,5 +1,6 @@
 #include "assembler/instruction.hpp"
 #include "assembler/operand.hpp"
+#include "assembler/symbol.hpp"
 #include "assembler/token.hpp"
 
 #include "gtest/gtest.h"
@@ -10,6 +11,7 @@
 #include <cstdio>
 #include <cstring>
 #include <limits>
+#include <sstream>
 
 namespace {
 /// Helper function to construct a `Token` object with the specified `kind` and `content`, allowing
@@ -82,8 +84,6 @@ void check_integer_range_conversion(int beg, int end, Func constructor) {
 TEST(InstructionTest, AddIntegerOperand) {
     // Valid immediate values.
     {
-        Instruction instr;
-
         char const* const inputs[] = {
             "#0",      "+0",      "-0",      "#1",     "#+1",      "#-1",
             "#000",    "#-000",   "+000",    "#42",    "#0042",    "#-123",
@@ -101,11 +101,15 @@ TEST(InstructionTest, AddIntegerOperand) {
         // We can also use `std::size()` to get the size of the array, which is a C++17 feature.
         constexpr std::size_t arr_size = sizeof(inputs) / sizeof(inputs[0]);
         for (std::size_t i = 0; i != arr_size; ++i) {
+            // An instruction stores at most `Instruction::max_operand_count` operands, so every
+            // input gets its own instruction.
+            Instruction instr;
+
             EXPECT_EQ(
                 instr.add_operand(construct_token(Token::Immediate, inputs[i])),
                 OperandConstructionErrorType::NoError
             );
-            EXPECT_EQ(instr.operand_size(), i + 1);
+            EXPECT_EQ(instr.operand_size(), 1);
             EXPECT_EQ(instr.get_operands().back().type(), Operand::Immediate);
             EXPECT_EQ(instr.get_operands().back().immediate_value(), expected[i]);
         }
@@ -151,8 +155,6 @@ TEST(InstructionTest, AddIntegerOperand) {
 
     // Valid regular decimal numbers.
     {
-        Instruction instr;
-
         char const* const inputs[] = {
             "0",  "+0",   "-0",   "1",      "+1",   "-1",     "000",   "-000",   "+000",
             "42", "0042", "-123", "-00123", "5432", "-12123", "32767", "-32768", "65535",
@@ -164,11 +166,15 @@ TEST(InstructionTest, AddIntegerOperand) {
         // We can also use `std::size()` to get the size of the array, which is a C++17 feature.
         constexpr std::size_t arr_size = sizeof(inputs) / sizeof(inputs[0]);
         for (std::size_t i = 0; i != arr_size; ++i) {
+            // An instruction stores at most `Instruction::max_operand_count` operands, so every
+            // input gets its own instruction.
+            Instruction instr;
+
             EXPECT_EQ(
                 instr.add_operand(construct_token(Token::Number, inputs[i])),
                 OperandConstructionErrorType::NoError
             );
-            EXPECT_EQ(instr.operand_size(), i + 1);
+            EXPECT_EQ(instr.operand_size(), 1);
             EXPECT_EQ(instr.get_operands().back().type(), Operand::Number);
             EXPECT_EQ(instr.get_operands().back().regular_decimal(), expected[i]);
         }
@@ -250,6 +256,8 @@ TEST(InstructionTest, AddIntegerOperand) {
 }
 
 TEST(InstructionTest, AddStringLiteralOperand) {
+    SymbolPool pool;
+    SymbolPool::Scope const scope(&pool);
     Instruction instr;
 
     // Valid string literals.
@@ -291,6 +299,8 @@ TEST(InstructionTest, AddStringLiteralOperand) {
 }
 
 TEST(InstructionTest, AddLabelOperand) {
+    SymbolPool pool;
+    SymbolPool::Scope const scope(&pool);
     Instruction instr;
 
     // Valid label operands.
@@ -360,6 +370,8 @@ TEST(InstructionTest, AddInvalidOperand) {
 }
 
 TEST(InstructionTest, SetLabel) {
+    SymbolPool pool;
+    SymbolPool::Scope const scope(&pool);
     Instruction instr;
 
     instr.set_label("abc");
@@ -373,6 +385,15 @@ TEST(InstructionTest, SetLabel) {
 
     instr.set_label(construct_token(Token::Label, "World"));
     EXPECT_EQ(instr.get_label(), "World");
+
+    // Labels are interned, so equal labels have equal symbols.
+    Instruction other;
+    other.set_label("World");
+    EXPECT_EQ(other.get_label_symbol(), instr.get_label_symbol());
+    EXPECT_TRUE(other.has_label());
+
+    other.set_label("");
+    EXPECT_FALSE(other.has_label());
 }
 
 TEST(InstructionTest, SetOpcode) {
@@ -396,3 +417,31 @@ TEST(InstructionTest, SetOpcode) {
     instr.set_opcode(construct_token(Token::Pseudo, ".END"));
     EXPECT_EQ(instr.get_opcode(), Instruction::END);
 }
+
+TEST(InstructionTest, OperandSignatures) {
+    auto const signature_count = [](Instruction::Opcode opcode) {
+        auto const signatures = Instruction::operand_signatures(opcode);
+        return static_cast<std::size_t>(signatures.second - signatures.first);
+    };
+
+    // `ADD` accepts a register or an immediate as its third operand.
+    auto const add = Instruction::operand_signatures(Instruction::ADD);
+    ASSERT_EQ(signature_count(Instruction::ADD), 2);
+    EXPECT_EQ(add.first[0].size, 3);
+    EXPECT_EQ(add.first[0].types[2], Operand::Register);
+    EXPECT_EQ(add.first[1].types[0], Operand::Register);
+    EXPECT_EQ(add.first[1].types[2], Operand::Immediate);
+
+    auto const blkw = Instruction::operand_signatures(Instruction::BLKW);
+    ASSERT_EQ(signature_count(Instruction::BLKW), 1);
+    EXPECT_EQ(blkw.first->size, 1);
+    EXPECT_EQ(blkw.first->types[0], Operand::Number);
+
+    // Instructions without operands, including unknown ones, have a single empty signature.
+    for (Instruction::Opcode const opcode :
+         { Instruction::UnknownOp, Instruction::RET, Instruction::HALT, Instruction::END }) {
+        int const value = opcode;
+        ASSERT_EQ(signature_count(opcode), 1) << value;
+        EXPECT_EQ(Instruction::operand_signatures(opcode).first->size, 0) << value;
+    }
+}
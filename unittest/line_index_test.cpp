@@ -0,0 +1,138 @@
+#include "assembler/diagnostic.hpp"
+#include "assembler/instruction.hpp"
+#include "assembler/line_index.hpp"
+#include "assembler/parallel_parser.hpp"
+#include "assembler/parser.hpp"
+#include "assembler/streaming_parser.hpp"
+#include "assembler/token_stream.hpp"
+
+#include "gtest/gtest.h"
+
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+auto locate(LineIndex const& index, std::size_t offset) -> std::string {
+    SourceLocation const location = index.locate(offset);
+    return std::to_string(location.line) + ":" + std::to_string(location.column);
+}
+}  // namespace
+
+TEST(LineIndexTest, Locate) {
+    std::string const code = "AB\n\nC\r\nDEF";
+    LineIndex const index(code.data(), code.data() + code.size());
+
+    EXPECT_EQ(index.size(), code.size());
+    EXPECT_EQ(locate(index, 0), "1:1");
+    EXPECT_EQ(locate(index, 1), "1:2");
+    // A newline character belongs to the line it ends.
+    EXPECT_EQ(locate(index, 2), "1:3");
+    EXPECT_EQ(locate(index, 3), "2:1");
+    EXPECT_EQ(locate(index, 4), "3:1");
+    EXPECT_EQ(locate(index, 6), "3:3");
+    EXPECT_EQ(locate(index, 7), "4:1");
+    EXPECT_EQ(locate(index, 9), "4:3");
+    // The end of the source code is located just past the last character.
+    EXPECT_EQ(locate(index, 10), "4:4");
+
+    std::string const empty;
+    LineIndex const empty_index(empty.data(), empty.data());
+    EXPECT_EQ(locate(empty_index, 0), "1:1");
+}
+
+TEST(LineIndexTest, ReportError) {
+    std::string const code = ".ORIG x3000\n  ADD R1, R1, #1\n";
+    LineIndex const index(code.data(), code.data() + code.size());
+    std::ostringstream out;
+    DiagnosticRedirect const redirect(out);
+
+    report_error(DiagnosticKind::MissingOrig, 14, 17, "a");
+    {
+        DiagnosticSource const source(&index);
+        report_error(DiagnosticKind::MissingOrig, 14, 17, "b");
+        // Offsets outside of the source code have no location.
+        report_error(DiagnosticKind::MissingOrig, code.size() + 1, code.size() + 1, "c");
+        report_error(
+            DiagnosticKind::MissingOrig,
+            Diagnostic::unknown_offset,
+            Diagnostic::unknown_offset,
+            "d"
+        );
+    }
+    report_error(DiagnosticKind::MissingOrig, 14, 17, "e");
+
+    EXPECT_EQ(
+        out.str(),
+        "error: expected the first instruction to be `.ORIG`, but got `a`\n"
+        "2:3: error: expected the first instruction to be `.ORIG`, but got `b`\n"
+        "error: expected the first instruction to be `.ORIG`, but got `c`\n"
+        "error: expected the first instruction to be `.ORIG`, but got `d`\n"
+        "error: expected the first instruction to be `.ORIG`, but got `e`\n"
+    );
+    EXPECT_EQ(diagnostic_source(), nullptr);
+}
+
+TEST(LineIndexTest, InstructionOffsets) {
+    std::string const code = ".ORIG x3000\n\nLOOP\n  ADD R1, R1, #1 ; comment\n  BRp LOOP\n.END\n";
+    std::vector<std::size_t> const expected = { 0, 13, 47, 56 };
+
+    Parser parser(code);
+    std::vector<Instruction> const instructions = parser.parse_instructions();
+    ASSERT_EQ(instructions.size(), expected.size());
+    for (std::size_t i = 0; i != expected.size(); ++i) {
+        EXPECT_EQ(instructions[i].source_offset(), expected[i]) << "instruction " << i;
+    }
+
+    // Offsets are relative to the whole source code when parsing pre-lexed tokens in parallel, and
+    // to the whole input when parsing in windows.
+    TokenStream const tokens(code.data(), code.data() + code.size(), 4, 1);
+    std::vector<Instruction> const parallel = parse_parallel(tokens, parser.symbols(), 4, 1);
+    ASSERT_EQ(parallel.size(), expected.size());
+    for (std::size_t i = 0; i != expected.size(); ++i) {
+        EXPECT_EQ(parallel[i].source_offset(), expected[i]) << "instruction " << i;
+    }
+
+    std::istringstream input(code);
+    StreamingParser streaming_parser(input, 8);
+    std::vector<std::size_t> streaming;
+    streaming_parser.parse_instructions([&](Instruction instr) {
+        streaming.push_back(instr.source_offset());
+    });
+    EXPECT_EQ(streaming, expected);
+
+    // An instruction that was not parsed has no location.
+    std::ostringstream out;
+    DiagnosticRedirect const redirect(out);
+    LineIndex const index(code.data(), code.data() + code.size());
+    DiagnosticSource const source(&index);
+
+    Instruction instr;
+    EXPECT_EQ(instr.source_offset(), Instruction::unknown_source_offset);
+    instr.report_error(DiagnosticKind::MissingOrig, "HALT");
+    instructions[2].report_error(DiagnosticKind::MissingOrig, "HALT");
+    EXPECT_EQ(
+        out.str(),
+        "error: expected the first instruction to be `.ORIG`, but got `HALT`\n"
+        "5:3: error: expected the first instruction to be `.ORIG`, but got `HALT`\n"
+    );
+}
+
+TEST(LineIndexTest, ParserDiagnostics) {
+    std::string const code = ".ORIG x3000\nLOOP ADD R1,, R1\n";
+    LineIndex const index(code.data(), code.data() + code.size());
+    std::ostringstream out;
+    DiagnosticRedirect const redirect(out);
+    DiagnosticSource const source(&index);
+
+    Parser parser(code);
+    parser.parse_instructions();
+
+    TokenStream const tokens(code.data(), code.data() + code.size());
+    parse_parallel(tokens, parser.symbols(), 2, 1);
+
+    std::string const expected = "2:13: error: at token `,`: error when constructing an operand: "
+                                 "cannot construct an operand from token kind `Token::Comma`\n";
+    EXPECT_EQ(out.str(), expected + expected);
+}
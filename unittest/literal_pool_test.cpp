@@ -0,0 +1,232 @@
+#include "assembler/assembler.hpp"
+#include "assembler/diagnostic.hpp"
+#include "assembler/instruction.hpp"
+#include "assembler/parser.hpp"
+
+#include "assemble.hpp"
+
+#include "gtest/gtest.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+/// Returns a line of `count` copies of `ADD R0, R0, #1`.
+auto adds(std::size_t count) -> std::string {
+    std::string lines;
+    for (std::size_t i = 0; i != count; ++i) {
+        lines += "ADD R0, R0, #1\n";
+    }
+    return lines;
+}
+}  // namespace
+
+TEST(LiteralPoolTest, Loads) {
+    std::string const code =
+        ".ORIG x3000\nLD R0, =x1234\nLDI R1, =FAR\nLD R2, =x1234\nSTI R2, =FAR\nLD R3, =#-1\n"
+        "HALT\n.BLKW 2\nFAR .FILL #7\nLD R4, =FAR\nLD R5, =42\n.END\n";
+
+    // The first pool follows `HALT`, and the second one ends the section, behind a `BRnzp`.
+    // `LD R4, =FAR` reaches back into the first pool.
+    std::vector<std::uint16_t> const expected = {
+        0x2005, 0xA205, 0x2403, 0xB403, 0x2603, 0xF025,  // x3000
+        0x1234, 0x300B, 0xFFFF,                          // x3006, the first pool
+        0x0000, 0x0000, 0x0007,                          // x3009
+        0x29FA, 0x2A01,                                  // x300C
+        0x0E01, 0x002A,                                  // x300E, the second pool
+    };
+    EXPECT_EQ(assemble(code), expected);
+
+    Parser parser(code);
+    Assembler assembler(parser.parse_instructions(), parser.symbols());
+    ASSERT_FALSE(assembler.run().empty());
+    ASSERT_EQ(assembler.literal_pools().size(), 2);
+    EXPECT_EQ(assembler.literal_pools()[0].row, 6);
+    EXPECT_FALSE(assembler.literal_pools()[0].jump);
+    EXPECT_EQ(assembler.literal_pools()[1].row, 10);
+    EXPECT_TRUE(assembler.literal_pools()[1].jump);
+}
+
+TEST(LiteralPoolTest, Reuse) {
+    // The second load reuses the literal of the first pool, which is still within reach, while
+    // the third one is too far away and gets its own.
+    std::string const code = ".ORIG x3000\nLD R0, =x5\nRET\nLD R1, =x5\n" + adds(300)
+        + "LD R2, =x5\nRET\n.END\n";
+    std::vector<std::uint16_t> const words = assemble(code);
+    ASSERT_EQ(words.size(), 307);
+    EXPECT_EQ(words[0], 0x2001);
+    EXPECT_EQ(words[1], 0xC1C0);
+    EXPECT_EQ(words[2], 0x0005);
+    EXPECT_EQ(words[3], 0x23FE);
+    EXPECT_EQ(words[304], 0x2401);
+    EXPECT_EQ(words[305], 0xC1C0);
+    EXPECT_EQ(words[306], 0x0005);
+}
+
+TEST(LiteralPoolTest, ForcedPool) {
+    // Without a barrier in reach, the pool is placed as late as possible, behind a `BRnzp`.
+    std::vector<std::uint16_t> const words =
+        assemble(".ORIG x3000\nLD R0, =x1234\n" + adds(300) + "HALT\n.END\n");
+    ASSERT_EQ(words.size(), 304);
+    EXPECT_EQ(words[0], 0x20FF);
+    EXPECT_EQ(words[254], 0x1021);
+    EXPECT_EQ(words[255], 0x0E01);
+    EXPECT_EQ(words[256], 0x1234);
+    EXPECT_EQ(words[257], 0x1021);
+    EXPECT_EQ(words[303], 0xF025);
+
+    // A block that does not fit ends the pool before the row that precedes it, since the pool is
+    // never placed right before a block. The second load reaches back into it.
+    std::vector<std::uint16_t> const block_words =
+        assemble(".ORIG x3000\nLD R0, =#1\nLD R1, =#1\n.BLKW 300\n.END\n");
+    ASSERT_EQ(block_words.size(), 304);
+    EXPECT_EQ(block_words[0], 0x2001);
+    EXPECT_EQ(block_words[1], 0x0E01);
+    EXPECT_EQ(block_words[2], 0x0001);
+    EXPECT_EQ(block_words[3], 0x23FE);
+}
+
+TEST(LiteralPoolTest, Tables) {
+    std::string table = "TABLE .FILL #0\n";
+    for (int i = 1; i != 300; ++i) {
+        table += ".FILL #" + std::to_string(i) + "\n";
+    }
+
+    // The pool is placed before `TRAP x25`, rather than within the table.
+    std::vector<std::uint16_t> const words =
+        assemble(".ORIG x3000\nLD R1, =x1234\nTRAP x25\n" + table + ".END\n");
+    ASSERT_EQ(words.size(), 304);
+    EXPECT_EQ(words[0], 0x2201);
+    EXPECT_EQ(words[1], 0x0E01);
+    EXPECT_EQ(words[2], 0x1234);
+    EXPECT_EQ(words[3], 0xF025);
+    for (std::uint16_t i = 0; i != 300; ++i) {
+        EXPECT_EQ(words[4 + i], i);
+    }
+
+    // Without a place before the table, the pool follows it, out of reach.
+    std::string diagnostics;
+    EXPECT_TRUE(
+        assemble(".ORIG x3000\nLD R1, =x1234\n" + table + ".END\n", &diagnostics).empty()
+    );
+    EXPECT_NE(
+        diagnostics.find("offset 301 of literal `=#4660` in instruction `LD R1, =#4660`"),
+        std::string::npos
+    ) << diagnostics;
+}
+
+TEST(LiteralPoolTest, Sections) {
+    // Each section has its own pool, even for the same literal.
+    EXPECT_EQ(
+        assemble(".ORIG x3000\nLD R0, =x7\n.END\n.ORIG x4000\nLD R1, =x7\nHALT\n.END\n"),
+        (std::vector<std::uint16_t> { 0x2001, 0x0E01, 0x0007, 0x2201, 0xF025, 0x0007 })
+    );
+}
+
+TEST(LiteralPoolTest, Errors) {
+    std::string diagnostics;
+    EXPECT_TRUE(assemble(".ORIG x3000\nLD R0, =NONE\n.END\n", &diagnostics).empty());
+    EXPECT_NE(diagnostics.find("label `NONE`"), std::string::npos) << diagnostics;
+
+    // Literals are only accepted where a word is loaded or stored through them.
+    EXPECT_TRUE(assemble(".ORIG x3000\nLEA R0, =x1\n.END\n", &diagnostics).empty());
+    EXPECT_NE(diagnostics.find("should be of type `Label`"), std::string::npos) << diagnostics;
+
+    EXPECT_TRUE(assemble_one_pass(".ORIG x3000\nLD R0, =x1\n.END\n", &diagnostics).empty());
+    EXPECT_NE(diagnostics.find("needs a literal pool"), std::string::npos) << diagnostics;
+}
+
+TEST(LiteralPoolTest, WithinReach) {
+    // Random programs with literals, barriers, blocks, and branches that may be relaxed. Every
+    // load must reach the value of its literal, in both serial and parallel runs.
+    std::mt19937 random(7);
+    char const* const literals[] = { "=x1234", "=#-5", "=L3", "=42", "=L100", "=xBEEF" };
+    std::uint16_t const ops[] = { 0x2000, 0xA000, 0xB000 };
+    char const* const op_names[] = { "LD", "LDI", "STI" };
+
+    for (int round = 0; round != 20; ++round) {
+        std::size_t const row_count = 400;
+        std::vector<int> literal_of_rows(row_count, -1);
+        std::vector<int> op_of_rows(row_count, 0);
+
+        std::ostringstream code;
+        code << ".ORIG x3000\n";
+        for (std::size_t row = 0; row != row_count; ++row) {
+            code << 'L' << row << ' ';
+            unsigned const choice = random() % 20;
+            if (choice < 7) {
+                literal_of_rows[row] = static_cast<int>(random() % 6);
+                op_of_rows[row] = static_cast<int>(random() % 3);
+                code << op_names[op_of_rows[row]] << " R1, " << literals[literal_of_rows[row]];
+            } else if (choice < 8) {
+                code << "BRnzp L" << random() % row_count;
+            } else if (choice < 10) {
+                code << "BRz L" << random() % row_count;
+            } else if (choice < 11) {
+                code << ".BLKW " << random() % 40;
+            } else {
+                code << "ADD R0, R0, #1";
+            }
+            code << '\n';
+        }
+        code << ".END\n";
+
+        std::string const source = code.str();
+        std::vector<std::uint16_t> serial_words;
+        for (unsigned const thread_count : { 1u, 3u }) {
+            std::ostringstream diagnostics;
+            DiagnosticRedirect const redirect(diagnostics);
+            Parser parser(source);
+            Assembler assembler(parser.parse_instructions(), parser.symbols());
+            assembler.set_relax_branches(true);
+            std::vector<std::uint16_t> const words =
+                thread_count == 1 ? assembler.run() : assembler.run_parallel(thread_count, 32);
+            ASSERT_FALSE(words.empty()) << diagnostics.str();
+
+            // The first word is at x3001.
+            ProgramTable const& program = assembler.get_program();
+            auto const word_at = [&](std::size_t address) { return words.at(address - 0x3001); };
+            for (std::size_t row = 0; row != row_count; ++row) {
+                if (literal_of_rows[row] < 0) {
+                    continue;
+                }
+                // Skip the `.ORIG` row.
+                std::uint16_t const address = program.address(row + 1);
+                std::uint16_t const word = word_at(address);
+                ASSERT_EQ(word & 0xF000, ops[op_of_rows[row]]) << "row " << row;
+
+                auto const offset = static_cast<std::int16_t>((word & 0x1FF) << 7) >> 7;
+                std::uint16_t const value = word_at(address + 1 + offset);
+                // A label is loaded one word before its address in the table, which counts the
+                // `.ORIG` row.
+                std::uint16_t const expected[] = {
+                    0x1234,
+                    0xFFFB,
+                    static_cast<std::uint16_t>(program.address(4) - 1),
+                    42,
+                    static_cast<std::uint16_t>(program.address(101) - 1),
+                    0xBEEF,
+                };
+                EXPECT_EQ(value, expected[literal_of_rows[row]]) << "row " << row;
+            }
+
+            // Pools without a `BRnzp` only follow instructions that never fall through.
+            for (Assembler::LiteralPool const& pool : assembler.literal_pools()) {
+                Instruction::Opcode const opcode = program.opcode(pool.row);
+                EXPECT_TRUE(
+                    pool.jump || opcode == Instruction::BRnzp || opcode == Instruction::HALT
+                ) << "row " << pool.row;
+            }
+
+            if (thread_count == 1) {
+                serial_words = words;
+            } else {
+                EXPECT_EQ(words, serial_words) << "round " << round;
+            }
+        }
+    }
+}
@@ -0,0 +1,246 @@
+#include "assembler/assembler.hpp"
+#include "assembler/diagnostic.hpp"
+#include "assembler/instruction.hpp"
+#include "assembler/one_pass_assembler.hpp"
+#include "assembler/parser.hpp"
+#include "assembler/section.hpp"
+#include "assembler/symbol.hpp"
+
+#include "assemble.hpp"
+
+#include "gtest/gtest.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+/// Parses `code`, interning its symbols into `symbols`.
+auto parse(std::string const& code, std::shared_ptr<SymbolPool> const& symbols)
+    -> std::vector<Instruction> {
+    Parser parser(code, symbols);
+    return parser.parse_instructions();
+}
+}  // namespace
+
+TEST(OnePassAssemblerTest, SameResultOnLabs) {
+    for (int lab = 1; lab <= 5; ++lab) {
+        std::string const name = "lab" + std::to_string(lab);
+        std::ifstream input(
+            ASSEMBLER_SOURCE_DIR "/test/code_lc3/" + name + "/" + name + ".asm",
+            std::ios::binary
+        );
+        ASSERT_TRUE(input) << "cannot open " << name;
+        std::string const code(
+            (std::istreambuf_iterator<char>(input)),
+            std::istreambuf_iterator<char>()
+        );
+
+        auto const symbols = std::make_shared<SymbolPool>();
+        Assembler assembler(parse(code, symbols), symbols);
+        std::vector<std::uint16_t> const expected = assembler.run();
+        ASSERT_FALSE(expected.empty()) << name;
+
+        OnePassAssembler one_pass(symbols);
+        EXPECT_TRUE(one_pass.run(parse(code, symbols))) << name;
+        EXPECT_EQ(one_pass.words(), expected) << name;
+        EXPECT_EQ(one_pass.start_address(), assembler.start_address()) << name;
+    }
+}
+
+TEST(OnePassAssemblerTest, ForwardReferences) {
+    // `.ORIG` occupies a word, so `ADD` is at x3001 and `DONE` at x3006.
+    EXPECT_EQ(
+        assemble_one_pass(
+            ".ORIG x3000\nADD R1, R1, #-1\nBRz DONE\nJSR SUB\nBRnzp DONE\nSUB RET\nDONE HALT\n"
+            ".END\n"
+        ),
+        (std::vector<std::uint16_t> { 0x127F, 0x0403, 0x4801, 0x0E01, 0xC1C0, 0xF025 })
+    );
+
+    // A label that is defined after several references patches all of them.
+    EXPECT_EQ(
+        assemble_one_pass(".ORIG x3000\nLEA R0, TEXT\nLD R1, TEXT\nTEXT .FILL #5\n.END\n"),
+        (std::vector<std::uint16_t> { 0xE001, 0x2200, 0x0005 })
+    );
+}
+
+TEST(OnePassAssemblerTest, Constants) {
+    // Constants and expressions that refer to labels defined before them are evaluated at once,
+    // and a forward label in a `.FILL` is patched with its address.
+    std::string const code =
+        ".ORIG x3000\nN .EQU #10\nLD R0, DATA\nTOP ADD R0, R0, #10\nLEA R1, TOP+2\n"
+        "T .EQU TOP-1\n.FILL T\n.FILL LATER\n.FILL M\nDATA .FILL N\nM .EQU x20\nLATER HALT\n"
+        ".END\n";
+    auto const symbols = std::make_shared<SymbolPool>();
+    Assembler assembler(parse(code, symbols), symbols);
+    std::vector<std::uint16_t> const expected = assembler.run();
+    ASSERT_FALSE(expected.empty());
+
+    std::string diagnostics;
+    EXPECT_EQ(assemble_one_pass(code, &diagnostics), expected) << diagnostics;
+    EXPECT_EQ(
+        expected,
+        (std::vector<std::uint16_t> {
+            0x2005, 0x102A, 0xE200, 0x3000, 0x3007, 0x0020, 0x000A, 0xF025 })
+    );
+}
+
+TEST(OnePassAssemblerTest, Sink) {
+    auto const symbols = std::make_shared<SymbolPool>();
+    OnePassAssembler assembler(symbols);
+    std::vector<std::uint16_t> flushed;
+    assembler.set_sink([&](std::uint16_t origin, std::size_t index, std::uint16_t word) {
+        EXPECT_EQ(origin, 0x3000);
+        EXPECT_EQ(index, flushed.size());
+        flushed.push_back(word);
+    });
+
+    std::vector<Instruction> const instructions =
+        parse(".ORIG x3000\nHALT\nBRnzp DONE\nHALT\nDONE HALT\nHALT\n.END\n", symbols);
+    ASSERT_EQ(instructions.size(), 7);
+
+    // Words are passed to the sink as soon as every word before them is final.
+    EXPECT_TRUE(assembler.add(instructions[0]));
+    EXPECT_TRUE(assembler.add(instructions[1]));
+    EXPECT_EQ(flushed.size(), 1);
+    EXPECT_TRUE(assembler.add(instructions[2]));
+    EXPECT_TRUE(assembler.add(instructions[3]));
+    EXPECT_EQ(flushed.size(), 1);
+    EXPECT_TRUE(assembler.add(instructions[4]));
+    EXPECT_EQ(flushed, (std::vector<std::uint16_t> { 0xF025, 0x0E01, 0xF025, 0xF025 }));
+    EXPECT_TRUE(assembler.add(instructions[5]));
+    EXPECT_TRUE(assembler.add(instructions[6]));
+    EXPECT_EQ(flushed, assembler.words());
+}
+
+TEST(OnePassAssemblerTest, Sections) {
+    auto const symbols = std::make_shared<SymbolPool>();
+    OnePassAssembler assembler(symbols);
+    std::vector<std::uint16_t> origins;
+    std::vector<std::size_t> indexes;
+    assembler.set_sink([&](std::uint16_t origin, std::size_t index, std::uint16_t) {
+        origins.push_back(origin);
+        indexes.push_back(index);
+    });
+
+    // A label of a later section is patched into an earlier one.
+    EXPECT_TRUE(assembler.run(parse(
+        ".ORIG x3000\nLD R0, A\nHALT\n.END\n.ORIG x3010\nA .FILL #7\n.END\n.ORIG x2000\n.END\n",
+        symbols
+    )));
+    EXPECT_EQ(assembler.words(), (std::vector<std::uint16_t> { 0x200F, 0xF025, 0x0007 }));
+    EXPECT_EQ(origins, (std::vector<std::uint16_t> { 0x3000, 0x3000, 0x3010 }));
+    EXPECT_EQ(indexes, (std::vector<std::size_t> { 0, 1, 0 }));
+
+    std::vector<Section> const& sections = assembler.sections();
+    ASSERT_EQ(sections.size(), 3);
+    EXPECT_EQ(sections[1].origin, 0x3010);
+    EXPECT_EQ(sections[1].first_word, 2);
+    EXPECT_EQ(sections[1].word_count, 1);
+    EXPECT_EQ(sections[2].origin, 0x2000);
+    EXPECT_EQ(sections[2].word_count, 0);
+}
+
+TEST(OnePassAssemblerTest, Errors) {
+    std::string diagnostics;
+
+    EXPECT_TRUE(assemble_one_pass(".ORIG x3000\nBRnzp MISSING\n.END\n", &diagnostics).empty());
+    EXPECT_NE(diagnostics.find("label `MISSING`"), std::string::npos) << diagnostics;
+    EXPECT_NE(diagnostics.find("not found"), std::string::npos) << diagnostics;
+
+    // The input ends without `.END`, so the undefined label is reported by `finish()`.
+    EXPECT_TRUE(assemble_one_pass(".ORIG x3000\nBRnzp MISSING\n", &diagnostics).empty());
+    EXPECT_NE(diagnostics.find("not found"), std::string::npos) << diagnostics;
+
+    EXPECT_TRUE(assemble_one_pass(".ORIG x3000\nA HALT\nA HALT\n.END\n", &diagnostics).empty());
+    EXPECT_NE(diagnostics.find("redefined"), std::string::npos) << diagnostics;
+
+    EXPECT_TRUE(assemble_one_pass("HALT\n.END\n", &diagnostics).empty());
+    EXPECT_NE(diagnostics.find("expected the first instruction"), std::string::npos);
+
+    EXPECT_TRUE(
+        assemble_one_pass(".ORIG x3000\nHALT\nHALT\n.ORIG x3001\n.END\n", &diagnostics).empty()
+    );
+    EXPECT_NE(diagnostics.find("section at x3001 overlaps"), std::string::npos) << diagnostics;
+
+    // The offset of a forward reference is checked when the label is defined.
+    EXPECT_TRUE(
+        assemble_one_pass(".ORIG x3000\nBRnzp FAR\n.BLKW 300\nFAR HALT\n.END\n", &diagnostics)
+            .empty()
+    );
+    EXPECT_NE(diagnostics.find("out of range"), std::string::npos) << diagnostics;
+
+    // Only the first error is reported.
+    EXPECT_EQ(diagnostics.find("error"), diagnostics.rfind("error"));
+}
+
+TEST(OnePassAssemblerTest, ErrorRecovery) {
+    std::ostringstream out;
+    DiagnosticRedirect const redirect(out);
+    DiagnosticEngine engine;
+    DiagnosticEngine::Scope const scope(engine);
+    auto const symbols = std::make_shared<SymbolPool>();
+
+    // Errors are reported in source order, except that undefined labels are only known at the end.
+    OnePassAssembler assembler(symbols);
+    std::vector<std::uint16_t> flushed;
+    assembler.set_sink([&](std::uint16_t, std::size_t, std::uint16_t word) {
+        flushed.push_back(word);
+    });
+    EXPECT_FALSE(assembler.run(parse(
+        ".ORIG x3000\nA BR A\nLD R0, FAR\nA HALT\nBR NONE\n.BLKW 300\nFAR HALT\n.END\n",
+        symbols
+    )));
+
+    std::vector<std::string> messages;
+    for (Diagnostic const& diagnostic : engine.diagnostics()) {
+        std::ostringstream message;
+        write_message(message, diagnostic);
+        messages.push_back(message.str());
+    }
+    EXPECT_EQ(
+        messages,
+        std::vector<std::string>({
+            "label `A` redefined by instruction `A HALT`",
+            "offset 302 of label `FAR` in instruction `LD R0, FAR` is out of range",
+            "label `NONE` in instruction `BR NONE` not found",
+        })
+    );
+    // No words are passed to the sink after an error.
+    EXPECT_EQ(flushed.size(), 1u);
+
+    // After an invalid instruction, the remaining instructions are only validated, but the labels
+    // that are never defined are still reported at the end, like `Assembler::run()` does.
+    engine = DiagnosticEngine();
+    OnePassAssembler invalid(symbols);
+    EXPECT_FALSE(invalid.run(parse(
+        ".ORIG x3000\nADD R1\nBR NONE\nBR LATER\nAND R0, R0, #99\nLATER HALT\n.END\n",
+        symbols
+    )));
+    ASSERT_EQ(engine.error_count(), 3u);
+    EXPECT_EQ(engine.diagnostics()[1].kind, DiagnosticKind::ImmediateOutOfRange);
+    EXPECT_EQ(engine.diagnostics()[2].kind, DiagnosticKind::LabelNotFound);
+
+    // A label referred to before the error, and defined after it, is not reported either.
+    engine = DiagnosticEngine();
+    OnePassAssembler pending(symbols);
+    EXPECT_FALSE(pending.run(parse(
+        ".ORIG x3000\nBR LATER\nBR NOWHERE\nADD R1\nLATER HALT\n.END\n",
+        symbols
+    )));
+    ASSERT_EQ(engine.error_count(), 2u);
+    EXPECT_EQ(engine.diagnostics()[1].kind, DiagnosticKind::LabelNotFound);
+
+    // The limit stops the assembler.
+    engine = DiagnosticEngine(2);
+    OnePassAssembler limited(symbols);
+    EXPECT_FALSE(limited.run(parse(".ORIG x3000\nA HALT\nA HALT\nA HALT\nA HALT\n", symbols)));
+    EXPECT_EQ(engine.error_count(), 2u);
+    EXPECT_EQ(out.str(), "");
+}
@@ -0,0 +1,212 @@
+#include "assembler/assembler.hpp"
+#include "assembler/output_writer.hpp"
+#include "assembler/parser.hpp"
+#include "assembler/section.hpp"
+
+#include "gtest/gtest.h"
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <ios>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+/// Formats `words` like the listing has always been printed, through `std::ostream`.
+auto reference_text(std::uint16_t start_address, std::vector<std::uint16_t> const& words)
+    -> std::string {
+    std::ostringstream out;
+    for (std::size_t i = 0; i != words.size(); ++i) {
+        out << '(' << std::hex << std::uppercase << start_address + i << ") "
+            << std::bitset<16>(words[i]) << '\n';
+    }
+    return out.str();
+}
+
+/// A word of a program and its address.
+struct AddressedWord {
+    std::size_t address;
+    std::uint16_t word;
+
+    auto operator==(AddressedWord const& other) const -> bool {
+        return address == other.address && word == other.word;
+    }
+};
+
+/// Reads the listing at `path`, whose lines are `(ADDR) WORD` with the word in 16 binary or 4
+/// hexadecimal digits.
+auto read_listing(std::string const& path) -> std::vector<AddressedWord> {
+    std::ifstream input(path);
+    std::vector<AddressedWord> listing;
+    std::string address;
+    std::string word;
+    while (input >> address >> word) {
+        listing.push_back({
+            std::stoul(address.substr(1, address.size() - 2), nullptr, 16),
+            static_cast<std::uint16_t>(std::stoul(word, nullptr, word.size() == 16 ? 2 : 16)),
+        });
+    }
+    return listing;
+}
+
+/// Decodes the LC-3 object file `object`.
+auto decode_object(std::string const& object) -> std::vector<AddressedWord> {
+    std::vector<AddressedWord> words;
+    auto byte = [&](std::size_t i) -> unsigned { return static_cast<unsigned char>(object[i]); };
+    std::size_t const origin = byte(0) << 8 | byte(1);
+    for (std::size_t i = 2; i + 1 < object.size(); i += 2) {
+        std::uint16_t const word = static_cast<std::uint16_t>(byte(i) << 8 | byte(i + 1));
+        words.push_back({ origin + words.size(), word });
+    }
+    return words;
+}
+
+auto write(
+    OutputFormat format,
+    std::uint16_t start_address,
+    std::vector<std::uint16_t> const& words
+) -> std::string {
+    std::ostringstream out;
+    OutputWriter(out, format).write(start_address, words);
+    return out.str();
+}
+}  // namespace
+
+TEST(OutputWriterTest, Text) {
+    std::vector<std::uint16_t> const words = { 0x0000, 0xFFFF, 0x1E25, 0x8001 };
+    EXPECT_EQ(
+        write(OutputFormat::Text, 0x3000, words),
+        "(3000) 0000000000000000\n"
+        "(3001) 1111111111111111\n"
+        "(3002) 0001111000100101\n"
+        "(3003) 1000000000000001\n"
+    );
+    EXPECT_EQ(write(OutputFormat::Text, 0x3000, {}), "");
+}
+
+TEST(OutputWriterTest, MatchesStream) {
+    // Every possible word, starting at addresses whose listings have few digits, or run past
+    // 0xFFFF, which the listing does not wrap around. The output is several times the size of the
+    // buffer.
+    std::vector<std::uint16_t> words(0x10000);
+    for (std::size_t i = 0; i != words.size(); ++i) {
+        words[i] = static_cast<std::uint16_t>(i * 40503);
+    }
+
+    for (std::uint16_t start_address : { 0x0, 0x1, 0x3000, 0xFFFF }) {
+        EXPECT_EQ(
+            write(OutputFormat::Text, start_address, words),
+            reference_text(start_address, words)
+        ) << "start address " << start_address;
+    }
+}
+
+TEST(OutputWriterTest, SingleWords) {
+    // Words written one at a time are buffered until the writer is flushed.
+    std::ostringstream out;
+    {
+        OutputWriter writer(out, OutputFormat::Text);
+        writer.write(0x3000, 0, 0x1234);
+        writer.write(0x3000, 1, 0xF025);
+        EXPECT_EQ(out.str(), "");
+        writer.flush();
+        EXPECT_EQ(out.str(), "(3000) 0001001000110100\n(3001) 1111000000100101\n");
+        writer.write(0x3000, 2, 0x0000);
+    }
+    EXPECT_EQ(
+        out.str(),
+        "(3000) 0001001000110100\n(3001) 1111000000100101\n(3002) 0000000000000000\n"
+    );
+}
+
+TEST(OutputWriterTest, Hex) {
+    EXPECT_EQ(
+        write(OutputFormat::Hex, 0x3000, { 0x0000, 0xFFFF, 0x1E25, 0x00A0 }),
+        "0000\nFFFF\n1E25\n00A0\n"
+    );
+}
+
+TEST(OutputWriterTest, Raw) {
+    EXPECT_EQ(
+        write(OutputFormat::Raw, 0x3000, { 0x0000, 0xFFFF, 0x1E25, 0x00A0 }),
+        std::string("\x00\x00\xFF\xFF\x1E\x25\x00\xA0", 8)
+    );
+}
+
+TEST(OutputWriterTest, Sections) {
+    std::vector<std::uint16_t> const words = { 0x0001, 0x0002, 0x0003, 0x0004 };
+    std::vector<Section> const sections = { { 0x4000, 0, 1 }, { 0x5000, 1, 0 }, { 0x3000, 1, 3 } };
+
+    std::ostringstream out;
+    OutputWriter(out, OutputFormat::Text).write(words, {}, sections);
+    EXPECT_EQ(
+        out.str(),
+        "(4000) 0000000000000001\n"
+        "(3000) 0000000000000010\n"
+        "(3001) 0000000000000011\n"
+        "(3002) 0000000000000100\n"
+    );
+}
+
+TEST(OutputWriterTest, ZeroRuns) {
+    // The runs lie at the start of a section, at the end of the last one, and across the boundary
+    // of two sections. The last run is larger than the buffer.
+    std::vector<std::uint16_t> const words = { 0x0001, 0x0002, 0x0003 };
+    std::vector<ZeroRun> const zero_runs = { { 0, 2 }, { 3, 4 }, { 8, 100000 } };
+    std::vector<Section> const sections = { { 0x3000, 0, 5 }, { 0x4000, 5, 100004 } };
+    std::vector<std::uint16_t> expanded = { 0, 0, 0x0001, 0, 0, 0, 0, 0x0002 };
+    expanded.resize(100008, 0);
+    expanded.push_back(0x0003);
+
+    for (OutputFormat const format :
+         { OutputFormat::Text, OutputFormat::Hex, OutputFormat::Raw, OutputFormat::Object }) {
+        std::ostringstream out;
+        std::ostringstream expected;
+        OutputWriter(out, format).write(words, zero_runs, sections);
+        OutputWriter(expected, format).write(expanded, {}, sections);
+        EXPECT_TRUE(out.str() == expected.str()) << static_cast<int>(format);
+    }
+
+    std::vector<std::uint16_t> const first(expanded.begin(), expanded.begin() + 5);
+    std::ostringstream out;
+    write_object(out, 0x3000, { 0x0001 }, { { 0, 2 }, { 3, 2 } });
+    EXPECT_EQ(out.str(), write(OutputFormat::Object, 0x3000, first));
+}
+
+TEST(OutputWriterTest, Object) {
+    std::vector<std::uint16_t> const words = { 0x0000, 0xFFFF, 0x1E25, 0x00A0 };
+    std::string const expected("\x30\x00\x00\x00\xFF\xFF\x1E\x25\x00\xA0", 10);
+
+    std::ostringstream out;
+    write_object(out, 0x3000, words);
+    EXPECT_EQ(out.str(), expected);
+    EXPECT_EQ(write(OutputFormat::Object, 0x3000, words), expected);
+}
+
+TEST(OutputWriterTest, ObjectMatchesLabImages) {
+    for (int lab = 1; lab <= 5; ++lab) {
+        std::string const name = "lab" + std::to_string(lab);
+        std::string const path = ASSEMBLER_SOURCE_DIR "/test/code_lc3/" + name + "/" + name;
+        std::ifstream input(path + ".asm", std::ios::binary);
+        std::string const code(
+            (std::istreambuf_iterator<char>(input)),
+            std::istreambuf_iterator<char>()
+        );
+
+        Parser parser(code);
+        Assembler assembler(parser.parse_instructions(), parser.symbols());
+        std::vector<std::uint16_t> words = assembler.run();
+        ASSERT_FALSE(words.empty()) << name;
+
+        std::ostringstream out;
+        write_object(out, assembler.start_address(), std::move(words));
+        std::vector<AddressedWord> const expected = read_listing(path + ".bin");
+        ASSERT_FALSE(expected.empty()) << name;
+        EXPECT_TRUE(decode_object(out.str()) == expected) << name;
+    }
+}
@@ -0,0 +1,285 @@
+#include "assembler/assembler.hpp"
+#include "assembler/diagnostic.hpp"
+#include "assembler/instruction.hpp"
+#include "assembler/line_index.hpp"
+#include "assembler/parser.hpp"
+#include "assembler/section.hpp"
+
+#include "test_support.hpp"
+
+#include "gtest/gtest.h"
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+/// Prints the words, sections, zero runs, and diagnostic messages produced by assembling, so that
+/// the results of serial and parallel assembly can be compared.
+auto describe(
+    std::vector<std::uint16_t> const& words,
+    Assembler const& assembler,
+    std::string const& diagnostics
+) -> std::string {
+    std::ostringstream out;
+    out << diagnostics;
+    for (Section const& section : assembler.sections()) {
+        out << "section " << section.origin << ' ' << section.first_word << ' '
+            << section.word_count << '\n';
+    }
+    for (ZeroRun const& run : assembler.zero_runs()) {
+        out << "zeros " << run.first_word << ' ' << run.word_count << '\n';
+    }
+    for (std::uint16_t const word : words) {
+        out << std::bitset<16>(word) << '\n';
+    }
+    return out.str();
+}
+
+/// Returns the words of a program whose zeros in `zero_runs` are not stored in `words`.
+auto expand(std::vector<std::uint16_t> const& words, std::vector<ZeroRun> const& zero_runs)
+    -> std::vector<std::uint16_t> {
+    std::vector<std::uint16_t> expanded;
+    std::vector<std::uint16_t>::const_iterator stored = words.begin();
+    for (ZeroRun const& run : zero_runs) {
+        std::size_t const count = run.first_word - expanded.size();
+        expanded.insert(expanded.end(), stored, stored + static_cast<std::ptrdiff_t>(count));
+        stored += static_cast<std::ptrdiff_t>(count);
+        expanded.resize(expanded.size() + run.word_count, 0);
+    }
+    expanded.insert(expanded.end(), stored, words.end());
+    return expanded;
+}
+
+void check_same_result(
+    std::string const& code,
+    std::string const& description,
+    std::size_t max_errors = 0
+) {
+    LineIndex const line_index(code.data(), code.data() + code.size());
+    DiagnosticSource const source(&line_index);
+
+    Parser parser(code);
+    std::vector<Instruction> instructions;
+    capture(max_errors, [&]() { instructions = parser.parse_instructions(); });
+
+    if (instructions.size() == 1 && instructions.front().is_unknown()) {
+        // The code does not parse, so there is nothing to assemble.
+        return;
+    }
+
+    Assembler expanded(instructions, parser.symbols());
+    std::vector<std::uint16_t> expanded_words;
+    std::string const expanded_diagnostics =
+        capture(max_errors, [&]() { expanded_words = expanded.run(); });
+
+    for (bool const keep_zero_runs : { false, true }) {
+        Assembler serial(instructions, parser.symbols());
+        serial.set_keep_zero_runs(keep_zero_runs);
+        std::vector<std::uint16_t> expected_words;
+        std::string const expected_diagnostics =
+            capture(max_errors, [&]() { expected_words = serial.run(); });
+        std::string const expected = describe(expected_words, serial, expected_diagnostics);
+
+        // Keeping the zero runs only changes how the words are stored.
+        EXPECT_EQ(expected_diagnostics, expanded_diagnostics) << description;
+        EXPECT_EQ(expand(expected_words, serial.zero_runs()), expanded_words) << description;
+
+        for (unsigned const thread_count : { 1u, 2u, 3u, 8u }) {
+            for (std::size_t const min_chunk_size : { 1, 4, 32 }) {
+                Assembler assembler(instructions, parser.symbols());
+                assembler.set_keep_zero_runs(keep_zero_runs);
+                std::vector<std::uint16_t> words;
+                std::string const diagnostics = capture(max_errors, [&]() {
+                    words = assembler.run_parallel(thread_count, min_chunk_size);
+                });
+
+                EXPECT_EQ(describe(words, assembler, diagnostics), expected)
+                    << description << ", " << thread_count << " threads, chunk size "
+                    << min_chunk_size << ", " << max_errors << " errors, zero runs "
+                    << keep_zero_runs;
+            }
+        }
+    }
+}
+}  // namespace
+
+TEST(ParallelAssemblerTest, SameResultOnTestFiles) {
+    for_each_test_file([](std::string const& code, std::string const& path) {
+        check_same_result(code, path);
+    });
+}
+
+TEST(ParallelAssemblerTest, FirstErrorOnly) {
+    // Each chunk stops at its own first error, but only the first error overall is reported.
+    check_same_result(".ORIG x3000\nHALT\nADD R1, R2\nHALT\nADD R1\nHALT\n.END\n", "validation");
+    check_same_result(".ORIG x3000\nHALT\nBR A\nHALT\nBR B\n.END\n", "undefined labels");
+    check_same_result(".ORIG x3000\nHALT\n.ORIG x4000\nHALT\n.ORIG x5000\n.END\n", "orig");
+
+    // The first redefinition is reported, even if the label is first defined in a later chunk
+    // than another redefined label.
+    check_same_result(
+        ".ORIG x3000\nA HALT\nB HALT\nHALT\nHALT\nB HALT\nHALT\nA HALT\n.END\n",
+        "redefinitions"
+    );
+    check_same_result(
+        ".ORIG x3000\nA HALT\nB HALT\nHALT\nHALT\nA HALT\nHALT\nB HALT\n.END\n",
+        "redefinitions in order"
+    );
+}
+
+TEST(ParallelAssemblerTest, ErrorRecovery) {
+    std::vector<std::string> const codes = {
+        ".ORIG x3000\nHALT\nADD R1, R2\nHALT\nADD R1\nHALT\nAND R0, R0, #99\n.END\n",
+        ".ORIG x3000\nHALT\nBR A\nHALT\nBR B\nJSR C\nLD R0, D\n.END\n",
+        ".ORIG x3000\nHALT\n.ORIG x4000\nHALT\n.ORIG x5000\n.ORIG x6000\n.END\n",
+        ".ORIG x3000\nA HALT\nB HALT\nHALT\nHALT\nB HALT\nHALT\nA HALT\nBR C\nB HALT\n.END\n",
+        ".ORIG x3000\nA BR A\nLD R0, FAR\nA HALT\nBR NONE\n.BLKW 300\nFAR HALT\nA HALT\n.END\n",
+        // After an invalid instruction, redefinitions and undefined labels are still reported.
+        ".ORIG x3000\nADD R1, R2\nA ADD R1, R1, #1\nHALT\nA HALT\nBR NOPE\nADD R1\nA HALT\n.END\n",
+    };
+
+    for (std::string const& code : codes) {
+        for (std::size_t const max_errors : { 1, 2, 3, 100 }) {
+            check_same_result(code, code, max_errors);
+        }
+    }
+}
+
+TEST(ParallelAssemblerTest, ReportsAllErrors) {
+    std::string const code =
+        ".ORIG x3000\nA BR A\nLD R0, FAR\nA HALT\nBR NONE\n.BLKW 300\nFAR HALT\n.END\n";
+    Parser parser(code);
+    std::vector<Instruction> const instructions = parser.parse_instructions();
+
+    // A redefined label keeps its first definition, and translation still reports its errors.
+    std::string const expected =
+        "error: label `A` redefined by instruction `A HALT`\n"
+        "error: offset 302 of label `FAR` in instruction `LD R0, FAR` is out of range\n"
+        "error: label `NONE` in instruction `BR NONE` not found\n";
+    std::vector<std::uint16_t> words = { 1 };
+    std::string const serial = capture(100, [&]() {
+        words = Assembler(instructions, parser.symbols()).run();
+    });
+    EXPECT_EQ(serial, expected);
+    EXPECT_TRUE(words.empty());
+
+    words = { 1 };
+    std::string const diagnostics = capture(100, [&]() {
+        words = Assembler(instructions, parser.symbols()).run_parallel(2, 1);
+    });
+    EXPECT_EQ(diagnostics, expected);
+    EXPECT_TRUE(words.empty());
+}
+
+TEST(ParallelAssemblerTest, Sections) {
+    std::string const code =
+        ".ORIG x4000\nHALT\n.END\n\n.ORIG x3000\nA .FILL x1234\n.BLKW 2\nLEA R0, A\n.END\n"
+        ".ORIG x5000\n.END\n";
+    Parser parser(code);
+    std::vector<Instruction> const instructions = parser.parse_instructions();
+
+    Assembler assembler(instructions, parser.symbols());
+    EXPECT_EQ(
+        assembler.run(),
+        (std::vector<std::uint16_t> { 0xF025, 0x1234, 0x0000, 0x0000, 0xE1FC })
+    );
+    std::vector<Section> const& sections = assembler.sections();
+    ASSERT_EQ(sections.size(), 3);
+    EXPECT_EQ(sections[0].origin, 0x4000);
+    EXPECT_EQ(sections[0].first_word, 0);
+    EXPECT_EQ(sections[0].word_count, 1);
+    EXPECT_EQ(sections[1].origin, 0x3000);
+    EXPECT_EQ(sections[1].first_word, 1);
+    EXPECT_EQ(sections[1].word_count, 4);
+    EXPECT_EQ(sections[2].origin, 0x5000);
+    EXPECT_EQ(sections[2].first_word, 5);
+    EXPECT_EQ(sections[2].word_count, 0);
+
+    check_same_result(code, "sections");
+    // Sections that only touch do not overlap.
+    std::string const adjacent = ".ORIG x3000\n.BLKW 4\n.END\n.ORIG x3004\nHALT\n.END\n";
+    check_same_result(adjacent, "adjacent");
+    Parser adjacent_parser(adjacent);
+    std::vector<Instruction> adjacent_instructions = adjacent_parser.parse_instructions();
+    Assembler adjacent_assembler(std::move(adjacent_instructions), adjacent_parser.symbols());
+    EXPECT_EQ(adjacent_assembler.run().size(), 5u);
+    for (std::size_t const max_errors : { 0, 1, 100 }) {
+        check_same_result(
+            ".ORIG x3000\n.BLKW 4\n.END\n.ORIG x3002\nHALT\n.END\n.ORIG x2FFF\nHALT\n.END\n",
+            "overlaps",
+            max_errors
+        );
+    }
+}
+
+TEST(ParallelAssemblerTest, ZeroRuns) {
+    // Adjacent blocks form a single run, even across chunks and sections, and empty blocks form
+    // none.
+    std::string const code =
+        ".ORIG x3000\nHALT\n.BLKW 3\n.BLKW 0\n.BLKW 2\nA HALT\n.BLKW 0\nLD R0, A\n.BLKW 4\n.END\n"
+        ".ORIG x4000\n.BLKW 1\n.STRINGZ \"a\"\n.END\n";
+    Parser parser(code);
+    std::vector<Instruction> const instructions = parser.parse_instructions();
+
+    Assembler assembler(instructions, parser.symbols());
+    assembler.set_keep_zero_runs(true);
+    EXPECT_EQ(
+        assembler.run(),
+        (std::vector<std::uint16_t> { 0xF025, 0xF025, 0x21FE, 0x0061, 0x0000 })
+    );
+    std::vector<ZeroRun> const& zero_runs = assembler.zero_runs();
+    ASSERT_EQ(zero_runs.size(), 2);
+    EXPECT_EQ(zero_runs[0].first_word, 1);
+    EXPECT_EQ(zero_runs[0].word_count, 5);
+    EXPECT_EQ(zero_runs[1].first_word, 8);
+    EXPECT_EQ(zero_runs[1].word_count, 5);
+    ASSERT_EQ(assembler.sections().size(), 2);
+    EXPECT_EQ(assembler.sections()[0].word_count, 12);
+    EXPECT_EQ(assembler.sections()[1].first_word, 12);
+    EXPECT_EQ(assembler.sections()[1].word_count, 3);
+
+    check_same_result(code, "zero runs");
+    check_same_result(".ORIG x3000\n.BLKW 2\n.END\n.ORIG x3001\n.BLKW 2\n.END\n", "overlap", 100);
+}
+
+TEST(ParallelAssemblerTest, NegativeBlockCount) {
+    // The count of `.BLKW` is a 16-bit word, so `-1` reserves xFFFF words, in the addresses and in
+    // the zero runs alike.
+    std::string const code = ".ORIG x0000\n.BLKW -1\nHALT\n.END\n";
+    Parser parser(code);
+    std::vector<Instruction> const instructions = parser.parse_instructions();
+
+    Assembler expanded(instructions, parser.symbols());
+    std::vector<std::uint16_t> const words = expanded.run();
+    ASSERT_EQ(words.size(), 0x10000);
+    EXPECT_EQ(words.back(), 0xF025);
+
+    for (unsigned const thread_count : { 1u, 2u }) {
+        Assembler assembler(instructions, parser.symbols());
+        assembler.set_keep_zero_runs(true);
+        std::vector<std::uint16_t> const stored =
+            thread_count == 1 ? assembler.run() : assembler.run_parallel(thread_count, 1);
+        EXPECT_EQ(stored, (std::vector<std::uint16_t> { 0xF025 }));
+        ASSERT_EQ(assembler.zero_runs().size(), 1);
+        EXPECT_EQ(assembler.zero_runs()[0].word_count, 0xFFFF);
+        // The program table gives `.ORIG` a word, so `HALT` is loaded one word before its row.
+        EXPECT_EQ(static_cast<std::uint16_t>(assembler.get_program().address(2) - 1), 0xFFFF);
+    }
+}
+
+TEST(ParallelAssemblerTest, LabelDefinedBefore) {
+    std::string const code = ".ORIG x3000\nHALT\nPDEFINED HALT\n.END\n";
+    Parser parser(code);
+    std::vector<Instruction> const instructions = parser.parse_instructions();
+
+    std::ostringstream diagnostics;
+    DiagnosticRedirect const redirect(diagnostics);
+    Assembler assembler(instructions, parser.symbols());
+    EXPECT_TRUE(assembler.add_label("PDEFINED", 0x4000));
+    EXPECT_TRUE(assembler.run_parallel(2, 1).empty());
+    EXPECT_NE(diagnostics.str().find("redefined"), std::string::npos) << diagnostics.str();
+}
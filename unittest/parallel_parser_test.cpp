@@ -0,0 +1,159 @@
+#include "assembler/diagnostic.hpp"
+#include "assembler/instruction.hpp"
+#include "assembler/parallel_parser.hpp"
+#include "assembler/parser.hpp"
+#include "assembler/symbol.hpp"
+#include "assembler/token_stream.hpp"
+
+#include "test_support.hpp"
+
+#include "gtest/gtest.h"
+
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+/// Prints the instructions and diagnostic messages produced by parsing, so that the results of
+/// serial and parallel parsing can be compared.
+auto describe(std::vector<Instruction> const& instructions, std::string const& diagnostics)
+    -> std::string {
+    std::ostringstream out;
+    out << diagnostics;
+    for (Instruction const& instr : instructions) {
+        out << instr << '\n';
+    }
+    return out.str();
+}
+
+void check_same_result(
+    std::string const& code,
+    std::string const& description,
+    std::size_t max_errors = 0
+) {
+    TokenStream const tokens(code.data(), code.data() + code.size());
+
+    Parser parser(code);
+    std::vector<Instruction> expected_instructions;
+    std::string const expected_diagnostics =
+        capture(max_errors, [&]() { expected_instructions = parser.parse_instructions(); });
+    SymbolPool::Scope const expected_scope(parser.symbols().get());
+    std::string const expected = describe(expected_instructions, expected_diagnostics);
+
+    for (unsigned const thread_count : { 1u, 2u, 3u, 8u, 64u }) {
+        for (std::size_t const min_chunk_size : { 1, 4, 32 }) {
+            auto const symbols = std::make_shared<SymbolPool>();
+            std::vector<Instruction> instructions;
+            std::string const diagnostics = capture(max_errors, [&]() {
+                instructions = parse_parallel(tokens, symbols, thread_count, min_chunk_size);
+            });
+
+            SymbolPool::Scope const symbol_scope(symbols.get());
+            EXPECT_EQ(describe(instructions, diagnostics), expected)
+                << description << ", " << thread_count << " threads, chunk size "
+                << min_chunk_size << ", " << max_errors << " errors";
+        }
+    }
+}
+}  // namespace
+
+TEST(ParallelParserTest, DiagnosticRedirect) {
+    std::ostringstream outer;
+    std::ostringstream inner;
+    {
+        DiagnosticRedirect const redirect_outer(outer);
+        diagnostic_stream() << "a";
+        {
+            DiagnosticRedirect const redirect_inner(inner);
+            diagnostic_stream() << "b";
+        }
+        diagnostic_stream() << "c";
+    }
+
+    EXPECT_EQ(outer.str(), "ac");
+    EXPECT_EQ(inner.str(), "b");
+    EXPECT_EQ(&diagnostic_stream(), &std::cout);
+}
+
+TEST(ParallelParserTest, SameResultOnTestFiles) {
+    for_each_test_file([](std::string const& code, std::string const& path) {
+        check_same_result(code, path);
+    });
+}
+
+TEST(ParallelParserTest, LabelOnSeparateLine) {
+    check_same_result(".ORIG x3000\nLOOP\n\n\nADD R1, R1, #1\nBRz LOOP\n.END\n", "label");
+    check_same_result("ADD R1, R1, R2 DONE\n\nHALT\n", "label after instruction");
+    check_same_result("A\nB\nADD R1, R1, #1\n", "two labels");
+    check_same_result("ADD R1, R1, #1\nLOOP\n", "label at end");
+}
+
+TEST(ParallelParserTest, EndAndErrors) {
+    // Nothing after `.END` is parsed, so the error on the last line is not reported.
+    check_same_result(".ORIG x3000\nADD R1, R1, #1\n.END\nHALT\nADD R1, #99999\n", "end");
+    // Only the first error is reported, even if later chunks contain errors as well.
+    check_same_result(".ORIG x3000\nHALT\nADD R1, #99999\nHALT\n, R1\nHALT\n", "errors");
+}
+
+TEST(ParallelParserTest, Sections) {
+    // A `.ORIG` right after `.END` continues the program, even if blank lines or comments separate
+    // them. Anything else after `.END` ends it.
+    std::string const code =
+        ".ORIG x3000\nHALT\n.END\n\n; table\n\n.ORIG x5000\n.FILL #1\n.END\nHALT\n.ORIG x6000\n";
+    Parser parser(code);
+    std::vector<Instruction> instructions;
+    EXPECT_EQ(
+        parser.parse_instructions([&](Instruction instr) {
+            instructions.push_back(std::move(instr));
+        }),
+        Parser::ParseStatus::EndPseudo
+    );
+    ASSERT_EQ(instructions.size(), 6u);
+    EXPECT_EQ(instructions[3].get_opcode(), Instruction::ORIG);
+    EXPECT_EQ(instructions[5].get_opcode(), Instruction::END);
+
+    check_same_result(code, "sections");
+    check_same_result(".ORIG x3000\n.END\n.ORIG x4000\n.END\n\n\n", "end at end");
+    check_same_result(".ORIG x3000\nHALT\n.END\nLABEL .ORIG x4000\n.END\n", "label after end");
+}
+
+TEST(ParallelParserTest, ErrorRecovery) {
+    std::string const code =
+        ".ORIG x3000\nHALT\nADD R1, #99999\nHALT\n, R1\nHALT\nLD R0,, X\nHALT\n.END\nHALT,\n";
+    for (std::size_t const max_errors : { 1, 2, 3, 100 }) {
+        check_same_result(code, "errors", max_errors);
+    }
+
+    // The parser recovers at the next line, and stops at the limit.
+    std::ostringstream out;
+    DiagnosticRedirect const redirect(out);
+    DiagnosticEngine engine(2);
+    DiagnosticEngine::Scope const scope(engine);
+
+    Parser parser(code);
+    std::vector<Instruction> parsed;
+    Parser::ParseStatus const status = parser.parse_instructions([&](Instruction instr) {
+        parsed.push_back(instr);
+    });
+    EXPECT_EQ(status, Parser::ParseStatus::Error);
+    EXPECT_EQ(parser.error_count(), 2u);
+    // The line with the first error is passed on as an unknown instruction, and parsing continues
+    // with the instructions after it until the second error.
+    ASSERT_EQ(parsed.size(), 4u);
+    EXPECT_TRUE(parsed[2].is_unknown());
+    EXPECT_EQ(parsed[3].get_opcode(), Instruction::HALT);
+
+    Parser unlimited_parser(code);
+    engine = DiagnosticEngine();
+    EXPECT_EQ(
+        unlimited_parser.parse_instructions([](Instruction) { }),
+        Parser::ParseStatus::EndPseudo
+    );
+    EXPECT_EQ(unlimited_parser.error_count(), 3u);
+    EXPECT_EQ(engine.error_count(), 3u);
+    EXPECT_EQ(out.str(), "");
+}
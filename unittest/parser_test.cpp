@@ -1,9 +1,14 @@
+#include "assembler/diagnostic.hpp"
+#include "assembler/instruction.hpp"
 #include "assembler/parser.hpp"
 #include "assembler/token.hpp"
 
 #include "gtest/gtest.h"
 
+#include <cstdint>
+#include <sstream>
 #include <string>
+#include <vector>
 
 namespace {
 /// Helper function for constructing a token in unit tests, which avoids writing `Token(kind,
@@ -158,6 +163,49 @@ TEST(ParserTest, TokenOpcode) {
     }
 }
 
+TEST(ParserTest, TokenOpcodeValue) {
+    // Opcode and pseudo-instruction tokens carry the opcode they denote.
+    {
+        std::string const code =
+            "ADD AND BR BRn BRz BRp BRzp BRnp BRnz BRnzp JMP JSR JSRR LD LDI LDR LEA NOT RET RTI "
+            "ST STI STR TRAP GETC OUT PUTS IN PUTSP HALT .ORIG .FILL .BLKW .STRINGZ .END .EQU";
+        Instruction::Opcode const expected[] = {
+#define OPCODE(name) Instruction::name,
+#define PSEUDO(name) Instruction::name,
+#include "assembler/opcode.def"
+        };
+        Parser parser(code);
+
+        for (Instruction::Opcode const opcode : expected) {
+            Token const& token = parser.next_token();
+            EXPECT_TRUE(token.kind() == Token::Opcode || token.kind() == Token::Pseudo) << token;
+            EXPECT_EQ(token.opcode(), opcode) << token;
+        }
+        EXPECT_EQ(parser.next_token().kind(), Token::End);
+    }
+
+    {
+        // Identifiers that are close to keywords are not keywords, and carry no opcode.
+        std::string const code = "ADDD AD add BRr BRzn BRnzpp JSRRR HALT0 R1 x1 .ORIGIN .ORI .end";
+        Parser parser(code);
+
+        while (parser.next_token().kind() != Token::End) {
+            EXPECT_NE(parser.current_token().kind(), Token::Opcode) << parser.current_token();
+            EXPECT_NE(parser.current_token().kind(), Token::Pseudo) << parser.current_token();
+            EXPECT_EQ(parser.current_token().opcode(), Instruction::UnknownOp)
+                << parser.current_token();
+        }
+    }
+
+    {
+        // Tokens constructed outside the lexer decode their opcode from their content.
+        std::string const code = "BRnp .STRINGZ";
+        EXPECT_EQ(construct_token(Token::Opcode, code, 0, 4).opcode(), Instruction::BRnp);
+        EXPECT_EQ(construct_token(Token::Pseudo, code, 5, 13).opcode(), Instruction::STRINGZ);
+        EXPECT_EQ(construct_token(Token::Label, code, 0, 4).opcode(), Instruction::UnknownOp);
+    }
+}
+
 TEST(ParserTest, TokenPseudo) {
     {
         // Check if the parser can correctly handle all pseudo-instructions.
@@ -400,6 +448,135 @@ TEST(ParserTest, TokenImmediateAndNumber) {
     }
 }
 
+TEST(ParserTest, TokenImmediateValue) {
+    {
+        // Immediates and numbers carry their decoded value.
+        std::string const code = "#12 #-12 #+12 x12 xAb b101 12 -12 +0 xFFFF #-32768 x0";
+        std::int16_t const expected[] = { 12, -12, 12, 18, 171, 5, 12, -12, 0, -1, -32768, 0 };
+        Parser parser(code);
+
+        for (std::int16_t const value : expected) {
+            Token const& token = parser.next_token();
+            EXPECT_TRUE(token.kind() == Token::Immediate || token.kind() == Token::Number) << token;
+            EXPECT_EQ(token.number_error(), OperandConstructionErrorType::NoError) << token;
+            EXPECT_EQ(token.value(), value) << token;
+        }
+        EXPECT_EQ(parser.next_token().kind(), Token::End);
+    }
+
+    {
+        // Decoding errors are recorded in the token instead of being reported by the lexer.
+        std::string const code = "#+ - x #65536 -32769 b10000000000000000 #00000000000000000001";
+        OperandConstructionErrorType const expected[] = {
+            OperandConstructionErrorType::InvalidNumber,
+            OperandConstructionErrorType::InvalidNumber,
+            OperandConstructionErrorType::InvalidNumber,
+            OperandConstructionErrorType::IntegerOverflow,
+            OperandConstructionErrorType::IntegerOverflow,
+            OperandConstructionErrorType::IntegerOverflow,
+            OperandConstructionErrorType::NoError,
+        };
+        Parser parser(code);
+
+        for (OperandConstructionErrorType const error : expected) {
+            EXPECT_EQ(parser.next_token().number_error(), error) << parser.current_token();
+        }
+        EXPECT_EQ(parser.next_token().kind(), Token::End);
+    }
+
+    {
+        // Other tokens carry no value.
+        std::string const code = "ADD R1 LOOP \"x1\" ,";
+        Parser parser(code);
+
+        while (parser.next_token().kind() != Token::End) {
+            EXPECT_EQ(parser.current_token().value(), 0) << parser.current_token();
+            EXPECT_EQ(
+                parser.current_token().number_error(),
+                OperandConstructionErrorType::NoError
+            ) << parser.current_token();
+        }
+    }
+}
+
+TEST(ParserTest, TokenLiteral) {
+    {
+        // A literal is an immediate, a number, or a label after '='.
+        std::string const code = "=x1F =#-3 =12 =b11 =TABLE =xyz";
+        Parser parser(code);
+
+        EXPECT_EQ(parser.next_token(), construct_token(Token::ImmediateLiteral, code, 0, 4));
+        EXPECT_EQ(parser.current_token().value(), 0x1F);
+        EXPECT_EQ(parser.next_token(), construct_token(Token::ImmediateLiteral, code, 5, 9));
+        EXPECT_EQ(parser.current_token().value(), -3);
+        EXPECT_EQ(parser.next_token(), construct_token(Token::ImmediateLiteral, code, 10, 13));
+        EXPECT_EQ(parser.current_token().value(), 12);
+        EXPECT_EQ(parser.next_token(), construct_token(Token::ImmediateLiteral, code, 14, 18));
+        EXPECT_EQ(parser.current_token().value(), 3);
+        EXPECT_EQ(parser.next_token(), construct_token(Token::LabelLiteral, code, 19, 25));
+        EXPECT_EQ(parser.next_token(), construct_token(Token::LabelLiteral, code, 26, 30));
+        EXPECT_EQ(parser.next_token(), construct_token(Token::End, code, 30, 30));
+    }
+
+    {
+        // Registers, opcodes, and a lone '=' are not literals, and numbers keep their errors.
+        std::string const code = "=R1 =ADD = x =#70000";
+        Parser parser(code);
+
+        EXPECT_EQ(parser.next_token(), construct_token(Token::Unknown, code, 0, 3));
+        EXPECT_EQ(parser.next_token(), construct_token(Token::Unknown, code, 4, 8));
+        EXPECT_EQ(parser.current_token().opcode(), 0);
+        EXPECT_EQ(parser.next_token(), construct_token(Token::Unknown, code, 9, 10));
+        EXPECT_EQ(parser.next_token(), construct_token(Token::Immediate, code, 11, 12));
+        EXPECT_EQ(parser.next_token(), construct_token(Token::ImmediateLiteral, code, 13, 20));
+        EXPECT_EQ(
+            parser.current_token().number_error(),
+            OperandConstructionErrorType::IntegerOverflow
+        );
+    }
+}
+
+TEST(ParserTest, TokenExpression) {
+    {
+        // A label or an immediate directly followed by a sign and a term starts an expression.
+        std::string const code = "TABLE+3 END-START x10+#-1 A+b1-C";
+        Parser parser(code);
+
+        EXPECT_EQ(parser.next_token(), construct_token(Token::Expression, code, 0, 7));
+        EXPECT_EQ(parser.next_token(), construct_token(Token::Expression, code, 8, 17));
+        EXPECT_EQ(parser.next_token(), construct_token(Token::Expression, code, 18, 25));
+        EXPECT_EQ(parser.next_token(), construct_token(Token::Expression, code, 26, 32));
+        EXPECT_EQ(parser.next_token(), construct_token(Token::End, code, 32, 32));
+    }
+
+    {
+        // A sign that no term follows, and a number before a sign, do not start expressions.
+        std::string const code = "TABLE+ 3 A+,B 12+3";
+        Parser parser(code);
+
+        EXPECT_EQ(parser.next_token(), construct_token(Token::Label, code, 0, 5));
+        EXPECT_EQ(parser.next_token(), construct_token(Token::Number, code, 5, 6));
+        EXPECT_EQ(parser.next_token(), construct_token(Token::Number, code, 7, 8));
+        EXPECT_EQ(parser.next_token(), construct_token(Token::Label, code, 9, 10));
+        EXPECT_EQ(parser.next_token(), construct_token(Token::Number, code, 10, 11));
+        EXPECT_EQ(parser.next_token(), construct_token(Token::Comma, code, 11, 12));
+        EXPECT_EQ(parser.next_token(), construct_token(Token::Label, code, 12, 13));
+        EXPECT_EQ(parser.next_token(), construct_token(Token::Number, code, 14, 16));
+        EXPECT_EQ(parser.next_token(), construct_token(Token::Number, code, 16, 18));
+        EXPECT_EQ(parser.next_token(), construct_token(Token::End, code, 18, 18));
+    }
+
+    {
+        // The terms are only checked when the operand is constructed.
+        std::string const code = "A+R1 B-ADD";
+        Parser parser(code);
+
+        EXPECT_EQ(parser.next_token(), construct_token(Token::Expression, code, 0, 4));
+        EXPECT_EQ(parser.next_token(), construct_token(Token::Expression, code, 5, 10));
+        EXPECT_EQ(parser.next_token(), construct_token(Token::End, code, 10, 10));
+    }
+}
+
 TEST(ParserTest, TokenComment) {
     {
         // Check if the parser can correctly handle comments.
@@ -484,4 +661,34 @@ SIX     .FILL   x0006
         Token const token = parser.next_token();
         EXPECT_EQ(token.kind(), kind) << "Unexpected token " << token;
     }
-}
\ No newline at end of file
+}
+
+TEST(ParserTest, TooManyOperands) {
+    // No instruction takes more operands than an `Instruction` stores, so the parser reports the
+    // operand count while it can still quote every operand.
+    std::string const code = ".ORIG x3000\nLOOP  ADD R1,R2, R3 ,x4, #-5 ; comment\nHALT\n";
+    std::ostringstream messages;
+    std::vector<Instruction> instructions;
+    {
+        DiagnosticRedirect const redirect(messages);
+        Parser parser(code);
+        instructions = parser.parse_instructions();
+    }
+    EXPECT_EQ(
+        messages.str(),
+        "error: instruction `LOOP ADD R1, R2, R3, #4, #-5` expects 3 operand(s), but got 5 "
+        "operand(s)\n"
+    );
+    ASSERT_EQ(instructions.size(), 1);
+    EXPECT_TRUE(instructions.front().is_unknown());
+
+    // An invalid operand among those that are not stored is reported instead.
+    messages.str("");
+    {
+        DiagnosticRedirect const redirect(messages);
+        std::string const invalid = ".ORIG x3000\nADD R1, R2, R3, #99999\n";
+        Parser parser(invalid);
+        parser.parse_instructions();
+    }
+    EXPECT_NE(messages.str().find("overflow"), std::string::npos) << messages.str();
+}
@@ -0,0 +1,151 @@
+#include "assembler/assembler.hpp"
+#include "assembler/instruction.hpp"
+#include "assembler/operand.hpp"
+#include "assembler/parser.hpp"
+#include "assembler/program_table.hpp"
+#include "assembler/symbol.hpp"
+
+#include "gtest/gtest.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+TEST(ProgramTableTest, Columns) {
+    std::string const code =
+        ".ORIG x3000\nLOOP ADD R1, R2, #3\nBRp LOOP\nTEXT .STRINGZ \"ab\"\n.END\n";
+    Parser parser(code);
+    std::vector<Instruction> const instructions = parser.parse_instructions();
+    ASSERT_EQ(instructions.size(), 5);
+    SymbolPool::Scope const scope(parser.symbols().get());
+
+    ProgramTable const program(instructions);
+    ASSERT_EQ(program.size(), instructions.size());
+    EXPECT_EQ(program.opcode(0), Instruction::ORIG);
+    EXPECT_EQ(program.opcode(1), Instruction::ADD);
+    EXPECT_EQ(program.opcode(2), Instruction::BRp);
+    EXPECT_EQ(program.opcode(3), Instruction::STRINGZ);
+    EXPECT_EQ(program.opcode(4), Instruction::END);
+    EXPECT_EQ(program.operands(1).size(), 3);
+    EXPECT_EQ(&program.instruction(2), &instructions[2]);
+
+    EXPECT_TRUE(program.label(0).empty());
+    EXPECT_EQ(program.label(1).str(), "LOOP");
+    EXPECT_EQ(program.label(3).str(), "TEXT");
+
+    EXPECT_EQ(program.operand(1, 0).register_id(), 1);
+    EXPECT_EQ(program.operand(1, 1).register_id(), 2);
+    EXPECT_EQ(program.operand(1, 2).immediate_value(), 3);
+    EXPECT_EQ(program.operand(2, 0).label(), "LOOP");
+    EXPECT_EQ(program.operand(3, 0).string_literal(), "ab");
+
+    // A row reads like the instruction it was built from.
+    ProgramTable::Row const row = program.row(1);
+    EXPECT_EQ(row.index(), 1);
+    EXPECT_EQ(row.get_opcode(), Instruction::ADD);
+    EXPECT_TRUE(row.has_label());
+    EXPECT_EQ(row.get_label(), "LOOP");
+    EXPECT_EQ(row.get_operand(2).immediate_value(), 3);
+    EXPECT_FALSE(program.row(2).has_label());
+}
+
+TEST(ProgramTableTest, AssignAddresses) {
+    std::vector<Instruction> const instructions(4);
+    ProgramTable program(instructions);
+
+    std::uint16_t const word_counts[] = { 1, 3, 0, 2 };
+    for (std::size_t row = 0; row != program.size(); ++row) {
+        program.set_word_count(row, word_counts[row]);
+    }
+
+    program.assign_addresses(0x3000);
+    EXPECT_EQ(program.addresses(), (std::vector<std::uint16_t> { 0x3000, 0x3001, 0x3004, 0x3004 }));
+
+    // Addresses wrap around at the end of the address space.
+    program.assign_addresses(0xFFFE);
+    EXPECT_EQ(program.addresses(), (std::vector<std::uint16_t> { 0xFFFE, 0xFFFF, 0x0002, 0x0002 }));
+}
+
+TEST(ProgramTableTest, ParallelAssignAddresses) {
+    std::vector<Instruction> instructions(1000);
+    ProgramTable serial(instructions);
+    for (std::size_t row = 0; row != serial.size(); ++row) {
+        serial.set_word_count(row, static_cast<std::uint16_t>(row * 37 % 200));
+    }
+    serial.assign_addresses(0x3000);
+
+    // The chunks wrap around the address space several times.
+    for (unsigned const thread_count : { 2u, 3u, 8u }) {
+        ProgramTable parallel(instructions, thread_count, 1);
+        ASSERT_EQ(parallel.size(), serial.size());
+        for (std::size_t row = 0; row != parallel.size(); ++row) {
+            parallel.set_word_count(row, serial.word_counts()[row]);
+        }
+
+        parallel.assign_addresses(0x3000);
+        EXPECT_EQ(parallel.addresses(), serial.addresses()) << thread_count << " threads";
+    }
+}
+
+TEST(ProgramTableTest, Sections) {
+    std::string const code = ".ORIG x3000\nHALT\n.BLKW 3\n.ORIG x5000\nHALT\n.ORIG x4000\nHALT\n";
+    Parser parser(code);
+    std::vector<Instruction> const instructions = parser.parse_instructions();
+    ASSERT_EQ(instructions.size(), 7);
+
+    // Each `.ORIG` row restarts the addresses at its operand, wherever the chunks start.
+    std::uint16_t const word_counts[] = { 1, 1, 3, 1, 1, 1, 1 };
+    for (unsigned const thread_count : { 1u, 2u, 3u, 7u }) {
+        ProgramTable program(instructions, thread_count, 1);
+        for (std::size_t row = 0; row != program.size(); ++row) {
+            program.set_word_count(row, word_counts[row]);
+        }
+
+        program.assign_addresses(0x3000);
+        EXPECT_EQ(
+            program.addresses(),
+            (std::vector<std::uint16_t> { 0x3000, 0x3001, 0x3002, 0x5000, 0x5001, 0x4000, 0x4001 })
+        ) << thread_count << " threads";
+    }
+}
+
+TEST(ProgramTableTest, AssemblerPasses) {
+    std::string const code = ".ORIG x3000\nLOOP ADD R1, R1, #-1\nBRp LOOP\n.END\n";
+    Parser parser(code);
+    Assembler assembler(parser.parse_instructions(), parser.symbols());
+
+    EXPECT_EQ(assembler.run(), (std::vector<std::uint16_t> { 0x127F, 0x03FE }));
+    EXPECT_EQ(assembler.get_program().size(), 4);
+    EXPECT_EQ(assembler.start_address(), 0x3000);
+    EXPECT_EQ(assembler.get_program().address(2), assembler.get_program().address(1) + 1);
+}
+
+TEST(ProgramTableTest, SymbolTable) {
+    auto const symbols = std::make_shared<SymbolPool>();
+    SymbolPool::Scope const scope(symbols.get());
+    Assembler assembler({}, symbols);
+    Symbol const loop = Symbol::intern("SYMBOL_TABLE_LOOP");
+    bool ok = true;
+
+    EXPECT_EQ(assembler.get_label(loop, &ok), 0);
+    EXPECT_FALSE(ok);
+
+    // Every address, including 0 and 0xFFFF, can be stored.
+    EXPECT_TRUE(assembler.add_label(loop, 0xFFFF));
+    EXPECT_FALSE(assembler.add_label("SYMBOL_TABLE_LOOP", 0x3000));
+    EXPECT_EQ(assembler.get_label(loop, &ok), 0xFFFF);
+    EXPECT_TRUE(ok);
+    EXPECT_TRUE(assembler.add_label("SYMBOL_TABLE_ZERO", 0));
+    EXPECT_EQ(assembler.get_label(Symbol::intern("SYMBOL_TABLE_ZERO"), &ok), 0);
+    EXPECT_TRUE(ok);
+
+    // Labels interned after the table has grown are still looked up correctly.
+    Symbol const later = Symbol::intern("SYMBOL_TABLE_LATER");
+    EXPECT_EQ(assembler.get_label(later, &ok), 0);
+    EXPECT_FALSE(ok);
+    EXPECT_TRUE(assembler.add_label(later, 0x3001));
+    EXPECT_EQ(assembler.get_label("SYMBOL_TABLE_LATER", &ok), 0x3001);
+    EXPECT_TRUE(ok);
+}
@@ -0,0 +1,117 @@
+#include "assembler/parser.hpp"
+#include "assembler/scanner.hpp"
+#include "assembler/token.hpp"
+
+#include "test_support.hpp"
+
+#include "gtest/gtest.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace {
+/// Returns the vectorized instruction sets supported by the current processor.
+auto supported_vector_levels() -> std::vector<ScanLevel> {
+    std::vector<ScanLevel> levels;
+    for (ScanLevel const level : { ScanLevel::SSE2, ScanLevel::AVX2 }) {
+        if (is_scan_level_supported(level)) {
+            levels.push_back(level);
+        }
+    }
+    return levels;
+}
+
+/// Lexes `code` with the instruction set `level` until reaching `Token::End`, and returns all
+/// produced tokens (including the final `Token::End`).
+auto lex_all(std::string const& code, ScanLevel level) -> std::vector<Token> {
+    Parser parser(code);
+    parser.set_scan_level(level);
+    EXPECT_EQ(parser.scan_level(), level);
+
+    std::vector<Token> tokens;
+    do {
+        tokens.push_back(parser.next_token());
+    } while (tokens.back().kind() != Token::End);
+
+    return tokens;
+}
+
+/// Checks that every supported vectorized lexer produces exactly the same token stream as the
+/// scalar lexer for `code`. Since all lexers operate on the same buffer, equal tokens refer to the
+/// same bytes.
+void check_same_tokens(std::string const& code, std::string const& description) {
+    std::vector<Token> const expected = lex_all(code, ScanLevel::Scalar);
+
+    for (ScanLevel const level : supported_vector_levels()) {
+        std::vector<Token> const actual = lex_all(code, level);
+
+        ASSERT_EQ(actual.size(), expected.size())
+            << description << " (level " << static_cast<int>(level) << ")";
+        for (std::size_t i = 0; i != expected.size(); ++i) {
+            ASSERT_EQ(actual[i], expected[i])
+                << description << " (level " << static_cast<int>(level) << "), token " << i
+                << ": expected " << expected[i] << ", got " << actual[i];
+        }
+    }
+}
+}  // namespace
+
+TEST(ScannerTest, ScalarIsAlwaysSupported) {
+    EXPECT_TRUE(is_scan_level_supported(ScanLevel::Scalar));
+    EXPECT_TRUE(is_scan_level_supported(best_scan_level()));
+    EXPECT_EQ(vector_scan_kernels(ScanLevel::Scalar), nullptr);
+}
+
+TEST(ScannerTest, SameTokensOnTestFiles) {
+    for_each_test_file(check_same_tokens);
+}
+
+TEST(ScannerTest, SameTokensOnLongRuns) {
+    // Build runs of every length around the vector widths, and place them at every offset within
+    // a vector, so that each kernel stops both inside a vector and in the scalar tail.
+    for (std::size_t length = 0; length != 70; ++length) {
+        std::string const spaces(length, ' ');
+        std::string const mixed_spaces = [&] {
+            std::string result;
+            for (std::size_t i = 0; i != length; ++i) {
+                result.push_back(" \t\r\f\v"[i % 5]);
+            }
+            return result;
+        }();
+        std::string const identifier = "L" + std::string(length, 'a') + "Z9";
+        std::string const body(length, 'x');
+
+        for (std::size_t offset = 0; offset != 33; ++offset) {
+            std::string const prefix(offset, ' ');
+
+            check_same_tokens(prefix + "ADD" + spaces + "R1," + mixed_spaces + "#1\n", "spaces");
+            check_same_tokens(prefix + "; " + body + "\nHALT", "comment");
+            check_same_tokens(prefix + "; " + body, "comment at end");
+            check_same_tokens(prefix + identifier + " .FILL x1\n", "identifier");
+            check_same_tokens(prefix + identifier, "identifier at end");
+            check_same_tokens(prefix + ".STRINGZ \"" + body + "\", R1\n", "string");
+            check_same_tokens(prefix + ".STRINGZ \"" + body + "\nR1\n", "unterminated string");
+            check_same_tokens(prefix + ".STRINGZ \"" + body, "string at end");
+            check_same_tokens(prefix + "\"" + body + "\"", "closed string at end");
+        }
+    }
+}
+
+TEST(ScannerTest, SameTokensOnUnusualCharacters) {
+    // Characters adjacent to the ranges checked by the vectorized kernels, as well as bytes with
+    // the high bit set, must be classified exactly like the scalar lexer does.
+    std::string code;
+    for (int ch = 1; ch != 256; ++ch) {
+        code += "A";
+        code.push_back(static_cast<char>(ch));
+        code += std::string(40, static_cast<char>(ch));
+        code += " ; ";
+        code.push_back(static_cast<char>(ch));
+        code += "\n\"";
+        code += std::string(40, static_cast<char>(ch));
+        code += "\"\n";
+    }
+
+    check_same_tokens(code, "unusual characters");
+}
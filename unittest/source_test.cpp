@@ -0,0 +1,67 @@
+#include "assembler/parser.hpp"
+#include "assembler/source.hpp"
+#include "assembler/token.hpp"
+
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+
+namespace {
+/// Reads the file at `path` with the standard library, as a reference for `SourceBuffer`.
+auto read_file(std::string const& path) -> std::string {
+    std::ifstream input(path, std::ios::binary);
+    return { std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() };
+}
+
+auto content(SourceBuffer const& source) -> std::string {
+    return { source.begin(), source.end() };
+}
+}  // namespace
+
+TEST(SourceTest, MapRegularFile) {
+    std::string const path = ASSEMBLER_SOURCE_DIR "/test/code_lc3/lab5/lab5.asm";
+    SourceBuffer source;
+
+    ASSERT_TRUE(source.open(path));
+    EXPECT_EQ(content(source), read_file(path));
+    EXPECT_FALSE(source.empty());
+#if defined(__unix__) || defined(__APPLE__)
+    EXPECT_TRUE(source.is_mapped());
+#endif
+
+    // Moving the buffer transfers the mapping without changing the content.
+    char const* const begin = source.begin();
+    SourceBuffer moved(std::move(source));
+    EXPECT_EQ(moved.begin(), begin);
+    EXPECT_TRUE(source.empty());
+    EXPECT_EQ(content(moved), read_file(path));
+
+    // The parser lexes the mapped range in place.
+    Parser parser(moved.begin(), moved.end());
+    EXPECT_EQ(parser.next_token().begin(), begin);
+}
+
+TEST(SourceTest, EmptyFile) {
+    std::string const path = ::testing::TempDir() + "source_test_empty.asm";
+    std::ofstream(path).close();
+
+    SourceBuffer source;
+    ASSERT_TRUE(source.open(path));
+    EXPECT_TRUE(source.empty());
+    EXPECT_FALSE(source.is_mapped());
+
+    Parser parser(source.begin(), source.end());
+    EXPECT_EQ(parser.next_token().kind(), Token::End);
+
+    std::remove(path.c_str());
+}
+
+TEST(SourceTest, MissingFile) {
+    SourceBuffer source;
+    EXPECT_FALSE(source.open(ASSEMBLER_SOURCE_DIR "/test/input/does-not-exist.in"));
+    EXPECT_TRUE(source.empty());
+}
@@ -0,0 +1,163 @@
+#include "assembler/diagnostic.hpp"
+#include "assembler/instruction.hpp"
+#include "assembler/parser.hpp"
+#include "assembler/streaming_parser.hpp"
+#include "assembler/symbol.hpp"
+#include "assembler/token.hpp"
+
+#include "test_support.hpp"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+/// The result of parsing some source code: the printed instructions and diagnostic messages, and
+/// why parsing stopped.
+struct ParseResult {
+    std::string output;
+    Parser::ParseStatus status;
+};
+
+auto parse_whole(std::string const& code) -> ParseResult {
+    std::ostringstream out;
+    Parser parser(code);
+
+    testing::internal::CaptureStdout();
+    Parser::ParseStatus const status =
+        parser.parse_instructions([&](Instruction instr) { out << instr << '\n'; });
+    return { testing::internal::GetCapturedStdout() + out.str(), status };
+}
+
+auto parse_streaming(std::string const& code, std::size_t window_size) -> ParseResult {
+    std::ostringstream out;
+    std::istringstream input(code);
+    StreamingParser parser(input, window_size);
+
+    testing::internal::CaptureStdout();
+    Parser::ParseStatus const status =
+        parser.parse_instructions([&](Instruction instr) { out << instr << '\n'; });
+    return { testing::internal::GetCapturedStdout() + out.str(), status };
+}
+
+auto tokenize_whole(std::string const& code) -> std::string {
+    std::ostringstream out;
+    Parser parser(code);
+
+    while (parser.next_token().kind() != Token::End) {
+        out << parser.current_token() << '\n';
+    }
+    out << parser.current_token() << '\n';
+    return out.str();
+}
+
+auto tokenize_streaming(std::string const& code, std::size_t window_size) -> std::string {
+    std::ostringstream out;
+    std::istringstream input(code);
+    StreamingParser parser(input, window_size);
+
+    parser.tokenize([&](Token const& token) { out << token << '\n'; });
+    return out.str();
+}
+
+/// Checks that parsing `code` in windows of several sizes gives the same result as parsing it as a
+/// whole.
+void check_same_result(std::string const& code, std::string const& description) {
+    ParseResult const expected = parse_whole(code);
+    std::string const expected_tokens = tokenize_whole(code);
+
+    for (std::size_t const window_size : { 1, 2, 7, 16, 64, 4096 }) {
+        ParseResult const actual = parse_streaming(code, window_size);
+        EXPECT_EQ(actual.output, expected.output) << description << ", window " << window_size;
+        EXPECT_EQ(actual.status, expected.status) << description << ", window " << window_size;
+        EXPECT_EQ(tokenize_streaming(code, window_size), expected_tokens)
+            << description << ", window " << window_size;
+    }
+}
+}  // namespace
+
+TEST(StreamingParserTest, SameResultOnTestFiles) {
+    for_each_test_file(check_same_result);
+}
+
+TEST(StreamingParserTest, LabelOnSeparateLine) {
+    // A label on a line of its own belongs to the next instruction, even if the window ends in
+    // between.
+    check_same_result(
+        ".ORIG x3000\nLOOP\n\n  ; comment\n\nADD R1, R1, #1\nBRz LOOP\n.END\n",
+        "label"
+    );
+    check_same_result("A\nB\nADD R1, R1, #1\n", "two labels");
+    check_same_result("ADD R1, R1, #1\nLOOP\n", "label at end");
+    check_same_result("ADD R1, R1, #1\nLOOP", "label at end without newline");
+}
+
+TEST(StreamingParserTest, Sections) {
+    // A `.ORIG` after `.END` continues the program, even if `.END` ends a window.
+    check_same_result(
+        ".ORIG x3000\nHALT\n.END\n\n; table\n\n.ORIG x5000\n.FILL #1\n.END\nHALT\n.ORIG x6000\n",
+        "sections"
+    );
+    check_same_result(".ORIG x3000\n.END\n.ORIG x4000\n.END\n\n\n", "end at end");
+}
+
+TEST(StreamingParserTest, StringsOutliveWindow) {
+    std::string const code =
+        ".ORIG x3000\nLEA R0, TEXT\nBR LOOP\nTEXT .STRINGZ \"Hello\"\nLOOP BR LOOP\n.END\n";
+    std::istringstream input(code);
+    StreamingParser parser(input, 8);
+
+    std::vector<Instruction> instructions;
+    parser.parse_instructions([&](Instruction instr) { instructions.push_back(std::move(instr)); });
+
+    // The window has been reused many times, but the operands refer to interned symbols.
+    SymbolPool::Scope const scope(parser.symbols().get());
+    ASSERT_EQ(instructions.size(), 6);
+    EXPECT_EQ(instructions[1].get_operand(1).label(), "TEXT");
+    EXPECT_EQ(instructions[2].get_operand(0).label(), "LOOP");
+    EXPECT_EQ(instructions[3].get_operand(0).string_literal(), "Hello");
+    EXPECT_EQ(instructions[4].get_label(), "LOOP");
+
+    // `LOOP` is referenced twice but stored once.
+    EXPECT_EQ(instructions[2].get_operand(0).symbol(), instructions[4].get_label_symbol());
+}
+
+TEST(StreamingParserTest, ErrorRecovery) {
+    std::string const code =
+        ".ORIG x3000\nADD R1,, R1\nHALT\nLD R0, #1x\nA\n\nB ,\nHALT\n.END\nHALT,\n";
+
+    for (std::size_t const max_errors : { 2, 100 }) {
+        for (std::size_t const window_size : { 1, 7, 64, 4096 }) {
+            DiagnosticEngine engine(max_errors);
+            DiagnosticEngine::Scope const scope(engine);
+
+            std::istringstream input(code);
+            StreamingParser parser(input, window_size);
+            std::size_t parsed = 0;
+            std::size_t unknown = 0;
+            Parser::ParseStatus const status = parser.parse_instructions([&](Instruction instr) {
+                ++parsed;
+                unknown += instr.is_unknown() ? 1 : 0;
+            });
+
+            // The errors on lines 2, 4 and 7 are reported, up to the limit. Nothing after `.END`
+            // is parsed. The lines that the parser recovers from are passed on as unknown
+            // instructions, and the well-formed instructions around them are passed on as well.
+            std::size_t const error_count = std::min<std::size_t>(max_errors, 3);
+            EXPECT_EQ(parser.error_count(), error_count) << "window " << window_size;
+            EXPECT_EQ(engine.error_count(), error_count) << "window " << window_size;
+            EXPECT_EQ(parsed, max_errors == 2 ? 4u : 8u) << "window " << window_size;
+            EXPECT_EQ(unknown, max_errors == 2 ? 1u : 3u) << "window " << window_size;
+            EXPECT_EQ(
+                status,
+                max_errors == 2 ? Parser::ParseStatus::Error : Parser::ParseStatus::EndPseudo
+            ) << "window "
+              << window_size;
+        }
+    }
+}
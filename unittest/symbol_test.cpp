@@ -0,0 +1,105 @@
+#include "assembler/parallel.hpp"
+#include "assembler/symbol.hpp"
+
+#include "gtest/gtest.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+TEST(SymbolTest, Intern) {
+    SymbolPool pool;
+    SymbolPool::Scope const scope(&pool);
+
+    Symbol const empty;
+    EXPECT_TRUE(empty.empty());
+    EXPECT_EQ(empty.id(), 0);
+    EXPECT_EQ(empty.str(), "");
+    EXPECT_EQ(Symbol::intern(""), empty);
+
+    Symbol const loop = Symbol::intern("LOOP");
+    EXPECT_FALSE(loop.empty());
+    EXPECT_EQ(loop.str(), "LOOP");
+    EXPECT_EQ(Symbol::intern(std::string("LOOP")), loop);
+    EXPECT_NE(Symbol::intern("LOOP2"), loop);
+    EXPECT_EQ(Symbol::from_id(loop.id()), loop);
+
+    // Only the given range is interned, and a text may contain null characters.
+    std::string const text("LOOP\0LOOP", 9);
+    EXPECT_EQ(Symbol::intern(text.data(), text.data() + 4), loop);
+    EXPECT_EQ(Symbol::intern(text).str(), text);
+
+    // Symbols fit into the payload of an `Operand`.
+    EXPECT_LT(loop.id(), 1u << Symbol::id_bits);
+}
+
+TEST(SymbolTest, ManySymbols) {
+    SymbolPool pool;
+    SymbolPool::Scope const scope(&pool);
+
+    // Enough texts to fill several segments and grow the hash tables of every shard.
+    std::vector<Symbol> symbols;
+    for (int i = 0; i != 20000; ++i) {
+        symbols.push_back(Symbol::intern("symbol-test-" + std::to_string(i)));
+    }
+
+    // The empty string has id 0.
+    EXPECT_EQ(pool.size(), symbols.size() + 1);
+    for (int i = 0; i != 20000; ++i) {
+        std::string const text = "symbol-test-" + std::to_string(i);
+        // Ids are dense, so new texts get consecutive ids.
+        EXPECT_EQ(symbols[i].id(), i + 1);
+        EXPECT_EQ(symbols[i].str(), text);
+        EXPECT_EQ(Symbol::intern(text), symbols[i]);
+    }
+}
+
+TEST(SymbolTest, ConcurrentIntern) {
+    // Every thread interns the same texts, so all of them must agree on the symbols.
+    constexpr std::size_t thread_count = 4;
+    constexpr int text_count = 5000;
+    std::vector<std::vector<Symbol>> results(thread_count);
+    SymbolPool pool;
+    SymbolPool::Scope const scope(&pool);
+
+    parallel_for(thread_count, [&](std::size_t index) {
+        for (int i = 0; i != text_count; ++i) {
+            results[index].push_back(pool.intern("concurrent-" + std::to_string(i)));
+        }
+    });
+
+    for (std::size_t index = 1; index != thread_count; ++index) {
+        EXPECT_EQ(results[index], results[0]);
+    }
+    for (int i = 0; i != text_count; ++i) {
+        EXPECT_EQ(results[0][i].str(), "concurrent-" + std::to_string(i));
+        EXPECT_LT(results[0][i].id(), pool.size());
+    }
+}
+
+TEST(SymbolTest, Pools) {
+    // Each pool numbers its own texts, so the ids of a program do not depend on other programs.
+    SymbolPool first;
+    SymbolPool second;
+    EXPECT_EQ(first.intern("pool-a").id(), 1);
+    EXPECT_EQ(first.intern("pool-b").id(), 2);
+    EXPECT_EQ(second.intern("pool-b").id(), 1);
+    EXPECT_EQ(first.str(Symbol::from_id(2)), "pool-b");
+    EXPECT_EQ(second.str(Symbol::from_id(1)), "pool-b");
+
+    // A scope installs its pool for `Symbol::intern()` and `Symbol::str()`, and restores the
+    // previous one when it ends.
+    EXPECT_EQ(SymbolPool::current(), nullptr);
+    {
+        SymbolPool::Scope const outer(&first);
+        {
+            SymbolPool::Scope const inner(&second);
+            EXPECT_EQ(SymbolPool::current(), &second);
+            EXPECT_EQ(Symbol::from_id(1).str(), "pool-b");
+        }
+        EXPECT_EQ(SymbolPool::current(), &first);
+        EXPECT_EQ(Symbol::intern("pool-b").id(), 2);
+    }
+    EXPECT_EQ(SymbolPool::current(), nullptr);
+}
@@ -0,0 +1,61 @@
+#ifndef ASSEMBLER_UNITTEST_TEST_SUPPORT_HPP
+#define ASSEMBLER_UNITTEST_TEST_SUPPORT_HPP
+
+#include "assembler/diagnostic.hpp"
+
+#include "gtest/gtest.h"
+
+#include <cstddef>
+#include <fstream>
+#include <functional>
+#include <ios>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+/// Calls `callback(code, path)` for each test program in `LEXER_TEST_FILES`, with the contents of
+/// the file at `path` as `code`. Fails the test if a file cannot be read, or if there are none.
+inline void for_each_test_file(
+    std::function<void(std::string const& code, std::string const& path)> const& callback
+) {
+    std::istringstream paths(LEXER_TEST_FILES);
+    std::size_t file_count = 0;
+
+    for (std::string path; std::getline(paths, path, '|');) {
+        std::ifstream input(path, std::ios::binary);
+        ASSERT_TRUE(input) << "cannot open " << path;
+
+        std::string const code(
+            (std::istreambuf_iterator<char>(input)),
+            std::istreambuf_iterator<char>()
+        );
+        callback(code, path);
+        ++file_count;
+    }
+
+    EXPECT_NE(file_count, 0);
+}
+
+/// Calls `run`, and returns the diagnostic messages it emitted. If `max_errors` is not 0, the
+/// diagnostics are collected by a `DiagnosticEngine` with that limit, which allows `run` to recover
+/// from errors.
+inline auto capture(std::size_t max_errors, std::function<void()> const& run) -> std::string {
+    std::ostringstream out;
+    DiagnosticRedirect const redirect(out);
+    if (max_errors == 0) {
+        run();
+        return out.str();
+    }
+
+    DiagnosticEngine engine(max_errors);
+    {
+        DiagnosticEngine::Scope const scope(engine);
+        run();
+    }
+
+    TextDiagnosticSink sink(out, diagnostic_source());
+    engine.flush(sink);
+    return out.str();
+}
+
+#endif  // ASSEMBLER_UNITTEST_TEST_SUPPORT_HPP
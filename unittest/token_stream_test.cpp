@@ -0,0 +1,178 @@
+#include "assembler/instruction.hpp"
+#include "assembler/parallel.hpp"
+#include "assembler/parser.hpp"
+#include "assembler/symbol.hpp"
+#include "assembler/token.hpp"
+#include "assembler/token_stream.hpp"
+
+#include "test_support.hpp"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+auto lex_serial(std::string const& code) -> std::vector<Token> {
+    Parser parser(code);
+    std::vector<Token> tokens;
+    do {
+        tokens.push_back(parser.next_token());
+    } while (tokens.back().kind() != Token::End);
+    return tokens;
+}
+
+/// Checks that lexing `code` into a `TokenStream` with various numbers of threads and chunk sizes
+/// produces exactly the tokens of the serial lexer, including their decoded content.
+void check_same_tokens(std::string const& code, std::string const& description) {
+    std::vector<Token> const expected = lex_serial(code);
+
+    for (unsigned const thread_count : { 1u, 2u, 3u, 8u }) {
+        for (std::size_t const min_chunk_size : { 1, 16, 256 }) {
+            TokenStream const actual(
+                code.data(),
+                code.data() + code.size(),
+                thread_count,
+                min_chunk_size
+            );
+
+            ASSERT_EQ(actual.size(), expected.size()) << description;
+            for (std::size_t i = 0; i != expected.size(); ++i) {
+                Token const token = actual[i];
+                ASSERT_EQ(token, expected[i]) << description << ", token " << i;
+                ASSERT_EQ(actual.kind(i), expected[i].kind()) << description << ", token " << i;
+                ASSERT_EQ(token.opcode(), expected[i].opcode()) << description << ", token " << i;
+                ASSERT_EQ(token.value(), expected[i].value()) << description << ", token " << i;
+                ASSERT_EQ(token.number_error(), expected[i].number_error())
+                    << description << ", token " << i;
+            }
+        }
+    }
+}
+}  // namespace
+
+TEST(TokenStreamTest, SplitLines) {
+    std::string const code = "AB\nCD\n\nEFGH\nI";
+    char const* const begin = code.data();
+    char const* const end = code.data() + code.size();
+
+    // Small inputs are not split.
+    EXPECT_EQ(split_lines(begin, end, 4, 1024), (std::vector<char const*> { begin, end }));
+    EXPECT_EQ(split_lines(begin, begin, 4, 1), (std::vector<char const*> { begin, begin }));
+
+    // Boundaries lie just past newline characters, and are strictly increasing.
+    for (std::size_t chunk_count = 1; chunk_count != 20; ++chunk_count) {
+        std::vector<char const*> const boundaries = split_lines(begin, end, chunk_count, 1);
+
+        ASSERT_GE(boundaries.size(), 2);
+        EXPECT_LE(boundaries.size(), chunk_count + 1);
+        EXPECT_EQ(boundaries.front(), begin);
+        EXPECT_EQ(boundaries.back(), end);
+        for (std::size_t i = 1; i + 1 < boundaries.size(); ++i) {
+            EXPECT_LT(boundaries[i - 1], boundaries[i]);
+            EXPECT_EQ(boundaries[i][-1], '\n');
+        }
+    }
+}
+
+TEST(TokenStreamTest, SplitRange) {
+    // Small ranges are not split.
+    EXPECT_EQ(split_range(10, 4, 1024), (std::vector<std::size_t> { 0, 10 }));
+    EXPECT_EQ(split_range(0, 4, 1), (std::vector<std::size_t> { 0, 0 }));
+    EXPECT_EQ(split_range(10, 4, 1), (std::vector<std::size_t> { 0, 3, 6, 8, 10 }));
+    EXPECT_EQ(split_range(10, 4, 3), (std::vector<std::size_t> { 0, 4, 7, 10 }));
+    EXPECT_EQ(split_range(3, 8, 1), (std::vector<std::size_t> { 0, 1, 2, 3 }));
+}
+
+TEST(TokenStreamTest, ParallelFor) {
+    // Every index is called once, even with more calls than threads, and across repeated calls on
+    // the same threads.
+    for (std::size_t count : { 0, 1, 2, 64 }) {
+        std::vector<int> calls(count, 0);
+        parallel_for(count, [&](std::size_t index) { ++calls[index]; });
+        EXPECT_EQ(calls, std::vector<int>(count, 1));
+    }
+
+    // A call may run a `parallel_for()` of its own.
+    std::vector<std::vector<int>> calls(8, std::vector<int>(8, 0));
+    parallel_for(calls.size(), [&](std::size_t outer) {
+        parallel_for(calls[outer].size(), [&](std::size_t inner) { ++calls[outer][inner]; });
+    });
+    EXPECT_EQ(calls, std::vector<std::vector<int>>(8, std::vector<int>(8, 1)));
+}
+
+TEST(TokenStreamTest, SameTokensOnTestFiles) {
+    for_each_test_file(check_same_tokens);
+}
+
+TEST(TokenStreamTest, LongTokens) {
+    // Tokens too long for the length field of a record keep their full length.
+    std::string const label(TokenStream::long_token_length, 'A');
+    std::string const string = '"' + std::string(TokenStream::long_token_length + 10, 'B') + '"';
+    std::string const code =
+        label + " ADD R1, R1, #1\n" + string + "\n.STRINGZ " + string + " " + label + "\n";
+
+    check_same_tokens(code, "long tokens");
+}
+
+TEST(TokenStreamTest, ParseFromTokens) {
+    // A parser reading pre-lexed tokens stops at `.END` like a parser reading the source code.
+    std::string const code = ".ORIG x3000\nLOOP\nADD R1, R1, #1\nBRz LOOP\n.END\nHALT\n";
+    TokenStream const tokens(code.data(), code.data() + code.size(), 4, 1);
+
+    Parser source_parser(code);
+    Parser token_parser(tokens, source_parser.symbols());
+    std::vector<Instruction> const expected = source_parser.parse_instructions();
+    std::vector<Instruction> const actual = token_parser.parse_instructions();
+    SymbolPool::Scope const scope(source_parser.symbols().get());
+
+    ASSERT_EQ(actual.size(), 4);
+    ASSERT_EQ(actual.size(), expected.size());
+    for (std::size_t i = 0; i != expected.size(); ++i) {
+        std::ostringstream expected_text;
+        std::ostringstream actual_text;
+        expected_text << expected[i];
+        actual_text << actual[i];
+        EXPECT_EQ(actual_text.str(), expected_text.str());
+    }
+
+    // The parser stops at the first token after `.END`, since it is not `.ORIG`. The tokens after
+    // it are still available, and the final `Token::End` is returned repeatedly.
+    EXPECT_EQ(token_parser.current_token().kind(), Token::Opcode);
+    EXPECT_EQ(token_parser.next_token().kind(), Token::EOL);
+    EXPECT_EQ(token_parser.next_token().kind(), Token::End);
+    EXPECT_EQ(token_parser.next_token().kind(), Token::End);
+}
+
+TEST(TokenStreamTest, Peek) {
+    std::string const code = "ADD R1, R1, #1\nHALT";
+    TokenStream const tokens(code.data(), code.data() + code.size());
+    std::vector<Token> const expected = lex_serial(code);
+    ASSERT_EQ(expected.size(), 9);
+
+    Parser source_parser(code);
+    Parser token_parser(tokens);
+    for (std::size_t consumed = 0; consumed != expected.size(); ++consumed) {
+        for (std::size_t n = 1; n != 14; ++n) {
+            // Past the end of the tokens, `peek()` returns the final `Token::End`.
+            Token const& peeked = expected[std::min(consumed + n - 1, expected.size() - 1)];
+            EXPECT_EQ(token_parser.peek(n), peeked) << consumed << " consumed, peek " << n;
+            EXPECT_EQ(source_parser.peek(n), peeked) << consumed << " consumed, peek " << n;
+        }
+
+        // Peeking does not consume tokens.
+        EXPECT_EQ(token_parser.next_token(), expected[consumed]);
+        EXPECT_EQ(source_parser.next_token(), expected[consumed]);
+        EXPECT_EQ(token_parser.peek(0), expected[consumed]);
+    }
+
+    // A parser reading a range of the tokens stops at the end of the range.
+    Parser range_parser(tokens, 0, 3);
+    EXPECT_EQ(range_parser.peek(3), expected[2]);
+    EXPECT_EQ(range_parser.peek(4).kind(), Token::End);
+    EXPECT_EQ(range_parser.peek(4).begin(), expected[2].end());
+    EXPECT_EQ(range_parser.peek(100).kind(), Token::End);
+}